@@ -0,0 +1,66 @@
+#pragma once
+
+// Incremental-build manifest for the asset cooker.
+//
+// One line per cooked asset: "<cook key> <source path relative to the input root>". The cook key hashes
+// the source bytes together with the cooker version and the settings for that asset type, so an asset is
+// re-cooked when its content, the cooker or its settings change, and skipped otherwise. Timestamps are
+// deliberately not used: checkouts and copies touch them without changing content.
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+class CookManifest
+{
+public:
+	void load(const std::filesystem::path& path)
+	{
+		std::ifstream file(path);
+		if (!file.is_open())
+			return; // first cook
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string key;
+			std::string source;
+			if (stream >> key && std::getline(stream >> std::ws, source))
+				entries[source] = std::stoull(key, nullptr, 16);
+		}
+	}
+
+	void save(const std::filesystem::path& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+			throw std::runtime_error("failed to write cook manifest: " + path.string());
+
+		for (const auto& [source, key] : entries)
+			file << std::hex << key << std::dec << " " << source << "\n";
+	}
+
+	// True when the output exists and was cooked from the same key.
+	bool upToDate(const std::string& source, uint64_t key, const std::filesystem::path& output)
+	{
+		std::lock_guard lock(mutex);
+		auto entry = entries.find(source);
+		return entry != entries.end() && entry->second == key && std::filesystem::exists(output);
+	}
+
+	void record(const std::string& source, uint64_t key)
+	{
+		std::lock_guard lock(mutex);
+		entries[source] = key;
+	}
+
+private:
+	std::unordered_map<std::string, uint64_t> entries;
+	std::mutex mutex;
+};
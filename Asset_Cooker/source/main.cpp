@@ -0,0 +1,287 @@
+// Offline asset cooker.
+//
+//   Asset_Cooker <input dir> <output dir> [--force] [--threads=N] [--pack=<file>]
+//
+// Walks the input tree and cooks every PNG/JPG into a UASTC KTX2 file with a full mip chain and every
+// OBJ/glTF into a cooked mesh, mirroring the directory layout under the output directory. Assets are
+// cooked in parallel on a thread pool. The build is incremental: an asset is skipped when its content
+// hash, the cooker version and its cook settings match the manifest entry from the previous run.
+// --pack then writes every runtime file under the input directory, cooked output included when it lives
+// there, into one asset pack (core/assetPack.h) with names relative to the input directory.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <latch>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <stb_image.h>
+#include <tiny_obj_loader.h>
+#include <tiny_gltf.h>
+#include <ktx.h>
+
+#include "core/contentHash.h"
+#include "core/assetPack.h"
+#include "core/taskGraph.h"
+#include "cookManifest.h"
+#include "textureCooker.h"
+#include "meshCooker.h"
+
+// Bump whenever a change to the cooker alters its output, so every asset is re-cooked once.
+constexpr uint32_t COOKER_VERSION = 1;
+const char* const MANIFEST_NAME = ".cook_manifest";
+
+struct CookOptions
+{
+	std::filesystem::path input;
+	std::filesystem::path output;
+	std::filesystem::path pack;
+	bool force = false;
+	uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	static CookOptions parse(int argc, char** argv)
+	{
+		CookOptions options;
+		std::vector<std::string_view> positional;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string_view argument = argv[i];
+			if (argument == "--force")
+				options.force = true;
+			else if (argument.starts_with("--threads="))
+				options.threads = std::max(static_cast<uint32_t>(std::stoul(std::string(argument.substr(10)))), 1u);
+			else if (argument.starts_with("--pack="))
+				options.pack = argument.substr(7);
+			else if (argument.starts_with("--"))
+				throw std::invalid_argument("unknown option: " + std::string(argument));
+			else
+				positional.push_back(argument);
+		}
+
+		if (positional.size() != 2)
+			throw std::invalid_argument("expected an input and an output directory");
+
+		options.input = positional[0];
+		options.output = positional[1];
+		return options;
+	}
+
+	static void printUsage()
+	{
+		std::cerr << "usage: Asset_Cooker <input dir> <output dir> [--force] [--threads=N] [--pack=<file>]" << std::endl;
+	}
+};
+
+enum class AssetType
+{
+	Texture,
+	Mesh
+};
+
+struct CookJob
+{
+	AssetType type;
+	std::filesystem::path source;
+	std::filesystem::path output;
+	std::string name; // source path relative to the input root, the manifest key
+};
+
+bool isInside(const std::filesystem::path& path, const std::filesystem::path& directory)
+{
+	auto relative = path.lexically_relative(directory);
+	return !relative.empty() && *relative.begin() != "..";
+}
+
+std::vector<CookJob> collectJobs(const CookOptions& options)
+{
+	std::filesystem::path outputRoot = std::filesystem::weakly_canonical(options.output);
+
+	std::vector<CookJob> jobs;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(options.input))
+	{
+		if (!entry.is_regular_file() || isInside(std::filesystem::weakly_canonical(entry.path()), outputRoot))
+			continue;
+
+		std::filesystem::path relative = entry.path().lexically_relative(options.input);
+		if (isTextureSource(entry.path()))
+			jobs.push_back({ AssetType::Texture, entry.path(), options.output / std::filesystem::path(relative).replace_extension(".ktx2"), relative.generic_string() });
+		else if (isMeshSource(entry.path()))
+			jobs.push_back({ AssetType::Mesh, entry.path(), options.output / std::filesystem::path(relative).replace_extension(".mesh"), relative.generic_string() });
+	}
+
+	// Deterministic order keeps the log readable between runs
+	std::ranges::sort(jobs, {}, &CookJob::name);
+	return jobs;
+}
+
+// Sources and tooling files stay out of packs; everything else under the input tree is loaded at runtime.
+bool isPackable(const std::filesystem::path& path, const std::filesystem::path& packPath)
+{
+	std::string extension = path.extension().string();
+	return extension != ".bat" && extension != ".sh" && extension != ".slang" && path.filename() != MANIFEST_NAME &&
+		!(std::filesystem::exists(packPath) && std::filesystem::equivalent(path, packPath));
+}
+
+// Blobs the apps upload to the GPU unchanged (cooked meshes) stay raw so they can be copied from the
+// mapping straight into staging memory; the rest is LZ4-compressed when that pays off.
+uint64_t writePack(const CookOptions& options, ThreadPool& pool)
+{
+	std::vector<std::filesystem::path> files;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(options.input))
+		if (entry.is_regular_file() && isPackable(entry.path(), options.pack))
+			files.push_back(entry.path());
+
+	AssetPackWriter writer;
+	std::latch packed(static_cast<std::ptrdiff_t>(files.size()));
+	std::exception_ptr failure;
+	std::mutex failureMutex;
+	for (const auto& path : files)
+	{
+		pool.submit([&, path]()
+			{
+				try
+				{
+					std::ifstream file(path, std::ios::binary | std::ios::ate);
+					std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+					file.seekg(0);
+					file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+					writer.add(path.lexically_relative(options.input).generic_string(), bytes, path.extension() != ".mesh");
+				}
+				catch (...)
+				{
+					std::lock_guard lock(failureMutex);
+					failure = std::current_exception();
+				}
+
+				packed.count_down();
+			});
+	}
+	packed.wait();
+
+	if (failure != nullptr)
+		std::rethrow_exception(failure);
+
+	return writer.write(options.pack);
+}
+
+int main(int argc, char** argv)
+{
+	CookOptions options;
+	try
+	{
+		options = CookOptions::parse(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		CookOptions::printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (!std::filesystem::is_directory(options.input))
+	{
+		std::cerr << "input directory not found: " << options.input << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::filesystem::create_directories(options.output);
+	std::vector<CookJob> jobs = collectJobs(options);
+
+	CookManifest manifest;
+	std::filesystem::path manifestPath = options.output / MANIFEST_NAME;
+	if (!options.force)
+		manifest.load(manifestPath);
+
+	TextureCookSettings textureSettings;
+	MeshCookSettings meshSettings;
+	uint64_t versionSeed = hashString(std::to_string(COOKER_VERSION));
+	uint64_t textureSeed = hashString(textureSettings.key(), versionSeed);
+	uint64_t meshSeed = hashString(meshSettings.key(), versionSeed);
+
+	// One texture gets every core through the Basis encoder; many textures share them one per job
+	auto textureCount = static_cast<uint32_t>(std::ranges::count(jobs, AssetType::Texture, &CookJob::type));
+	uint32_t encoderThreads = std::max(options.threads / std::max(textureCount, 1u), 1u);
+
+	std::atomic<uint32_t> cooked = 0;
+	std::atomic<uint32_t> skipped = 0;
+	std::atomic<uint32_t> failed = 0;
+	std::mutex logMutex;
+	std::latch finished(static_cast<std::ptrdiff_t>(jobs.size()));
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		ThreadPool pool(options.threads);
+		for (const CookJob& job : jobs)
+		{
+			pool.submit([&, job]()
+				{
+					try
+					{
+						uint64_t key = hashFile(job.source, job.type == AssetType::Texture ? textureSeed : meshSeed);
+						if (manifest.upToDate(job.name, key, job.output))
+						{
+							skipped++;
+						}
+						else
+						{
+							std::filesystem::create_directories(job.output.parent_path());
+							if (job.type == AssetType::Texture)
+								cookTexture(job.source, job.output, textureSettings, encoderThreads);
+							else
+								cookMesh(job.source, job.output, meshSettings);
+
+							manifest.record(job.name, key);
+							cooked++;
+
+							std::lock_guard lock(logMutex);
+							std::cout << "cooked " << job.name << " -> " << job.output.generic_string() << " (" << hashToString(key) << ")" << std::endl;
+						}
+					}
+					catch (const std::exception& e)
+					{
+						failed++;
+						std::lock_guard lock(logMutex);
+						std::cerr << "failed to cook " << job.name << ": " << e.what() << std::endl;
+					}
+
+					finished.count_down();
+				});
+		}
+
+		finished.wait();
+		manifest.save(manifestPath);
+
+		auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << cooked << " cooked, " << skipped << " up to date, " << failed << " failed in " << elapsed << " s" << std::endl;
+
+		if (!options.pack.empty() && failed == 0)
+		{
+			try
+			{
+				uint64_t packBytes = writePack(options, pool);
+				std::cout << "packed " << options.pack.generic_string() << " (" << packBytes << " bytes)" << std::endl;
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "failed to write asset pack: " << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+// OBJ/glTF -> cooked mesh (.mesh, see core/cookedMesh.h).
+// Expects Vulkan-Hpp (header or module), <tiny_obj_loader.h> and <tiny_gltf.h> to be visible at the include site.
+//
+// Runs the same processing the apps otherwise do at load time: vertices are deduplicated, triangles are
+// reordered for the vertex cache and overdraw, vertices for fetch locality, an LOD chain is appended and
+// the result is encoded with the requested VertexLayout. Indices are packed to at most 16 bits but never
+// to 8, which needs a device extension the cooker cannot know about.
+// OBJ texture coordinates are flipped to a top-left origin; glTF already uses one. No other axis
+// conventions are applied: those belong to the app.
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/meshData.h"
+#include "core/meshOptimizer.h"
+#include "core/meshSimplifier.h"
+#include "core/vertexLayout.h"
+#include "core/indexFormat.h"
+#include "core/cookedMesh.h"
+
+struct MeshCookSettings
+{
+	VertexLayout layout;
+	bool buildLods = true;
+
+	[[nodiscard]] std::string key() const
+	{
+		return "layout " + std::to_string(static_cast<int>(layout.position)) + std::to_string(static_cast<int>(layout.texCoord))
+			+ std::to_string(static_cast<int>(layout.normal)) + " lods " + std::to_string(buildLods);
+	}
+};
+
+namespace mesh_cooker
+{
+	// Appends a vertex unless an identical one was already added and returns its index.
+	inline uint32_t addVertex(MeshData& mesh, std::unordered_map<MeshVertex, uint32_t>& uniqueVertices, const MeshVertex& vertex)
+	{
+		auto [entry, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(mesh.vertices.size()));
+		if (inserted)
+			mesh.vertices.push_back(vertex);
+
+		return entry->second;
+	}
+
+	inline MeshData loadObj(const std::filesystem::path& source)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, source.string().c_str()))
+			throw std::runtime_error(warn + err);
+
+		MeshData mesh;
+		std::unordered_map<MeshVertex, uint32_t> uniqueVertices;
+		for (const auto& shape : shapes)
+		{
+			for (const auto& index : shape.mesh.indices)
+			{
+				MeshVertex vertex{};
+				vertex.pos = {
+					attrib.vertices[3 * index.vertex_index + 0],
+					attrib.vertices[3 * index.vertex_index + 1],
+					attrib.vertices[3 * index.vertex_index + 2]
+				};
+
+				if (index.texcoord_index >= 0)
+				{
+					vertex.texCoord = {
+						attrib.texcoords[2 * index.texcoord_index + 0],
+						1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
+					};
+				}
+
+				if (index.normal_index >= 0)
+				{
+					vertex.normal = {
+						attrib.normals[3 * index.normal_index + 0],
+						attrib.normals[3 * index.normal_index + 1],
+						attrib.normals[3 * index.normal_index + 2]
+					};
+				}
+
+				mesh.indices.push_back(addVertex(mesh, uniqueVertices, vertex));
+			}
+		}
+
+		return mesh;
+	}
+
+	// Pointer to element i of a float accessor, honouring the buffer view's byte stride.
+	inline const float* floatElement(const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t i)
+	{
+		if (accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+			throw std::runtime_error("only float vertex attributes are supported");
+
+		const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+		size_t stride = static_cast<size_t>(accessor.ByteStride(view));
+
+		return reinterpret_cast<const float*>(&buffer.data[view.byteOffset + accessor.byteOffset + i * stride]);
+	}
+
+	inline uint32_t indexElement(const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t i)
+	{
+		const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+		const unsigned char* data = &buffer.data[view.byteOffset + accessor.byteOffset];
+
+		switch (accessor.componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return data[i];
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+		{
+			uint16_t index;
+			std::memcpy(&index, data + i * sizeof(uint16_t), sizeof(index));
+			return index;
+		}
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+		{
+			uint32_t index;
+			std::memcpy(&index, data + i * sizeof(uint32_t), sizeof(index));
+			return index;
+		}
+		default:
+			throw std::runtime_error("Unsupported index component type");
+		}
+	}
+
+	// Merges every triangle primitive of every mesh; node transforms are not applied.
+	inline MeshData loadGltf(const std::filesystem::path& source)
+	{
+		tinygltf::Model model;
+		tinygltf::TinyGLTF loader;
+		std::string err, warn;
+
+		bool loaded = source.extension() == ".glb"
+			? loader.LoadBinaryFromFile(&model, &err, &warn, source.string())
+			: loader.LoadASCIIFromFile(&model, &err, &warn, source.string());
+		if (!loaded)
+			throw std::runtime_error("failed to load glTF model: " + err);
+
+		MeshData mesh;
+		std::unordered_map<MeshVertex, uint32_t> uniqueVertices;
+		for (const auto& gltfMesh : model.meshes)
+		{
+			for (const auto& primitive : gltfMesh.primitives)
+			{
+				if (primitive.mode != TINYGLTF_MODE_TRIANGLES && primitive.mode != -1)
+					continue;
+
+				const tinygltf::Accessor& positions = model.accessors[primitive.attributes.at("POSITION")];
+				auto normals = primitive.attributes.find("NORMAL");
+				auto texCoords = primitive.attributes.find("TEXCOORD_0");
+
+				std::vector<uint32_t> remap(positions.count);
+				for (size_t i = 0; i < positions.count; i++)
+				{
+					MeshVertex vertex{};
+					const float* pos = floatElement(model, positions, i);
+					vertex.pos = { pos[0], pos[1], pos[2] };
+
+					if (normals != primitive.attributes.end())
+					{
+						const float* normal = floatElement(model, model.accessors[normals->second], i);
+						vertex.normal = { normal[0], normal[1], normal[2] };
+					}
+
+					if (texCoords != primitive.attributes.end())
+					{
+						const float* texCoord = floatElement(model, model.accessors[texCoords->second], i);
+						vertex.texCoord = { texCoord[0], texCoord[1] };
+					}
+
+					remap[i] = addVertex(mesh, uniqueVertices, vertex);
+				}
+
+				if (primitive.indices < 0)
+				{
+					mesh.indices.insert(mesh.indices.end(), remap.begin(), remap.end());
+					continue;
+				}
+
+				const tinygltf::Accessor& indices = model.accessors[primitive.indices];
+				for (size_t i = 0; i < indices.count; i++)
+					mesh.indices.push_back(remap[indexElement(model, indices, i)]);
+			}
+		}
+
+		return mesh;
+	}
+}
+
+inline bool isMeshSource(const std::filesystem::path& path)
+{
+	std::string extension = path.extension().string();
+	return extension == ".obj" || extension == ".gltf" || extension == ".glb";
+}
+
+inline void cookMesh(const std::filesystem::path& source, const std::filesystem::path& output, const MeshCookSettings& settings)
+{
+	MeshData mesh = source.extension() == ".obj" ? mesh_cooker::loadObj(source) : mesh_cooker::loadGltf(source);
+	if (mesh.indices.empty())
+		throw std::runtime_error("model has no triangles: " + source.string());
+
+	mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size());
+	mesh.indices = optimizeOverdraw(mesh.indices, mesh.vertices);
+	optimizeVertexFetch(mesh);
+	if (settings.buildLods)
+		buildLodChain(mesh);
+	else
+		mesh.lods = { MeshLod{ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f } };
+
+	CookedMesh cooked
+	{
+		.vertices = encodeVertices(mesh.vertices, settings.layout, mesh.bounds()),
+		.indices = packIndices(mesh.indices, mesh.vertices.size(), false),
+		.lods = mesh.lods,
+		.bounds = mesh.bounds()
+	};
+
+	writeCookedMesh(output, cooked);
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+// PNG/JPG -> KTX2 texture cooking.
+// Expects Vulkan-Hpp (header or module), <ktx.h> and <stb_image.h> to be visible at the include site.
+//
+// The full mip chain is built on the CPU with a gamma-correct 2x2 box filter (odd dimensions clamp the
+// last row and column), then every level is encoded to UASTC by the Basis Universal encoder in libktx
+// and zstd-supercompressed. The runtime transcodes UASTC to BC7, ASTC or ETC2 (see core/ktxUpload.h).
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct TextureCookSettings
+{
+	uint32_t uastcLevel = KTX_PACK_UASTC_LEVEL_DEFAULT;
+	uint32_t zstdLevel = 18; // 0 disables supercompression
+
+	[[nodiscard]] std::string key() const
+	{
+		return "uastc " + std::to_string(uastcLevel) + " zstd " + std::to_string(zstdLevel);
+	}
+};
+
+namespace texture_cooker
+{
+	inline float srgbToLinear(uint8_t value)
+	{
+		static const std::array<float, 256> table = []()
+			{
+				std::array<float, 256> values{};
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					float c = static_cast<float>(i) / 255.0f;
+					values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+				}
+				return values;
+			}();
+
+		return table[value];
+	}
+
+	inline uint8_t linearToSrgb(float value)
+	{
+		value = std::clamp(value, 0.0f, 1.0f);
+		float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::lround(c * 255.0f));
+	}
+
+	// Halves an RGBA8 sRGB image; colour is averaged in linear space, alpha directly.
+	inline std::vector<uint8_t> downsample(const std::vector<uint8_t>& source, uint32_t width, uint32_t height)
+	{
+		uint32_t outWidth = std::max(width / 2, 1u);
+		uint32_t outHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> result(static_cast<size_t>(outWidth) * outHeight * 4);
+
+		for (uint32_t y = 0; y < outHeight; y++)
+		{
+			uint32_t y0 = std::min(y * 2, height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, height - 1);
+			for (uint32_t x = 0; x < outWidth; x++)
+			{
+				uint32_t x0 = std::min(x * 2, width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, width - 1);
+				const uint8_t* texels[4] = {
+					&source[(static_cast<size_t>(y0) * width + x0) * 4],
+					&source[(static_cast<size_t>(y0) * width + x1) * 4],
+					&source[(static_cast<size_t>(y1) * width + x0) * 4],
+					&source[(static_cast<size_t>(y1) * width + x1) * 4]
+				};
+
+				uint8_t* destination = &result[(static_cast<size_t>(y) * outWidth + x) * 4];
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					float sum = 0.0f;
+					for (const uint8_t* texel : texels)
+						sum += srgbToLinear(texel[c]);
+					destination[c] = linearToSrgb(sum * 0.25f);
+				}
+
+				uint32_t alpha = 0;
+				for (const uint8_t* texel : texels)
+					alpha += texel[3];
+				destination[3] = static_cast<uint8_t>((alpha + 2) / 4);
+			}
+		}
+
+		return result;
+	}
+}
+
+inline bool isTextureSource(const std::filesystem::path& path)
+{
+	std::string extension = path.extension().string();
+	return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+}
+
+/**
+* Cooks one image into a UASTC KTX2 file with a full mip chain. threadCount is handed to the Basis
+* encoder, which splits each level into blocks across that many threads.
+*/
+inline void cookTexture(const std::filesystem::path& source, const std::filesystem::path& output, const TextureCookSettings& settings, uint32_t threadCount)
+{
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* pixels = stbi_load(source.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+		throw std::runtime_error("failed to load texture image: " + source.string());
+
+	std::vector<uint8_t> level(pixels, pixels + static_cast<size_t>(width) * height * 4);
+	stbi_image_free(pixels);
+
+	uint32_t levelWidth = static_cast<uint32_t>(width);
+	uint32_t levelHeight = static_cast<uint32_t>(height);
+	uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(levelWidth, levelHeight)))) + 1;
+
+	ktxTextureCreateInfo createInfo
+	{
+		.glInternalformat = 0,
+		.vkFormat = static_cast<ktx_uint32_t>(vk::Format::eR8G8B8A8Srgb),
+		.pDfd = nullptr,
+		.baseWidth = levelWidth,
+		.baseHeight = levelHeight,
+		.baseDepth = 1,
+		.numDimensions = 2,
+		.numLevels = mipLevels,
+		.numLayers = 1,
+		.numFaces = 1,
+		.isArray = KTX_FALSE,
+		.generateMipmaps = KTX_FALSE
+	};
+
+	ktxTexture2* texture = nullptr;
+	if (ktxTexture2_Create(&createInfo, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture) != KTX_SUCCESS)
+		throw std::runtime_error("failed to create ktx2 texture: " + source.string());
+
+	auto* base = reinterpret_cast<ktxTexture*>(texture);
+	try
+	{
+		for (uint32_t mip = 0; mip < mipLevels; mip++)
+		{
+			if (ktxTexture_SetImageFromMemory(base, mip, 0, 0, level.data(), level.size()) != KTX_SUCCESS)
+				throw std::runtime_error("failed to set ktx2 mip level: " + source.string());
+
+			if (mip + 1 < mipLevels)
+			{
+				level = texture_cooker::downsample(level, levelWidth, levelHeight);
+				levelWidth = std::max(levelWidth / 2, 1u);
+				levelHeight = std::max(levelHeight / 2, 1u);
+			}
+		}
+
+		ktxBasisParams params{};
+		params.structSize = sizeof(params);
+		params.uastc = KTX_TRUE;
+		params.uastcFlags = settings.uastcLevel;
+		params.threadCount = std::max(threadCount, 1u);
+		if (ktxTexture2_CompressBasisEx(texture, &params) != KTX_SUCCESS)
+			throw std::runtime_error("failed to encode texture to UASTC: " + source.string());
+
+		if (settings.zstdLevel > 0 && ktxTexture2_DeflateZstd(texture, settings.zstdLevel) != KTX_SUCCESS)
+			throw std::runtime_error("failed to supercompress texture: " + source.string());
+
+		if (ktxTexture_WriteToNamedFile(base, output.string().c_str()) != KTX_SUCCESS)
+			throw std::runtime_error("failed to write ktx2 texture: " + output.string());
+	}
+	catch (...)
+	{
+		ktxTexture_Destroy(base);
+		throw;
+	}
+
+	ktxTexture_Destroy(base);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+// A Vulkan device for the tests that need one, created without a window or surface.
+
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "testing.h"
+
+// Device on the first physical device with one queue of family 0; skips the test when there is none.
+struct HeadlessDevice
+{
+	std::optional<vk::raii::Context> context;
+	vk::raii::Instance instance = nullptr;
+	vk::raii::PhysicalDevice physicalDevice = nullptr;
+	vk::raii::Device device = nullptr;
+	vk::raii::Queue queue = nullptr;
+
+	HeadlessDevice()
+	{
+		try
+		{
+			context.emplace();
+
+			constexpr vk::ApplicationInfo appInfo
+			{
+				.pApplicationName = "Tests",
+				.apiVersion = vk::ApiVersion11
+			};
+			instance = vk::raii::Instance(*context, vk::InstanceCreateInfo{ .pApplicationInfo = &appInfo });
+
+			std::vector<vk::raii::PhysicalDevice> devices = instance.enumeratePhysicalDevices();
+			if (devices.empty())
+				throw testing::SkipTest("no Vulkan device");
+			physicalDevice = std::move(devices.front());
+
+			float queuePriority = 0.5f;
+			vk::DeviceQueueCreateInfo queueCreateInfo
+			{
+				.queueFamilyIndex = 0,
+				.queueCount = 1,
+				.pQueuePriorities = &queuePriority
+			};
+			device = vk::raii::Device(physicalDevice, vk::DeviceCreateInfo{ .queueCreateInfoCount = 1, .pQueueCreateInfos = &queueCreateInfo });
+			queue = vk::raii::Queue(device, 0, 0);
+		}
+		catch (const testing::SkipTest&)
+		{
+			throw;
+		}
+		catch (const std::exception& e)
+		{
+			throw testing::SkipTest(std::string("no Vulkan device: ") + e.what());
+		}
+	}
+
+	// Signals fence once the queue has finished everything submitted before it.
+	void signal(vk::Fence fence) const
+	{
+		queue.submit(vk::SubmitInfo{}, fence);
+	}
+};
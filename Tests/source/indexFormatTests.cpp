@@ -0,0 +1,82 @@
+// core/indexFormat.h: format selection at the type boundaries and the packed byte layout.
+
+#include <cstring>
+#include <vector>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "core/indexFormat.h"
+#include "testing.h"
+
+namespace
+{
+	template<typename T>
+	std::vector<uint32_t> unpack(const PackedIndices& packed)
+	{
+		std::vector<uint32_t> indices(packed.count);
+		for (uint32_t i = 0; i < packed.count; i++)
+		{
+			T index;
+			std::memcpy(&index, packed.data.data() + i * sizeof(T), sizeof(T));
+			indices[i] = index;
+		}
+		return indices;
+	}
+}
+
+TEST(indexFormat_selectsNarrowestTypeBelowRestartValue)
+{
+	// n bits hold 2^n - 1 vertices: the largest index, 2^n - 2, stays below the all-ones restart value
+	CHECK(selectIndexFormat(0, true) == IndexFormat::Uint8);
+	CHECK(selectIndexFormat(255, true) == IndexFormat::Uint8);
+	CHECK(selectIndexFormat(256, true) == IndexFormat::Uint16);
+	CHECK(selectIndexFormat(65535, true) == IndexFormat::Uint16);
+	CHECK(selectIndexFormat(65536, true) == IndexFormat::Uint32);
+}
+
+TEST(indexFormat_skipsUint8WhenUnsupported)
+{
+	CHECK(selectIndexFormat(1, false) == IndexFormat::Uint16);
+	CHECK(selectIndexFormat(255, false) == IndexFormat::Uint16);
+	CHECK(selectIndexFormat(65536, false) == IndexFormat::Uint32);
+}
+
+TEST(indexFormat_mapsToVulkanIndexTypes)
+{
+	CHECK(toIndexType(IndexFormat::Uint8) == vk::IndexType::eUint8EXT);
+	CHECK(toIndexType(IndexFormat::Uint16) == vk::IndexType::eUint16);
+	CHECK(toIndexType(IndexFormat::Uint32) == vk::IndexType::eUint32);
+	CHECK(indexSize(IndexFormat::Uint8) == 1);
+	CHECK(indexSize(IndexFormat::Uint16) == 2);
+	CHECK(indexSize(IndexFormat::Uint32) == 4);
+}
+
+TEST(indexFormat_packsLargestIndexOfEachType)
+{
+	std::vector<uint32_t> indices = { 0, 1, 254 };
+	PackedIndices packed = packIndices(indices, 255, true);
+	REQUIRE(packed.format == IndexFormat::Uint8);
+	CHECK(packed.indexType() == vk::IndexType::eUint8EXT);
+	CHECK(packed.count == 3);
+	CHECK(packed.data.size() == 3);
+	CHECK(unpack<uint8_t>(packed) == indices);
+
+	indices = { 0, 255, 65534 };
+	packed = packIndices(indices, 65535, true);
+	REQUIRE(packed.format == IndexFormat::Uint16);
+	CHECK(packed.data.size() == 6);
+	CHECK(unpack<uint16_t>(packed) == indices);
+
+	indices = { 0, 65535, 65536, 4000000000u };
+	packed = packIndices(indices, 4000000001u, true);
+	REQUIRE(packed.format == IndexFormat::Uint32);
+	CHECK(packed.data.size() == 16);
+	CHECK(unpack<uint32_t>(packed) == indices);
+}
+
+TEST(indexFormat_packsEmptyIndexList)
+{
+	PackedIndices packed = packIndices({}, IndexFormat::Uint16);
+	CHECK(packed.count == 0);
+	CHECK(packed.data.empty());
+}
@@ -0,0 +1,183 @@
+// core/assetPack.h, lz4_block: round trips over the format's edge cases and rejection of corrupt blocks.
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "core/assetPack.h"
+#include "testing.h"
+
+namespace
+{
+	std::vector<uint8_t> compress(const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> compressed(lz4_block::compressBound(data.size()));
+		size_t size = lz4_block::compress(data.data(), data.size(), compressed.data(), compressed.size());
+		compressed.resize(size);
+		return compressed;
+	}
+
+	std::vector<uint8_t> decompress(const std::vector<uint8_t>& compressed, size_t size)
+	{
+		std::vector<uint8_t> data(size);
+		lz4_block::decompress(compressed.data(), compressed.size(), data.data(), size);
+		return data;
+	}
+
+	std::vector<uint8_t> randomBytes(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<uint8_t> data(size);
+		for (uint8_t& byte : data)
+			byte = static_cast<uint8_t>(random());
+		return data;
+	}
+
+	// The end-of-block rules LZ4_decompress_safe relies on: the last sequence is literals only, holding
+	// at least the last five bytes, and no match starts within the last twelve bytes.
+	bool followsEndOfBlockRules(const std::vector<uint8_t>& compressed, size_t size)
+	{
+		size_t input = 0, output = 0;
+		auto readLength = [&](size_t length)
+			{
+				if (length == 15)
+				{
+					uint8_t byte;
+					do
+					{
+						byte = compressed[input++];
+						length += byte;
+					} while (byte == 255);
+				}
+				return length;
+			};
+
+		while (true)
+		{
+			uint8_t token = compressed[input++];
+			size_t literalCount = readLength(token >> 4);
+			input += literalCount;
+			output += literalCount;
+			if (input == compressed.size())
+				return size < lz4_block::MATCH_LIMIT + 1 || literalCount >= lz4_block::LAST_LITERALS;
+
+			if (output + lz4_block::MATCH_LIMIT > size)
+				return false;
+
+			input += 2;
+			output += readLength(token & 15) + lz4_block::MIN_MATCH;
+		}
+	}
+
+	void checkRoundTrip(const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> compressed = compress(data);
+		REQUIRE(!compressed.empty());
+		CHECK(compressed.size() <= lz4_block::compressBound(data.size()));
+		CHECK(followsEndOfBlockRules(compressed, data.size()));
+		CHECK(decompress(compressed, data.size()) == data);
+	}
+}
+
+TEST(lz4_roundTripsEmptyAndTinyInputs)
+{
+	checkRoundTrip({});
+	checkRoundTrip({ 42 });
+
+	// Up to MATCH_LIMIT bytes no match may start, so even repeated bytes stay literals
+	std::vector<uint8_t> repeated(lz4_block::MATCH_LIMIT, 7);
+	std::vector<uint8_t> compressed = compress(repeated);
+	CHECK(compressed.size() == repeated.size() + 1);
+	CHECK(decompress(compressed, repeated.size()) == repeated);
+
+	checkRoundTrip(std::vector<uint8_t>(lz4_block::MATCH_LIMIT + 1, 7));
+}
+
+TEST(lz4_roundTripsLongRunsAndLiterals)
+{
+	// Match and literal lengths of 15 + 255 and beyond need extra length bytes, including a 255 byte
+	std::vector<uint8_t> zeros(100000, 0);
+	std::vector<uint8_t> compressed = compress(zeros);
+	CHECK(compressed.size() < zeros.size() / 100);
+	CHECK(decompress(compressed, zeros.size()) == zeros);
+
+	for (size_t size : { size_t{ 14 }, size_t{ 15 }, size_t{ 16 }, size_t{ 269 }, size_t{ 270 }, size_t{ 271 }, size_t{ 525 }, size_t{ 4096 } })
+		checkRoundTrip(randomBytes(size, static_cast<uint32_t>(size)));
+}
+
+TEST(lz4_roundTripsIncompressibleData)
+{
+	std::vector<uint8_t> data = randomBytes(1 << 20, 1);
+	std::vector<uint8_t> compressed = compress(data);
+	REQUIRE(!compressed.empty());
+	CHECK(compressed.size() > data.size());
+	CHECK(compressed.size() <= lz4_block::compressBound(data.size()));
+	CHECK(decompress(compressed, data.size()) == data);
+}
+
+TEST(lz4_roundTripsMatchesAtOffsetLimits)
+{
+	// A repeat exactly MAX_OFFSET back is still referenced; one byte further it is out of reach
+	for (size_t distance : { lz4_block::MAX_OFFSET, lz4_block::MAX_OFFSET + 1 })
+	{
+		std::vector<uint8_t> data = randomBytes(distance + 4096, 2);
+		std::copy_n(data.begin(), 1024, data.begin() + distance);
+		checkRoundTrip(data);
+	}
+
+	// Overlapping matches (offset < length) repeat a short pattern
+	std::vector<uint8_t> pattern;
+	for (size_t i = 0; i < 5000; i++)
+		pattern.push_back(static_cast<uint8_t>("abc"[i % 3]));
+	checkRoundTrip(pattern);
+
+	std::string_view text = "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy cat.";
+	checkRoundTrip({ text.begin(), text.end() });
+}
+
+TEST(lz4_decodesReferenceBlock)
+{
+	// "abcd", a match of 8 at offset 4, then the literals "efghi", as the reference encoder writes it
+	std::vector<uint8_t> block = { 0x44, 'a', 'b', 'c', 'd', 4, 0, 0x50, 'e', 'f', 'g', 'h', 'i' };
+	std::string_view expected = "abcdabcdabcdefghi";
+	CHECK(decompress(block, expected.size()) == std::vector<uint8_t>(expected.begin(), expected.end()));
+}
+
+TEST(lz4_reportsInsufficientCapacity)
+{
+	std::vector<uint8_t> data = randomBytes(1000, 3);
+	std::vector<uint8_t> compressed(data.size() / 2);
+	CHECK(lz4_block::compress(data.data(), data.size(), compressed.data(), compressed.size()) == 0);
+	CHECK(lz4_block::compress(data.data(), data.size(), compressed.data(), 0) == 0);
+}
+
+TEST(lz4_rejectsCorruptBlocks)
+{
+	std::vector<uint8_t> block = { 0x44, 'a', 'b', 'c', 'd', 4, 0, 0x50, 'e', 'f', 'g', 'h', 'i' };
+	size_t size = 17;
+
+	// Truncated anywhere inside a sequence
+	CHECK_THROWS(decompress({ block.begin(), block.begin() + 3 }, size), std::runtime_error);
+	CHECK_THROWS(decompress({ block.begin(), block.begin() + 6 }, size), std::runtime_error);
+	CHECK_THROWS(decompress({ block.begin(), block.begin() + 10 }, size), std::runtime_error);
+	CHECK_THROWS(decompress({ 0xf0 }, size), std::runtime_error);
+
+	// Wrong output size in either direction
+	CHECK_THROWS(decompress(block, size - 1), std::runtime_error);
+	CHECK_THROWS(decompress(block, size + 1), std::runtime_error);
+
+	// Offsets of zero or reaching before the start of the output
+	std::vector<uint8_t> corrupt = block;
+	corrupt[5] = 0;
+	CHECK_THROWS(decompress(corrupt, size), std::runtime_error);
+	corrupt[5] = 5;
+	CHECK_THROWS(decompress(corrupt, size), std::runtime_error);
+
+	// A match running past the end of the output
+	corrupt = block;
+	corrupt[0] = 0x4f;
+	corrupt.insert(corrupt.begin() + 7, 200);
+	CHECK_THROWS(decompress(corrupt, size), std::runtime_error);
+}
@@ -0,0 +1,52 @@
+// Unit tests for the core headers shared by the application and the asset cooker.
+//
+//   Tests [filter]
+//
+// Runs every test whose name contains filter (all of them without one) and returns non-zero when any
+// check fails. Tests that need a Vulkan device are skipped on machines without one.
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string_view>
+
+#include "testing.h"
+
+int main(int argc, char** argv)
+{
+	std::string_view filter = argc > 1 ? argv[1] : "";
+
+	uint32_t passed = 0, failed = 0, skipped = 0;
+	for (const testing::TestCase& test : testing::registry())
+	{
+		if (std::string_view(test.name).find(filter) == std::string_view::npos)
+			continue;
+
+		uint32_t failuresBefore = testing::failures();
+		try
+		{
+			test.run();
+		}
+		catch (const testing::SkipTest& e)
+		{
+			std::cout << "[ skip ] " << test.name << ": " << e.what() << std::endl;
+			skipped++;
+			continue;
+		}
+		catch (const testing::RequireFailed&)
+		{
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << test.name << ": unexpected exception: " << e.what() << std::endl;
+			testing::failures()++;
+		}
+
+		bool ok = testing::failures() == failuresBefore;
+		std::cout << (ok ? "[  ok  ] " : "[ FAIL ] ") << test.name << std::endl;
+		(ok ? passed : failed)++;
+	}
+
+	std::cout << passed << " passed, " << failed << " failed, " << skipped << " skipped" << std::endl;
+	return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
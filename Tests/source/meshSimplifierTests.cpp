@@ -0,0 +1,133 @@
+// core/meshSimplifier.h: LOD chain length, index ranges and errors, and LOD selection.
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/meshSimplifier.h"
+#include "testing.h"
+
+namespace
+{
+	// Closed unit icosphere with shared vertices, so nothing is locked as a border or seam.
+	MeshData makeIcosphere(uint32_t subdivisions)
+	{
+		const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+		std::vector<glm::vec3> positions =
+		{
+			{ -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 },
+			{ 0, -1, t }, { 0, 1, t }, { 0, -1, -t }, { 0, 1, -t },
+			{ t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 },
+		};
+		std::vector<uint32_t> indices =
+		{
+			0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+			1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+			3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+			4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1,
+		};
+
+		for (uint32_t level = 0; level < subdivisions; level++)
+		{
+			std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+			auto midpoint = [&](uint32_t a, uint32_t b)
+				{
+					auto [it, inserted] = midpoints.try_emplace({ std::min(a, b), std::max(a, b) }, static_cast<uint32_t>(positions.size()));
+					if (inserted)
+						positions.push_back((positions[a] + positions[b]) * 0.5f);
+					return it->second;
+				};
+
+			std::vector<uint32_t> subdivided;
+			for (size_t i = 0; i < indices.size(); i += 3)
+			{
+				uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+				uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+				subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+			}
+			indices = std::move(subdivided);
+		}
+
+		MeshData mesh;
+		for (const glm::vec3& position : positions)
+		{
+			glm::vec3 normal = glm::normalize(position);
+			mesh.vertices.push_back({ .pos = normal, .normal = normal });
+		}
+		mesh.indices = std::move(indices);
+		return mesh;
+	}
+
+	uint32_t triangleCount(const MeshLod& lod)
+	{
+		return lod.indexCount / 3;
+	}
+}
+
+TEST(meshSimplifier_buildsRequestedLevelCount)
+{
+	MeshData mesh = makeIcosphere(4);
+	size_t fullIndexCount = mesh.indices.size();
+
+	LodOptions options;
+	buildLodChain(mesh, options);
+	REQUIRE(mesh.lods.size() == options.maxLevels);
+
+	// Level 0 is the untouched mesh; the levels follow it back to back in one index buffer
+	CHECK(mesh.lods[0].firstIndex == 0);
+	CHECK(mesh.lods[0].indexCount == fullIndexCount);
+	CHECK(mesh.lods[0].error == 0.0f);
+	for (size_t i = 1; i < mesh.lods.size(); i++)
+	{
+		const MeshLod& previous = mesh.lods[i - 1];
+		const MeshLod& lod = mesh.lods[i];
+		CHECK(lod.firstIndex == previous.firstIndex + previous.indexCount);
+		CHECK(lod.indexCount % 3 == 0);
+		CHECK(triangleCount(lod) > 0);
+		CHECK(static_cast<float>(triangleCount(lod)) <= static_cast<float>(triangleCount(previous)) * options.minimumReduction);
+		CHECK(lod.error > 0.0f);
+		CHECK(lod.error >= previous.error);
+	}
+
+	const MeshLod& last = mesh.lods.back();
+	CHECK(mesh.indices.size() == last.firstIndex + last.indexCount);
+	for (uint32_t index : mesh.indices)
+		CHECK(index < mesh.vertices.size());
+}
+
+TEST(meshSimplifier_honoursMaxLevels)
+{
+	MeshData mesh = makeIcosphere(3);
+	buildLodChain(mesh, { .maxLevels = 2 });
+	CHECK(mesh.lods.size() == 2);
+
+	mesh = makeIcosphere(3);
+	buildLodChain(mesh, { .maxLevels = 1 });
+	CHECK(mesh.lods.size() == 1);
+}
+
+TEST(meshSimplifier_stopsAtErrorBound)
+{
+	// Every collapse on a sphere moves the surface, so a zero error bound leaves only the full mesh
+	MeshData mesh = makeIcosphere(2);
+	size_t fullIndexCount = mesh.indices.size();
+	buildLodChain(mesh, { .maxRelativeError = 0.0f });
+	REQUIRE(mesh.lods.size() == 1);
+	CHECK(mesh.indices.size() == fullIndexCount);
+}
+
+TEST(meshSimplifier_selectsCoarsestLevelUnderPixelError)
+{
+	std::vector<MeshLod> lods = { { 0, 300, 0.0f }, { 300, 150, 0.01f }, { 450, 75, 0.1f } };
+	float pixelsPerUnit = 1000.0f;
+
+	// 0.01 projects to 1 pixel at distance 10 and 0.1 at distance 100
+	CHECK(selectLod(lods, 8.0f, 1.0f, pixelsPerUnit) == 0);
+	CHECK(selectLod(lods, 12.0f, 1.0f, pixelsPerUnit) == 1);
+	CHECK(selectLod(lods, 80.0f, 1.0f, pixelsPerUnit) == 1);
+	CHECK(selectLod(lods, 120.0f, 1.0f, pixelsPerUnit) == 2);
+	CHECK(selectLod(lods, 120.0f, 2.0f, pixelsPerUnit) == 1);
+	CHECK(selectLod({ lods[0] }, 1000.0f, 1.0f, pixelsPerUnit) == 0);
+}
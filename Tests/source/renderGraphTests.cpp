@@ -0,0 +1,254 @@
+// core/renderGraph.h: which batch each barrier lands in, what it waits for, pass culling, and which
+// transients share memory (those cases on a real device).
+
+#include <stdexcept>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "core/renderGraph.h"
+#include "headlessDevice.h"
+#include "testing.h"
+
+namespace
+{
+	const vk::ImageSubresourceRange COLOR_RANGE{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+	const RenderGraph::Usage UNDEFINED{ vk::PipelineStageFlagBits2::eNone, {}, vk::ImageLayout::eUndefined };
+
+	void noRecord(const vk::raii::CommandBuffer&)
+	{
+	}
+
+	vk::Image image(uint64_t id)
+	{
+		return reinterpret_cast<VkImage>(id);
+	}
+
+	vk::Buffer buffer(uint64_t id)
+	{
+		return reinterpret_cast<VkBuffer>(id);
+	}
+
+	const RenderGraph::ImageDesc TRANSIENT{ vk::Format::eR8G8B8A8Unorm, { 64, 64 }, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::ImageAspectFlagBits::eColor };
+
+	bool hasMemoryBarrier(const RenderGraph::Batch& batch)
+	{
+		return batch.memory.srcStageMask || batch.memory.dstStageMask;
+	}
+}
+
+TEST(renderGraph_placesLayoutTransitionsBeforeFirstUse)
+{
+	RenderGraph graph;
+	RenderGraph::Resource offscreen = graph.importImage("offscreen", image(1), COLOR_RANGE, UNDEFINED);
+	RenderGraph::Resource swapchain = graph.importImage("swapchain", image(2), COLOR_RANGE, UNDEFINED, RenderGraph::present());
+
+	uint32_t scene = graph.addPass("scene", noRecord);
+	graph.write(scene, offscreen, RenderGraph::colorAttachment());
+	uint32_t post = graph.addPass("post", noRecord);
+	graph.read(post, offscreen, RenderGraph::sampled(vk::PipelineStageFlagBits2::eFragmentShader));
+	graph.write(post, swapchain, RenderGraph::colorAttachment());
+	graph.compile();
+
+	// First uses of both images wait on nothing in the frame, so they share the first batch
+	const RenderGraph::Batch& before = graph.barriersBefore(scene);
+	CHECK(!hasMemoryBarrier(before));
+	REQUIRE(before.images.size() == 2);
+	for (const vk::ImageMemoryBarrier2& barrier : before.images)
+	{
+		CHECK(barrier.oldLayout == vk::ImageLayout::eUndefined);
+		CHECK(barrier.newLayout == vk::ImageLayout::eColorAttachmentOptimal);
+		CHECK(barrier.dstStageMask == vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+	}
+	CHECK(before.images[0].image == image(1));
+	CHECK(before.images[1].image == image(2));
+
+	// Sampling the scene output waits for its attachment writes
+	const RenderGraph::Batch& between = graph.barriersBefore(post);
+	CHECK(!hasMemoryBarrier(between));
+	REQUIRE(between.images.size() == 1);
+	const vk::ImageMemoryBarrier2& sample = between.images[0];
+	CHECK(sample.image == image(1));
+	CHECK(sample.oldLayout == vk::ImageLayout::eColorAttachmentOptimal);
+	CHECK(sample.newLayout == vk::ImageLayout::eShaderReadOnlyOptimal);
+	CHECK(sample.srcStageMask == vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+	CHECK(sample.srcAccessMask == vk::AccessFlagBits2::eColorAttachmentWrite);
+	CHECK(sample.dstStageMask == vk::PipelineStageFlagBits2::eFragmentShader);
+	CHECK(sample.dstAccessMask == vk::AccessFlagBits2::eShaderSampledRead);
+
+	// Only the exported image moves to its final usage after the last pass
+	const RenderGraph::Batch& after = graph.finalBarriers();
+	REQUIRE(after.images.size() == 1);
+	CHECK(after.images[0].image == image(2));
+	CHECK(after.images[0].oldLayout == vk::ImageLayout::eColorAttachmentOptimal);
+	CHECK(after.images[0].newLayout == vk::ImageLayout::ePresentSrcKHR);
+	CHECK(after.images[0].srcAccessMask == vk::AccessFlagBits2::eColorAttachmentWrite);
+
+	CHECK(graph.barrierCount() == 3);
+	CHECK(graph.culledPasses() == 0);
+}
+
+TEST(renderGraph_foldsBufferDependenciesIntoMemoryBarrier)
+{
+	RenderGraph graph;
+	RenderGraph::Resource draws = graph.importBuffer("draws", buffer(1), { vk::PipelineStageFlagBits2::eNone, {} });
+
+	uint32_t cull = graph.addPass("cull", noRecord);
+	graph.write(cull, draws, RenderGraph::storageWrite(vk::PipelineStageFlagBits2::eComputeShader));
+	uint32_t draw = graph.addPass("draw", noRecord);
+	graph.read(draw, draws, RenderGraph::indirectRead());
+	graph.keep(draw);
+	graph.compile();
+
+	CHECK(graph.barriersBefore(cull).empty());
+
+	const RenderGraph::Batch& before = graph.barriersBefore(draw);
+	CHECK(before.images.empty());
+	CHECK(before.memory.srcStageMask == vk::PipelineStageFlagBits2::eComputeShader);
+	CHECK(before.memory.srcAccessMask == vk::AccessFlagBits2::eShaderStorageWrite);
+	CHECK(before.memory.dstStageMask == vk::PipelineStageFlagBits2::eDrawIndirect);
+	CHECK(before.memory.dstAccessMask == vk::AccessFlagBits2::eIndirectCommandRead);
+	CHECK(graph.finalBarriers().empty());
+}
+
+TEST(renderGraph_ordersWriteAfterReadWithExecutionDependencyOnly)
+{
+	RenderGraph graph;
+	RenderGraph::Resource data = graph.importBuffer("data", buffer(1), { vk::PipelineStageFlagBits2::eNone, {} });
+
+	uint32_t reader = graph.addPass("reader", noRecord);
+	graph.read(reader, data, RenderGraph::storageRead(vk::PipelineStageFlagBits2::eComputeShader));
+	graph.keep(reader);
+	uint32_t writer = graph.addPass("writer", noRecord);
+	graph.write(writer, data, RenderGraph::storageWrite(vk::PipelineStageFlagBits2::eVertexShader));
+	graph.keep(writer);
+	graph.compile();
+
+	const RenderGraph::Batch& before = graph.barriersBefore(writer);
+	CHECK(before.memory.srcStageMask == vk::PipelineStageFlagBits2::eComputeShader);
+	CHECK(!before.memory.srcAccessMask);
+	CHECK(before.memory.dstStageMask == vk::PipelineStageFlagBits2::eVertexShader);
+}
+
+TEST(renderGraph_skipsBarriersBetweenReadsInOneLayout)
+{
+	RenderGraph graph;
+	RenderGraph::Usage sampled = RenderGraph::sampled(vk::PipelineStageFlagBits2::eFragmentShader);
+	RenderGraph::Resource texture = graph.importImage("texture", image(1), COLOR_RANGE, sampled);
+
+	uint32_t first = graph.addPass("first", noRecord);
+	graph.read(first, texture, sampled);
+	graph.keep(first);
+	uint32_t second = graph.addPass("second", noRecord);
+	graph.read(second, texture, sampled);
+	graph.keep(second);
+	graph.compile();
+
+	CHECK(graph.barriersBefore(first).empty());
+	CHECK(graph.barriersBefore(second).empty());
+	CHECK(graph.barrierCount() == 0);
+}
+
+TEST(renderGraph_cullsPassesWithUnusedResults)
+{
+	RenderGraph graph;
+	RenderGraph::Resource unused = graph.importImage("unused", image(1), COLOR_RANGE, UNDEFINED);
+	RenderGraph::Resource swapchain = graph.importImage("swapchain", image(2), COLOR_RANGE, UNDEFINED, RenderGraph::present());
+
+	uint32_t dead = graph.addPass("dead", noRecord);
+	graph.write(dead, unused, RenderGraph::colorAttachment());
+	uint32_t overwritten = graph.addPass("overwritten", noRecord);
+	graph.write(overwritten, swapchain, RenderGraph::storageWrite(vk::PipelineStageFlagBits2::eComputeShader));
+	uint32_t clear = graph.addPass("clear", noRecord);
+	graph.write(clear, swapchain, { vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, vk::ImageLayout::eTransferDstOptimal });
+	graph.compile();
+
+	CHECK(graph.culledPasses() == 2);
+	CHECK_THROWS(graph.barriersBefore(dead), std::runtime_error);
+	CHECK_THROWS(graph.barriersBefore(overwritten), std::runtime_error);
+
+	// Culled passes leave no barriers behind: the clear is the swapchain image's first use
+	const RenderGraph::Batch& before = graph.barriersBefore(clear);
+	REQUIRE(before.images.size() == 1);
+	CHECK(before.images[0].oldLayout == vk::ImageLayout::eUndefined);
+	CHECK(before.images[0].newLayout == vk::ImageLayout::eTransferDstOptimal);
+	CHECK(graph.finalBarriers().images.size() == 1);
+}
+
+TEST(renderGraph_rejectsInspectionBeforeCompile)
+{
+	RenderGraph graph;
+	uint32_t pass = graph.addPass("pass", noRecord);
+	graph.keep(pass);
+	CHECK_THROWS(graph.barriersBefore(pass), std::runtime_error);
+	CHECK_THROWS(graph.finalBarriers(), std::runtime_error);
+
+	graph.compile();
+	CHECK(graph.barriersBefore(pass).empty());
+}
+
+TEST(renderGraph_aliasesTransientsWithDisjointLifetimes)
+{
+	HeadlessDevice vulkan;
+	RenderGraph graph;
+	RenderGraph::Resource first = graph.transientImage("first", TRANSIENT);
+	RenderGraph::Resource second = graph.transientImage("second", TRANSIENT);
+
+	uint32_t a = graph.addPass("a", noRecord);
+	graph.write(a, first, RenderGraph::colorAttachment());
+	graph.keep(a);
+	uint32_t b = graph.addPass("b", noRecord);
+	graph.write(b, second, RenderGraph::colorAttachment());
+	graph.keep(b);
+
+	CHECK(graph.needsAllocation());
+	graph.allocate(vulkan.physicalDevice, vulkan.device);
+	CHECK(!graph.needsAllocation());
+	CHECK(graph.transientBlocks() == 1);
+	CHECK(graph.image(first));
+	CHECK(graph.image(second));
+	CHECK(!(graph.image(first) == graph.image(second)));
+
+	// The second image takes over the memory of the first, so its first use waits for the first's writes
+	graph.compile();
+	REQUIRE(graph.barriersBefore(a).images.size() == 1);
+	CHECK(graph.barriersBefore(a).images[0].image == graph.image(first));
+	const RenderGraph::Batch& handover = graph.barriersBefore(b);
+	REQUIRE(handover.images.size() == 1);
+	CHECK(handover.images[0].image == graph.image(second));
+	CHECK(handover.images[0].oldLayout == vk::ImageLayout::eUndefined);
+	CHECK(handover.images[0].srcStageMask == vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+	CHECK(handover.images[0].srcAccessMask == vk::AccessFlagBits2::eColorAttachmentWrite);
+}
+
+TEST(renderGraph_keepsOverlappingTransientsApart)
+{
+	HeadlessDevice vulkan;
+	RenderGraph graph;
+	RenderGraph::Resource first = graph.transientImage("first", TRANSIENT);
+	RenderGraph::Resource second = graph.transientImage("second", TRANSIENT);
+
+	uint32_t a = graph.addPass("a", noRecord);
+	graph.write(a, first, RenderGraph::colorAttachment());
+	uint32_t b = graph.addPass("b", noRecord);
+	graph.read(b, first, RenderGraph::sampled(vk::PipelineStageFlagBits2::eFragmentShader));
+	graph.write(b, second, RenderGraph::colorAttachment());
+	graph.keep(b);
+
+	graph.allocate(vulkan.physicalDevice, vulkan.device);
+	CHECK(graph.transientBlocks() == 2);
+
+	// The same declaration next frame reuses the allocation; a different extent needs a new one
+	graph.reset();
+	graph.transientImage("first", TRANSIENT);
+	graph.transientImage("second", TRANSIENT);
+	graph.keep(graph.addPass("c", noRecord));
+	CHECK(!graph.needsAllocation());
+
+	graph.reset();
+	RenderGraph::ImageDesc larger = TRANSIENT;
+	larger.extent = vk::Extent2D{ 128, 128 };
+	graph.transientImage("first", larger);
+	graph.transientImage("second", TRANSIENT);
+	graph.keep(graph.addPass("c", noRecord));
+	CHECK(graph.needsAllocation());
+}
@@ -0,0 +1,108 @@
+// core/stagingRing.h: placement, wraparound and blocking behaviour of the ring on a real device.
+// Fences are signalled by empty queue submissions, so no copies are recorded.
+
+#include <stdexcept>
+
+#include <vulkan/vulkan_raii.hpp>
+
+#include "core/stagingRing.h"
+#include "headlessDevice.h"
+#include "testing.h"
+
+TEST(stagingRing_placesAlignedAllocationsBackToBack)
+{
+	HeadlessDevice vulkan;
+	StagingRing ring;
+	ring.init(vulkan.physicalDevice, vulkan.device, 1024);
+	CHECK(ring.size() == 1024);
+	CHECK(ring.maxAllocation() == 512);
+
+	StagingRing::Allocation first = ring.allocate(10);
+	StagingRing::Allocation second = ring.allocate(10, 256);
+	StagingRing::Allocation third = ring.allocate(1, 1);
+	CHECK(first.offset == 0);
+	CHECK(second.offset == 256);
+	CHECK(third.offset == 266);
+	CHECK(second.data == first.data + 256);
+	CHECK(first.buffer == ring.buffer());
+	CHECK(second.size == 10);
+
+	vulkan.signal(ring.submitFence());
+	ring.waitIdle();
+	CHECK(ring.submittedBatches() == 1);
+	CHECK(ring.completedBatches() == 1);
+
+	// An idle ring starts over at the beginning
+	CHECK(ring.allocate(64).offset == 0);
+}
+
+TEST(stagingRing_wrapsAroundAfterRetiringOldestBatch)
+{
+	HeadlessDevice vulkan;
+	StagingRing ring;
+	ring.init(vulkan.physicalDevice, vulkan.device, 1024);
+
+	StagingRing::Allocation first = ring.allocate(400);
+	vulkan.signal(ring.submitFence());
+	StagingRing::Allocation second = ring.allocate(400);
+	vulkan.signal(ring.submitFence());
+	CHECK(first.offset == 0);
+	CHECK(second.offset == 400);
+
+	// [800, 1024) is too small and [0, 400) is still read by the first batch
+	CHECK(!ring.tryAllocate(400));
+	CHECK(ring.completedBatches() == 0);
+
+	// allocate() waits for the first batch only and wraps to the start
+	StagingRing::Allocation third = ring.allocate(400);
+	CHECK(third.offset == 0);
+	CHECK(third.data == first.data);
+	CHECK(ring.completedBatches() == 1);
+
+	// The open batch now ends where the second one starts
+	CHECK(!ring.tryAllocate(16));
+	StagingRing::Allocation fourth = ring.allocate(16);
+	CHECK(fourth.offset == 400);
+	CHECK(ring.completedBatches() == 2);
+
+	vulkan.signal(ring.submitFence());
+	ring.waitIdle();
+	CHECK(ring.completedBatches() == ring.submittedBatches());
+}
+
+TEST(stagingRing_reclaimsCompletedBatchesWithoutBlocking)
+{
+	HeadlessDevice vulkan;
+	StagingRing ring;
+	ring.init(vulkan.physicalDevice, vulkan.device, 1024);
+
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		ring.allocate(200);
+		vulkan.signal(ring.submitFence());
+	}
+	vulkan.queue.waitIdle();
+
+	ring.reclaim();
+	CHECK(ring.submittedBatches() == 3);
+	CHECK(ring.completedBatches() == 3);
+	CHECK(ring.tryAllocate(512).has_value());
+}
+
+TEST(stagingRing_rejectsAllocationsItCannotHold)
+{
+	HeadlessDevice vulkan;
+	StagingRing ring;
+	ring.init(vulkan.physicalDevice, vulkan.device, 1024);
+
+	CHECK_THROWS(ring.allocate(513), std::runtime_error);
+	CHECK_THROWS(ring.tryAllocate(513), std::runtime_error);
+
+	// Without a submitted batch there is nothing to wait for
+	ring.allocate(400);
+	ring.allocate(400);
+	CHECK_THROWS(ring.allocate(400), std::runtime_error);
+
+	vulkan.signal(ring.submitFence());
+	ring.waitIdle();
+}
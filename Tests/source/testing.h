@@ -0,0 +1,87 @@
+#pragma once
+
+// Minimal test harness for the Tests project, so it needs no third-party framework.
+//
+// TEST(name) registers a test case; main.cpp runs every registered case and returns non-zero when one
+// fails. CHECK() records a failure and carries on, REQUIRE() records it and leaves the case. A case
+// may also throw SkipTest when the machine lacks what it needs (a Vulkan device, for instance).
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace testing
+{
+	struct TestCase
+	{
+		const char* name;
+		std::function<void()> run;
+	};
+
+	struct SkipTest : std::runtime_error
+	{
+		using std::runtime_error::runtime_error;
+	};
+
+	struct RequireFailed {};
+
+	inline std::vector<TestCase>& registry()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+
+	inline uint32_t& failures()
+	{
+		static uint32_t count = 0;
+		return count;
+	}
+
+	struct Registrar
+	{
+		Registrar(const char* name, std::function<void()> run)
+		{
+			registry().push_back({ name, std::move(run) });
+		}
+	};
+
+	inline bool check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+			failures()++;
+		}
+		return condition;
+	}
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST(name)                                                                                      \
+	static void TEST_CONCAT(test_, name)();                                                             \
+	static testing::Registrar TEST_CONCAT(registrar_, name)(#name, TEST_CONCAT(test_, name));           \
+	static void TEST_CONCAT(test_, name)()
+
+#define CHECK(condition) testing::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#define REQUIRE(condition)                                                                              \
+	do                                                                                                  \
+	{                                                                                                   \
+		if (!CHECK(condition))                                                                          \
+			throw testing::RequireFailed{};                                                             \
+	} while (false)
+
+// Passes when expression throws an exception derived from type.
+#define CHECK_THROWS(expression, type)                                                                  \
+	do                                                                                                  \
+	{                                                                                                   \
+		bool thrown = false;                                                                            \
+		try { (void)(expression); }                                                                     \
+		catch (const type&) { thrown = true; }                                                          \
+		testing::check(thrown, #expression " throws " #type, __FILE__, __LINE__);                      \
+	} while (false)
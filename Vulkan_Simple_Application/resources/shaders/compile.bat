@@ -8,4 +8,8 @@ slangc.exe shader_textures.slang -target spirv -profile spirv_1_4 -emit-spirv-di
 
 slangc.exe shader_depth.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry fragMain -o slang_depth.spv
 
+slangc.exe shader_mesh.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry vertMainNormal -entry vertMainDepth -entry fragMain -o slang_mesh.spv
+
+slangc.exe shader_mesh_bindless.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry vertMainNormal -entry vertMainDepth -entry fragMain -o slang_mesh_bindless.spv
+
 PAUSE
\ No newline at end of file
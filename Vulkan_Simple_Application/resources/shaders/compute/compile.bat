@@ -1,3 +1,9 @@
 slangc.exe shader_compute.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry vertMain -entry fragMain -entry compMain -o slang_compute.spv
 
+slangc.exe shader_meshlet_cull.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry cullMain -o slang_meshlet_cull.spv
+
+slangc.exe shader_depth_pyramid.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry downsampleMain -o slang_depth_pyramid.spv
+
+slangc.exe shader_mipgen.slang -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name -entry downsampleMain -o slang_mipgen.spv
+
 PAUSE
\ No newline at end of file
@@ -1,3 +0,0 @@
-toktx.exe viking_room.ktx2 viking_room.png
-
-pause
\ No newline at end of file
@@ -4,14 +4,18 @@
 #include <cstdlib>
 #include <cstdint>
 #include <chrono>
+#include <cmath>
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
+#include <span>
 #include <limits>
 
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <unordered_map>
 
 #include <assert.h> // assert
@@ -73,20 +77,51 @@ typedef void AssetMangerType;
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/hash.hpp>
 
 #include <ktx.h>
+#include <stb_image.h>
+
+#include "core/cpuTracer.h"
+#include "core/gpuProfiler.h"
+#include "core/benchmark.h"
+#include "core/taskGraph.h"
+#include "core/meshData.h"
+#include "core/meshOptimizer.h"
+#include "core/meshSimplifier.h"
+#include "core/vertexLayout.h"
+#include "core/indexFormat.h"
+#include "core/meshlets.h"
+#include "core/meshletCuller.h"
+#include "core/workgroupTuner.h"
+#include "core/depthPyramid.h"
+#include "core/renderGraph.h"
+#include "core/ktxUpload.h"
+#include "core/assetPack.h"
+#include "core/uploadManager.h"
+#include "core/textureStreamer.h"
+#include "core/bindlessTable.h"
+#include "core/uniformArena.h"
+#include "core/commandCache.h"
+#include "core/pipelineVariants.h"
+#include "core/parallelRecorder.h"
+#include "core/contentHash.h"
 
 constexpr uint32_t WIDTH = 1290;
 constexpr uint32_t HEIGHT = 720;
 
 constexpr uint64_t FenceTimeout = 100000000;
 constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-constexpr int MAX_OBJECTS = 3;
+constexpr uint32_t DEFAULT_OBJECT_COUNT = 3; // --objects=N replaces the default scene with N objects
 
 const std::string TITLE = "TRIANGLE";
 const std::string MODEL_PATH = "resources/models/viking_room.obj";
-const std::string TEXTURE_PATH = "resources/textures/viking_room.png";
+const std::string TEXTURE_PATH = "resources/cooked/textures/viking_room.ktx2"; // written by Asset_Cooker, see cook.bat
+const std::string PNG_TEXTURE_PATH = "resources/textures/viking_room.png"; // --texture=png, for comparison
+const std::string ASSET_PACK_PATH = "resources/assets.pack"; // Asset_Cooker --pack; --assets=loose ignores it
+constexpr vk::DeviceSize TEXTURE_STAGING_SIZE = 4 * 1024 * 1024; // staging ring for streamed texture mips
+constexpr uint32_t MATERIAL_COUNT = 1; // the scene has one texture, so every object uses material 0
+constexpr uint32_t DRAWS_PER_RECORD_SLICE = 512; // passes with at least two slices of draws are recorded in parallel
+constexpr RenderState DEPTH_EQUAL_STATE{ .depthWrite = false, .depthCompare = vk::CompareOp::eEqual }; // main pass after a depth prepass
 
 #ifdef NDEBUG
 constexpr bool enableValidationLayers = false;
@@ -131,53 +166,14 @@ struct AndroidAppState
 };
 #endif // PLATFORM_ANDROID
 
-struct Vertex
-{
-	glm::vec3 pos;
-	glm::vec3 color;
-	glm::vec2 texCoord;
-
-	static vk::VertexInputBindingDescription getBindingDescription()
-	{
-		return { 0, sizeof(Vertex), vk::VertexInputRate::eVertex };
-	}
-
-	static std::array<vk::VertexInputAttributeDescription, 3> getAttributeDescriptions()
-	{
-		return {
-			vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, pos)),
-			vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)),
-			vk::VertexInputAttributeDescription(2, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, texCoord))
-		};
-	}
-
-	bool operator==(const Vertex& other) const
-	{
-		return pos == other.pos && color == other.color && texCoord == other.texCoord;
-	}
-};
-
-template<> struct std::hash<Vertex>
-{
-	size_t operator()(Vertex const& vertex) const 
-	{
-		return ((hash<glm::vec3>()(vertex.pos) ^
-			(hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^
-			(hash<glm::vec2>()(vertex.texCoord) << 1);
-	}
-};
-
 struct GameObject
 {
 	glm::vec3 position = { 0.0f, 0.0f, 0.0f };
 	glm::vec3 rotation = { 0.0f, 0.0f, 0.0f };
 	glm::vec3 scale = { 1.0f, 1.0f, 1.0f };
-
-	std::vector<vk::raii::Buffer> uniformBuffers;
-	std::vector<vk::raii::DeviceMemory> uniformBuffersMemory;
-	std::vector<void*> uniformBuffersMapped;
-
-	std::vector<vk::raii::DescriptorSet> descriptorSets;
+	uint32_t lod = 0;
+	uint32_t material = 0;
+	uint32_t uniformOffset = 0;              // this frame's ObjectUniform in the uniform arena
 
 	glm::mat4 getModelMatrix() const
 	{
@@ -191,13 +187,72 @@ struct GameObject
 	}
 };
 
-struct UniformBufferObject
+// Uniform arena values of the classic path, see shader_mesh.slang
+struct ObjectUniform
 {
 	alignas(16) glm::mat4 model;
+};
+
+struct FrameUniform
+{
 	alignas(16) glm::mat4 view;
 	alignas(16) glm::mat4 proj;
 };
 
+// Storage buffer elements and push constants of the bindless path, see shader_mesh_bindless.slang
+struct ObjectData
+{
+	alignas(16) glm::mat4 model;
+	uint32_t material = 0;
+	uint32_t padding[3] = {};
+};
+
+struct MaterialData
+{
+	uint32_t baseColorTexture = 0;
+	uint32_t padding[3] = {};
+};
+
+struct BindlessConstants
+{
+	PositionQuantization quantization;
+	glm::mat4 viewProj;
+	uint32_t objectBuffer = 0;
+	uint32_t materialBuffer = 0;
+	uint32_t padding[2] = {};
+};
+
+// The object and material buffers one frame in flight writes, registered in the bindless table
+struct BindlessFrame
+{
+	vk::raii::Buffer objects = nullptr;
+	vk::raii::DeviceMemory objectsMemory = nullptr;
+	void* objectsMapped = nullptr;
+	vk::raii::Buffer materials = nullptr;
+	vk::raii::DeviceMemory materialsMemory = nullptr;
+	void* materialsMapped = nullptr;
+	uint32_t objectSlot = 0;
+	uint32_t materialSlot = 0;
+};
+
+// Consecutive object slots drawn as instances of one LOD
+struct DrawBatch
+{
+	uint32_t lod = 0;
+	uint32_t firstInstance = 0;
+	uint32_t instanceCount = 0;
+};
+
+// What a cached command buffer recorded that a replay has to report again
+struct RecordedCommands
+{
+	uint32_t draws = 0;
+	uint32_t descriptorBinds = 0;
+	uint32_t barriers = 0;                   // pipelineBarrier2 calls
+	GpuProfiler::RecordedScopes scopes;
+	ParallelRecorder recorder;               // secondaries the buffer executes, recorded with it
+};
+
 //const std::vector<Vertex> vertices = {
 //	{ {-0.5f, -0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f }},
 //	{ {0.5f, -0.5f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f }},
@@ -224,19 +279,8 @@ public:
 #if PLATFORM_ANDROID
 	void cleanupAndroid()
 	{
-		for (auto& gameObject : gameObjects)
-		{
-			for (size_t i = 0; i < gameObject.uniformBuffersMemory.size(); i++)
-			{
-				if (gameObject.uniformBuffersMapped[i] != nullptr)
-					gameObject.uniformBuffersMemory[i].unmapMemory();
-			}
-
-			gameObject.uniformBuffers.clear();
-			gameObject.uniformBuffersMemory.clear();
-			gameObject.uniformBuffersMapped.clear();
-			gameObject.descriptorSets.clear();
-		}
+		frameDescriptorSets.clear();
+		uniformArena = UniformArena();
 	}
 
 	void run(android_app* app)
@@ -260,10 +304,16 @@ public:
 		if (androidAppState.initialized) device.waitIdle();
 	}
 #else
-	void run()
+	void run(const BenchmarkOptions& options = BenchmarkOptions())
 	{
+		benchmark = BenchmarkRun(options);
+		depthPrepass = options.depthPrepass;
+		commandCache.setEnabled(options.commandCache);
+		benchmark.beginStartup();
 		initWindow();
+		benchmark.startupPhase("window");
 		initVulkan();
+		benchmark.endStartup();
 		mainLoop();
 		cleanup();
 	}
@@ -281,6 +331,7 @@ private:
 
 		//glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+		glfwWindowHint(GLFW_VISIBLE, benchmark.options().headless ? GLFW_FALSE : GLFW_TRUE);
 
 		window = glfwCreateWindow(WIDTH, HEIGHT, TITLE.c_str(), nullptr, nullptr);
 		glfwSetWindowUserPointer(window, this);
@@ -289,45 +340,91 @@ private:
 				auto app = static_cast<Triangle*>(glfwGetWindowUserPointer(window));
 				app->framebufferResized = true;
 			});
+		glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int, int action, int)
+			{
+				if (key == GLFW_KEY_P && action == GLFW_PRESS)
+				{
+					auto app = static_cast<Triangle*>(glfwGetWindowUserPointer(window));
+					app->depthPrepass = !app->depthPrepass;
+					std::cout << "Depth prepass " << (app->depthPrepass ? "on" : "off") << std::endl;
+				}
+			});
 	}
 #endif // PLATFORM_DESKTOP
 
 
 	void initVulkan()
 	{
+		uint32_t recordThreads = benchmark.options().recordThreads;
+		recordPool = std::make_unique<ThreadPool>(recordThreads == 0 ? ThreadPool::defaultThreadCount() : recordThreads);
+
+		openAssetPack();
+		benchmark.startupPhase("asset_pack");
 		createInstance();
 		setupDebugMessenger();
+		benchmark.startupPhase("instance");
 		createSurface();
+		benchmark.startupPhase("surface");
 		pickPhysicalDevice();
 		msaaSamples = getMaxUsableSampleCount();
 		checkFeatureSupport();
 		createLogicalDevice();
+		benchmark.startupPhase("device");
+		// Queries the framebuffer size, which GLFW only allows on the main thread
 		createSwapChain();
 		createImageViews();
+		benchmark.startupPhase("swapchain");
 
-		if (!appInfo.profileSupported)
-			createRenderPass();
+		// The rest runs on a task graph. Texture uploads and vertex/index uploads both submit
+		// through the same queue and command pool, so they are chained.
+		TaskGraph startup;
+		auto renderPassTask = startup.add("render_pass", [this]()
+			{
+				if (!appInfo.profileSupported)
+					createRenderPass();
+			});
+		auto layoutTask = startup.add("descriptor_layout", [this]() { createDescriptorSetLayout(); });
+		startup.add("pipeline", [this]() { createGraphicsPipeline(); }, { renderPassTask, layoutTask });
+		auto commandPoolTask = startup.add("command_pool", [this]() { createCommandPool(); });
+		auto depthTask = startup.add("depth", [this]() { createDepthResources(); });
+		startup.add("framebuffers", [this]()
+			{
+				if (!appInfo.profileSupported)
+					createFramebuffers();
+			}, { renderPassTask, depthTask });
+		auto decodeTask = startup.add("texture_decode", [this]() { loadTextureFile(); });
+		auto modelTask = startup.add("model", [this]() { loadModel(); });
+		auto textureTask = startup.add("texture_upload", [this]()
+			{
+				createTextureImage();
+				createTextureImageView();
+				createTextureSampler();
+			}, { commandPoolTask, decodeTask });
+		auto geometryTask = startup.add("geometry_upload", [this]() { createVertexBuffer(); createIndexBuffer(); }, { commandPoolTask, modelTask, textureTask });
+		auto uniformTask = startup.add("uniform_buffers", [this]() { setupGameObjects(); createUniformBuffers(); });
+		startup.add("descriptors", [this]() { createDescriptorPool(); createDescriptorSets(); }, { layoutTask, textureTask, uniformTask });
+		// Initializes the pyramid through the upload pool and queue, so it follows the geometry upload
+		auto cullingTask = startup.add("meshlet_culling", [this]()
+			{
+				if (meshletCullingSupported)
+				{
+					WorkgroupTuner tuner(physicalDevice);
+					meshletCuller.init(physicalDevice, device, readFile("resources/shaders/compute/slang_meshlet_cull.spv"), meshlets, static_cast<uint32_t>(gameObjects.size()), MAX_FRAMES_IN_FLIGHT,
+						tuner.cachedOr(meshletCullKey(), MeshletCuller::WORKGROUP_SIZE));
+					depthPyramid.init(physicalDevice, device, readFile("resources/shaders/compute/slang_depth_pyramid.spv"));
+					createDepthPyramid();
+				}
+			}, { modelTask, uniformTask, depthTask, geometryTask });
+		// Allocates from the upload pool too, so it waits for the last submission through it
+		startup.add("command_buffers", [this]() { createCommandBuffers(); createSyncObjects(); }, { commandPoolTask, cullingTask });
 
-		createDescriptorSetLayout();
-		createGraphicsPipeline();
+		ThreadPool startupPool;
+		startup.run(startupPool);
 
-		if (!appInfo.profileSupported)
-			createFramebuffers();
+		for (const auto& task : startup.taskTimings())
+			benchmark.startupPhase(task.name, task.begin, task.end);
 
-		createCommandPool();
-		createDepthResources();
-		createTextureImage();
-		createTextureImageView();
-		createTextureSampler();
-		loadModel();
-		createVertexBuffer();
-		createIndexBuffer();
-		setupGameObjects();
-		createUniformBuffers();
-		createDescriptorPool();
-		createDescriptorSets();
-		createCommandBuffers();
-		createSyncObjects();
+		tuneMeshletCulling();
 	}
 
 	void createInstance()
@@ -544,12 +641,49 @@ private:
 		if ((graphicsIndex == queueFamilyProperties.size()) || (presentIndex == queueFamilyProperties.size()))
 			throw std::runtime_error("Could not find a queue for graphics or present -> terminating");
 
+		bool pipelineStatisticsSupported = physicalDevice.getFeatures().pipelineStatisticsQuery;
+		// Lets the pass scopes keep their statistics queries active around secondary command buffers
+		inheritedStatistics = pipelineStatisticsSupported && physicalDevice.getFeatures().inheritedQueries;
+
+		// 8-bit indices are optional, small meshes fall back to 16-bit indices
+		uint8IndicesEnabled = indexTypeUint8Supported(physicalDevice);
+		if (uint8IndicesEnabled)
+			requiredDeviceExtension.push_back(vk::EXTIndexTypeUint8ExtensionName);
+
+		// GPU meshlet culling draws through drawIndexedIndirectCount, otherwise every object is drawn whole
+		meshletCullingSupported = MeshletCuller::supported(physicalDevice);
+
+		// One descriptor-indexed set per frame instead of a set per object and frame, see core/bindlessTable.h
+		bindlessEnabled = benchmark.options().descriptors == "bindless" && BindlessTable::supported(physicalDevice);
+		benchmark.setDescriptors(bindlessEnabled ? "bindless" : "classic");
+
+		// Cull mode, depth test and the like are set while recording instead of baked, see core/pipelineVariants.h
+		if (benchmark.options().dynamicState)
+			dynamicStateSupport = PipelineVariants::supported(physicalDevice);
+		if (dynamicStateSupport.polygonMode)
+			requiredDeviceExtension.push_back(vk::EXTExtendedDynamicState3ExtensionName);
+
+		// Decides what KTX2 Basis textures are transcoded to
+		textureCompression = ktx_upload::compressionSupport(physicalDevice);
+
 		// һܽṹ
-		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> featureChain = {
-			{ .features = {.samplerAnisotropy = true }}, // vk::PhysicalDeviceFeatures2 (empty for now)
-			{ .synchronization2 = true, .dynamicRendering = true }, //  Vulkan 1.3 ö̬Ⱦ
-			{ .extendedDynamicState = true} // չչ̬״̬
+		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceIndexTypeUint8FeaturesEXT,
+			vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT> featureChain = {
+			{ .features = {.multiDrawIndirect = meshletCullingSupported, .samplerAnisotropy = true, .textureCompressionETC2 = textureCompression.etc2,
+				.textureCompressionASTC_LDR = textureCompression.astc, .textureCompressionBC = textureCompression.bc7, .pipelineStatisticsQuery = pipelineStatisticsSupported,
+				.inheritedQueries = inheritedStatistics }}, // vk::PhysicalDeviceFeatures2
+			{ .synchronization2 = true, .dynamicRendering = true, .maintenance4 = true }, //  Vulkan 1.3 ö̬Ⱦ
+			{ .extendedDynamicState = true}, // չչ̬״̬
+			{ .drawIndirectCount = meshletCullingSupported, .hostQueryReset = true }, // vk::PhysicalDeviceVulkan12Features, the GPU profiler resets its queries from the host
+			{ .indexTypeUint8 = true }, // vk::PhysicalDeviceIndexTypeUint8FeaturesEXT
+			{ .extendedDynamicState3PolygonMode = true } // vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT
 		};
+		if (!uint8IndicesEnabled)
+			featureChain.unlink<vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>();
+		if (!dynamicStateSupport.polygonMode)
+			featureChain.unlink<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>();
+		if (bindlessEnabled)
+			BindlessTable::enableFeatures(featureChain.get<vk::PhysicalDeviceFeatures2>().features, featureChain.get<vk::PhysicalDeviceVulkan12Features>());
 
 		float queuePriority = 0.0f;
 
@@ -570,6 +704,12 @@ private:
 		device = vk::raii::Device(physicalDevice, deviceCreateInfo);
 		graphicsQueue = vk::raii::Queue(device, graphicsIndex, 0);
 		presentQueue = vk::raii::Queue(device, presentIndex, 0);
+
+		gpuProfiler.init(physicalDevice, device, graphicsIndex, MAX_FRAMES_IN_FLIGHT, pipelineStatisticsSupported);
+		gpuProfiler.calibrate(device, graphicsQueue);
+
+		auto deviceProperties = physicalDevice.getProperties();
+		benchmark.setDevice(deviceProperties.deviceName, deviceProperties.driverVersion);
 	}
 
 	void createSwapChain()
@@ -715,7 +855,7 @@ private:
 		{
 			std::array attachments = {
 				*colorImageView,
-				*depthImageView,
+				depthImageView,
 				*swapChainImageViews[i]
 			};
 
@@ -735,9 +875,17 @@ private:
 
 	void createDescriptorSetLayout()
 	{
+		if (bindlessEnabled)
+		{
+			bindless.init(physicalDevice, device, MAX_FRAMES_IN_FLIGHT, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment);
+			return;
+		}
+
+		// Both uniform bindings point into the uniform arena and are placed with dynamic offsets
 		std::array bindings = {
-			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex, nullptr),
+			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex, nullptr),
 			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment, nullptr),
+			vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex, nullptr),
 		};
 
 		vk::DescriptorSetLayoutCreateInfo layoutInfo
@@ -751,12 +899,12 @@ private:
 
 	void createGraphicsPipeline()
 	{
-		vk::raii::ShaderModule shaderModule = createShaderModule(readFile("resources/shaders/slang_depth.spv"));
+		vk::raii::ShaderModule shaderModule = createShaderModule(readFile(bindlessEnabled ? "resources/shaders/slang_mesh_bindless.spv" : "resources/shaders/slang_mesh.spv"));
 
 		vk::PipelineShaderStageCreateInfo vertShaderStageInfo{
 			.stage = vk::ShaderStageFlagBits::eVertex,
 			.module = shaderModule,
-			.pName = "vertMain"
+			.pName = vertexLayout.vertexEntryPoint()
 		};
 
 		vk::PipelineShaderStageCreateInfo fragShaderStageInfo{
@@ -768,12 +916,12 @@ private:
 		vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 		
 		// 
-		auto bindindDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+		auto bindingDescriptions = vertexLayout.bindingDescriptions();
+		auto attributeDescriptions = vertexLayout.attributeDescriptions();
 		vk::PipelineVertexInputStateCreateInfo vertexInputInfo
 		{
-			.vertexBindingDescriptionCount = 1,
-			.pVertexBindingDescriptions = &bindindDescription,
+			.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size()),
+			.pVertexBindingDescriptions = bindingDescriptions.data(),
 			.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
 			.pVertexAttributeDescriptions = attributeDescriptions.data()
 		};
@@ -850,11 +998,27 @@ private:
 			.pDynamicStates = dynamicStates.data()
 		};
 
+		// Dequantization constants for the compact vertex positions; the bindless path adds the camera and
+		// the slots of the frame's object and material buffers
+		vk::PushConstantRange pushConstantRange
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PositionQuantization)
+		};
+		if (bindlessEnabled)
+		{
+			pushConstantRange.stageFlags |= vk::ShaderStageFlagBits::eFragment;
+			pushConstantRange.size = sizeof(BindlessConstants);
+		}
+
+		vk::DescriptorSetLayout setLayout = bindlessEnabled ? *bindless.layout() : *descriptorSetLayout;
 		vk::PipelineLayoutCreateInfo pipelineLayoutInfo
 		{
 			.setLayoutCount = 1,
-			.pSetLayouts = &*descriptorSetLayout,
-			.pushConstantRangeCount = 0
+			.pSetLayouts = &setLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
 		};
 
 		pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
@@ -874,17 +1038,18 @@ private:
 			.layout = pipelineLayout,
 		};
 
-		if (appInfo.profileSupported)
+		vk::Format colorFormat = swapChainImageFormat;
+		vk::PipelineRenderingCreateInfo renderingInfo
 		{
-			vk::Format colorFormat = swapChainImageFormat;
-			vk::Format depthFormat = findDepthFormat();
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &colorFormat,
+			.depthAttachmentFormat = findDepthFormat()
+		};
 
-			vk::PipelineRenderingCreateInfo renderingInfo
-			{
-				.colorAttachmentCount = 1,
-				.pColorAttachmentFormats = &colorFormat,
-				.depthAttachmentFormat = depthFormat
-			};
+		if (appInfo.profileSupported)
+		{
+			// Dynamic rendering draws straight into the single-sampled swapchain and depth images
+			multisampling.rasterizationSamples = vk::SampleCountFlagBits::e1;
 
 			pipelineInfo.pNext = &renderingInfo;
 			pipelineInfo.renderPass = nullptr;
@@ -900,7 +1065,55 @@ private:
 			std::cout << "Create pipeline with traditional render pass (fallback)" << std::endl;
 		}
 
-		graphicsPipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+		// After a depth prepass the main pass only shades the visible surface; with extended dynamic state
+		// both states share one pipeline. The depth prepass is recorded with dynamic rendering only
+		std::vector<RenderState> mainStates = { RenderState{} };
+		if (appInfo.profileSupported)
+			mainStates.push_back(DEPTH_EQUAL_STATE);
+		graphicsPipelines.init(dynamicStateSupport);
+		graphicsPipelines.create(device, pipelineInfo, mainStates);
+
+		depthPrepassPipelines.init(dynamicStateSupport);
+		if (appInfo.profileSupported)
+			createDepthPrepassPipeline(shaderModule, pipelineInfo, renderingInfo);
+
+		benchmark.setPipelines(PipelineVariants::name(dynamicStateSupport), graphicsPipelines.pipelineCount() + depthPrepassPipelines.pipelineCount(),
+			graphicsPipelines.createMs() + depthPrepassPipelines.createMs());
+	}
+
+	// The depth-only variant of the main pipeline description, see createGraphicsPipeline()
+	void createDepthPrepassPipeline(const vk::raii::ShaderModule& shaderModule, vk::GraphicsPipelineCreateInfo pipelineInfo, vk::PipelineRenderingCreateInfo renderingInfo)
+	{
+		// The prepass binds positions only and has no fragment shader or colour attachment;
+		// vertMainDepth transforms positions exactly like the main vertex shaders
+		vk::PipelineShaderStageCreateInfo depthShaderStage
+		{
+			.stage = vk::ShaderStageFlagBits::eVertex,
+			.module = shaderModule,
+			.pName = VertexLayout::depthEntryPoint()
+		};
+		auto positionBinding = vertexLayout.positionBindingDescription();
+		auto positionAttribute = vertexLayout.positionAttributeDescription();
+		vk::PipelineVertexInputStateCreateInfo depthVertexInputInfo
+		{
+			.vertexBindingDescriptionCount = 1,
+			.pVertexBindingDescriptions = &positionBinding,
+			.vertexAttributeDescriptionCount = 1,
+			.pVertexAttributeDescriptions = &positionAttribute
+		};
+		vk::PipelineColorBlendStateCreateInfo depthColorBlending
+		{
+			.logicOpEnable = vk::False,
+			.attachmentCount = 0
+		};
+		renderingInfo.colorAttachmentCount = 0;
+
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.stageCount = 1;
+		pipelineInfo.pStages = &depthShaderStage;
+		pipelineInfo.pVertexInputState = &depthVertexInputInfo;
+		pipelineInfo.pColorBlendState = &depthColorBlending;
+		depthPrepassPipelines.create(device, pipelineInfo, { RenderState{} });
 	}
 
 	void createCommandPool()
@@ -917,65 +1130,304 @@ private:
 	void createDepthResources()
 	{
 		vk::Format depthFormat = findDepthFormat();
+		vk::ImageAspectFlags depthAspect = vk::ImageAspectFlagBits::eDepth;
+		if (depthFormat == vk::Format::eD32SfloatS8Uint || depthFormat == vk::Format::eD24UnormS8Uint)
+			depthAspect |= vk::ImageAspectFlagBits::eStencil;
 
-		createImage(swapChainExtent.width, swapChainExtent.height, depthFormat, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, depthImage, depthImageMemory);
-		
-		depthImageView = createImageView(depthImage, depthFormat, vk::ImageAspectFlagBits::eDepth, 1);
+		// Sampled by the depth pyramid build
+		depthDesc =
+		{
+			.format = depthFormat,
+			.extent = swapChainExtent,
+			.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
+			.aspect = depthAspect
+		};
+
+		// The depth buffer is a transient of the frame graph. Its memory comes from a graph holding it alone;
+		// every recording declares it again with the same description, which keeps that allocation
+		frameGraph.reset();
+		RenderGraph::Resource depth = frameGraph.transientImage("depth", depthDesc);
+		frameGraph.allocate(physicalDevice, device);
+		depthImageView = frameGraph.view(depth);
 	}
 
-	void createTextureImage()
+	// Hi-Z pyramid for the late culling phase; follows the depth buffer size.
+	void createDepthPyramid()
 	{
-		ktxTexture* kTexture;
-		KTX_error_code result = ktxTexture_CreateFromNamedFile(
-			TEXTURE_PATH.c_str(),
-			KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
-			&kTexture
-		);
+		depthPyramid.resize(device, depthImageView, swapChainExtent);
+		meshletCuller.setDepthPyramid(*device, *depthPyramid.view(), depthPyramid.width(), depthPyramid.height(), depthPyramid.mips());
+
+		// Every frame finds the pyramid in the general layout, including frames replayed from the command cache
+		std::unique_ptr<vk::raii::CommandBuffer> commandBuffer = beginSingleTimeCommands();
+		depthPyramid.initializeLayout(*commandBuffer);
+		endSingleTimeCommands(*commandBuffer);
+	}
+
+	[[nodiscard]] std::string meshletCullKey() const
+	{
+		return "meshlet_cull_" + std::to_string(meshlets.size());
+	}
+
+	// Times the culling dispatch at every workgroup size (see core/workgroupTuner.h), on the view of
+	// updateUniformBuffer() with every object at LOD 0. Runs once the startup queue work is done.
+	void tuneMeshletCulling()
+	{
+		if (!meshletCuller.enabled() || !WorkgroupTuner::autotuneRequested())
+			return;
+
+		std::vector<MeshletCuller::Instance> instances;
+		for (const auto& gameObject : gameObjects)
+			instances.push_back({ gameObject.getModelMatrix(), lodMeshlets[0] });
+		glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 6.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 proj = glm::perspective(glm::radians(45.0f), static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height), 0.1f, 50.0f);
+		meshletCuller.update(0, instances, view, proj);
+
+		WorkgroupTuner tuner(physicalDevice);
+		uint32_t workgroupSize = tuner.tune(meshletCullKey(), device, graphicsQueue, graphicsIndex,
+			physicalDevice.getQueueFamilyProperties()[graphicsIndex].timestampValidBits,
+			[this](uint32_t size)
+			{
+				return meshletCuller.buildPipeline(device, size);
+			},
+			[this](const vk::raii::CommandBuffer& commandBuffer, const vk::raii::Pipeline& pipeline, uint32_t size)
+			{
+				meshletCuller.recordTuning(commandBuffer, pipeline, size, 0);
+			},
+			MeshletCuller::WORKGROUP_SIZE);
+		meshletCuller.setWorkgroupSize(device, workgroupSize);
+		benchmark.startupPhase("autotune");
+	}
+
+	// CPU-only half of the texture setup, safe to run next to other startup work: reads the file and
+	// transcodes Basis payloads to the GPU format picked in createLogicalDevice.
+	void loadTextureFile()
+	{
+		if (benchmark.options().texture == "png")
+		{
+			int channels = 0;
+			if (const AssetPackEntry* entry = assets.find(PNG_TEXTURE_PATH))
+			{
+				std::vector<uint8_t> scratch;
+				std::span<const uint8_t> encoded = assets.contents(*entry, scratch);
+				loadedPixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &loadedPixelsWidth, &loadedPixelsHeight, &channels, STBI_rgb_alpha);
+			}
+			else
+			{
+				loadedPixels = stbi_load(PNG_TEXTURE_PATH.c_str(), &loadedPixelsWidth, &loadedPixelsHeight, &channels, STBI_rgb_alpha);
+			}
+
+			if (!loadedPixels)
+				throw std::runtime_error("failed to load texture image!");
+			return;
+		}
+
+		// From the pack libktx parses the file in place; only the image data it keeps is copied out
+		KTX_error_code result;
+		if (const AssetPackEntry* entry = assets.find(TEXTURE_PATH))
+		{
+			std::vector<uint8_t> scratch;
+			std::span<const uint8_t> file = assets.contents(*entry, scratch);
+			result = ktxTexture2_CreateFromMemory(file.data(), file.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &loadedTexture);
+		}
+		else
+		{
+			result = ktxTexture2_CreateFromNamedFile(TEXTURE_PATH.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &loadedTexture);
+		}
 
 		if (result != KTX_SUCCESS)
 			throw std::runtime_error("failed to load ktx texture image!");
 
-		uint32_t texWidth = kTexture->baseWidth;
-		uint32_t texHeight = kTexture->baseHeight;
-		ktx_size_t imageSize = ktxTexture_GetImageSize(kTexture, 0);
-		ktx_uint8_t* ktxTextureData = ktxTexture_GetData(kTexture);
+		transcodedFormatName = ktx_upload::transcode(loadedTexture, textureCompression);
+	}
+
+	void createTextureImage()
+	{
+		if (loadedPixels)
+			createPngTextureImage();
+		else
+			createKtxTextureImage();
+
+		vk::DeviceSize textureBytes = textureStreaming ? textureStreamer.statistics().residentBytes : textureImage.getMemoryRequirements().size;
+		benchmark.setResourceBytes("texture", textureBytes);
+		std::cout << "Texture: " << vk::to_string(textureImageFormat) << ", " << mipLevels << " levels, "
+			<< static_cast<double>(textureBytes) / (1024.0 * 1024.0) << " MiB" << (textureStreaming ? " resident (streaming)" : "") << std::endl;
+	}
+
+	// Every level, layer and face of the KTX2 file in one staging buffer and one multi-region copy.
+	void createKtxTextureImage()
+	{
+		ktxTexture2* kTexture = loadedTexture;
+		loadedTexture = nullptr;
+
+		textureImageFormat = static_cast<vk::Format>(kTexture->vkFormat);
+		if (textureImageFormat == vk::Format::eUndefined)
+			throw std::runtime_error("ktx2 texture has no Vulkan format!");
+		if (!(physicalDevice.getFormatProperties(textureImageFormat).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+			throw std::runtime_error("ktx2 texture format " + vk::to_string(textureImageFormat) + " cannot be sampled on this device!");
+		if (transcodedFormatName)
+			std::cout << "Transcoded KTX2 texture to " << transcodedFormatName << std::endl;
+
+		if (ktx_upload::layerCount(kTexture) == 1)
+		{
+			createStreamedTextureImage(kTexture);
+			return;
+		}
+
+		auto* base = reinterpret_cast<ktxTexture*>(kTexture);
+		ktx_size_t dataSize = ktxTexture_GetDataSize(base);
 
 		vk::raii::Buffer stagingBuffer({});
 		vk::raii::DeviceMemory stagingBufferMemory({});
-		createBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
+		createBuffer(dataSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
 
-		void* data = stagingBufferMemory.mapMemory(0, imageSize);
-		memcpy(data, ktxTextureData, imageSize);
+		void* data = stagingBufferMemory.mapMemory(0, dataSize);
+		memcpy(data, ktxTexture_GetData(base), dataSize);
 		stagingBufferMemory.unmapMemory();
 
-		vk::Format textureFormat;
+		mipLevels = kTexture->numLevels;
+		uint32_t layers = ktx_upload::layerCount(kTexture);
+		vk::ImageCreateFlags flags = kTexture->numFaces == 6 ? vk::ImageCreateFlagBits::eCubeCompatible : vk::ImageCreateFlags{};
+		createImage(kTexture->baseWidth, kTexture->baseHeight, mipLevels, textureImageFormat, vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			vk::MemoryPropertyFlagBits::eDeviceLocal, textureImage, textureImageMemory, layers, flags);
+
+		uploadTexture(stagingBuffer, ktx_upload::copyRegions(kTexture), layers, vk::ImageLayout::eShaderReadOnlyOptimal);
+
+		ktxTexture_Destroy(base);
+	}
+
+	/**
+	* Plain 2D textures are streamed: the transcoded levels stay in system memory, the mip tail is resident
+	* for the first frame and finer levels follow in drawFrame as the objects get close enough to need them,
+	* within --texture-budget.
+	*/
+	void createStreamedTextureImage(ktxTexture2* kTexture)
+	{
+		auto* base = reinterpret_cast<ktxTexture*>(kTexture);
+		const auto* data = ktxTexture_GetData(base);
+
+		TextureStreamer::Source source
+		{
+			.format = textureImageFormat,
+			.width = kTexture->baseWidth,
+			.height = kTexture->baseHeight,
+			.rowHeight = vk::blockExtent(textureImageFormat)[1],
+			.data = std::vector<uint8_t>(data, data + ktxTexture_GetDataSize(base))
+		};
 
-		if (kTexture->classId == ktxTexture2_c)
+		for (uint32_t level = 0; level < kTexture->numLevels; level++)
 		{
-			auto* ktx2 = reinterpret_cast<ktxTexture2*>(kTexture);
-			textureFormat = static_cast<vk::Format>(ktx2->vkFormat);
-			if (textureFormat == vk::Format::eUndefined)
-				textureFormat == vk::Format::eR8G8B8A8Unorm;
+			ktx_size_t offset = 0;
+			if (ktxTexture_GetImageOffset(base, level, 0, 0, &offset) != KTX_SUCCESS)
+				throw std::runtime_error("failed to locate ktx2 texture level!");
+			source.levels.push_back({ offset, ktxTexture_GetImageSize(base, level) });
 		}
-		else
-			textureFormat == vk::Format::eR8G8B8A8Unorm;
 
-		textureImageFormat = textureFormat;
+		mipLevels = kTexture->numLevels;
+		ktxTexture_Destroy(base);
 
-		createImage(texWidth, texHeight, textureFormat, vk::ImageTiling::eOptimal,
-			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+		uploads.init(physicalDevice, device, graphicsQueue, graphicsIndex, TEXTURE_STAGING_SIZE, benchmark.options().io != "threads");
+		benchmark.setIoBackend(uploads.ioBackendName());
+		textureStreamer.init(physicalDevice, device, uploads, static_cast<vk::DeviceSize>(benchmark.options().textureBudgetMiB) * 1024 * 1024, MAX_FRAMES_IN_FLIGHT);
+		streamedTexture = textureStreamer.add(std::move(source));
+		textureStreaming = true;
+
+		// The first frame samples the mip tail
+		uploads.flush();
+		textureStreamer.update();
+	}
+
+	// RGBA8 level 0 from the PNG, the rest of the chain blitted on the GPU.
+	void createPngTextureImage()
+	{
+		stbi_uc* pixels = loadedPixels;
+		loadedPixels = nullptr;
+
+		uint32_t texWidth = static_cast<uint32_t>(loadedPixelsWidth);
+		uint32_t texHeight = static_cast<uint32_t>(loadedPixelsHeight);
+		vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(texWidth) * texHeight * 4;
+
+		vk::raii::Buffer stagingBuffer({});
+		vk::raii::DeviceMemory stagingBufferMemory({});
+		createBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
+
+		void* data = stagingBufferMemory.mapMemory(0, imageSize);
+		memcpy(data, pixels, imageSize);
+		stagingBufferMemory.unmapMemory();
+		stbi_image_free(pixels);
+
+		textureImageFormat = vk::Format::eR8G8B8A8Srgb;
+		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
+		createImage(texWidth, texHeight, mipLevels, textureImageFormat, vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
 			vk::MemoryPropertyFlagBits::eDeviceLocal, textureImage, textureImageMemory);
 
-		transitionImageLayout(textureImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-		copyBufferToImage(stagingBuffer, textureImage, texWidth, texHeight);
-		transitionImageLayout(textureImage, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal);
+		vk::BufferImageCopy region
+		{
+			.bufferOffset = 0,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+			.imageOffset = { 0, 0, 0 },
+			.imageExtent = { texWidth, texHeight, 1 }
+		};
+		uploadTexture(stagingBuffer, { region }, 1, vk::ImageLayout::eTransferDstOptimal);
+		generateMipmaps(textureImage, textureImageFormat, static_cast<int32_t>(texWidth), static_cast<int32_t>(texHeight), mipLevels);
+	}
+
+	/**
+	* Moves every level and layer of textureImage to eTransferDstOptimal, copies all regions in one command
+	* and, for eShaderReadOnlyOptimal, makes the result visible to fragment shaders, all in one submission.
+	*/
+	void uploadTexture(const vk::raii::Buffer& stagingBuffer, const std::vector<vk::BufferImageCopy>& regions, uint32_t layers, vk::ImageLayout finalLayout)
+	{
+		std::unique_ptr<vk::raii::CommandBuffer> commandBuffer = beginSingleTimeCommands();
+		gpuProfiler.beginOneShot(*commandBuffer);
+
+		vk::ImageMemoryBarrier2 barrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
+			.srcAccessMask = {},
+			.dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eTransferDstOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = *textureImage,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, layers }
+		};
+		commandBuffer->pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &barrier });
 
-		ktxTexture_Destroy(kTexture);
+		commandBuffer->copyBufferToImage(*stagingBuffer, *textureImage, vk::ImageLayout::eTransferDstOptimal, regions);
+
+		if (finalLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
+		{
+			barrier.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+			barrier.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+			barrier.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader;
+			barrier.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead;
+			barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+			barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+			commandBuffer->pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &barrier });
+		}
+
+		gpuProfiler.endOneShot(*commandBuffer);
+		endSingleTimeCommands(*commandBuffer);
+		benchmark.setOneShotGpuMs("texture_upload", gpuProfiler.oneShotMs());
 	}
 
+	// The shader samples a 2D texture: for arrays and cube maps only the first layer is visible.
+	// Streamed textures get their views from the TextureStreamer instead, see textureView().
 	void createTextureImageView()
 	{
-		textureImageView = createImageView(textureImage, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor, mipLevels);
+		if (!textureStreaming)
+			textureImageView = createImageView(textureImage, textureImageFormat, vk::ImageAspectFlagBits::eColor, mipLevels);
+	}
+
+	[[nodiscard]] vk::ImageView textureView() const
+	{
+		return textureStreaming ? textureStreamer.view(streamedTexture) : *textureImageView;
 	}
 
 	void createTextureSampler()
@@ -993,7 +1445,9 @@ private:
 			.anisotropyEnable = vk::True,
 			.maxAnisotropy = properties.limits.maxSamplerAnisotropy,
 			.compareEnable = vk::False,
-			.compareOp = vk::CompareOp::eAlways
+			.compareOp = vk::CompareOp::eAlways,
+			.minLod = 0.0f,
+			.maxLod = vk::LodClampNone
 		};
 
 		textureSampler = vk::raii::Sampler(device, samplerInfo);
@@ -1016,12 +1470,12 @@ private:
 		if (!ret)
 			throw std::runtime_error("failed to load glTF model");
 
-		vertices.clear();
-		indices.clear();
+		mesh.vertices.clear();
+		mesh.indices.clear();
 
-		for (const auto& mesh : model.meshes) 
+		for (const auto& gltfMesh : model.meshes) 
 		{
-			for (const auto& primitive : mesh.primitives) 
+			for (const auto& primitive : gltfMesh.primitives) 
 			{
 				const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
 				const tinygltf::BufferView& indexBufferView = model.bufferViews[indexAccessor.bufferView];
@@ -1043,11 +1497,23 @@ private:
 					texCoordBuffer = &model.buffers[texCoordBufferView->buffer];
 				}
 
-				uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+				bool hasNormals = primitive.attributes.find("NORMAL") != primitive.attributes.end();
+				const tinygltf::Accessor* normalAccessor = nullptr;
+				const tinygltf::BufferView* normalBufferView = nullptr;
+				const tinygltf::Buffer* normalBuffer = nullptr;
+
+				if (hasNormals)
+				{
+					normalAccessor = &model.accessors[primitive.attributes.at("NORMAL")];
+					normalBufferView = &model.bufferViews[normalAccessor->bufferView];
+					normalBuffer = &model.buffers[normalBufferView->buffer];
+				}
+
+				uint32_t baseVertex = static_cast<uint32_t>(mesh.vertices.size());
 
 				for (size_t i = 0; i < posAccessor.count; i++) 
 				{
-					Vertex vertex{};
+					MeshVertex vertex{};
 
 					const float* pos = reinterpret_cast<const float*>(&posBuffer.data[posBufferView.byteOffset + posAccessor.byteOffset + i * 12]);
 
@@ -1061,9 +1527,13 @@ private:
 					else 
 						vertex.texCoord = { 0.0f, 0.0f };
 
-					vertex.color = { 1.0f, 1.0f, 1.0f };
+					if (hasNormals)
+					{
+						const float* normal = reinterpret_cast<const float*>(&normalBuffer->data[normalBufferView->byteOffset + normalAccessor->byteOffset + i * 12]);
+						vertex.normal = { normal[0], -normal[1], normal[2] };
+					}
 
-					vertices.push_back(vertex);
+					mesh.vertices.push_back(vertex);
 				}
 
 				const unsigned char* indexData = &indexBuffer.data[indexBufferView.byteOffset + indexAccessor.byteOffset];
@@ -1080,7 +1550,7 @@ private:
 				else 
 					throw std::runtime_error("Unsupported index component type");
 
-				indices.reserve(indices.size() + indexCount);
+				mesh.indices.reserve(mesh.indices.size() + indexCount);
 
 				for (size_t i = 0; i < indexCount; i++) 
 				{
@@ -1093,21 +1563,34 @@ private:
 					else if (indexAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) 
 						index = *reinterpret_cast<const uint8_t*>(indexData + i * indexStride);
 
-					indices.push_back(baseVertex + index);
+					mesh.indices.push_back(baseVertex + index);
 				}
 			}
 		}
+
+		optimizeMesh(mesh, vertexLayout.stride());
+		buildLodChain(mesh);
+		encodedVertices = encodeVertices(mesh.vertices, vertexLayout, mesh.bounds());
+		packedIndices = packIndices(mesh.indices, mesh.vertices.size(), uint8IndicesEnabled);
+		// Positions are y-mirrored above, which turns the rasterizer's counter-clockwise front faces clockwise
+		meshlets.clear();
+		lodMeshlets = buildLodMeshlets(mesh, meshlets, { .clockwiseFrontFaces = true });
+		meshRadius = glm::length(mesh.bounds().extent()) * 0.5f;
+		std::cout << "Meshlets: " << meshlets.size() << " across " << lodMeshlets.size() << " LODs" << std::endl;
+		std::cout << "Vertex buffer: " << encodedVertices.data.size() << " bytes (" << vertexLayout.positionStride() << " + " << vertexLayout.attributeStride() << " bytes per vertex in position and attribute streams, "
+			<< mesh.vertices.size() * sizeof(MeshVertex) << " bytes unpacked)" << std::endl;
+		std::cout << "Index buffer: " << packedIndices.data.size() << " bytes (" << indexFormatName(packedIndices.format) << ")" << std::endl;
 	} 
 
 	void createVertexBuffer()
 	{
-		vk::DeviceSize bufferSize = sizeof(vertices[0]) * vertices.size();
+		vk::DeviceSize bufferSize = encodedVertices.data.size();
 		vk::raii::Buffer stagingBuffer({});
 		vk::raii::DeviceMemory stagingBufferMemory({});
 		createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
 
 		void* dataStaging = stagingBufferMemory.mapMemory(0, bufferSize);
-		memcpy(dataStaging, vertices.data(), bufferSize);
+		memcpy(dataStaging, encodedVertices.data.data(), bufferSize);
 		stagingBufferMemory.unmapMemory();
 
 		createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, vertexBuffer, vertexBufferMemory);
@@ -1117,14 +1600,14 @@ private:
 
 	void createIndexBuffer()
 	{
-		vk::DeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+		vk::DeviceSize bufferSize = packedIndices.data.size();
 
 		vk::raii::Buffer stagingBuffer({});
 		vk::raii::DeviceMemory stagingBufferMemory({});
 		createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
 
 		void* data = stagingBufferMemory.mapMemory(0, bufferSize);
-		memcpy(data, indices.data(), (size_t)bufferSize);
+		memcpy(data, packedIndices.data.data(), (size_t)bufferSize);
 		stagingBufferMemory.unmapMemory();
 
 		createBuffer(bufferSize, vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eIndexBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, indexBuffer, indexBufferMemory);
@@ -1134,10 +1617,16 @@ private:
 
 	void setupGameObjects()
 	{
+		uint32_t objectCount = benchmark.options().objects == 0 ? DEFAULT_OBJECT_COUNT : benchmark.options().objects;
+		gameObjects = std::vector<GameObject>(objectCount);
+
 		gameObjects[0].position = { 0.0f, 0.0f, 0.0f };
 		gameObjects[0].rotation = { 0.0f, 0.0f, 0.0f };
 		gameObjects[0].scale = { 1.0f, 1.0f, 1.0f };
 
+		if (objectCount < 3)
+			return;
+
 		gameObjects[1].position = { -2.0f, 0.0, -1.0f };
 		gameObjects[1].rotation = { 0.0f, glm::radians(45.0f), 0.0f };
 		gameObjects[1].scale = { 0.75f, 0.75f, 0.75f };
@@ -1145,39 +1634,62 @@ private:
 		gameObjects[2].position = { 2.0f, 0.0f, -1.0f };
 		gameObjects[2].rotation = { 0.0f, glm::radians(-45.0f), 0.0f };
 		gameObjects[2].scale = { 0.75f, 0.75f, 0.75f };
+
+		// Further objects fill a grid that recedes from the camera, so they spread over the LOD levels
+		constexpr uint32_t gridColumns = 16;
+		constexpr float gridSpacing = 2.0f;
+		for (uint32_t i = 3; i < objectCount; i++)
+		{
+			uint32_t column = (i - 3) % gridColumns;
+			uint32_t row = (i - 3) / gridColumns;
+			gameObjects[i].position = { (static_cast<float>(column) - (gridColumns - 1) * 0.5f) * gridSpacing, 0.0f, -3.0f - static_cast<float>(row) * gridSpacing };
+			gameObjects[i].rotation = { 0.0f, glm::radians(static_cast<float>(i) * 37.0f), 0.0f };
+			gameObjects[i].scale = { 0.75f, 0.75f, 0.75f };
+		}
 	}
 
 	void createUniformBuffers()
 	{
-		for (auto& gameObject : gameObjects)
+		if (bindlessEnabled)
 		{
-			gameObject.uniformBuffers.clear();
-			gameObject.uniformBuffersMemory.clear();
-			gameObject.uniformBuffersMapped.clear();
+			createBindlessBuffers();
+			return;
+		}
 
-			for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-			{
-				vk::DeviceSize bufferSize = sizeof(UniformBufferObject);
-				vk::raii::Buffer buffer({});
-				vk::raii::DeviceMemory bufferMem({});
-				createBuffer(bufferSize, vk::BufferUsageFlagBits::eUniformBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, buffer, bufferMem);
-				gameObject.uniformBuffers.emplace_back(std::move(buffer));
-				gameObject.uniformBuffersMemory.emplace_back(std::move(bufferMem));
-				gameObject.uniformBuffersMapped.emplace_back(gameObject.uniformBuffersMemory[i].mapMemory(0, bufferSize));
-			}
+		// One ObjectUniform per object and one FrameUniform per frame
+		uint32_t valuesPerFrame = static_cast<uint32_t>(gameObjects.size()) + 1;
+		uniformArena.init(physicalDevice, device, MAX_FRAMES_IN_FLIGHT, std::max(sizeof(ObjectUniform), sizeof(FrameUniform)), valuesPerFrame);
+	}
+
+	// Per frame in flight: the transform and material of every object, and the material table.
+	void createBindlessBuffers()
+	{
+		vk::DeviceSize objectBytes = sizeof(ObjectData) * gameObjects.size();
+		vk::DeviceSize materialBytes = sizeof(MaterialData) * MATERIAL_COUNT;
+		for (auto& frame : bindlessFrames)
+		{
+			createBuffer(objectBytes, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, frame.objects, frame.objectsMemory);
+			frame.objectsMapped = frame.objectsMemory.mapMemory(0, objectBytes);
+			createBuffer(materialBytes, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, frame.materials, frame.materialsMemory);
+			frame.materialsMapped = frame.materialsMemory.mapMemory(0, materialBytes);
 		}
 	}
 
+	// The bindless table owns its pool
 	void createDescriptorPool()
 	{
+		if (bindlessEnabled)
+			return;
+
+		// One set per frame in flight, however many objects are drawn
 		std::array poolSizes = {
-			vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, MAX_OBJECTS * MAX_FRAMES_IN_FLIGHT),
-			vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, MAX_OBJECTS * MAX_FRAMES_IN_FLIGHT),
+			vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, 2 * MAX_FRAMES_IN_FLIGHT),
+			vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, MAX_FRAMES_IN_FLIGHT),
 		};
 		vk::DescriptorPoolCreateInfo poolInfo
 		{
 			.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-			.maxSets = MAX_OBJECTS * MAX_FRAMES_IN_FLIGHT,
+			.maxSets = MAX_FRAMES_IN_FLIGHT,
 			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
 			.pPoolSizes = poolSizes.data()
 		};
@@ -1187,72 +1699,96 @@ private:
 
 	void createDescriptorSets()
 	{
-		for (auto& gameObject : gameObjects)
+		if (bindlessEnabled)
 		{
-			std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, *descriptorSetLayout);
-			vk::DescriptorSetAllocateInfo allocInfo
+			bindless.setSampler(*textureSampler);
+			for (auto& frame : bindlessFrames)
 			{
-				.descriptorPool = *descriptorPool,
-				.descriptorSetCount = static_cast<uint32_t>(layouts.size()),
-				.pSetLayouts = layouts.data()
-			};
+				frame.objectSlot = bindless.addBuffer(*frame.objects);
+				frame.materialSlot = bindless.addBuffer(*frame.materials);
+			}
+			textureSlot = bindless.addImage(textureView());
+			if (textureStreaming)
+				textureSlotVersion = textureStreamer.viewVersion(streamedTexture);
+			return;
+		}
+
+		std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, *descriptorSetLayout);
+		vk::DescriptorSetAllocateInfo allocInfo
+		{
+			.descriptorPool = *descriptorPool,
+			.descriptorSetCount = static_cast<uint32_t>(layouts.size()),
+			.pSetLayouts = layouts.data()
+		};
 
-			gameObject.descriptorSets.clear();
-			gameObject.descriptorSets = device.allocateDescriptorSets(allocInfo);
+		frameDescriptorSets.clear();
+		frameDescriptorSets = device.allocateDescriptorSets(allocInfo);
 
-			for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-			{
-				vk::DescriptorBufferInfo bufferInfo
-				{
-					.buffer = *gameObject.uniformBuffers[i],
-					.offset = 0,
-					.range = sizeof(UniformBufferObject)
-				};
+		// The buffer infos are the base of each binding; the draws add their arena offsets
+		vk::DescriptorBufferInfo objectInfo
+		{
+			.buffer = uniformArena.buffer(),
+			.offset = 0,
+			.range = sizeof(ObjectUniform)
+		};
+
+		vk::DescriptorBufferInfo frameInfo
+		{
+			.buffer = uniformArena.buffer(),
+			.offset = 0,
+			.range = sizeof(FrameUniform)
+		};
+
+		vk::DescriptorImageInfo imageInfo
+		{
+			.sampler = *textureSampler,
+			.imageView = textureView(),
+			.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+		};
 
-				vk::DescriptorImageInfo imageInfo
+		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			std::array descriptorWrites{
+				vk::WriteDescriptorSet
+				{
+					.dstSet = *frameDescriptorSets[i],
+					.dstBinding = 0,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+					.pBufferInfo = &objectInfo
+				},
+				vk::WriteDescriptorSet
 				{
-					.sampler = *textureSampler,
-					.imageView = *textureImageView,
-					.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
-				};
+					.dstSet = *frameDescriptorSets[i],
+					.dstBinding = 1,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+					.pImageInfo = &imageInfo
+				},
+				vk::WriteDescriptorSet
+				{
+					.dstSet = *frameDescriptorSets[i],
+					.dstBinding = 2,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = vk::DescriptorType::eUniformBufferDynamic,
+					.pBufferInfo = &frameInfo
+				},
+			};
 
-				std::array descriptorWrites{
-					vk::WriteDescriptorSet
-					{
-						.dstSet = *gameObject.descriptorSets[i],
-						.dstBinding = 0,
-						.dstArrayElement = 0,
-						.descriptorCount = 1,
-						.descriptorType = vk::DescriptorType::eUniformBuffer,
-						.pBufferInfo = &bufferInfo
-					},
-					vk::WriteDescriptorSet
-					{
-						.dstSet = *gameObject.descriptorSets[i],
-						.dstBinding = 1,
-						.dstArrayElement = 0,
-						.descriptorCount = 1,
-						.descriptorType = vk::DescriptorType::eCombinedImageSampler,
-						.pImageInfo = &imageInfo
-					},
-				};
-
-				device.updateDescriptorSets(descriptorWrites, {});
-			}
+			device.updateDescriptorSets(descriptorWrites, {});
 		}
+
+		if (textureStreaming)
+			textureViewVersions.fill(textureStreamer.viewVersion(streamedTexture));
 	}
 
+	// One per frame in flight and swapchain image, kept recorded while the scene keeps its structure
 	void createCommandBuffers()
 	{
-		commandBuffers.clear();
-		vk::CommandBufferAllocateInfo allocInfo
-		{
-			.commandPool = commandPool,
-			.level = vk::CommandBufferLevel::ePrimary,
-			.commandBufferCount = MAX_FRAMES_IN_FLIGHT
-		};
-
-		commandBuffers = vk::raii::CommandBuffers(device, allocInfo);
+		commandCache.init(device, commandPool, MAX_FRAMES_IN_FLIGHT, static_cast<uint32_t>(swapChainImages.size()));
 	}
 
 	void createSyncObjects()
@@ -1276,10 +1812,17 @@ private:
 #if PLATFORM_DESKTOP
 	void mainLoop()
 	{
-		while (!glfwWindowShouldClose(window))
+		while (!glfwWindowShouldClose(window) && !benchmark.finished())
 		{
+			VSA_TRACE_ZONE("frame");
 			glfwPollEvents();
 			drawFrame();
+
+			if (benchmark.endFrame())
+			{
+				gpuProfiler.resetStatistics();
+				meshletCuller.resetStatistics();
+			}
 		}
 
 		device.waitIdle();
@@ -1288,9 +1831,19 @@ private:
 
 
 	void drawFrame() {
-		while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX));
+		{
+			VSA_TRACE_ZONE("wait_fence");
+			while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX));
+		}
+		gpuProfiler.beginFrame(currentFrame);
+		if (bindlessEnabled)
+			bindless.beginFrame();
 
-		auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[semaphoreIndex], nullptr);
+		auto [result, imageIndex] = [&]
+			{
+				VSA_TRACE_ZONE("acquire");
+				return swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[semaphoreIndex], nullptr);
+			}();
 
 		if (result == vk::Result::eErrorOutOfDateKHR) 
 		{
@@ -1300,24 +1853,53 @@ private:
 		if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR) 
 			throw std::runtime_error("failed to acquire swap chain image!");
 		
-		updateUniformBuffer(currentFrame);
+		{
+			VSA_TRACE_ZONE("update_ubo");
+			updateUniformBuffer(currentFrame);
+		}
+
+		if (textureStreaming)
+		{
+			VSA_TRACE_ZONE("texture_streaming");
+			updateTextureStreaming();
+		}
 
 		device.resetFences(*inFlightFences[currentFrame]);
-		commandBuffers[currentFrame].reset();
-		recordCommandBuffer(imageIndex);
+		vk::CommandBuffer commandBuffer;
+		{
+			VSA_TRACE_ZONE("record");
+			auto [commands, record] = commandCache.acquire(currentFrame, imageIndex, commandKey());
+			if (record)
+				recordCommandBuffer(commands.commandBuffer, imageIndex, commands.recorded);
+			else
+			{
+				gpuProfiler.replay(commands.recorded.scopes);
+				if (meshletCuller.enabled())
+					meshletCuller.resubmit(currentFrame);
+			}
 
-		vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		const vk::SubmitInfo submitInfo
-		{ 
-			.waitSemaphoreCount = 1, 
-			.pWaitSemaphores = &*presentCompleteSemaphores[semaphoreIndex],
-			.pWaitDstStageMask = &waitDestinationStageMask, 
-			.commandBufferCount = 1,
-			.pCommandBuffers = &*commandBuffers[currentFrame],
-			.signalSemaphoreCount = 1, 
-			.pSignalSemaphores = &*renderFinishedSemaphores[imageIndex] 
-		};
-		graphicsQueue.submit(submitInfo, *inFlightFences[currentFrame]);
+			benchmark.addCounter("draws", static_cast<double>(commands.recorded.draws));
+			benchmark.addCounter("descriptor_binds", static_cast<double>(commands.recorded.descriptorBinds));
+			benchmark.addCounter("barriers", static_cast<double>(commands.recorded.barriers));
+			benchmark.addCounter("command_records", record ? 1.0 : 0.0);
+			commandBuffer = *commands.commandBuffer;
+		}
+
+		{
+			VSA_TRACE_ZONE("submit");
+			vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+			const vk::SubmitInfo submitInfo
+			{ 
+				.waitSemaphoreCount = 1, 
+				.pWaitSemaphores = &*presentCompleteSemaphores[semaphoreIndex],
+				.pWaitDstStageMask = &waitDestinationStageMask, 
+				.commandBufferCount = 1,
+				.pCommandBuffers = &commandBuffer,
+				.signalSemaphoreCount = 1, 
+				.pSignalSemaphores = &*renderFinishedSemaphores[imageIndex] 
+			};
+			graphicsQueue.submit(submitInfo, *inFlightFences[currentFrame]);
+		}
 
 		const vk::PresentInfoKHR presentInfoKHR
 		{ 
@@ -1328,7 +1910,10 @@ private:
 			.pImageIndices = &imageIndex 
 		};
 
-		result = presentQueue.presentKHR(presentInfoKHR);
+		{
+			VSA_TRACE_ZONE("present");
+			result = presentQueue.presentKHR(presentInfoKHR);
+		}
 
 		if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || framebufferResized) {
 			framebufferResized = false;
@@ -1341,6 +1926,106 @@ private:
 		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 	}
 
+	// The mip level at which the texture spans about as many texels as the object's bounds cover pixels.
+	[[nodiscard]] float textureLevel(float distance, float scale, float pixelsPerUnit) const
+	{
+		vk::Extent2D extent = textureStreamer.extent(streamedTexture);
+		float projectedPixels = 2.0f * meshRadius * scale * pixelsPerUnit / std::max(distance, 0.001f);
+		float texels = static_cast<float>(std::max(extent.width, extent.height));
+		return std::log2(std::max(texels / projectedPixels, 1.0f));
+	}
+
+	/**
+	* Completes texture uploads, lets the streamer act on this frame's requests and points the next draws
+	* at the current view: this frame's descriptor sets, whose previous submission has completed
+	* (inFlightFences), or a new slot of the bindless table.
+	*/
+	void updateTextureStreaming()
+	{
+		uploads.pump();
+		textureStreamer.update();
+
+		uint64_t version = textureStreamer.viewVersion(streamedTexture);
+		if (bindlessEnabled)
+		{
+			// A new slot: frames in flight, this one included, may still sample the old one
+			if (textureSlotVersion != version)
+			{
+				bindless.releaseImage(textureSlot);
+				textureSlot = bindless.addImage(textureView());
+				textureSlotVersion = version;
+			}
+		}
+		else if (textureViewVersions[currentFrame] != version)
+		{
+			vk::DescriptorImageInfo imageInfo
+			{
+				.sampler = *textureSampler,
+				.imageView = textureView(),
+				.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal
+			};
+
+			vk::WriteDescriptorSet descriptorWrite
+			{
+				.dstSet = *frameDescriptorSets[currentFrame],
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eCombinedImageSampler,
+				.pImageInfo = &imageInfo
+			};
+			device.updateDescriptorSets(descriptorWrite, {});
+			textureViewVersions[currentFrame] = version;
+			// Recordings that bind the set became invalid with the write
+			commandCache.invalidate();
+		}
+
+		// Time from the end of startup until the texture is as sharp as the scene needs
+		if (!textureSettled && textureStreamer.settled(streamedTexture))
+		{
+			textureSettled = true;
+			benchmark.startupPhase("texture_streaming");
+		}
+
+		const TextureStreamer::Statistics& stats = textureStreamer.statistics();
+		benchmark.setResourceBytes("texture", stats.residentBytes);
+		benchmark.setResourceBytes("texture_peak", stats.peakResidentBytes);
+		benchmark.addCounter("texture_resident_mib", static_cast<double>(stats.residentBytes) / (1024.0 * 1024.0));
+	}
+
+	/**
+	* Fills the frame's object and material buffers. Without meshlet culling the objects are stored grouped
+	* by LOD, so each LOD is one instanced draw whatever the materials of its objects. The culler emits
+	* per-object draws whose firstInstance is the object's index, so there objects keep their order.
+	*/
+	void writeBindlessFrame(uint32_t frameIndex, const std::vector<MeshletCuller::Instance>& instances)
+	{
+		BindlessFrame& frame = bindlessFrames[frameIndex];
+
+		std::vector<uint32_t> order(gameObjects.size());
+		std::iota(order.begin(), order.end(), 0u);
+		drawBatches.clear();
+		if (!meshletCuller.enabled())
+		{
+			std::ranges::stable_sort(order, {}, [this](uint32_t i) { return gameObjects[i].lod; });
+			for (uint32_t slot = 0; slot < order.size(); slot++)
+			{
+				uint32_t lod = gameObjects[order[slot]].lod;
+				if (drawBatches.empty() || drawBatches.back().lod != lod)
+					drawBatches.push_back({ lod, slot, 0 });
+				drawBatches.back().instanceCount++;
+			}
+		}
+
+		auto* objects = static_cast<ObjectData*>(frame.objectsMapped);
+		for (uint32_t slot = 0; slot < order.size(); slot++)
+			objects[slot] = { .model = instances[order[slot]].model, .material = gameObjects[order[slot]].material };
+
+		auto* materials = static_cast<MaterialData*>(frame.materialsMapped);
+		for (uint32_t material = 0; material < MATERIAL_COUNT; material++)
+			materials[material] = { .baseColorTexture = textureSlot };
+	}
+
 	void updateUniformBuffer(uint32_t currentImage)
 	{
 		static auto startTime = std::chrono::high_resolution_clock::now();
@@ -1351,30 +2036,65 @@ private:
 		float deltaTime = std::chrono::duration<float>(currentTime - lastFrameTime).count();
 		lastFrameTime = currentTime;
 
-		glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 6.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-		glm::mat4 proj = glm::perspective(glm::radians(45.0f), static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height), 0.1f, 20.0f);
+		const glm::vec3 cameraPosition(2.0f, 2.0f, 6.0f);
+		const float fovY = glm::radians(45.0f);
+		glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 proj = glm::perspective(fovY, static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height), 0.1f, 50.0f);
+
+		// LODs are chosen so their simplification error stays under a pixel on screen
+		float pixelsPerUnit = static_cast<float>(swapChainExtent.height) / (2.0f * std::tan(fovY * 0.5f));
+		uint64_t triangles = 0;
 
+		// The camera is shared by every draw of the frame and written once
+		if (!bindlessEnabled)
+		{
+			uniformArena.beginFrame(currentImage);
+			frameUniformOffset = uniformArena.push(FrameUniform{ .view = view, .proj = proj });
+		}
+
+		std::vector<MeshletCuller::Instance> instances;
 		for (auto& gameObject : gameObjects)
 		{
 			const float rotationSpeed = 0.5f;
 			gameObject.rotation.y += rotationSpeed * deltaTime;
 
 			glm::mat4 model = gameObject.getModelMatrix();
+			float scale = std::max({ gameObject.scale.x, gameObject.scale.y, gameObject.scale.z });
+			float distance = glm::length(cameraPosition - gameObject.position) - meshRadius * scale;
+			gameObject.lod = selectLod(mesh.lods, distance, scale, pixelsPerUnit);
+			if (textureStreaming)
+				textureStreamer.request(streamedTexture, textureLevel(distance, scale, pixelsPerUnit));
+			triangles += mesh.lods[gameObject.lod].indexCount / 3;
 
-			UniformBufferObject ubo
-			{
-				.model = model,
-				.view = view,
-				.proj = proj
-			};
+			instances.push_back({ model, lodMeshlets[gameObject.lod] });
 
-			memcpy(gameObject.uniformBuffersMapped[currentFrame], &ubo, sizeof(ubo));
+			if (bindlessEnabled)
+				continue;
+
+			gameObject.uniformOffset = uniformArena.push(ObjectUniform{ .model = model });
+		}
+
+		if (bindlessEnabled)
+		{
+			bindlessViewProj = proj * view;
+			writeBindlessFrame(currentImage, instances);
 		}
+
+		meshletCuller.update(currentFrame, instances, view, proj);
+
+		// With GPU culling the drawn triangles are only known once a frame's counters come back
+		benchmark.addCounter("triangles", static_cast<double>(meshletCuller.enabled() ? meshletCuller.lastVisibleTriangles() : triangles));
+		benchmark.addCounter("objects", static_cast<double>(gameObjects.size()));
 	}
 
 #if PLATFORM_DESKTOP
 	void cleanup() const
 	{
+		meshletCuller.printStatistics();
+		gpuProfiler.exportFromEnvironment();
+		CpuTracer::instance().exportFromEnvironment();
+		benchmark.writeReport(gpuProfiler.toJson("  "));
+
 		glfwDestroyWindow(window);
 
 		glfwTerminate();
@@ -1489,15 +2209,17 @@ private:
 		endSingleTimeCommands(*commandBuffer);
 	}
 
-	void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Image& image, vk::raii::DeviceMemory& imageMemory)
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties,
+		vk::raii::Image& image, vk::raii::DeviceMemory& imageMemory, uint32_t arrayLayers = 1, vk::ImageCreateFlags flags = {})
 	{
 		vk::ImageCreateInfo imageInfo
 		{
+			.flags = flags,
 			.imageType = vk::ImageType::e2D,
 			.format = format,
 			.extent = { width, height, 1 },
 			.mipLevels = mipLevels,
-			.arrayLayers = 1,
+			.arrayLayers = arrayLayers,
 			.samples = vk::SampleCountFlagBits::e1,
 			.tiling = tiling,
 			.usage = usage,
@@ -1744,13 +2466,19 @@ private:
 		createSwapChain();
 		createImageViews();
 
+		// The framebuffers take the new depth view
+		createDepthResources();
 		if (!appInfo.profileSupported)
 		{
 			createRenderPass();
 			createFramebuffers();
 		}
 
-		createDepthResources();
+		if (meshletCuller.enabled())
+			createDepthPyramid();
+
+		// The recordings reference the old images, and the image count may have changed
+		createCommandBuffers();
 	}
 
 	void cleanupSwapChain()
@@ -1758,19 +2486,28 @@ private:
 		swapChainImageViews.clear();
 	}
 	
-	void recordCommandBuffer(uint32_t imageIndex)
-	{
-		commandBuffers[currentFrame].begin({});
-
-		transition_image_layout(
-			imageIndex,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::eColorAttachmentOptimal,
-			{},
-			vk::AccessFlagBits2::eColorAttachmentWrite,
-			vk::PipelineStageFlagBits2::eTopOfPipe,
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput
-		);
+	/**
+	* Hash of what recordCommandBuffer() records by value: which passes run, each object's LOD (its draw
+	* and meshlet ranges) and uniform offset, the bindless batches and camera. The culling projection is
+	* only changed with the swapchain, which drops every recording anyway, as do rewritten descriptors.
+	*/
+	[[nodiscard]] uint64_t commandKey() const
+	{
+		uint64_t key = hashBytes(&depthPrepass, sizeof(depthPrepass));
+		key = hashBytes(&frameUniformOffset, sizeof(frameUniformOffset), key);
+		for (const GameObject& gameObject : gameObjects)
+		{
+			key = hashBytes(&gameObject.lod, sizeof(gameObject.lod), key);
+			key = hashBytes(&gameObject.uniformOffset, sizeof(gameObject.uniformOffset), key);
+		}
+
+		key = hashBytes(drawBatches.data(), drawBatches.size() * sizeof(DrawBatch), key);
+		return hashBytes(&bindlessViewProj, sizeof(bindlessViewProj), key);
+	}
+
+	void recordCommandBuffer(const vk::raii::CommandBuffer& commandBuffer, uint32_t imageIndex, RecordedCommands& recorded)
+	{
+		commandBuffer.begin({});
 
 		vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
 		
@@ -1782,124 +2519,268 @@ private:
 			.clearValue = clearColor
 		};
 		
+		vk::RenderingAttachmentInfo depthAttachmentInfo = {
+			.imageView = depthImageView,
+			.imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eDontCare,
+			.clearValue = vk::ClearDepthStencilValue(1.0f, 0)
+		};
+
 		vk::RenderingInfo renderingInfo = {
 			.renderArea = {.offset = { 0, 0 }, .extent = swapChainExtent },
 			.layerCount = 1,
 			.colorAttachmentCount = 1,
-			.pColorAttachments = &attachmentInfo
+			.pColorAttachments = &attachmentInfo,
+			.pDepthAttachment = &depthAttachmentInfo
 		};
 
-		commandBuffers[currentFrame].beginRendering(renderingInfo);
-		commandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
-		commandBuffers[currentFrame].setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
-		commandBuffers[currentFrame].setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+		// Bindless: the set stays bound through every pass of the frame (the culling passes bind on the
+		// compute bind point); the constants are pushed per pass, as compute pushes in between replace them
+		std::atomic<uint32_t> descriptorBinds = 0;
+		std::atomic<uint32_t> draws = 0;
+		BindlessConstants bindlessConstants;
+		if (bindlessEnabled)
+		{
+			const BindlessFrame& frame = bindlessFrames[currentFrame];
+			bindlessConstants =
+			{
+				.quantization = encodedVertices.quantization,
+				.viewProj = bindlessViewProj,
+				.objectBuffer = frame.objectSlot,
+				.materialBuffer = frame.materialSlot
+			};
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, bindless.set(), nullptr);
+			descriptorBinds++;
+		}
 
-		commandBuffers[currentFrame].bindVertexBuffers(0, *vertexBuffer, { 0 });
-		commandBuffers[currentFrame].bindIndexBuffer(*indexBuffer, 0, vk::IndexType::eUint32);
+		// Large draw lists are recorded into secondary command buffers on the record pool, see core/parallelRecorder.h
+		uint32_t passDraws = bindlessEnabled && !meshletCuller.enabled() ? static_cast<uint32_t>(drawBatches.size()) : static_cast<uint32_t>(gameObjects.size());
+		bool parallel = recordPool->threadCount() > 1 && passDraws >= 2 * DRAWS_PER_RECORD_SLICE;
+		if (parallel)
+		{
+			if (!recorded.recorder.ready())
+				recorded.recorder.init(device, graphicsIndex, recordPool->threadCount());
+			recorded.recorder.reset();
+			renderingInfo.flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers;
+		}
 
-		for (const auto& gameObject : gameObjects)
+		// Pipeline statistics scopes may only span secondaries that inherit the query
+		bool passStatistics = !parallel || inheritedStatistics;
+		vk::QueryPipelineStatisticFlags inheritedQueries = inheritedStatistics ? GpuProfiler::pipelineStatisticFlags() : vk::QueryPipelineStatisticFlags();
+		vk::Format colorFormat = swapChainImageFormat;
+		vk::Format depthFormat = parallel ? findDepthFormat() : vk::Format::eUndefined;
+		vk::CommandBufferInheritanceRenderingInfo depthInheritance
 		{
-			commandBuffers[currentFrame].bindDescriptorSets(
-				vk::PipelineBindPoint::eGraphics,
-				*pipelineLayout,
-				0,
-				*gameObject.descriptorSets[currentFrame],
-				nullptr
-			);
+			.depthAttachmentFormat = depthFormat,
+			.rasterizationSamples = vk::SampleCountFlagBits::e1
+		};
+		vk::CommandBufferInheritanceRenderingInfo mainInheritance
+		{
+			.colorAttachmentCount = 1,
+			.pColorAttachmentFormats = &colorFormat,
+			.depthAttachmentFormat = depthFormat,
+			.rasterizationSamples = vk::SampleCountFlagBits::e1
+		};
 
-			commandBuffers[currentFrame].drawIndexed(indices.size(), 1, 0, 0, 0);
-		}
+		// Both passes of a phase draw exactly the same geometry: the same LODs and the same culled meshlet lists.
+		// Records draws [first, first + count) of the pass: objects, or LOD batches for bindless without culling.
+		// Secondaries inherit no bindings, so they bind the bindless set themselves
+		auto drawObjects = [this, &bindlessConstants, &descriptorBinds, &draws](const vk::raii::CommandBuffer& commandBuffer, uint32_t phase, uint32_t first, uint32_t count, bool secondary)
+			{
+				commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+				commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+				commandBuffer.bindIndexBuffer(*indexBuffer, 0, packedIndices.indexType());
+				if (bindlessEnabled)
+				{
+					if (secondary)
+					{
+						commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, *pipelineLayout, 0, bindless.set(), nullptr);
+						descriptorBinds++;
+					}
+					commandBuffer.pushConstants<BindlessConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, bindlessConstants);
+				}
+				else
+					commandBuffer.pushConstants<PositionQuantization>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, encodedVertices.quantization);
 
-		commandBuffers[currentFrame].endRendering();
+				if (bindlessEnabled && !meshletCuller.enabled())
+				{
+					for (uint32_t batchIndex = first; batchIndex < first + count; batchIndex++)
+					{
+						const DrawBatch& batch = drawBatches[batchIndex];
+						const MeshLod& lod = mesh.lods[batch.lod];
+						commandBuffer.drawIndexed(lod.indexCount, batch.instanceCount, lod.firstIndex, 0, batch.firstInstance);
+					}
+					draws += count;
+					return;
+				}
 
-		transition_image_layout(
-			imageIndex,
-			vk::ImageLayout::eColorAttachmentOptimal,
-			vk::ImageLayout::ePresentSrcKHR,
-			vk::AccessFlagBits2::eColorAttachmentWrite,
-			{},
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-			vk::PipelineStageFlagBits2::eBottomOfPipe
-		);
-		commandBuffers[currentFrame].end();
-	}
-
-	void transition_image_layout_custom(
-		vk::raii::Image& image,
-		vk::ImageLayout old_layout,
-		vk::ImageLayout new_layout,
-		vk::AccessFlags2 src_access_mask,
-		vk::AccessFlags2 dst_access_mask,
-		vk::PipelineStageFlags2 src_stage_mask,
-		vk::PipelineStageFlags2 dst_stage_mask,
-		vk::ImageAspectFlags aspect_mask
-	)
-	{
-		vk::ImageMemoryBarrier2 barrier = {
-			.srcStageMask = src_stage_mask,
-			.srcAccessMask = src_access_mask,
-			.dstStageMask = dst_stage_mask,
-			.dstAccessMask = dst_access_mask,
-			.oldLayout = old_layout,
-			.newLayout = new_layout,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = image,
-			.subresourceRange = {
-				.aspectMask = aspect_mask,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			}
-		};
+				for (uint32_t objectIndex = first; objectIndex < first + count; objectIndex++)
+				{
+					if (!bindlessEnabled)
+					{
+						// Same set every draw, only the object's offset changes; offsets go in binding order
+						std::array<uint32_t, 2> dynamicOffsets = { gameObjects[objectIndex].uniformOffset, frameUniformOffset };
+						commandBuffer.bindDescriptorSets(
+							vk::PipelineBindPoint::eGraphics,
+							*pipelineLayout,
+							0,
+							*frameDescriptorSets[currentFrame],
+							dynamicOffsets
+						);
+						descriptorBinds++;
+					}
 
-		vk::DependencyInfo dependency_info{
-			.dependencyFlags = {},
-			.imageMemoryBarrierCount = 1,
-			.pImageMemoryBarriers = &barrier
-		};
+					if (meshletCuller.enabled())
+					{
+						meshletCuller.draw(commandBuffer, currentFrame, objectIndex, phase);
+					}
+					else
+					{
+						const MeshLod& lod = mesh.lods[gameObjects[objectIndex].lod];
+						commandBuffer.drawIndexed(lod.indexCount, 1, lod.firstIndex, 0, 0);
+					}
+					draws++;
+				}
+			};
 
-		commandBuffers[currentFrame].pipelineBarrier2(dependency_info);
-	}
+		// Records the draws of one rendering scope inline, or in slices the primary executes in order
+		auto drawPass = [&](const vk::raii::CommandBuffer& passBuffer, uint32_t phase, const PipelineVariants& pipelines, const RenderState& state, bool depthOnly)
+			{
+				auto bindPass = [&](const vk::raii::CommandBuffer& target)
+					{
+						pipelines.bind(target, state);
+						if (depthOnly)
+							target.bindVertexBuffers(VertexLayout::POSITION_BINDING, *vertexBuffer, { 0 });
+						else
+							target.bindVertexBuffers(0, { *vertexBuffer, *vertexBuffer }, { 0, encodedVertices.attributeOffset });
+					};
+
+				if (!parallel)
+				{
+					bindPass(passBuffer);
+					drawObjects(passBuffer, phase, 0, passDraws, false);
+					return;
+				}
 
-	void transition_image_layout(
-		uint32_t imageIndex, 
-		vk::ImageLayout old_layout,
-		vk::ImageLayout new_layout,
-		vk::AccessFlagBits2 src_access_mask,
-		vk::AccessFlagBits2 dst_access_mask,
-		vk::PipelineStageFlagBits2 src_stage_mask,
-		vk::PipelineStageFlagBits2 dst_stage_mask
-	)
-	{
-		vk::ImageMemoryBarrier2 barrier = {
-			.srcStageMask = src_stage_mask,
-			.srcAccessMask = src_access_mask,
-			.dstStageMask = dst_stage_mask,
-			.dstAccessMask = dst_access_mask,
-			.oldLayout = old_layout,
-			.newLayout = new_layout,
-			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-			.image = swapChainImages[imageIndex],
-			.subresourceRange = 
+				recorded.recorder.record(*recordPool, depthOnly ? depthInheritance : mainInheritance, inheritedQueries, passDraws, DRAWS_PER_RECORD_SLICE,
+					[&](const vk::raii::CommandBuffer& slice, uint32_t first, uint32_t count)
+					{
+						bindPass(slice);
+						drawObjects(slice, phase, first, count, true);
+					});
+				recorded.recorder.execute(passBuffer);
+			};
+
+		bool prepass = depthPrepass && depthPrepassPipelines.ready();
+		bool occlusion = meshletCuller.occlusionEnabled();
+
+		// The passes of the frame and what they touch; the graph places the barriers, see core/renderGraph.h.
+		// The acquire semaphore is waited on at the color output stage, and the image is cleared anyway
+		frameGraph.reset();
+		RenderGraph::Resource color = frameGraph.importImage("swapchain", swapChainImages[imageIndex], { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+			{ vk::PipelineStageFlagBits2::eColorAttachmentOutput, {}, vk::ImageLayout::eUndefined }, RenderGraph::present());
+		// Initial usages are fixed, as cached recordings are replayed whatever frame ran before them. The depth
+		// buffer is the graph's own (createDepthResources()); its first use clears it after the previous frame's uses
+		RenderGraph::Resource depth = frameGraph.transientImage("depth", depthDesc);
+
+		// Culling output is read back by the host; the pyramid is kept for the next frame's early culling
+		RenderGraph::Resource culled = 0;
+		RenderGraph::Resource pyramid = 0;
+		RenderGraph::Usage pyramidRead = RenderGraph::sampled(vk::PipelineStageFlagBits2::eComputeShader, vk::ImageLayout::eGeneral);
+		RenderGraph::Usage cullWrite = { vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite };
+		if (meshletCuller.enabled())
+		{
+			culled = frameGraph.importBuffer("meshlet_draws", meshletCuller.drawBuffer(currentFrame), { vk::PipelineStageFlagBits2::eNone, {} }, RenderGraph::hostRead());
+			// Stays in the general layout from its creation on (createDepthPyramid); last written by a pyramid build
+			pyramid = frameGraph.importImage("depth_pyramid", depthPyramid.pyramidImage(), { vk::ImageAspectFlagBits::eColor, 0, depthPyramid.mips(), 0, 1 },
+				{ vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite, vk::ImageLayout::eGeneral }, pyramidRead);
+
+			uint32_t cull = frameGraph.addPass("meshlet_cull", [&](const vk::raii::CommandBuffer& passBuffer)
+				{
+					auto cullScope = gpuProfiler.scope(passBuffer, "meshlet_cull");
+					meshletCuller.record(passBuffer, currentFrame);
+				});
+			frameGraph.write(cull, culled, { cullWrite.stages | vk::PipelineStageFlagBits2::eTransfer, cullWrite.access | vk::AccessFlagBits2::eTransferWrite });
+			// Bound even where the early phase does not sample it, so it must be in its layout
+			frameGraph.read(cull, pyramid, pyramidRead);
+		}
+
+		// The early phase clears and draws what was visible last frame; the late phase draws on top of it
+		auto renderPhase = [&](uint32_t phase)
 			{
-				.aspectMask = vk::ImageAspectFlagBits::eColor,
-				.baseMipLevel = 0,
-				.levelCount = 1,
-				.baseArrayLayer = 0,
-				.layerCount = 1
-			}
-		};
+				bool late = phase == MeshletCuller::LATE_PHASE;
+				if (prepass)
+				{
+					uint32_t pass = frameGraph.addPass(late ? "depth_prepass_late" : "depth_prepass", [&, late, phase](const vk::raii::CommandBuffer& passBuffer)
+						{
+							auto prepassScope = gpuProfiler.scope(passBuffer, late ? "depth_prepass_late" : "depth_prepass", passStatistics);
+							depthAttachmentInfo.loadOp = late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+							depthAttachmentInfo.storeOp = vk::AttachmentStoreOp::eStore;
+							vk::RenderingInfo depthRenderingInfo = {
+								.flags = renderingInfo.flags,
+								.renderArea = {.offset = { 0, 0 }, .extent = swapChainExtent },
+								.layerCount = 1,
+								.colorAttachmentCount = 0,
+								.pDepthAttachment = &depthAttachmentInfo
+							};
+
+							passBuffer.beginRendering(depthRenderingInfo);
+							drawPass(passBuffer, phase, depthPrepassPipelines, RenderState{}, true);
+							passBuffer.endRendering();
+						});
+					frameGraph.write(pass, depth, RenderGraph::depthAttachment());
+					if (meshletCuller.enabled())
+						frameGraph.read(pass, culled, RenderGraph::indirectRead());
+				}
 
-		vk::DependencyInfo dependency_info = {
-			.dependencyFlags = {},
-			.imageMemoryBarrierCount = 1,
-			.pImageMemoryBarriers = &barrier
-		};
+				uint32_t pass = frameGraph.addPass(late ? "main_pass_late" : "main_pass", [&, late, phase](const vk::raii::CommandBuffer& passBuffer)
+					{
+						auto passScope = gpuProfiler.scope(passBuffer, late ? "main_pass_late" : "main_pass", passStatistics);
+						attachmentInfo.loadOp = late ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+						depthAttachmentInfo.loadOp = late || prepass ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+						// The early depth feeds the pyramid and the late phase
+						depthAttachmentInfo.storeOp = occlusion && !late ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+						passBuffer.beginRendering(renderingInfo);
+						drawPass(passBuffer, phase, graphicsPipelines, prepass ? DEPTH_EQUAL_STATE : RenderState{}, false);
+						passBuffer.endRendering();
+					});
+				frameGraph.write(pass, color, RenderGraph::colorAttachment());
+				frameGraph.write(pass, depth, RenderGraph::depthAttachment());
+				if (meshletCuller.enabled())
+					frameGraph.read(pass, culled, RenderGraph::indirectRead());
+			};
 
-		commandBuffers[currentFrame].pipelineBarrier2(dependency_info);
+		renderPhase(MeshletCuller::EARLY_PHASE);
+
+		if (occlusion)
+		{
+			uint32_t pyramidPass = frameGraph.addPass("depth_pyramid", [&](const vk::raii::CommandBuffer& passBuffer)
+				{
+					auto pyramidScope = gpuProfiler.scope(passBuffer, "depth_pyramid");
+					depthPyramid.record(passBuffer);
+				});
+			frameGraph.read(pyramidPass, depth, RenderGraph::depthSampled(vk::PipelineStageFlagBits2::eComputeShader));
+			frameGraph.write(pyramidPass, pyramid, RenderGraph::storageWrite(vk::PipelineStageFlagBits2::eComputeShader));
+
+			uint32_t cullLate = frameGraph.addPass("meshlet_cull_late", [&](const vk::raii::CommandBuffer& passBuffer)
+				{
+					auto cullScope = gpuProfiler.scope(passBuffer, "meshlet_cull_late");
+					meshletCuller.recordLate(passBuffer, currentFrame);
+				});
+			frameGraph.write(cullLate, culled, cullWrite);
+			frameGraph.read(cullLate, pyramid, pyramidRead);
+
+			renderPhase(MeshletCuller::LATE_PHASE);
+		}
+
+		frameGraph.execute(commandBuffer);
+		commandBuffer.end();
+
+		recorded.draws = draws;
+		recorded.descriptorBinds = descriptorBinds;
+		recorded.barriers = frameGraph.barrierCount();
+		recorded.scopes = gpuProfiler.recordedScopes();
 	}
 
 	[[nodiscard]] vk::raii::ShaderModule createShaderModule(const std::vector<char>& code) const
@@ -1958,8 +2839,23 @@ private:
 		};
 	}
 
-	static std::vector<char> readFile(const std::string& filename)
+	void openAssetPack()
+	{
+		if (benchmark.options().assets == "pack" && !assets.open(ASSET_PACK_PATH, "resources/"))
+			std::cout << "No asset pack at " << ASSET_PACK_PATH << ", loading loose files (see cook.bat)" << std::endl;
+
+		benchmark.setAssetSource(assets.isOpen() ? "pack" : "loose");
+	}
+
+	std::vector<char> readFile(const std::string& filename) const
 	{
+		if (const AssetPackEntry* entry = assets.find(filename))
+		{
+			std::vector<char> buffer(entry->size);
+			assets.read(*entry, buffer.data());
+			return buffer;
+		}
+
 		std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
 		if (!file.is_open())
@@ -2053,37 +2949,69 @@ private:
 
 	vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
 	vk::raii::PipelineLayout pipelineLayout = nullptr;
-	vk::raii::Pipeline graphicsPipeline = nullptr;
+	PipelineVariants::Support dynamicStateSupport;       // none with --dynamic-state=off: a pipeline per render state
+	PipelineVariants graphicsPipelines;                  // main pass, also after a prepass (DEPTH_EQUAL_STATE)
+	PipelineVariants depthPrepassPipelines;              // depth only, writes the depth buffer
+	bool depthPrepass = false;
 
 	vk::raii::Image colorImage = nullptr;
 	vk::raii::DeviceMemory colorImageMemory = nullptr;
 	vk::raii::ImageView colorImageView = nullptr;
 
-	vk::raii::Image depthImage = nullptr;
-	vk::raii::DeviceMemory depthImageMemory = nullptr;
-	vk::raii::ImageView depthImageView = nullptr;
-
-	uint32_t mipLevels = 0;
+	RenderGraph::ImageDesc depthDesc;        // of the depth buffer, a transient of frameGraph
+	vk::ImageView depthImageView;            // owned by frameGraph
+
+	AssetPack assets;
+	uint32_t mipLevels = 1;
+	ktxTexture2* loadedTexture = nullptr;
+	const char* transcodedFormatName = nullptr;
+	stbi_uc* loadedPixels = nullptr; // --texture=png
+	int loadedPixelsWidth = 0;
+	int loadedPixelsHeight = 0;
+	TextureCompressionSupport textureCompression;
 	vk::raii::Image textureImage = nullptr;
 	vk::raii::ImageView textureImageView = nullptr;
 	vk::raii::DeviceMemory textureImageMemory = nullptr;
 	vk::raii::Sampler textureSampler = nullptr;
 	vk::Format textureImageFormat = vk::Format::eUndefined;
-
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	UploadManager uploads;                   // streamed texture mips only
+	TextureStreamer textureStreamer;
+	TextureStreamer::TextureId streamedTexture = 0;
+	bool textureStreaming = false;           // KTX2 2D textures; PNG, arrays and cube maps are uploaded whole
+	bool textureSettled = false;
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> textureViewVersions{}; // view version each frame's descriptor sets hold
+
+	BindlessTable bindless;
+	bool bindlessEnabled = false;            // --descriptors=bindless on a device with descriptor indexing
+	std::array<BindlessFrame, MAX_FRAMES_IN_FLIGHT> bindlessFrames;
+	uint32_t textureSlot = 0;                // the texture in the bindless image array
+	uint64_t textureSlotVersion = 0;         // streamed view version textureSlot holds
+	glm::mat4 bindlessViewProj{ 1.0f };
+	std::vector<DrawBatch> drawBatches;
+
+	MeshData mesh;
+	VertexLayout vertexLayout;
+	EncodedVertices encodedVertices;
+	PackedIndices packedIndices;
+	bool uint8IndicesEnabled = false;
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletRange> lodMeshlets;
+	float meshRadius = 0.0f;
 
 	vk::raii::Buffer vertexBuffer = nullptr;
 	vk::raii::DeviceMemory vertexBufferMemory = nullptr;
 	vk::raii::Buffer indexBuffer = nullptr;
 	vk::raii::DeviceMemory indexBufferMemory = nullptr;
 
-	std::array<GameObject, MAX_OBJECTS> gameObjects;
+	std::vector<GameObject> gameObjects;
 
 	vk::raii::DescriptorPool descriptorPool = nullptr;
+	std::vector<vk::raii::DescriptorSet> frameDescriptorSets;   // classic path, one per frame in flight
+	UniformArena uniformArena;
+	uint32_t frameUniformOffset = 0;
 
 	vk::raii::CommandPool commandPool = nullptr;
-	std::vector<vk::raii::CommandBuffer> commandBuffers;
+	CommandCache<RecordedCommands> commandCache;
 	uint32_t graphicsIndex = 0;
 
 	std::vector<vk::raii::Semaphore> presentCompleteSemaphores;
@@ -2092,6 +3020,15 @@ private:
 	uint32_t semaphoreIndex = 0;
 	uint32_t currentFrame = 0;
 
+	GpuProfiler gpuProfiler;
+	MeshletCuller meshletCuller;
+	DepthPyramid depthPyramid;
+	RenderGraph frameGraph;                  // declared again by every recording
+	bool meshletCullingSupported = false;
+	bool inheritedStatistics = false;        // inheritedQueries, with pipeline statistics
+	std::unique_ptr<ThreadPool> recordPool;  // records large passes into secondary command buffers
+	BenchmarkRun benchmark;
+
 	bool framebufferResized = false;
 
 	std::vector<const char*> requiredDeviceExtension = {
@@ -2103,12 +3040,12 @@ private:
 
 };
 
-int main3()
+int runTriangle(const BenchmarkOptions& options)
 {
 	try
 	{
 		Triangle triangle;
-		triangle.run();
+		triangle.run(options);
 	}
 	catch (const std::exception& e)
 	{
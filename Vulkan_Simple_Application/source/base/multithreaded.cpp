@@ -30,6 +30,12 @@ import vulkan_hpp;
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "core/cpuTracer.h"
+#include "core/gpuProfiler.h"
+#include "core/benchmark.h"
+#include "core/taskGraph.h"
+#include "core/renderGraph.h"
+
 constexpr uint32_t WIDTH = 800;
 constexpr uint32_t HEIGHT = 600;
 constexpr uint64_t FenceTimeout = 100000000;
@@ -81,6 +87,7 @@ public:
         std::lock_guard<std::mutex> lock(resourceMutex);
 
         commandBuffers.clear();
+        secondaryCommandBuffers.clear();
         commandPools.clear();
 
         for (uint32_t i = 0; i < threadCount; i++)
@@ -140,6 +147,37 @@ public:
         }
     }
 
+    // One secondary per thread, from the thread's own pool, for the graphics work the thread records
+    void allocateSecondaryCommandBuffers(vk::raii::Device& device, uint32_t threadCount)
+    {
+        std::lock_guard lock(resourceMutex);
+
+        secondaryCommandBuffers.clear();
+
+        if (commandPools.size() < threadCount)
+            throw std::runtime_error("Not enough command pools for thread count");
+
+        for (uint32_t i = 0; i < threadCount; i++)
+        {
+            vk::CommandBufferAllocateInfo allocInfo
+            {
+                .commandPool = *commandPools[i],
+                .level = vk::CommandBufferLevel::eSecondary,
+                .commandBufferCount = 1
+            };
+
+            secondaryCommandBuffers.emplace_back(std::move(device.allocateCommandBuffers(allocInfo).front()));
+        }
+    }
+
+    vk::raii::CommandBuffer& getSecondaryCommandBuffer(uint32_t threadIndex)
+    {
+        if (threadIndex >= secondaryCommandBuffers.size())
+            throw std::runtime_error("Secondary command buffer index out of range: " + std::to_string(threadIndex));
+
+        return secondaryCommandBuffers[threadIndex];
+    }
+
     vk::raii::CommandBuffer& getCommandBuffer(uint32_t index) 
     {
         // No need for mutex here as each thread accesses its own command buffer
@@ -154,16 +192,22 @@ private:
     std::mutex resourceMutex;
     std::vector<vk::raii::CommandPool> commandPools;
     std::vector<vk::raii::CommandBuffer> commandBuffers;
+    std::vector<vk::raii::CommandBuffer> secondaryCommandBuffers;
 };
 
 class Multithreaded
 {
 public:
-    void run()
+    void run(const BenchmarkOptions& options = BenchmarkOptions())
     {
+        benchmark = BenchmarkRun(options);
+        benchmark.beginStartup();
         initWindow();
+        benchmark.startupPhase("window");
         initVulkan();
         initThreads();
+        benchmark.startupPhase("threads");
+        benchmark.endStartup();
         mainLoop();
         cleanup();
     }
@@ -239,6 +283,7 @@ private:
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_VISIBLE, benchmark.options().headless ? GLFW_FALSE : GLFW_TRUE);
 
         window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan Multithreading", nullptr, nullptr);
         glfwSetWindowUserPointer(window, this);
@@ -249,21 +294,34 @@ private:
     void initVulkan()
     {
         createInstance();
+        benchmark.startupPhase("instance");
         createSurface();
+        benchmark.startupPhase("surface");
         pickPhysicalDevice();
         createLogicalDevice();
+        benchmark.startupPhase("device");
+        // Queries the framebuffer size, which GLFW only allows on the main thread
         createSwapChain();
         createImageViews();
-        createComputeDescriptorSetLayout();
-        createGraphicsPipeline();
-        createComputePipeline();
-        createCommandPool();
-        createShaderStorageBuffers();
-        createUniformBuffers();
-        createDescriptorPool();
-        createComputeDescriptorSets();
-        createGraphicsCommandBuffers();
-        createSyncObjects();
+        benchmark.startupPhase("swapchain");
+
+        // Both pipelines build while the particles are generated and uploaded
+        TaskGraph startup;
+        auto layoutTask = startup.add("descriptor_layout", [this]() { createComputeDescriptorSetLayout(); });
+        startup.add("graphics_pipeline", [this]() { createGraphicsPipeline(); });
+        startup.add("compute_pipeline", [this]() { createComputePipeline(); }, { layoutTask });
+        auto commandPoolTask = startup.add("command_pool", [this]() { createCommandPool(); });
+        auto storageTask = startup.add("storage_buffers", [this]() { createShaderStorageBuffers(); }, { commandPoolTask });
+        auto uniformTask = startup.add("uniform_buffers", [this]() { createUniformBuffers(); });
+        startup.add("descriptors", [this]() { createDescriptorPool(); createComputeDescriptorSets(); }, { layoutTask, storageTask, uniformTask });
+        // Allocates from the pool the particle upload uses, so it waits for it
+        startup.add("command_buffers", [this]() { createGraphicsCommandBuffers(); createSyncObjects(); }, { commandPoolTask, storageTask });
+
+        ThreadPool startupPool;
+        startup.run(startupPool);
+
+        for (const auto& task : startup.taskTimings())
+            benchmark.startupPhase(task.name, task.begin, task.end);
     }
 
     void initThreads()
@@ -306,6 +364,8 @@ private:
 
     void workerThreadFunc(uint32_t threadIndex)
     {
+        CpuTracer::instance().setThreadName("worker " + std::to_string(threadIndex));
+
         while (!shouldExit)
         {
             // Wait for work using condition variable
@@ -330,9 +390,16 @@ private:
 
             try
             {
-                // Get command buffer and record commands
-                vk::raii::CommandBuffer* cmdBuffer = &resourceManager.getCommandBuffer(threadIndex);
-                recordComputeCommandBuffer(*cmdBuffer, group.startIndex, group.count);
+                {
+                    VSA_TRACE_ZONE("record_compute");
+                    // Get command buffer and record commands
+                    vk::raii::CommandBuffer* cmdBuffer = &resourceManager.getCommandBuffer(threadIndex);
+                    recordComputeCommandBuffer(*cmdBuffer, group.startIndex, group.count);
+                }
+                {
+                    VSA_TRACE_ZONE("record_graphics");
+                    recordParticleDraws(resourceManager.getSecondaryCommandBuffer(threadIndex), group.startIndex, group.count);
+                }
                 workCompleted = true;
             }
             catch (const std::exception&)
@@ -360,22 +427,30 @@ private:
     {
         const double targetFrameTime = 1.0 / 60.0;
 
-        while (!glfwWindowShouldClose(window))
+        while (!glfwWindowShouldClose(window) && !benchmark.finished())
         {
             double frameStartTime = glfwGetTime();
 
-            glfwPollEvents();
-            drawFrame();
+            {
+                VSA_TRACE_ZONE("frame");
+                glfwPollEvents();
+                drawFrame();
+            }
+
+            if (benchmark.endFrame())
+                gpuProfiler.resetStatistics();
 
             double currentTime = glfwGetTime();
-            lastFrameTime = (currentTime - lastTime) * 1000.0;
+            lastFrameTime = benchmark.simulationStepMs((currentTime - lastTime) * 1000.0);
             lastTime = currentTime;
 
             double frameTime = currentTime - frameStartTime;
 
-            if (frameTime < targetFrameTime)
+            // Benchmarks measure the unthrottled frame rate
+            if (frameTime < targetFrameTime && !benchmark.active())
             {
                 double sleepTime = targetFrameTime - frameTime;
+                VSA_TRACE_ZONE("frame_pacing");
                 std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
             }
         }
@@ -436,11 +511,15 @@ private:
     {
         resourceManager.createThreadCommandPools(device, queueIndex, threadCount);
         resourceManager.allocateCommandBuffers(device, threadCount, 1);
+        resourceManager.allocateSecondaryCommandBuffers(device, threadCount);
     }
 
     void cleanup()
     {
         stopThreads();
+        gpuProfiler.exportFromEnvironment();
+        CpuTracer::instance().exportFromEnvironment();
+        benchmark.writeReport(gpuProfiler.toJson("  "));
 
         glfwDestroyWindow(window);
         glfwTerminate();
@@ -536,12 +615,19 @@ private:
         if (queueIndex == ~0)
             throw std::runtime_error("Could not find a queue for graphics and present -> terminating");
 
+        // Every supported core feature is enabled, pipelineStatisticsQuery included when present
         auto features = physicalDevice.getFeatures2();
         features.features.samplerAnisotropy = vk::True;
+        bool pipelineStatisticsSupported = features.features.pipelineStatisticsQuery;
+        // Lets the particles pass keep its statistics query active around the workers' secondaries
+        inheritedStatistics = pipelineStatisticsSupported && features.features.inheritedQueries;
         vk::PhysicalDeviceVulkan13Features vulkan13Features;
         vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures;
         vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR timelineSemaphoreFeatures;
+        vk::PhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures;
         timelineSemaphoreFeatures.timelineSemaphore = vk::True;
+        timelineSemaphoreFeatures.pNext = &hostQueryResetFeatures;
+        hostQueryResetFeatures.hostQueryReset = vk::True; // GPU profiler resets its queries from the host
         vulkan13Features.dynamicRendering = vk::True;
         vulkan13Features.synchronization2 = vk::True;
         extendedDynamicStateFeatures.extendedDynamicState = vk::True;
@@ -568,6 +654,12 @@ private:
 
         device = vk::raii::Device(physicalDevice, deviceCreateInfo);
         queue = vk::raii::Queue(device, queueIndex, 0);
+
+        gpuProfiler.init(physicalDevice, device, queueIndex, MAX_FRAMES_IN_FLIGHT, pipelineStatisticsSupported);
+        gpuProfiler.calibrate(device, queue);
+
+        auto deviceProperties = physicalDevice.getProperties();
+        benchmark.setDevice(deviceProperties.deviceName, deviceProperties.driverVersion);
     }
 
     void createSwapChain()
@@ -754,8 +846,6 @@ private:
 
     void createComputePipeline()
     {
-        vk::raii::ShaderModule shaderModule = createShaderModule(readFile("shaders/slang.spv"));
-
         // Create push constant range for particle group information
         vk::PushConstantRange pushConstantRange
         {
@@ -764,7 +854,6 @@ private:
             .size = sizeof(uint32_t) * 2  // startIndex and count
         };
 
-        vk::PipelineShaderStageCreateInfo computeShaderStageInfo{ .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "compMain" };
         vk::PipelineLayoutCreateInfo pipelineLayoutInfo
         {
             .setLayoutCount = 1,
@@ -774,6 +863,9 @@ private:
         };
 
         computePipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
+
+        vk::raii::ShaderModule shaderModule = createShaderModule(readFile("shaders/slang.spv"));
+        vk::PipelineShaderStageCreateInfo computeShaderStageInfo{ .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "compMain" };
         vk::ComputePipelineCreateInfo pipelineInfo{ .stage = computeShaderStageInfo, .layout = *computePipelineLayout };
         computePipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
     }
@@ -788,7 +880,7 @@ private:
 
     void createShaderStorageBuffers()
     {
-        std::default_random_engine rndEngine(static_cast<unsigned>(time(nullptr)));
+        std::default_random_engine rndEngine(benchmark.options().seed);
         std::uniform_real_distribution rndDist(0.0f, 1.0f);
 
         std::vector<Particle> particles(PARTICLE_COUNT);
@@ -977,19 +1069,56 @@ private:
         };
         cmdBuffer.begin(beginInfo);
 
-        cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *computePipeline);
-        cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipelineLayout, 0, { *computeDescriptorSets[currentFrame] }, {});
-
-        struct PushConstants
         {
-            uint32_t startIndex;
-            uint32_t count;
-        } pushConstants{ startIndex, count };
+            // Workers record concurrently, the profiler hands out query slots atomically
+            auto computeScope = gpuProfiler.scope(cmdBuffer, "compute_group", true);
+
+            cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *computePipeline);
+            cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *computePipelineLayout, 0, { *computeDescriptorSets[currentFrame] }, {});
 
-        cmdBuffer.pushConstants<PushConstants>(*computePipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, pushConstants);
+            struct PushConstants
+            {
+                uint32_t startIndex;
+                uint32_t count;
+            } pushConstants{ startIndex, count };
+
+            cmdBuffer.pushConstants<PushConstants>(*computePipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, pushConstants);
 
-        uint32_t groupCount = (count + 255) / 256;
-        cmdBuffer.dispatch(groupCount, 1, 1);
+            uint32_t groupCount = (count + 255) / 256;
+            cmdBuffer.dispatch(groupCount, 1, 1);
+        }
+
+        cmdBuffer.end();
+    }
+
+    // The draw of one particle group, executed by the particles pass of the primary in group order.
+    void recordParticleDraws(vk::raii::CommandBuffer& cmdBuffer, uint32_t startIndex, uint32_t count)
+    {
+        cmdBuffer.reset();
+
+        // Secondaries inherit the attachment formats, nothing else: pipeline and dynamic state are set here
+        vk::CommandBufferInheritanceRenderingInfo renderingInheritance
+        {
+            .colorAttachmentCount = 1,
+            .pColorAttachmentFormats = &swapChainImageFormat.format,
+            .rasterizationSamples = vk::SampleCountFlagBits::e1
+        };
+        vk::CommandBufferInheritanceInfo inheritance
+        {
+            .pNext = &renderingInheritance,
+            .pipelineStatistics = inheritedStatistics ? GpuProfiler::pipelineStatisticFlags() : vk::QueryPipelineStatisticFlags()
+        };
+        cmdBuffer.begin(vk::CommandBufferBeginInfo
+            {
+                .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue,
+                .pInheritanceInfo = &inheritance
+            });
+
+        cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
+        cmdBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+        cmdBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+        cmdBuffer.bindVertexBuffers(0, { shaderStorageBuffers[currentFrame] }, { 0 });
+        cmdBuffer.draw(count, 1, startIndex, 0);
 
         cmdBuffer.end();
     }
@@ -1005,16 +1134,6 @@ private:
 
         graphicsCommandBuffers[currentFrame].begin(beginInfo);
 
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eUndefined,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            {},
-            vk::AccessFlagBits2::eColorAttachmentWrite,
-            vk::PipelineStageFlagBits2::eTopOfPipe,
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput
-        );
-
         vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
         vk::RenderingAttachmentInfo attachmentInfo = {
             .imageView = swapChainImageViews[imageIndex],
@@ -1024,70 +1143,37 @@ private:
             .clearValue = clearColor
         };
         vk::RenderingInfo renderingInfo = {
+            .flags = vk::RenderingFlagBits::eContentsSecondaryCommandBuffers,
             .renderArea = {.offset = { 0, 0 }, .extent = swapChainExtent },
             .layerCount = 1,
             .colorAttachmentCount = 1,
             .pColorAttachments = &attachmentInfo
         };
 
-        graphicsCommandBuffers[currentFrame].beginRendering(renderingInfo);
-
-        graphicsCommandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
-        graphicsCommandBuffers[currentFrame].setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
-        graphicsCommandBuffers[currentFrame].setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
-        graphicsCommandBuffers[currentFrame].bindVertexBuffers(0, { shaderStorageBuffers[currentFrame] }, { 0 });
-        graphicsCommandBuffers[currentFrame].draw(PARTICLE_COUNT, 1, 0, 0);
-        graphicsCommandBuffers[currentFrame].endRendering();
-
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            vk::ImageLayout::ePresentSrcKHR,
-            vk::AccessFlagBits2::eColorAttachmentWrite,
-            {},
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-            vk::PipelineStageFlagBits2::eBottomOfPipe
-        );
+        // The workers recorded the draws of their particle groups; group order keeps the blend order
+        std::vector<vk::CommandBuffer> particleDraws;
+        particleDraws.reserve(threadCount);
+        for (uint32_t i = 0; i < threadCount; i++)
+            particleDraws.push_back(*resourceManager.getSecondaryCommandBuffer(i));
 
-        graphicsCommandBuffers[currentFrame].end();
-    }
+        // The swapchain image is the graph's only resource; the particle data is ordered by the compute semaphore.
+        // The acquire semaphore is waited on at the color output stage, and the image is cleared anyway
+        frameGraph.reset();
+        RenderGraph::Resource color = frameGraph.importImage("swapchain", swapChainImages[imageIndex], { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+            { vk::PipelineStageFlagBits2::eColorAttachmentOutput, {}, vk::ImageLayout::eUndefined }, RenderGraph::present());
 
-    void transition_image_layout(
-        uint32_t imageIndex,
-        vk::ImageLayout old_layout,
-        vk::ImageLayout new_layout,
-        vk::AccessFlags2 src_access_mask,
-        vk::AccessFlags2 dst_access_mask,
-        vk::PipelineStageFlags2 src_stage_mask,
-        vk::PipelineStageFlags2 dst_stage_mask
-    )
-    {
-        vk::ImageMemoryBarrier2 barrier = {
-            .srcStageMask = src_stage_mask,
-            .srcAccessMask = src_access_mask,
-            .dstStageMask = dst_stage_mask,
-            .dstAccessMask = dst_access_mask,
-            .oldLayout = old_layout,
-            .newLayout = new_layout,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = swapChainImages[imageIndex],
-            .subresourceRange = {
-                .aspectMask = vk::ImageAspectFlagBits::eColor,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            }
-        };
-
-        vk::DependencyInfo dependency_info = {
-            .dependencyFlags = {},
-            .imageMemoryBarrierCount = 1,
-            .pImageMemoryBarriers = &barrier
-        };
+        uint32_t particlesPass = frameGraph.addPass("particles_pass", [&](const vk::raii::CommandBuffer& commandBuffer)
+            {
+                // Statistics queries may only stay active around secondaries that inherit them
+                auto passScope = gpuProfiler.scope(commandBuffer, "particles_pass", inheritedStatistics);
+                commandBuffer.beginRendering(renderingInfo);
+                commandBuffer.executeCommands(particleDraws);
+                commandBuffer.endRendering();
+            });
+        frameGraph.write(particlesPass, color, RenderGraph::colorAttachment());
 
-        graphicsCommandBuffers[currentFrame].pipelineBarrier2(dependency_info);
+        frameGraph.execute(graphicsCommandBuffers[currentFrame]);
+        graphicsCommandBuffers[currentFrame].end();
     }
 
     void signalThreadsToWork()
@@ -1158,24 +1244,44 @@ private:
 
     void drawFrame()
     {
-        while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX))
-            ;
+        {
+            VSA_TRACE_ZONE("wait_fence");
+            while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX))
+                ;
+        }
         device.resetFences(*inFlightFences[currentFrame]);
 
-        auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, *imageAvailableSemaphores[currentFrame], nullptr);
+        // Must run before the workers start recording this frame's scopes
+        gpuProfiler.beginFrame(currentFrame);
+
+        auto [result, imageIndex] = [&]
+            {
+                VSA_TRACE_ZONE("acquire");
+                return swapChain.acquireNextImage(UINT64_MAX, *imageAvailableSemaphores[currentFrame], nullptr);
+            }();
 
         uint64_t computeWaitValue = timelineValue;
         uint64_t computeSignalValue = ++timelineValue;
         uint64_t graphicsWaitValue = computeSignalValue;
         uint64_t graphicsSignalValue = ++timelineValue;
 
-        updateUniformBuffer(currentFrame);
+        {
+            VSA_TRACE_ZONE("update_ubo");
+            updateUniformBuffer(currentFrame);
+        }
 
         signalThreadsToWork();
 
-        recordGraphicsCommandBuffer(imageIndex);
+        {
+            VSA_TRACE_ZONE("wait_workers");
+            waitForThreadsToComplete();
+        }
 
-        waitForThreadsToComplete();
+        // Executes the particle draws the workers recorded
+        {
+            VSA_TRACE_ZONE("record");
+            recordGraphicsCommandBuffer(imageIndex);
+        }
 
         std::vector<vk::CommandBuffer> computeCmdBuffers;
         computeCmdBuffers.reserve(threadCount);
@@ -1214,6 +1320,7 @@ private:
 
         // Submit compute work
         {
+            VSA_TRACE_ZONE("submit_compute");
             std::lock_guard<std::mutex> lock(queueSubmitMutex);
             queue.submit(computeSubmitInfo, nullptr);
         }
@@ -1246,6 +1353,7 @@ private:
 
         // Submit graphics work
         {
+            VSA_TRACE_ZONE("submit");
             std::lock_guard<std::mutex> lock(queueSubmitMutex);
             queue.submit(graphicsSubmitInfo, *inFlightFences[currentFrame]);
         }
@@ -1258,7 +1366,11 @@ private:
             .pValues = &graphicsSignalValue
         };
 
-        auto waitResult = device.waitSemaphores(waitInfo, 5000000000);
+        auto waitResult = [&]
+            {
+                VSA_TRACE_ZONE("wait_graphics");
+                return device.waitSemaphores(waitInfo, 5000000000);
+            }();
         if (waitResult == vk::Result::eTimeout)
         {
             device.waitIdle();
@@ -1275,7 +1387,10 @@ private:
             .pImageIndices = &imageIndex
         };
 
-        result = queue.presentKHR(presentInfo);
+        {
+            VSA_TRACE_ZONE("present");
+            result = queue.presentKHR(presentInfo);
+        }
 
         // Move to the next frame
         currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -1304,6 +1419,11 @@ private:
     vk::raii::PipelineLayout computePipelineLayout = nullptr;
     vk::raii::Pipeline computePipeline = nullptr;
 
+    GpuProfiler gpuProfiler;
+    RenderGraph frameGraph;
+    bool inheritedStatistics = false;
+    BenchmarkRun benchmark;
+
     std::vector<vk::raii::Buffer> shaderStorageBuffers;
     std::vector<vk::raii::DeviceMemory> shaderStorageBuffersMemory;
 
@@ -1354,12 +1474,12 @@ private:
 };
 
 
-int main()
+int runMultithreaded(const BenchmarkOptions& options)
 {
     try 
     {
         Multithreaded multi;
-        multi.run();
+        multi.run(options);
     }
     catch (const std::exception& e) 
     {
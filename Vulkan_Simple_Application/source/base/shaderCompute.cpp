@@ -26,6 +26,13 @@ import vulkan_hpp;
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "core/cpuTracer.h"
+#include "core/gpuProfiler.h"
+#include "core/benchmark.h"
+#include "core/taskGraph.h"
+#include "core/renderGraph.h"
+#include "core/workgroupTuner.h"
+
 constexpr uint32_t WIDTH = 800;
 constexpr uint32_t HEIGHT = 600;
 constexpr uint64_t FenceTimeout = 100000000;
@@ -71,10 +78,14 @@ struct Particle
 class ComputeShader
 {
 public:
-    void run()
+    void run(const BenchmarkOptions& options = BenchmarkOptions())
     {
+        benchmark = BenchmarkRun(options);
+        benchmark.beginStartup();
         initWindow();
+        benchmark.startupPhase("window");
         initVulkan();
+        benchmark.endStartup();
         mainLoop();
         cleanup();
     }
@@ -85,6 +96,7 @@ private:
         glfwInit();
 
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+        glfwWindowHint(GLFW_VISIBLE, benchmark.options().headless ? GLFW_FALSE : GLFW_TRUE);
 
         window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
         glfwSetWindowUserPointer(window, this);
@@ -101,33 +113,55 @@ private:
     {
         createInstance();
         setupDebugMessenger();
+        benchmark.startupPhase("instance");
         createSurface();
+        benchmark.startupPhase("surface");
         pickPhysicalDevice();
         createLogicalDevice();
+        benchmark.startupPhase("device");
+        // Queries the framebuffer size, which GLFW only allows on the main thread
         createSwapChain();
         createImageViews();
-        createComputeDescriptorSetLayout();
-        createGraphicsPipeline();
-        createComputePipeline();
-        createCommandPool();
-        createShaderStorageBuffers();
-        createUniformBuffers();
-        createDescriptorPool();
-        createComputeDescriptorSets();
-        createCommandBuffers();
-        createComputeCommandBuffers();
-        createSyncObjects();
+        benchmark.startupPhase("swapchain");
+
+        // Both pipelines build while the particles are generated and uploaded
+        TaskGraph startup;
+        auto layoutTask = startup.add("descriptor_layout", [this]() { createComputeDescriptorSetLayout(); });
+        startup.add("graphics_pipeline", [this]() { createGraphicsPipeline(); });
+        auto computePipelineTask = startup.add("compute_pipeline", [this]() { createComputePipeline(); }, { layoutTask });
+        auto commandPoolTask = startup.add("command_pool", [this]() { createCommandPool(); });
+        auto storageTask = startup.add("storage_buffers", [this]() { createShaderStorageBuffers(); }, { commandPoolTask });
+        auto uniformTask = startup.add("uniform_buffers", [this]() { createUniformBuffers(); });
+        auto descriptorTask = startup.add("descriptors", [this]() { createDescriptorPool(); createComputeDescriptorSets(); }, { layoutTask, storageTask, uniformTask });
+        startup.add("autotune", [this]() { tuneComputeWorkgroupSize(); }, { computePipelineTask, descriptorTask });
+        // Allocates from the pool the particle upload uses, so it waits for it
+        startup.add("command_buffers", [this]()
+            {
+                createCommandBuffers();
+                createComputeCommandBuffers();
+                createSyncObjects();
+            }, { commandPoolTask, storageTask });
+
+        ThreadPool startupPool;
+        startup.run(startupPool);
+
+        for (const auto& task : startup.taskTimings())
+            benchmark.startupPhase(task.name, task.begin, task.end);
     }
 
     void mainLoop()
     {
-        while (!glfwWindowShouldClose(window)) 
+        while (!glfwWindowShouldClose(window) && !benchmark.finished()) 
         {
+            VSA_TRACE_ZONE("frame");
             glfwPollEvents();
             drawFrame();
 
+            if (benchmark.endFrame())
+                gpuProfiler.resetStatistics();
+
             double currentTime = glfwGetTime();
-            lastFrameTime = (currentTime - lastTime) * 1000.0;
+            lastFrameTime = benchmark.simulationStepMs((currentTime - lastTime) * 1000.0);
             lastTime = currentTime;
         }
 
@@ -142,6 +176,10 @@ private:
 
     void cleanup() const 
     {
+        gpuProfiler.exportFromEnvironment();
+        CpuTracer::instance().exportFromEnvironment();
+        benchmark.writeReport(gpuProfiler.toJson("  "));
+
         glfwDestroyWindow(window);
 
         glfwTerminate();
@@ -298,16 +336,20 @@ private:
         if (queueIndex == ~0)
             throw std::runtime_error("Could not find a queue for graphics and present -> terminating");
 
+        bool pipelineStatisticsSupported = physicalDevice.getFeatures().pipelineStatisticsQuery;
+
         // query for Vulkan 1.3 features
         vk::StructureChain<vk::PhysicalDeviceFeatures2,
             vk::PhysicalDeviceVulkan13Features,
             vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT,
-            vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR>
+            vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR,
+            vk::PhysicalDeviceHostQueryResetFeatures>
             featureChain = {
-              {.features = {.samplerAnisotropy = true } },           // vk::PhysicalDeviceFeatures2
-              {.synchronization2 = true, .dynamicRendering = true },  // vk::PhysicalDeviceVulkan13Features
+              {.features = {.samplerAnisotropy = true, .pipelineStatisticsQuery = pipelineStatisticsSupported } }, // vk::PhysicalDeviceFeatures2
+              {.synchronization2 = true, .dynamicRendering = true, .maintenance4 = true },  // vk::PhysicalDeviceVulkan13Features (maintenance4 for LocalSizeId)
               {.extendedDynamicState = true },                        // vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
-              {.timelineSemaphore = true }                            // vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR
+              {.timelineSemaphore = true },                           // vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR
+              {.hostQueryReset = true }                               // vk::PhysicalDeviceHostQueryResetFeatures (GPU profiler)
         };
 
         // create a Device
@@ -330,6 +372,12 @@ private:
 
         device = vk::raii::Device(physicalDevice, deviceCreateInfo);
         queue = vk::raii::Queue(device, queueIndex, 0);
+
+        gpuProfiler.init(physicalDevice, device, queueIndex, MAX_FRAMES_IN_FLIGHT, pipelineStatisticsSupported);
+        gpuProfiler.calibrate(device, queue);
+
+        auto deviceProperties = physicalDevice.getProperties();
+        benchmark.setDevice(deviceProperties.deviceName, deviceProperties.driverVersion);
     }
 
     void createSwapChain() 
@@ -508,14 +556,6 @@ private:
 
     void createComputePipeline() 
     {
-        vk::raii::ShaderModule shaderModule = createShaderModule(readFile("resources/shaders/compute/slang_compute.spv"));
-
-        vk::PipelineShaderStageCreateInfo computeShaderStageInfo
-        { 
-            .stage = vk::ShaderStageFlagBits::eCompute, 
-            .module = shaderModule, .pName = "compMain" 
-        };
-
         vk::PipelineLayoutCreateInfo pipelineLayoutInfo
         {
             .setLayoutCount = 1, 
@@ -524,13 +564,76 @@ private:
 
         computePipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
 
+        WorkgroupTuner tuner(physicalDevice);
+        computeWorkgroupSize = tuner.cachedOr(computePipelineKey());
+        computePipeline = buildComputePipeline(computeWorkgroupSize);
+    }
+
+    [[nodiscard]] vk::raii::Pipeline buildComputePipeline(uint32_t workgroupSize) const
+    {
+        vk::raii::ShaderModule shaderModule = createShaderModule(readFile("resources/shaders/compute/slang_compute.spv"));
+
+        vk::SpecializationMapEntry specializationEntry
+        {
+            .constantID = WORKGROUP_SIZE_CONSTANT_ID,
+            .offset = 0,
+            .size = sizeof(uint32_t)
+        };
+
+        vk::SpecializationInfo specializationInfo
+        {
+            .mapEntryCount = 1,
+            .pMapEntries = &specializationEntry,
+            .dataSize = sizeof(uint32_t),
+            .pData = &workgroupSize
+        };
+
+        vk::PipelineShaderStageCreateInfo computeShaderStageInfo
+        { 
+            .stage = vk::ShaderStageFlagBits::eCompute, 
+            .module = shaderModule, .pName = "compMain",
+            .pSpecializationInfo = &specializationInfo
+        };
+
         vk::ComputePipelineCreateInfo pipelineInfo
         {
             .stage = computeShaderStageInfo, 
             .layout = *computePipelineLayout 
         };
 
-        computePipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+        return vk::raii::Pipeline(device, nullptr, pipelineInfo);
+    }
+
+    static std::string computePipelineKey()
+    {
+        return "particles_" + std::to_string(PARTICLE_COUNT);
+    }
+
+    void tuneComputeWorkgroupSize()
+    {
+        if (!WorkgroupTuner::autotuneRequested())
+            return;
+
+        // deltaTime 0 so the tuning dispatches leave the particles where they are
+        UniformBufferObject ubo{ .deltaTime = 0.0f };
+        for (void* mapped : uniformBuffersMapped)
+            memcpy(mapped, &ubo, sizeof(ubo));
+
+        WorkgroupTuner tuner(physicalDevice);
+        computeWorkgroupSize = tuner.tune(computePipelineKey(), device, queue, queueIndex,
+            physicalDevice.getQueueFamilyProperties()[queueIndex].timestampValidBits,
+            [this](uint32_t workgroupSize)
+            {
+                return buildComputePipeline(workgroupSize);
+            },
+            [this](const vk::raii::CommandBuffer& commandBuffer, const vk::raii::Pipeline& pipeline, uint32_t workgroupSize)
+            {
+                commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+                commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineLayout, 0, { computeDescriptorSets[0] }, {});
+                commandBuffer.dispatch(WorkgroupTuner::groupCount(PARTICLE_COUNT, workgroupSize), 1, 1);
+            });
+
+        computePipeline = buildComputePipeline(computeWorkgroupSize);
     }
 
     void createCommandPool() 
@@ -543,7 +646,7 @@ private:
 
     void createShaderStorageBuffers() 
     {
-        std::default_random_engine rndEngine(static_cast<unsigned>(time(nullptr)));
+        std::default_random_engine rndEngine(benchmark.options().seed);
         std::uniform_real_distribution rndDist(0.0f, 1.0f);
 
         std::vector<Particle> particles(PARTICLE_COUNT);
@@ -725,16 +828,6 @@ private:
         commandBuffers[currentFrame].reset();
         commandBuffers[currentFrame].begin({});
 
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eUndefined,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            {},                                                     // srcAccessMask (no need to wait for previous operations)
-            vk::AccessFlagBits2::eColorAttachmentWrite,                // dstAccessMask
-            vk::PipelineStageFlagBits2::eTopOfPipe,                   // srcStage
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput        // dstStage
-        );
-
         vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
         vk::RenderingAttachmentInfo attachmentInfo = 
         {
@@ -755,72 +848,39 @@ private:
             .pColorAttachments = &attachmentInfo
         };
 
-        commandBuffers[currentFrame].beginRendering(renderingInfo);
-        commandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
-        commandBuffers[currentFrame].setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
-        commandBuffers[currentFrame].setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
-        commandBuffers[currentFrame].bindVertexBuffers(0, { shaderStorageBuffers[currentFrame] }, { 0 });
-        commandBuffers[currentFrame].draw(PARTICLE_COUNT, 1, 0, 0);
-        commandBuffers[currentFrame].endRendering();
-
-        transition_image_layout(
-            imageIndex,
-            vk::ImageLayout::eColorAttachmentOptimal,
-            vk::ImageLayout::ePresentSrcKHR,
-            vk::AccessFlagBits2::eColorAttachmentWrite,                 // srcAccessMask
-            {},                                                      // dstAccessMask
-            vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // srcStage
-            vk::PipelineStageFlagBits2::eBottomOfPipe                  // dstStage
-        );
-
-        commandBuffers[currentFrame].end();
-    }
+        // The swapchain image is the graph's only resource; the particle data is ordered by the compute semaphore.
+        // The image was acquired with a fence the host has waited on, and it is cleared anyway
+        frameGraph.reset();
+        RenderGraph::Resource color = frameGraph.importImage("swapchain", swapChainImages[imageIndex], { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+            { vk::PipelineStageFlagBits2::eNone, {}, vk::ImageLayout::eUndefined }, RenderGraph::present());
 
-    void transition_image_layout(
-        uint32_t imageIndex,
-        vk::ImageLayout old_layout,
-        vk::ImageLayout new_layout,
-        vk::AccessFlags2 src_access_mask,
-        vk::AccessFlags2 dst_access_mask,
-        vk::PipelineStageFlags2 src_stage_mask,
-        vk::PipelineStageFlags2 dst_stage_mask
-    ) 
-    {
-        vk::ImageMemoryBarrier2 barrier =
-        {
-            .srcStageMask = src_stage_mask,
-            .srcAccessMask = src_access_mask,
-            .dstStageMask = dst_stage_mask,
-            .dstAccessMask = dst_access_mask,
-            .oldLayout = old_layout,
-            .newLayout = new_layout,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .image = swapChainImages[imageIndex],
-            .subresourceRange = {
-                .aspectMask = vk::ImageAspectFlagBits::eColor,
-                .baseMipLevel = 0,
-                .levelCount = 1,
-                .baseArrayLayer = 0,
-                .layerCount = 1
-            }
-        };
+        uint32_t particlesPass = frameGraph.addPass("particles_pass", [&](const vk::raii::CommandBuffer& commandBuffer)
+            {
+                auto passScope = gpuProfiler.scope(commandBuffer, "particles_pass", true);
+                commandBuffer.beginRendering(renderingInfo);
+                commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
+                commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+                commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+                commandBuffer.bindVertexBuffers(0, { shaderStorageBuffers[currentFrame] }, { 0 });
+                commandBuffer.draw(PARTICLE_COUNT, 1, 0, 0);
+                commandBuffer.endRendering();
+            });
+        frameGraph.write(particlesPass, color, RenderGraph::colorAttachment());
 
-        vk::DependencyInfo dependency_info = {
-            .dependencyFlags = {},
-            .imageMemoryBarrierCount = 1,
-            .pImageMemoryBarriers = &barrier
-        };
-        commandBuffers[currentFrame].pipelineBarrier2(dependency_info);
+        frameGraph.execute(commandBuffers[currentFrame]);
+        commandBuffers[currentFrame].end();
     }
 
     void recordComputeCommandBuffer() 
     {
         computeCommandBuffers[currentFrame].reset();
         computeCommandBuffers[currentFrame].begin({});
-        computeCommandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
-        computeCommandBuffers[currentFrame].bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineLayout, 0, { computeDescriptorSets[currentFrame] }, {});
-        computeCommandBuffers[currentFrame].dispatch(PARTICLE_COUNT / 256, 1, 1);
+        {
+            auto computeScope = gpuProfiler.scope(computeCommandBuffers[currentFrame], "particles_compute", true);
+            computeCommandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
+            computeCommandBuffers[currentFrame].bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipelineLayout, 0, { computeDescriptorSets[currentFrame] }, {});
+            computeCommandBuffers[currentFrame].dispatch(WorkgroupTuner::groupCount(PARTICLE_COUNT, computeWorkgroupSize), 1, 1);
+        }
         computeCommandBuffers[currentFrame].end();
     }
 
@@ -854,20 +914,34 @@ private:
 
     void drawFrame() 
     {
-        auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, nullptr, *inFlightFences[currentFrame]);
-        while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX))
-            ;
+        auto [result, imageIndex] = [&]
+            {
+                VSA_TRACE_ZONE("acquire");
+                return swapChain.acquireNextImage(UINT64_MAX, nullptr, *inFlightFences[currentFrame]);
+            }();
+        {
+            VSA_TRACE_ZONE("wait_fence");
+            while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[currentFrame], vk::True, UINT64_MAX))
+                ;
+        }
         device.resetFences(*inFlightFences[currentFrame]);
 
+        // Every frame waits for its graphics work before presenting, so this slot's queries are ready
+        gpuProfiler.beginFrame(currentFrame);
+
         // Update timeline value for this frame
         uint64_t computeWaitValue = timelineValue;
         uint64_t computeSignalValue = ++timelineValue;
         uint64_t graphicsWaitValue = computeSignalValue;
         uint64_t graphicsSignalValue = ++timelineValue;
 
-        updateUniformBuffer(currentFrame);
+        {
+            VSA_TRACE_ZONE("update_ubo");
+            updateUniformBuffer(currentFrame);
+        }
 
         {
+            VSA_TRACE_ZONE("compute");
             recordComputeCommandBuffer();
             // Submit compute work
             vk::TimelineSemaphoreSubmitInfo computeTimelineInfo
@@ -896,7 +970,10 @@ private:
         }
         {
             // Record graphics command buffer
-            recordCommandBuffer(imageIndex);
+            {
+                VSA_TRACE_ZONE("record");
+                recordCommandBuffer(imageIndex);
+            }
 
             // Submit graphics work (waits for compute to finish)
             vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eVertexInput;
@@ -920,7 +997,10 @@ private:
                 .pSignalSemaphores = &*semaphore
             };
 
-            queue.submit(graphicsSubmitInfo, nullptr);
+            {
+                VSA_TRACE_ZONE("submit");
+                queue.submit(graphicsSubmitInfo, nullptr);
+            }
 
             // Present the image (wait for graphics to finish)
             vk::SemaphoreWaitInfo waitInfo
@@ -931,8 +1011,11 @@ private:
             };
 
             // Wait for graphics to complete before presenting
-            while (vk::Result::eTimeout == device.waitSemaphores(waitInfo, UINT64_MAX))
-                ;
+            {
+                VSA_TRACE_ZONE("wait_graphics");
+                while (vk::Result::eTimeout == device.waitSemaphores(waitInfo, UINT64_MAX))
+                    ;
+            }
 
             vk::PresentInfoKHR presentInfo
             {
@@ -943,7 +1026,10 @@ private:
                 .pImageIndices = &imageIndex
             };
 
-            result = queue.presentKHR(presentInfo);
+            {
+                VSA_TRACE_ZONE("present");
+                result = queue.presentKHR(presentInfo);
+            }
             if (result == vk::Result::eErrorOutOfDateKHR || result == vk::Result::eSuboptimalKHR || framebufferResized) {
                 framebufferResized = false;
                 recreateSwapChain();
@@ -1057,6 +1143,11 @@ private:
         vk::raii::DescriptorSetLayout computeDescriptorSetLayout = nullptr;
         vk::raii::PipelineLayout computePipelineLayout = nullptr;
         vk::raii::Pipeline computePipeline = nullptr;
+        uint32_t computeWorkgroupSize = DEFAULT_WORKGROUP_SIZE;
+
+        GpuProfiler gpuProfiler;
+        RenderGraph frameGraph;
+        BenchmarkRun benchmark;
 
 
         std::vector<vk::raii::Buffer> shaderStorageBuffers;
@@ -1092,11 +1183,11 @@ private:
         };
 };
 
-int main1()
+int runComputeShader(const BenchmarkOptions& options)
 {
     try {
         ComputeShader computeShader;
-        computeShader.run();
+        computeShader.run(options);
     }
     catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,617 @@
+#pragma once
+
+// Single-file asset packs, memory-mapped at runtime.
+//
+// Layout:
+//
+//   AssetPackHeader
+//   AssetPackEntry[entryCount]   sorted by name hash
+//   name strings                 not terminated, addressed by nameOffset/nameLength
+//   blobs                        each starting on a 4 KiB boundary
+//
+// Blobs are stored raw or LZ4-block compressed, chosen per blob by the writer (Asset_Cooker --pack).
+// The runtime maps the whole file and never reads it into heap memory: raw blobs are used in place,
+// e.g. copied from the mapping straight into a staging buffer, and compressed ones are decompressed
+// from the mapping into the caller's memory. The 4 KiB alignment keeps every blob page-aligned, so
+// touching one blob only faults in its own pages.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "core/contentHash.h"
+
+constexpr uint32_t ASSET_PACK_MAGIC = 0x50415356; // "VSAP"
+constexpr uint32_t ASSET_PACK_VERSION = 1;
+constexpr uint64_t ASSET_PACK_ALIGNMENT = 4096;
+
+enum class AssetCompression : uint32_t
+{
+	None,
+	Lz4
+};
+
+struct AssetPackHeader
+{
+	uint32_t magic = ASSET_PACK_MAGIC;
+	uint32_t version = ASSET_PACK_VERSION;
+	uint32_t entryCount = 0;
+	uint32_t namesSize = 0;
+};
+
+struct AssetPackEntry
+{
+	uint64_t nameHash = 0;
+	uint64_t offset = 0;     // from the start of the file
+	uint64_t size = 0;       // uncompressed
+	uint64_t storedSize = 0; // bytes in the file
+	uint64_t checksum = 0;   // hashBytes() of the uncompressed data
+	AssetCompression compression = AssetCompression::None;
+	uint32_t nameOffset = 0;
+	uint32_t nameLength = 0;
+	uint32_t reserved = 0;
+};
+
+// LZ4 block format (no frame): byte-compatible with LZ4_compress_default/LZ4_decompress_safe.
+namespace lz4_block
+{
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t LAST_LITERALS = 5;   // the last five bytes are always literals
+	constexpr size_t MATCH_LIMIT = 12;    // no match may start in the last twelve bytes
+	constexpr uint32_t HASH_BITS = 16;
+	constexpr size_t MAX_OFFSET = 65535;
+
+	inline size_t compressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	inline uint32_t read32(const uint8_t* data)
+	{
+		uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	inline uint8_t* writeLength(uint8_t* destination, size_t length)
+	{
+		for (; length >= 255; length -= 255)
+			*destination++ = 255;
+		*destination++ = static_cast<uint8_t>(length);
+		return destination;
+	}
+
+	// Greedy single-probe compression. Returns the compressed size, or 0 when it exceeds capacity.
+	inline size_t compress(const uint8_t* source, size_t size, uint8_t* destination, size_t capacity)
+	{
+		std::vector<uint32_t> table(size_t{ 1 } << HASH_BITS, 0);
+		uint8_t* output = destination;
+		uint8_t* outputEnd = destination + capacity;
+
+		auto emit = [&](size_t anchor, size_t literalCount, size_t offset, size_t matchLength) -> bool
+			{
+				// Worst case for this sequence: token, literal length bytes, literals, offset, match length bytes
+				size_t worst = 1 + literalCount / 255 + 1 + literalCount + 2 + matchLength / 255 + 1;
+				if (static_cast<size_t>(outputEnd - output) < worst)
+					return false;
+
+				uint8_t* token = output++;
+				*token = static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4);
+				if (literalCount >= 15)
+					output = writeLength(output, literalCount - 15);
+
+				if (literalCount > 0)
+					std::memcpy(output, source + anchor, literalCount);
+				output += literalCount;
+
+				if (matchLength == 0)
+					return true; // last sequence: literals only
+
+				*output++ = static_cast<uint8_t>(offset);
+				*output++ = static_cast<uint8_t>(offset >> 8);
+
+				size_t encodedMatch = matchLength - MIN_MATCH;
+				*token |= static_cast<uint8_t>(std::min<size_t>(encodedMatch, 15));
+				if (encodedMatch >= 15)
+					output = writeLength(output, encodedMatch - 15);
+
+				return true;
+			};
+
+		size_t anchor = 0;
+		if (size > MATCH_LIMIT)
+		{
+			size_t matchStartLimit = size - MATCH_LIMIT;
+			size_t matchEndLimit = size - LAST_LITERALS;
+			size_t position = 0;
+			while (position < matchStartLimit)
+			{
+				uint32_t sequence = read32(source + position);
+				uint32_t& slot = table[hash(sequence)];
+				size_t candidate = slot;
+				slot = static_cast<uint32_t>(position);
+
+				if (candidate >= position || position - candidate > MAX_OFFSET || read32(source + candidate) != sequence)
+				{
+					position++;
+					continue;
+				}
+
+				size_t length = MIN_MATCH;
+				while (position + length < matchEndLimit && source[candidate + length] == source[position + length])
+					length++;
+
+				if (!emit(anchor, position - anchor, position - candidate, length))
+					return 0;
+
+				position += length;
+				anchor = position;
+			}
+		}
+
+		if (!emit(anchor, size - anchor, 0, 0))
+			return 0;
+
+		return static_cast<size_t>(output - destination);
+	}
+
+	// Decompresses exactly size bytes into destination; throws on malformed input instead of overrunning.
+	inline void decompress(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t size)
+	{
+		const uint8_t* input = source;
+		const uint8_t* inputEnd = source + sourceSize;
+		uint8_t* output = destination;
+		uint8_t* outputEnd = destination + size;
+
+		auto readLength = [&](size_t length) -> size_t
+			{
+				if (length != 15)
+					return length;
+
+				uint8_t byte;
+				do
+				{
+					if (input >= inputEnd)
+						throw std::runtime_error("corrupt lz4 block: truncated length");
+					byte = *input++;
+					length += byte;
+				} while (byte == 255);
+
+				return length;
+			};
+
+		while (input < inputEnd)
+		{
+			uint8_t token = *input++;
+
+			size_t literalCount = readLength(token >> 4);
+			if (static_cast<size_t>(inputEnd - input) < literalCount || static_cast<size_t>(outputEnd - output) < literalCount)
+				throw std::runtime_error("corrupt lz4 block: literals out of range");
+
+			if (literalCount > 0)
+				std::memcpy(output, input, literalCount);
+			input += literalCount;
+			output += literalCount;
+
+			if (input == inputEnd)
+				break;
+
+			if (inputEnd - input < 2)
+				throw std::runtime_error("corrupt lz4 block: truncated offset");
+
+			size_t offset = static_cast<size_t>(input[0]) | static_cast<size_t>(input[1]) << 8;
+			input += 2;
+			if (offset == 0 || offset > static_cast<size_t>(output - destination))
+				throw std::runtime_error("corrupt lz4 block: offset out of range");
+
+			size_t matchLength = readLength(token & 15) + MIN_MATCH;
+			if (static_cast<size_t>(outputEnd - output) < matchLength)
+				throw std::runtime_error("corrupt lz4 block: match out of range");
+
+			const uint8_t* match = output - offset;
+			if (offset >= matchLength)
+			{
+				std::memcpy(output, match, matchLength);
+				output += matchLength;
+			}
+			else
+			{
+				// Overlapping match: repeats the last offset bytes
+				for (size_t i = 0; i < matchLength; i++)
+					*output++ = match[i];
+			}
+		}
+
+		if (output != outputEnd)
+			throw std::runtime_error("corrupt lz4 block: size mismatch");
+	}
+}
+
+// Read-only memory mapping of a whole file.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+
+	explicit MappedFile(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("failed to open file for mapping: " + path.string());
+
+		LARGE_INTEGER fileSize{};
+		GetFileSizeEx(file, &fileSize);
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+			throw std::runtime_error("failed to map file: " + path.string());
+
+		bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+		descriptor = ::open(path.c_str(), O_RDONLY);
+		if (descriptor < 0)
+			throw std::runtime_error("failed to open file for mapping: " + path.string());
+
+		struct stat status{};
+		fstat(descriptor, &status);
+		size = static_cast<size_t>(status.st_size);
+
+		void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		bytes = address == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(address);
+#endif
+		if (bytes == nullptr)
+		{
+			close();
+			throw std::runtime_error("failed to map file: " + path.string());
+		}
+	}
+
+	~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(bytes, other.bytes);
+			std::swap(size, other.size);
+#ifdef _WIN32
+			std::swap(file, other.file);
+			std::swap(mapping, other.mapping);
+#else
+			std::swap(descriptor, other.descriptor);
+#endif
+		}
+		return *this;
+	}
+
+	[[nodiscard]] const uint8_t* data() const
+	{
+		return bytes;
+	}
+
+	[[nodiscard]] size_t fileSize() const
+	{
+		return size;
+	}
+
+private:
+	void close()
+	{
+#ifdef _WIN32
+		if (bytes != nullptr)
+			UnmapViewOfFile(bytes);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (bytes != nullptr)
+			munmap(const_cast<uint8_t*>(bytes), size);
+		if (descriptor >= 0)
+			::close(descriptor);
+		descriptor = -1;
+#endif
+		bytes = nullptr;
+		size = 0;
+	}
+
+	const uint8_t* bytes = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int descriptor = -1;
+#endif
+};
+
+class AssetPack
+{
+public:
+	/**
+	* Maps the pack at path; entries are looked up by paths under mountPoint, e.g. a pack mounted at
+	* "resources/" holding "shaders/slang.spv" serves "resources/shaders/slang.spv".
+	* Returns false when the file does not exist and throws when it is not a valid pack.
+	*/
+	bool open(const std::filesystem::path& path, std::string mountPoint)
+	{
+		if (!std::filesystem::exists(path))
+			return false;
+
+		file = MappedFile(path);
+		mount = std::move(mountPoint);
+
+		AssetPackHeader header;
+		if (file.fileSize() < sizeof(header))
+			throw std::runtime_error("asset pack is truncated: " + path.string());
+
+		std::memcpy(&header, file.data(), sizeof(header));
+		if (header.magic != ASSET_PACK_MAGIC)
+			throw std::runtime_error("not an asset pack: " + path.string());
+		if (header.version != ASSET_PACK_VERSION)
+			throw std::runtime_error("asset pack version mismatch, re-run the asset cooker: " + path.string());
+
+		size_t tocSize = static_cast<size_t>(header.entryCount) * sizeof(AssetPackEntry);
+		if (file.fileSize() < sizeof(header) + tocSize + header.namesSize)
+			throw std::runtime_error("asset pack is truncated: " + path.string());
+
+		toc = { reinterpret_cast<const AssetPackEntry*>(file.data() + sizeof(header)), header.entryCount };
+		names = { reinterpret_cast<const char*>(file.data() + sizeof(header) + tocSize), header.namesSize };
+
+		for (const AssetPackEntry& entry : toc)
+			if (entry.offset + entry.storedSize > file.fileSize() || static_cast<size_t>(entry.nameOffset) + entry.nameLength > names.size())
+				throw std::runtime_error("asset pack entry out of range: " + path.string());
+
+		return true;
+	}
+
+	[[nodiscard]] bool isOpen() const
+	{
+		return file.data() != nullptr;
+	}
+
+	[[nodiscard]] const AssetPackEntry* find(std::string_view path) const
+	{
+		if (!isOpen() || !path.starts_with(mount))
+			return nullptr;
+
+		std::string_view relative = path.substr(mount.size());
+		uint64_t key = hashString(relative);
+		auto range = std::ranges::equal_range(toc, key, {}, &AssetPackEntry::nameHash);
+		for (const AssetPackEntry& entry : range)
+			if (name(entry) == relative)
+				return &entry;
+
+		return nullptr;
+	}
+
+	[[nodiscard]] std::string_view name(const AssetPackEntry& entry) const
+	{
+		return names.substr(entry.nameOffset, entry.nameLength);
+	}
+
+	// The entry's bytes as stored in the mapping; only the uncompressed data for AssetCompression::None.
+	[[nodiscard]] std::span<const uint8_t> mapped(const AssetPackEntry& entry) const
+	{
+		return { file.data() + entry.offset, static_cast<size_t>(entry.storedSize) };
+	}
+
+	// Writes entry.size uncompressed bytes to destination: a copy out of the mapping or a decompression.
+	void read(const AssetPackEntry& entry, void* destination) const
+	{
+		std::span<const uint8_t> stored = mapped(entry);
+		auto* output = static_cast<uint8_t*>(destination);
+
+		if (entry.compression == AssetCompression::Lz4)
+			lz4_block::decompress(stored.data(), stored.size(), output, static_cast<size_t>(entry.size));
+		else
+			std::memcpy(output, stored.data(), stored.size());
+
+#ifdef VSA_Debug
+		if (hashBytes(output, static_cast<size_t>(entry.size)) != entry.checksum)
+			throw std::runtime_error("asset pack checksum mismatch: " + std::string(name(entry)));
+#endif
+	}
+
+	// The uncompressed bytes: the mapping itself for raw entries, otherwise decompressed into scratch.
+	[[nodiscard]] std::span<const uint8_t> contents(const AssetPackEntry& entry, std::vector<uint8_t>& scratch) const
+	{
+		if (entry.compression == AssetCompression::None)
+			return mapped(entry);
+
+		scratch.resize(static_cast<size_t>(entry.size));
+		read(entry, scratch.data());
+		return scratch;
+	}
+
+	[[nodiscard]] std::vector<uint8_t> load(const AssetPackEntry& entry) const
+	{
+		std::vector<uint8_t> bytes(static_cast<size_t>(entry.size));
+		read(entry, bytes.data());
+		return bytes;
+	}
+
+	[[nodiscard]] std::span<const AssetPackEntry> entries() const
+	{
+		return toc;
+	}
+
+	// The file offset of bytes that lie inside the mapping, e.g. part of a raw blob, so they can be read
+	// through another handle (see core/asyncIO.h); nothing when they are not part of the pack.
+	[[nodiscard]] std::optional<uint64_t> fileOffset(std::span<const uint8_t> bytes) const
+	{
+		auto begin = reinterpret_cast<uintptr_t>(file.data());
+		auto address = reinterpret_cast<uintptr_t>(bytes.data());
+		if (!isOpen() || address < begin || address + bytes.size() > begin + file.fileSize())
+			return std::nullopt;
+
+		return address - begin;
+	}
+
+	[[nodiscard]] size_t fileSize() const
+	{
+		return file.fileSize();
+	}
+
+private:
+	MappedFile file;
+	std::string mount;
+	std::span<const AssetPackEntry> toc;
+	std::string_view names;
+};
+
+// Builds a pack in memory and writes it in one go. add() may be called from several threads.
+class AssetPackWriter
+{
+public:
+	// compress requests LZ4; the blob is still stored raw when compression saves less than an eighth.
+	void add(std::string name, const std::vector<uint8_t>& bytes, bool compress)
+	{
+		Blob blob
+		{
+			.name = std::move(name),
+			.size = bytes.size(),
+			.checksum = hashBytes(bytes.data(), bytes.size()),
+			.compression = AssetCompression::None,
+			.data = {}
+		};
+
+		if (compress && !bytes.empty())
+		{
+			blob.data.resize(lz4_block::compressBound(bytes.size()));
+			size_t compressedSize = lz4_block::compress(bytes.data(), bytes.size(), blob.data.data(), blob.data.size());
+			if (compressedSize > 0 && compressedSize < bytes.size() - bytes.size() / 8)
+			{
+				blob.data.resize(compressedSize);
+				blob.compression = AssetCompression::Lz4;
+			}
+		}
+
+		if (blob.compression == AssetCompression::None)
+			blob.data = bytes;
+
+		std::lock_guard lock(mutex);
+		blobs.push_back(std::move(blob));
+	}
+
+	// Returns the number of bytes written.
+	uint64_t write(const std::filesystem::path& path)
+	{
+		std::lock_guard lock(mutex);
+		std::ranges::sort(blobs, {}, &Blob::name);
+
+		AssetPackHeader header{ .entryCount = static_cast<uint32_t>(blobs.size()) };
+		std::vector<AssetPackEntry> toc;
+		std::string names;
+		for (const Blob& blob : blobs)
+		{
+			toc.push_back({
+				.nameHash = hashString(blob.name),
+				.size = blob.size,
+				.storedSize = blob.data.size(),
+				.checksum = blob.checksum,
+				.compression = blob.compression,
+				.nameOffset = static_cast<uint32_t>(names.size()),
+				.nameLength = static_cast<uint32_t>(blob.name.size())
+			});
+			names += blob.name;
+		}
+		header.namesSize = static_cast<uint32_t>(names.size());
+
+		uint64_t offset = alignUp(sizeof(header) + toc.size() * sizeof(AssetPackEntry) + names.size());
+		for (AssetPackEntry& entry : toc)
+		{
+			entry.offset = offset;
+			offset = alignUp(offset + entry.storedSize);
+		}
+
+		// Sorting by hash after assigning offsets keeps the blobs in name order on disk
+		std::vector<size_t> order(blobs.size());
+		for (size_t i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::ranges::sort(order, {}, [&](size_t i) { return toc[i].nameHash; });
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throw std::runtime_error("failed to write asset pack: " + path.string());
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (size_t i : order)
+			file.write(reinterpret_cast<const char*>(&toc[i]), sizeof(AssetPackEntry));
+		file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		const std::vector<char> padding(ASSET_PACK_ALIGNMENT, 0);
+		for (size_t i = 0; i < blobs.size(); i++)
+		{
+			auto position = static_cast<uint64_t>(file.tellp());
+			file.write(padding.data(), static_cast<std::streamsize>(toc[i].offset - position));
+			file.write(reinterpret_cast<const char*>(blobs[i].data.data()), static_cast<std::streamsize>(blobs[i].data.size()));
+		}
+		file.write(padding.data(), static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp())));
+
+		return static_cast<uint64_t>(file.tellp());
+	}
+
+private:
+	struct Blob
+	{
+		std::string name;
+		uint64_t size = 0;
+		uint64_t checksum = 0;
+		AssetCompression compression = AssetCompression::None;
+		std::vector<uint8_t> data;
+	};
+
+	static uint64_t alignUp(uint64_t value)
+	{
+		return (value + ASSET_PACK_ALIGNMENT - 1) & ~(ASSET_PACK_ALIGNMENT - 1);
+	}
+
+	std::vector<Blob> blobs;
+	std::mutex mutex;
+};
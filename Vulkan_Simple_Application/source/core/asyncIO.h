@@ -0,0 +1,540 @@
+#pragma once
+
+// Asynchronous file reads into caller-owned memory, e.g. straight into a mapped staging buffer.
+//
+// On desktop Linux requests go through io_uring (raw syscalls against <linux/io_uring.h>, no liburing): one
+// submission queue entry per read, completions reaped without a syscall by polling the shared ring.
+// Everywhere else, and on kernels where io_uring is missing or blocked, each read runs as a blocking
+// positional read on a small thread pool. Both report through the same poll()/wait() interface.
+// read(), poll() and wait() belong to one thread; the destinations are written by the kernel or a
+// worker, so they must stay alive and untouched until their completion has been returned.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Android's seccomp policy rejects io_uring for apps, so it always takes the thread pool
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define VSA_IO_URING 1
+#endif
+
+#include "core/taskGraph.h"
+
+// A file opened for asynchronous reads.
+class AsyncFile
+{
+public:
+#ifdef _WIN32
+	using Handle = HANDLE;
+#else
+	using Handle = int;
+#endif
+
+	AsyncFile() = default;
+
+	explicit AsyncFile(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+#else
+		handle = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (handle < 0)
+#endif
+			throw std::runtime_error("failed to open file for async reads: " + path.string());
+	}
+
+	~AsyncFile()
+	{
+		close();
+	}
+
+	AsyncFile(const AsyncFile&) = delete;
+	AsyncFile& operator=(const AsyncFile&) = delete;
+
+	AsyncFile(AsyncFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	AsyncFile& operator=(AsyncFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(handle, other.handle);
+		}
+		return *this;
+	}
+
+	[[nodiscard]] bool isOpen() const
+	{
+#ifdef _WIN32
+		return handle != INVALID_HANDLE_VALUE;
+#else
+		return handle >= 0;
+#endif
+	}
+
+	[[nodiscard]] Handle native() const
+	{
+		return handle;
+	}
+
+private:
+	void close()
+	{
+#ifdef _WIN32
+		if (handle != INVALID_HANDLE_VALUE)
+			CloseHandle(handle);
+		handle = INVALID_HANDLE_VALUE;
+#else
+		if (handle >= 0)
+			::close(handle);
+		handle = -1;
+#endif
+	}
+
+#ifdef _WIN32
+	Handle handle = INVALID_HANDLE_VALUE;
+#else
+	Handle handle = -1;
+#endif
+};
+
+struct IoCompletion
+{
+	uint64_t userData = 0;
+	bool succeeded = false;
+};
+
+class AsyncIO
+{
+public:
+	enum class Backend
+	{
+		IoUring,
+		Threads
+	};
+
+	AsyncIO() = default;
+
+	~AsyncIO()
+	{
+		shutdown();
+	}
+
+	AsyncIO(const AsyncIO&) = delete;
+	AsyncIO& operator=(const AsyncIO&) = delete;
+
+	/**
+	* queueDepth bounds the reads in flight at once; more are queued and issued as earlier ones finish.
+	* preferIoUring = false forces the thread pool, e.g. to compare the two backends.
+	*/
+	void init(uint32_t queueDepth = 64, bool preferIoUring = true, uint32_t fallbackThreads = 2)
+	{
+		shutdown();
+		depth = std::max(queueDepth, 1u);
+
+#ifdef VSA_IO_URING
+		if (preferIoUring && ring.setup(depth))
+		{
+			activeBackend = Backend::IoUring;
+			return;
+		}
+#endif
+		activeBackend = Backend::Threads;
+		pool = std::make_unique<ThreadPool>(fallbackThreads);
+	}
+
+	[[nodiscard]] Backend backend() const
+	{
+		return activeBackend;
+	}
+
+	[[nodiscard]] const char* backendName() const
+	{
+		return activeBackend == Backend::IoUring ? "io_uring" : "threads";
+	}
+
+	// Reads size bytes at offset into destination; userData comes back in the completion.
+	void read(const AsyncFile& file, uint64_t offset, size_t size, void* destination, uint64_t userData)
+	{
+		if (!file.isOpen())
+			throw std::runtime_error("async read from a closed file!");
+
+		pending.push_back({ file.native(), offset, size, static_cast<uint8_t*>(destination), userData });
+		issue();
+	}
+
+	// Appends finished reads to completions without blocking; returns how many were appended.
+	size_t poll(std::vector<IoCompletion>& completions)
+	{
+		size_t before = completions.size();
+		reap(completions);
+		issue();
+		return completions.size() - before;
+	}
+
+	// Like poll(), but blocks until at least one read has finished unless none is outstanding.
+	size_t wait(std::vector<IoCompletion>& completions)
+	{
+		size_t count = poll(completions);
+		while (count == 0 && outstanding() > 0)
+		{
+#ifdef VSA_IO_URING
+			if (activeBackend == Backend::IoUring)
+				ring.enter(0, 1);
+			else
+#endif
+			{
+				std::unique_lock lock(finishedMutex);
+				finishedChanged.wait(lock, [this]() { return !finished.empty(); });
+			}
+			count = poll(completions);
+		}
+		return count;
+	}
+
+	// Reads submitted or queued whose completion has not been returned yet.
+	[[nodiscard]] size_t outstanding() const
+	{
+		return pending.size() + inFlight;
+	}
+
+private:
+	struct Request
+	{
+		AsyncFile::Handle file;
+		uint64_t offset;
+		size_t size;
+		uint8_t* destination;
+		uint64_t userData;
+	};
+
+	// Reads the whole range with blocking positional reads; false on an error or a premature end of file.
+	static bool readBlocking(const Request& request)
+	{
+		size_t done = 0;
+		while (done < request.size)
+		{
+			size_t chunk = std::min<size_t>(request.size - done, 1u << 30);
+#ifdef _WIN32
+			uint64_t position = request.offset + done;
+			OVERLAPPED overlapped{};
+			overlapped.Offset = static_cast<DWORD>(position);
+			overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+			DWORD bytes = 0;
+			if (!ReadFile(request.file, request.destination + done, static_cast<DWORD>(chunk), &bytes, &overlapped) || bytes == 0)
+				return false;
+#else
+			ssize_t bytes = ::pread(request.file, request.destination + done, chunk, static_cast<off_t>(request.offset + done));
+			if (bytes < 0 && errno == EINTR)
+				continue;
+			if (bytes <= 0)
+				return false;
+#endif
+			done += static_cast<size_t>(bytes);
+		}
+		return true;
+	}
+
+	void issue()
+	{
+		while (!pending.empty() && inFlight < depth)
+		{
+			Request request = pending.front();
+			pending.pop_front();
+			inFlight++;
+
+#ifdef VSA_IO_URING
+			if (activeBackend == Backend::IoUring)
+			{
+				uint64_t id = nextId++;
+				requests.emplace(id, request);
+				ring.push(request, id);
+				continue;
+			}
+#endif
+			pool->submit([this, request]()
+				{
+					bool succeeded = readBlocking(request);
+					{
+						std::lock_guard lock(finishedMutex);
+						finished.push_back({ request.userData, succeeded });
+					}
+					finishedChanged.notify_one();
+				});
+		}
+
+#ifdef VSA_IO_URING
+		if (activeBackend == Backend::IoUring)
+			ring.flush();
+#endif
+	}
+
+	void reap(std::vector<IoCompletion>& completions)
+	{
+#ifdef VSA_IO_URING
+		if (activeBackend == Backend::IoUring)
+		{
+			ring.drain([&](uint64_t id, int32_t result)
+				{
+					auto it = requests.find(id);
+					Request& request = it->second;
+
+					// A short read is not an error: the rest is queued again as a new request
+					if (result > 0 && static_cast<size_t>(result) < request.size)
+					{
+						pending.push_back({ request.file, request.offset + result, request.size - result, request.destination + result, request.userData });
+						requests.erase(it);
+						inFlight--;
+						return;
+					}
+
+					completions.push_back({ request.userData, result >= 0 && static_cast<size_t>(result) == request.size });
+					requests.erase(it);
+					inFlight--;
+				});
+			return;
+		}
+#endif
+		std::lock_guard lock(finishedMutex);
+		for (const IoCompletion& completion : finished)
+			completions.push_back(completion);
+		inFlight -= finished.size();
+		finished.clear();
+	}
+
+	void shutdown()
+	{
+		// Destroying the pool joins its workers, so every read it started has landed
+		pool.reset();
+#ifdef VSA_IO_URING
+		if (activeBackend == Backend::IoUring)
+		{
+			std::vector<IoCompletion> ignored;
+			while (inFlight > 0)
+			{
+				ring.enter(0, 1);
+				reap(ignored);
+			}
+		}
+		ring.teardown();
+		requests.clear();
+#endif
+		pending.clear();
+		finished.clear();
+		inFlight = 0;
+	}
+
+#ifdef VSA_IO_URING
+	// The submission and completion rings shared with the kernel.
+	class Ring
+	{
+	public:
+		bool setup(uint32_t entries)
+		{
+			io_uring_params params{};
+			descriptor = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+			if (descriptor < 0)
+				return false;
+
+			sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+			cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMap)
+				sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+			sqRing = mapRing(sqRingSize, IORING_OFF_SQ_RING);
+			cqRing = singleMap ? sqRing : mapRing(cqRingSize, IORING_OFF_CQ_RING);
+			sqes = static_cast<io_uring_sqe*>(mapRing(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+			sqeCount = params.sq_entries;
+			if (sqRing == nullptr || cqRing == nullptr || sqes == nullptr)
+			{
+				teardown();
+				return false;
+			}
+
+			auto* sq = static_cast<uint8_t*>(sqRing);
+			sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+			sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+			sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+			auto* cq = static_cast<uint8_t*>(cqRing);
+			cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+			cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+			cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+			cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+			// Probe: IORING_OP_READ needs Linux 5.6, and sandboxes may refuse io_uring altogether
+			uint8_t probe = 0;
+			int pipes[2];
+			if (pipe(pipes) != 0)
+			{
+				teardown();
+				return false;
+			}
+			bool supported = write(pipes[1], &probe, 1) == 1;
+			if (supported)
+			{
+				prepare(pipes[0], 0, &probe, 1, 0);
+				flush();
+				supported = enter(0, 1) >= 0;
+				drain([&](uint64_t, int32_t result) { supported = supported && result == 1; });
+			}
+			::close(pipes[0]);
+			::close(pipes[1]);
+
+			if (!supported)
+				teardown();
+			return supported;
+		}
+
+		void teardown()
+		{
+			if (sqes != nullptr)
+				munmap(sqes, sqeCount * sizeof(io_uring_sqe));
+			if (cqRing != nullptr && cqRing != sqRing)
+				munmap(cqRing, cqRingSize);
+			if (sqRing != nullptr)
+				munmap(sqRing, sqRingSize);
+			if (descriptor >= 0)
+				::close(descriptor);
+
+			sqes = nullptr;
+			sqRing = cqRing = nullptr;
+			descriptor = -1;
+			unsubmitted = 0;
+		}
+
+		// Callers keep at most queueDepth reads in flight, so a free entry always exists.
+		void push(const Request& request, uint64_t id)
+		{
+			prepare(request.file, request.offset, request.destination, request.size, id);
+		}
+
+		void flush()
+		{
+			if (unsubmitted > 0)
+				enter(unsubmitted, 0);
+		}
+
+		int enter(uint32_t toSubmit, uint32_t minComplete)
+		{
+			while (true)
+			{
+				long result = syscall(__NR_io_uring_enter, descriptor, toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+				if (result >= 0)
+				{
+					unsubmitted -= std::min(unsubmitted, static_cast<uint32_t>(result));
+					return static_cast<int>(result);
+				}
+				if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+					return -1;
+			}
+		}
+
+		template <typename Callback>
+		void drain(Callback&& callback)
+		{
+			std::atomic_ref<uint32_t> tail(*cqTail);
+			std::atomic_ref<uint32_t> head(*cqHead);
+			uint32_t current = head.load(std::memory_order_relaxed);
+			while (current != tail.load(std::memory_order_acquire))
+			{
+				const io_uring_cqe& cqe = cqes[current & cqMask];
+				uint64_t id = cqe.user_data;
+				int32_t result = cqe.res;
+				current++;
+				head.store(current, std::memory_order_release);
+				callback(id, result);
+			}
+		}
+
+	private:
+		void* mapRing(size_t size, off_t offset) const
+		{
+			void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, descriptor, offset);
+			return address == MAP_FAILED ? nullptr : address;
+		}
+
+		void prepare(int file, uint64_t offset, void* destination, size_t size, uint64_t id)
+		{
+			std::atomic_ref<uint32_t> tail(*sqTail);
+			uint32_t current = tail.load(std::memory_order_relaxed);
+			uint32_t index = current & sqMask;
+
+			io_uring_sqe& sqe = sqes[index];
+			std::memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = IORING_OP_READ;
+			sqe.fd = file;
+			sqe.off = offset;
+			sqe.addr = reinterpret_cast<uint64_t>(destination);
+			sqe.len = static_cast<uint32_t>(std::min<size_t>(size, 1u << 30));
+			sqe.user_data = id;
+
+			sqArray[index] = index;
+			tail.store(current + 1, std::memory_order_release);
+			unsubmitted++;
+		}
+
+		int descriptor = -1;
+		void* sqRing = nullptr;
+		void* cqRing = nullptr;
+		size_t sqRingSize = 0;
+		size_t cqRingSize = 0;
+		io_uring_sqe* sqes = nullptr;
+		uint32_t sqeCount = 0;
+		uint32_t* sqTail = nullptr;
+		uint32_t sqMask = 0;
+		uint32_t* sqArray = nullptr;
+		uint32_t* cqHead = nullptr;
+		uint32_t* cqTail = nullptr;
+		uint32_t cqMask = 0;
+		io_uring_cqe* cqes = nullptr;
+		uint32_t unsubmitted = 0;
+	};
+
+	Ring ring;
+	std::unordered_map<uint64_t, Request> requests; // io_uring reads by submission id
+	uint64_t nextId = 0;
+#endif
+
+	Backend activeBackend = Backend::Threads;
+	uint32_t depth = 64;
+	std::deque<Request> pending;
+	size_t inFlight = 0;
+
+	std::unique_ptr<ThreadPool> pool;
+	std::mutex finishedMutex;
+	std::condition_variable finishedChanged;
+	std::vector<IoCompletion> finished;
+};
@@ -0,0 +1,475 @@
+#pragma once
+
+// Benchmark options and report shared by all sample applications.
+//
+// A run renders warmupFrames untimed frames, then measuredFrames timed frames, then closes and writes
+// a JSON report (CPU frame-time percentiles, GPU pass times, startup phases, process memory) that can
+// be diffed between builds. Without --benchmark the options only select the app, window mode and seed.
+// Apps can add workload counters (e.g. triangles drawn) that are reported per frame and per second.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+constexpr uint32_t DEFAULT_RANDOM_SEED = 1337;
+
+struct BenchmarkOptions
+{
+	std::string app = "hello";
+	bool benchmark = false;
+	bool headless = false;
+	uint32_t warmupFrames = 100;
+	uint32_t measuredFrames = 1000;
+	uint32_t seed = DEFAULT_RANDOM_SEED;
+	uint32_t objects = 0; // scene object count for apps that support it, 0 keeps the app's default scene
+	bool depthPrepass = false; // start the scene with a depth-only prepass (P toggles it while running)
+	std::string mipGenerator = "compute"; // compute (single-pass downsampler) or blit (vkCmdBlitImage chain)
+	std::string texture = "ktx2"; // texture source for apps that support both: ktx2 (GPU-compressed) or png
+	uint32_t textureBudgetMiB = 256; // device memory for streamed texture mips, 0 for no limit
+	std::string assets = "pack"; // pack (memory-mapped resources/assets.pack) or loose (one file read per asset)
+	std::string io = "auto"; // asynchronous reads: auto (io_uring where available) or threads (thread pool only)
+	std::string descriptors = "bindless"; // bindless (one descriptor-indexed set, where supported) or classic (a set per frame, dynamic uniform offsets)
+	bool commandCache = true; // resubmit recorded command buffers while the scene keeps its structure, or record every frame
+	uint32_t recordThreads = 0; // threads recording large passes into secondary command buffers, 0 for all cores but one, 1 records inline
+	bool dynamicState = true; // set cull mode, depth test and the like while recording where supported, or bake a pipeline per state
+	std::string outputPath;
+
+	static void printUsage()
+	{
+		std::cout << "usage: Vulkan_Simple_Application [--app=hello|triangle|compute|multithreaded] [--benchmark]\n"
+			"                                   [--headless] [--warmup=N] [--frames=N] [--seed=N] [--objects=N]\n"
+			"                                   [--depth-prepass] [--mips=compute|blit] [--texture=ktx2|png]\n"
+			"                                   [--texture-budget=MiB] [--assets=pack|loose] [--io=auto|threads]\n"
+			"                                   [--descriptors=bindless|classic] [--command-cache=on|off]\n"
+			"                                   [--record-threads=N] [--dynamic-state=on|off] [--output=file.json]\n";
+	}
+
+	// Accepts --name=value arguments; throws on anything it does not understand.
+	static BenchmarkOptions parse(int argc, char** argv)
+	{
+		BenchmarkOptions options;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string_view argument = argv[i];
+			std::string_view value;
+			if (size_t separator = argument.find('='); separator != std::string_view::npos)
+			{
+				value = argument.substr(separator + 1);
+				argument = argument.substr(0, separator);
+			}
+
+			if (argument == "--app")
+				options.app = value;
+			else if (argument == "--benchmark")
+				options.benchmark = true;
+			else if (argument == "--headless")
+				options.headless = true;
+			else if (argument == "--warmup")
+				options.warmupFrames = parseNumber(argument, value);
+			else if (argument == "--frames")
+				options.measuredFrames = parseNumber(argument, value);
+			else if (argument == "--seed")
+				options.seed = parseNumber(argument, value);
+			else if (argument == "--objects")
+				options.objects = parseNumber(argument, value);
+			else if (argument == "--depth-prepass")
+				options.depthPrepass = true;
+			else if (argument == "--mips")
+			{
+				if (value != "compute" && value != "blit")
+					throw std::runtime_error("--mips must be compute or blit");
+				options.mipGenerator = value;
+			}
+			else if (argument == "--texture")
+			{
+				if (value != "ktx2" && value != "png")
+					throw std::runtime_error("--texture must be ktx2 or png");
+				options.texture = value;
+			}
+			else if (argument == "--texture-budget")
+				options.textureBudgetMiB = parseNumber(argument, value);
+			else if (argument == "--assets")
+			{
+				if (value != "pack" && value != "loose")
+					throw std::runtime_error("--assets must be pack or loose");
+				options.assets = value;
+			}
+			else if (argument == "--io")
+			{
+				if (value != "auto" && value != "threads")
+					throw std::runtime_error("--io must be auto or threads");
+				options.io = value;
+			}
+			else if (argument == "--descriptors")
+			{
+				if (value != "bindless" && value != "classic")
+					throw std::runtime_error("--descriptors must be bindless or classic");
+				options.descriptors = value;
+			}
+			else if (argument == "--command-cache")
+			{
+				if (value != "on" && value != "off")
+					throw std::runtime_error("--command-cache must be on or off");
+				options.commandCache = value == "on";
+			}
+			else if (argument == "--record-threads")
+				options.recordThreads = parseNumber(argument, value);
+			else if (argument == "--dynamic-state")
+			{
+				if (value != "on" && value != "off")
+					throw std::runtime_error("--dynamic-state must be on or off");
+				options.dynamicState = value == "on";
+			}
+			else if (argument == "--output")
+				options.outputPath = value;
+			else
+				throw std::runtime_error("unknown argument: " + std::string(argv[i]));
+		}
+
+		if (options.benchmark && options.measuredFrames == 0)
+			throw std::runtime_error("--frames must be greater than zero");
+
+		if (options.outputPath.empty())
+			options.outputPath = "benchmark_" + options.app + ".json";
+
+		return options;
+	}
+
+private:
+	static uint32_t parseNumber(std::string_view argument, std::string_view value)
+	{
+		uint32_t number = 0;
+		if (value.empty() || !std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; }))
+			throw std::runtime_error("expected a number for " + std::string(argument));
+
+		for (char c : value)
+			number = number * 10 + static_cast<uint32_t>(c - '0');
+
+		return number;
+	}
+};
+
+class BenchmarkRun
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// Simulations advance by this step during a benchmark so every run computes the same frames.
+	static constexpr double FIXED_STEP_MS = 1000.0 / 60.0;
+
+	BenchmarkRun() = default;
+
+	explicit BenchmarkRun(BenchmarkOptions options)
+		: runOptions(std::move(options))
+	{
+	}
+
+	[[nodiscard]] bool active() const
+	{
+		return runOptions.benchmark;
+	}
+
+	[[nodiscard]] const BenchmarkOptions& options() const
+	{
+		return runOptions;
+	}
+
+	void setDevice(const std::string& name, uint32_t driverVersion)
+	{
+		deviceName = name;
+		deviceDriverVersion = driverVersion;
+	}
+
+	// Starts the startup clock; call first thing in run().
+	void beginStartup()
+	{
+		startupBegin = Clock::now();
+		lastPhaseEnd = startupBegin;
+	}
+
+	// Records the time since the previous phase (or beginStartup) under name.
+	void startupPhase(const std::string& name)
+	{
+		startupPhase(name, lastPhaseEnd, Clock::now());
+	}
+
+	// Records a phase with explicit bounds, e.g. a task that ran concurrently with others.
+	void startupPhase(const std::string& name, Clock::time_point begin, Clock::time_point end)
+	{
+		startupPhases.push_back({ name, milliseconds(begin - startupBegin), milliseconds(end - begin) });
+		lastPhaseEnd = std::max(lastPhaseEnd, end);
+	}
+
+	void endStartup()
+	{
+		lastFrameEnd = Clock::now();
+		startupMs = milliseconds(lastFrameEnd - startupBegin);
+	}
+
+	/**
+	* Call once at the end of every frame. Returns true on the frame that completes the warm-up, so
+	* the caller can drop any statistics gathered so far (e.g. GpuProfiler::resetStatistics()).
+	*/
+	bool endFrame()
+	{
+		Clock::time_point now = Clock::now();
+		double frameMs = milliseconds(now - lastFrameEnd);
+		lastFrameEnd = now;
+
+		if (frameCount == 0)
+		{
+			firstFrameMs = milliseconds(now - startupBegin);
+			std::cout << "Time to first frame: " << firstFrameMs << " ms (startup " << startupMs << " ms)" << std::endl;
+		}
+
+		frameCount++;
+		if (frameCount > runOptions.warmupFrames)
+			frameTimes.push_back(frameMs);
+
+		return active() && frameCount == runOptions.warmupFrames;
+	}
+
+	// Adds value to a per-frame workload counter; only frames that are measured are counted.
+	void addCounter(const std::string& name, double value)
+	{
+		if (frameCount >= runOptions.warmupFrames)
+			counters[name] += value;
+	}
+
+	// Records the GPU time of one-off work, e.g. generating a texture's mip chain at startup.
+	void setOneShotGpuMs(const std::string& name, double ms)
+	{
+		oneShotGpuMs[name] = ms;
+	}
+
+	// Records the device memory taken by a resource, e.g. a texture, to compare formats between runs.
+	void setResourceBytes(const std::string& name, uint64_t bytes)
+	{
+		resourceBytes[name] = bytes;
+	}
+
+	// Where assets were actually read from; an app falls back to loose files when the pack is missing.
+	void setAssetSource(const std::string& source)
+	{
+		assetSource = source;
+	}
+
+	// The asynchronous I/O backend actually in use, e.g. io_uring or threads.
+	void setIoBackend(const std::string& backend)
+	{
+		ioBackend = backend;
+	}
+
+	// The descriptor model actually in use; bindless falls back to classic without descriptor indexing.
+	void setDescriptors(const std::string& model)
+	{
+		descriptorModel = model;
+	}
+
+	// The dynamic state level actually in use (see core/pipelineVariants.h) and the graphics pipelines it took.
+	void setPipelines(const std::string& dynamicStateLevel, uint32_t count, double createMs)
+	{
+		dynamicState = dynamicStateLevel;
+		pipelineCount = count;
+		pipelineCreateMs = createMs;
+	}
+
+	[[nodiscard]] double simulationStepMs(double measuredMs) const
+	{
+		return active() ? FIXED_STEP_MS : measuredMs;
+	}
+
+	// True once all measured frames of a benchmark run have been rendered.
+	[[nodiscard]] bool finished() const
+	{
+		return active() && frameTimes.size() >= runOptions.measuredFrames;
+	}
+
+	// gpuPassesJson is a JSON array such as GpuProfiler::toJson() produces.
+	bool writeReport(const std::string& gpuPassesJson = "[]") const
+	{
+		if (!active())
+			return false;
+
+		std::ofstream file(runOptions.outputPath, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "failed to write benchmark report: " << runOptions.outputPath << std::endl;
+			return false;
+		}
+
+		std::vector<double> sorted = frameTimes;
+		std::ranges::sort(sorted);
+
+		double sum = 0.0;
+		for (double frameMs : sorted)
+			sum += frameMs;
+		double averageMs = sorted.empty() ? 0.0 : sum / static_cast<double>(sorted.size());
+
+		MemoryUsage memory = processMemory();
+
+		file << std::fixed << std::setprecision(4);
+		file << "{\n";
+		file << "  \"app\": \"" << runOptions.app << "\",\n";
+		file << "  \"build\": \"" << buildConfiguration() << "\",\n";
+		file << "  \"device\": { \"name\": \"" << deviceName << "\", \"driver_version\": " << deviceDriverVersion << " },\n";
+		file << "  \"seed\": " << runOptions.seed << ",\n";
+		file << "  \"headless\": " << (runOptions.headless ? "true" : "false") << ",\n";
+		file << "  \"depth_prepass\": " << (runOptions.depthPrepass ? "true" : "false") << ",\n";
+		file << "  \"mip_generator\": \"" << runOptions.mipGenerator << "\",\n";
+		file << "  \"texture\": \"" << runOptions.texture << "\",\n";
+		file << "  \"texture_budget_mib\": " << runOptions.textureBudgetMiB << ",\n";
+		file << "  \"assets\": \"" << (assetSource.empty() ? runOptions.assets : assetSource) << "\",\n";
+		file << "  \"io_backend\": \"" << (ioBackend.empty() ? runOptions.io : ioBackend) << "\",\n";
+		file << "  \"descriptors\": \"" << (descriptorModel.empty() ? runOptions.descriptors : descriptorModel) << "\",\n";
+		file << "  \"command_cache\": " << (runOptions.commandCache ? "true" : "false") << ",\n";
+		file << "  \"record_threads\": " << runOptions.recordThreads << ",\n";
+		file << "  \"dynamic_state\": \"" << (dynamicState.empty() ? (runOptions.dynamicState ? "on" : "off") : dynamicState) << "\",\n";
+		file << "  \"pipelines\": { \"count\": " << pipelineCount << ", \"create_ms\": " << pipelineCreateMs << " },\n";
+		file << "  \"warmup_frames\": " << runOptions.warmupFrames << ",\n";
+		file << "  \"measured_frames\": " << frameTimes.size() << ",\n";
+		file << "  \"cpu_frame_ms\": { \"min\": " << percentile(sorted, 0.0) << ", \"avg\": " << averageMs
+			<< ", \"p50\": " << percentile(sorted, 0.5) << ", \"p90\": " << percentile(sorted, 0.9)
+			<< ", \"p95\": " << percentile(sorted, 0.95) << ", \"p99\": " << percentile(sorted, 0.99)
+			<< ", \"max\": " << percentile(sorted, 1.0) << " },\n";
+		file << "  \"fps\": " << (averageMs > 0.0 ? 1000.0 / averageMs : 0.0) << ",\n";
+		file << "  \"counters\": {";
+		for (auto it = counters.begin(); it != counters.end(); ++it)
+		{
+			double perFrame = sorted.empty() ? 0.0 : it->second / static_cast<double>(sorted.size());
+			file << (it == counters.begin() ? " " : ", ") << "\"" << it->first << "\": { \"per_frame\": " << perFrame
+				<< ", \"per_second\": " << (sum > 0.0 ? it->second * 1000.0 / sum : 0.0) << " }";
+		}
+		file << (counters.empty() ? "},\n" : " },\n");
+		file << "  \"one_shot_gpu_ms\": {";
+		for (auto it = oneShotGpuMs.begin(); it != oneShotGpuMs.end(); ++it)
+			file << (it == oneShotGpuMs.begin() ? " " : ", ") << "\"" << it->first << "\": " << it->second;
+		file << (oneShotGpuMs.empty() ? "},\n" : " },\n");
+		file << "  \"gpu_passes\": " << gpuPassesJson << ",\n";
+		file << "  \"startup\": { \"total_ms\": " << startupMs << ", \"first_frame_ms\": " << firstFrameMs << ", \"phases\": [";
+		for (size_t i = 0; i < startupPhases.size(); i++)
+			file << (i == 0 ? "\n" : ",\n") << "    { \"name\": \"" << startupPhases[i].name << "\", \"start_ms\": " << startupPhases[i].startMs << ", \"ms\": " << startupPhases[i].ms << " }";
+		file << (startupPhases.empty() ? "] },\n" : "\n  ] },\n");
+		file << "  \"memory\": { \"rss_bytes\": " << memory.currentBytes << ", \"peak_rss_bytes\": " << memory.peakBytes << ", \"resources\": {";
+		for (auto it = resourceBytes.begin(); it != resourceBytes.end(); ++it)
+			file << (it == resourceBytes.begin() ? " " : ", ") << "\"" << it->first << "\": " << it->second;
+		file << (resourceBytes.empty() ? "} }\n" : " } }\n");
+		file << "}\n";
+
+		std::cout << "Benchmark report written to " << runOptions.outputPath << std::endl;
+		return true;
+	}
+
+private:
+	struct StartupPhase
+	{
+		std::string name;
+		double startMs;
+		double ms;
+	};
+
+	struct MemoryUsage
+	{
+		uint64_t currentBytes = 0;
+		uint64_t peakBytes = 0;
+	};
+
+	static double milliseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	// Nearest-rank percentile of an ascending list.
+	static double percentile(const std::vector<double>& sorted, double fraction)
+	{
+		if (sorted.empty())
+			return 0.0;
+
+		size_t index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+
+	static const char* buildConfiguration()
+	{
+#if defined(VSA_Release)
+		return "release";
+#elif defined(VSA_Debug)
+		return "debug";
+#else
+		return "unknown";
+#endif
+	}
+
+	static MemoryUsage processMemory()
+	{
+		MemoryUsage usage;
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			usage.currentBytes = counters.WorkingSetSize;
+			usage.peakBytes = counters.PeakWorkingSetSize;
+		}
+#else
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			std::istringstream fields(line);
+			std::string key;
+			uint64_t kilobytes = 0;
+			fields >> key >> kilobytes;
+
+			if (key == "VmRSS:")
+				usage.currentBytes = kilobytes * 1024;
+			else if (key == "VmHWM:")
+				usage.peakBytes = kilobytes * 1024;
+		}
+#endif
+		return usage;
+	}
+
+	BenchmarkOptions runOptions;
+	std::string deviceName;
+	uint32_t deviceDriverVersion = 0;
+
+	Clock::time_point startupBegin = Clock::now();
+	Clock::time_point lastPhaseEnd = startupBegin;
+	Clock::time_point lastFrameEnd = startupBegin;
+	std::vector<StartupPhase> startupPhases;
+	double startupMs = 0.0;
+	double firstFrameMs = 0.0;
+
+	uint32_t frameCount = 0;
+	std::vector<double> frameTimes;
+	std::map<std::string, double> counters;
+	std::map<std::string, double> oneShotGpuMs;
+	std::map<std::string, uint64_t> resourceBytes;
+	std::string assetSource;
+	std::string ioBackend;
+	std::string descriptorModel;
+	std::string dynamicState;
+	uint32_t pipelineCount = 0;
+	double pipelineCreateMs = 0.0;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+// One descriptor set for everything the draws of a frame read, indexed in the shaders instead of bound
+// per draw ("bindless"). Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+//   binding 0  sampler, shared by every image
+//   binding 1  storage buffers[MAX_BUFFERS]
+//   binding 2  sampled images[imageCapacity()], variable count
+//
+// Both arrays are partially bound and update-after-bind: the set is bound once per command buffer and
+// slots are filled while frames that use the set are still executing, which is allowed as long as those
+// frames do not read the slots being written (descriptorBindingUpdateUnusedWhilePending). So a slot a
+// submitted frame may read is never rewritten: a changed image gets a new slot, and releaseImage() hands
+// the old one back only after framesInFlight more calls to beginFrame(). Storage buffers are registered
+// once and never released; a shader may view binding 1 as arrays of several element types.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+class BindlessTable
+{
+public:
+	static constexpr uint32_t MAX_BUFFERS = 64;
+	static constexpr uint32_t MAX_IMAGES = 4096;
+	static constexpr uint32_t SAMPLER_BINDING = 0;
+	static constexpr uint32_t BUFFER_BINDING = 1;
+	static constexpr uint32_t IMAGE_BINDING = 2;
+
+	static bool supported(const vk::raii::PhysicalDevice& physicalDevice)
+	{
+		auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		const vk::PhysicalDeviceFeatures& core = features.get<vk::PhysicalDeviceFeatures2>().features;
+		const vk::PhysicalDeviceVulkan12Features& vulkan12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+		return core.shaderSampledImageArrayDynamicIndexing && core.shaderStorageBufferArrayDynamicIndexing &&
+			vulkan12.shaderSampledImageArrayNonUniformIndexing && vulkan12.runtimeDescriptorArray &&
+			vulkan12.descriptorBindingPartiallyBound && vulkan12.descriptorBindingVariableDescriptorCount &&
+			vulkan12.descriptorBindingSampledImageUpdateAfterBind && vulkan12.descriptorBindingStorageBufferUpdateAfterBind &&
+			vulkan12.descriptorBindingUpdateUnusedWhilePending;
+	}
+
+	// Turns on what supported() checked, in the feature structs passed to device creation.
+	static void enableFeatures(vk::PhysicalDeviceFeatures& core, vk::PhysicalDeviceVulkan12Features& vulkan12)
+	{
+		core.shaderSampledImageArrayDynamicIndexing = vk::True;
+		core.shaderStorageBufferArrayDynamicIndexing = vk::True;
+		vulkan12.shaderSampledImageArrayNonUniformIndexing = vk::True;
+		vulkan12.runtimeDescriptorArray = vk::True;
+		vulkan12.descriptorBindingPartiallyBound = vk::True;
+		vulkan12.descriptorBindingVariableDescriptorCount = vk::True;
+		vulkan12.descriptorBindingSampledImageUpdateAfterBind = vk::True;
+		vulkan12.descriptorBindingStorageBufferUpdateAfterBind = vk::True;
+		vulkan12.descriptorBindingUpdateUnusedWhilePending = vk::True;
+	}
+
+	// stages are the shader stages that read the set.
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, uint32_t framesInFlight, vk::ShaderStageFlags stages)
+	{
+		this->device = &device;
+		releaseDelay = framesInFlight;
+
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+		const vk::PhysicalDeviceVulkan12Properties& limits = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+		imageSlots = std::min({ MAX_IMAGES, limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSampledImages });
+		if (limits.maxDescriptorSetUpdateAfterBindStorageBuffers < MAX_BUFFERS)
+			throw std::runtime_error("device supports too few update-after-bind storage buffers for the bindless table!");
+
+		vk::DescriptorBindingFlags arrayFlags = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+			vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+		std::array bindings = {
+			vk::DescriptorSetLayoutBinding(SAMPLER_BINDING, vk::DescriptorType::eSampler, 1, stages, nullptr),
+			vk::DescriptorSetLayoutBinding(BUFFER_BINDING, vk::DescriptorType::eStorageBuffer, MAX_BUFFERS, stages, nullptr),
+			vk::DescriptorSetLayoutBinding(IMAGE_BINDING, vk::DescriptorType::eSampledImage, imageSlots, stages, nullptr),
+		};
+		std::array<vk::DescriptorBindingFlags, 3> bindingFlags = { {}, arrayFlags, arrayFlags | vk::DescriptorBindingFlagBits::eVariableDescriptorCount };
+
+		vk::StructureChain<vk::DescriptorSetLayoutCreateInfo, vk::DescriptorSetLayoutBindingFlagsCreateInfo> layoutInfo = {
+			{
+				.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+				.bindingCount = static_cast<uint32_t>(bindings.size()),
+				.pBindings = bindings.data()
+			},
+			{
+				.bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+				.pBindingFlags = bindingFlags.data()
+			}
+		};
+		setLayout = vk::raii::DescriptorSetLayout(device, layoutInfo.get<vk::DescriptorSetLayoutCreateInfo>());
+
+		std::array poolSizes = {
+			vk::DescriptorPoolSize(vk::DescriptorType::eSampler, 1),
+			vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, MAX_BUFFERS),
+			vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, imageSlots),
+		};
+		vk::DescriptorPoolCreateInfo poolInfo
+		{
+			.flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet | vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+			.maxSets = 1,
+			.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+			.pPoolSizes = poolSizes.data()
+		};
+		pool = vk::raii::DescriptorPool(device, poolInfo);
+
+		vk::StructureChain<vk::DescriptorSetAllocateInfo, vk::DescriptorSetVariableDescriptorCountAllocateInfo> allocInfo = {
+			{
+				.descriptorPool = *pool,
+				.descriptorSetCount = 1,
+				.pSetLayouts = &*setLayout
+			},
+			{
+				.descriptorSetCount = 1,
+				.pDescriptorCounts = &imageSlots
+			}
+		};
+		descriptorSet = std::move(vk::raii::DescriptorSets(device, allocInfo.get<vk::DescriptorSetAllocateInfo>()).front());
+
+		freeImages.clear();
+		for (uint32_t slot = imageSlots; slot-- > 0;)
+			freeImages.push_back(slot);
+		pendingImages.clear();
+		bufferCount = 0;
+		frame = 0;
+	}
+
+	void setSampler(vk::Sampler sampler)
+	{
+		vk::DescriptorImageInfo samplerInfo{ .sampler = sampler };
+		write(SAMPLER_BINDING, 0, vk::DescriptorType::eSampler, &samplerInfo, nullptr);
+	}
+
+	// Returns the slot of binding 1 that the shaders index to reach buffer.
+	uint32_t addBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = vk::WholeSize)
+	{
+		if (bufferCount == MAX_BUFFERS)
+			throw std::runtime_error("bindless table is out of buffer slots!");
+
+		vk::DescriptorBufferInfo bufferInfo{ .buffer = buffer, .offset = offset, .range = range };
+		write(BUFFER_BINDING, bufferCount, vk::DescriptorType::eStorageBuffer, nullptr, &bufferInfo);
+		return bufferCount++;
+	}
+
+	// Returns the slot of binding 2 that the shaders index to sample view.
+	uint32_t addImage(vk::ImageView view, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal)
+	{
+		if (freeImages.empty())
+			throw std::runtime_error("bindless table is out of image slots!");
+
+		uint32_t slot = freeImages.back();
+		freeImages.pop_back();
+
+		vk::DescriptorImageInfo imageInfo{ .imageView = view, .imageLayout = layout };
+		write(IMAGE_BINDING, slot, vk::DescriptorType::eSampledImage, &imageInfo, nullptr);
+		return slot;
+	}
+
+	// The current frame and those before it may still sample the slot; frames recorded later must not.
+	void releaseImage(uint32_t slot)
+	{
+		pendingImages.push_back({ slot, frame + releaseDelay });
+	}
+
+	// Once per frame, after the fence of the frame about to be recorded has been waited on.
+	void beginFrame()
+	{
+		frame++;
+		std::erase_if(pendingImages, [this](const std::pair<uint32_t, uint64_t>& pending)
+			{
+				if (pending.second > frame)
+					return false;
+				freeImages.push_back(pending.first);
+				return true;
+			});
+	}
+
+	[[nodiscard]] const vk::raii::DescriptorSetLayout& layout() const
+	{
+		return setLayout;
+	}
+
+	[[nodiscard]] vk::DescriptorSet set() const
+	{
+		return *descriptorSet;
+	}
+
+	[[nodiscard]] uint32_t imageCapacity() const
+	{
+		return imageSlots;
+	}
+
+private:
+	void write(uint32_t binding, uint32_t element, vk::DescriptorType type, const vk::DescriptorImageInfo* imageInfo, const vk::DescriptorBufferInfo* bufferInfo)
+	{
+		vk::WriteDescriptorSet descriptorWrite
+		{
+			.dstSet = *descriptorSet,
+			.dstBinding = binding,
+			.dstArrayElement = element,
+			.descriptorCount = 1,
+			.descriptorType = type,
+			.pImageInfo = imageInfo,
+			.pBufferInfo = bufferInfo
+		};
+		device->updateDescriptorSets(descriptorWrite, {});
+	}
+
+	const vk::raii::Device* device = nullptr;
+	vk::raii::DescriptorSetLayout setLayout = nullptr;
+	vk::raii::DescriptorPool pool = nullptr;
+	vk::raii::DescriptorSet descriptorSet = nullptr;
+	uint32_t imageSlots = 0;
+	uint32_t bufferCount = 0;
+	uint32_t releaseDelay = 0;
+	uint64_t frame = 0;
+	std::vector<uint32_t> freeImages;
+	std::vector<std::pair<uint32_t, uint64_t>> pendingImages; // slot, frame it is free again
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+// Recorded primary command buffers that are submitted again while what they record stays the same.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// There is one buffer per (frame in flight, swapchain image): the frame slot picks the per-frame
+// resources a recording binds and the image its attachments. Each buffer keeps the key it was recorded
+// with; the caller hashes everything it records by value (draw parameters, push constants, dynamic
+// offsets, which passes run) into the key, and calls invalidate() when objects the buffers reference are
+// recreated (swapchain, pipelines) or descriptor sets they bind are rewritten. In a steady scene only the
+// contents of buffers change from frame to frame, so the recordings are simply submitted again.
+//
+// A buffer is only handed out after the fence of its frame slot has been waited on, so the previous
+// submission of the same buffer has completed and it may be reset or resubmitted. Recorded is whatever
+// the caller keeps with a buffer: what it has to restore when it replays the buffer instead of recording
+// it (counters, query scopes), and resources the recording uses (e.g. secondary command buffers). It is
+// kept across recordings, so the caller overwrites it when it records.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template <typename Recorded>
+class CommandCache
+{
+public:
+	struct Entry
+	{
+		vk::raii::CommandBuffer commandBuffer = nullptr;
+		Recorded recorded{};
+		uint64_t key = 0;
+		uint64_t generation = 0;
+	};
+
+	struct Statistics
+	{
+		uint64_t records = 0;
+		uint64_t replays = 0;
+	};
+
+	// The pool must allow resetting individual buffers (eResetCommandBuffer). Drops every recording.
+	void init(const vk::raii::Device& device, const vk::raii::CommandPool& commandPool, uint32_t framesInFlight, uint32_t imageCount)
+	{
+		entries.clear();
+		vk::CommandBufferAllocateInfo allocInfo
+		{
+			.commandPool = commandPool,
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = framesInFlight * imageCount
+		};
+
+		for (vk::raii::CommandBuffer& commandBuffer : vk::raii::CommandBuffers(device, allocInfo))
+			entries.push_back({ .commandBuffer = std::move(commandBuffer) });
+
+		images = imageCount;
+		generation++;
+	}
+
+	// Every buffer is recorded again the next time it is used.
+	void invalidate()
+	{
+		generation++;
+	}
+
+	/**
+	* Returns the buffer of frameIndex/imageIndex and true when it has to be recorded for key, in which
+	* case it has been reset and its entry already carries key. Without caching every call records.
+	*/
+	std::pair<Entry&, bool> acquire(uint32_t frameIndex, uint32_t imageIndex, uint64_t key)
+	{
+		Entry& entry = entries[frameIndex * images + imageIndex];
+		if (enabled && entry.generation == generation && entry.key == key)
+		{
+			stats.replays++;
+			return { entry, false };
+		}
+
+		entry.commandBuffer.reset();
+		entry.key = key;
+		entry.generation = generation;
+		stats.records++;
+		return { entry, true };
+	}
+
+	void setEnabled(bool enable)
+	{
+		enabled = enable;
+	}
+
+	[[nodiscard]] const Statistics& statistics() const
+	{
+		return stats;
+	}
+
+private:
+	std::vector<Entry> entries;
+	uint32_t images = 0;
+	uint64_t generation = 0;
+	bool enabled = true;
+	Statistics stats;
+};
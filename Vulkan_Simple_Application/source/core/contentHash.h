@@ -0,0 +1,60 @@
+#pragma once
+
+// 64-bit FNV-1a content hashing for incremental asset cooking and cooked-data checksums.
+//
+// Hashes are chained through the seed argument, so a key can cover the source bytes, the cooker
+// version and the cook settings at once. Not cryptographic: it only detects changed content.
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+{
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+inline uint64_t hashString(std::string_view text, uint64_t seed = FNV_OFFSET_BASIS)
+{
+	return hashBytes(text.data(), text.size(), seed);
+}
+
+inline uint64_t hashFile(const std::filesystem::path& path, uint64_t seed = FNV_OFFSET_BASIS)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open file for hashing: " + path.string());
+
+	std::vector<char> buffer(1 << 16);
+	uint64_t hash = seed;
+	while (file)
+	{
+		file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		hash = hashBytes(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+	}
+
+	return hash;
+}
+
+inline std::string hashToString(uint64_t hash)
+{
+	char text[17];
+	std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+	return text;
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+// Cooked mesh files (.mesh), written by the Asset_Cooker tool and loaded without any processing.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// A cooked mesh is already deduplicated, optimized for the vertex cache, overdraw and vertex fetch,
+// split into an LOD chain and encoded with a VertexLayout, so loading is a header check and two
+// copies. Layout (little-endian):
+//
+//   CookedMeshHeader
+//   MeshLod[lodCount]
+//   vertex data (EncodedVertices::data, vertexBytes)
+//   index data (PackedIndices::data, indexBytes)
+//
+// Files whose version or vertex layout differ from what the app expects are rejected so it can fall
+// back to loading the source asset.
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "core/meshData.h"
+#include "core/vertexLayout.h"
+#include "core/indexFormat.h"
+
+constexpr uint32_t COOKED_MESH_MAGIC = 0x4853454d; // "MESH"
+constexpr uint32_t COOKED_MESH_VERSION = 1;
+
+struct CookedMeshHeader
+{
+	uint32_t magic = COOKED_MESH_MAGIC;
+	uint32_t version = COOKED_MESH_VERSION;
+	uint8_t positionFormat = 0;
+	uint8_t texCoordFormat = 0;
+	uint8_t normalFormat = 0;
+	uint8_t indexFormat = 0;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	uint32_t lodCount = 0;
+	float quantizationScale[4] = {};
+	float quantizationOffset[4] = {};
+	float boundsMin[3] = {};
+	float boundsMax[3] = {};
+	uint64_t attributeOffset = 0;
+	uint64_t vertexBytes = 0;
+	uint64_t indexBytes = 0;
+};
+
+struct CookedMesh
+{
+	EncodedVertices vertices;
+	PackedIndices indices;
+	std::vector<MeshLod> lods;
+	MeshBounds bounds;
+};
+
+inline std::vector<uint8_t> serializeCookedMesh(const CookedMesh& mesh)
+{
+	CookedMeshHeader header
+	{
+		.positionFormat = static_cast<uint8_t>(mesh.vertices.layout.position),
+		.texCoordFormat = static_cast<uint8_t>(mesh.vertices.layout.texCoord),
+		.normalFormat = static_cast<uint8_t>(mesh.vertices.layout.normal),
+		.indexFormat = static_cast<uint8_t>(mesh.indices.format),
+		.vertexCount = mesh.vertices.count,
+		.indexCount = mesh.indices.count,
+		.lodCount = static_cast<uint32_t>(mesh.lods.size()),
+		.attributeOffset = mesh.vertices.attributeOffset,
+		.vertexBytes = mesh.vertices.data.size(),
+		.indexBytes = mesh.indices.data.size()
+	};
+	std::memcpy(header.quantizationScale, &mesh.vertices.quantization.scale, sizeof(header.quantizationScale));
+	std::memcpy(header.quantizationOffset, &mesh.vertices.quantization.offset, sizeof(header.quantizationOffset));
+	std::memcpy(header.boundsMin, &mesh.bounds.min, sizeof(header.boundsMin));
+	std::memcpy(header.boundsMax, &mesh.bounds.max, sizeof(header.boundsMax));
+
+	size_t lodBytes = mesh.lods.size() * sizeof(MeshLod);
+	std::vector<uint8_t> bytes(sizeof(header) + lodBytes + mesh.vertices.data.size() + mesh.indices.data.size());
+
+	uint8_t* cursor = bytes.data();
+	std::memcpy(cursor, &header, sizeof(header));
+	cursor += sizeof(header);
+	std::memcpy(cursor, mesh.lods.data(), lodBytes);
+	cursor += lodBytes;
+	std::memcpy(cursor, mesh.vertices.data.data(), mesh.vertices.data.size());
+	cursor += mesh.vertices.data.size();
+	std::memcpy(cursor, mesh.indices.data.data(), mesh.indices.data.size());
+
+	return bytes;
+}
+
+// A cooked mesh whose vertex and index bytes are left where they are, e.g. in a mapped asset pack, so
+// they can be copied straight into staging memory. vertices.data and indices.data stay empty.
+struct CookedMeshView
+{
+	CookedMesh mesh;
+	std::span<const uint8_t> vertexData;
+	std::span<const uint8_t> indexData;
+};
+
+// Parses the header and LOD table of a cooked mesh in memory. Throws on malformed data.
+inline CookedMeshView viewCookedMesh(const uint8_t* data, size_t size)
+{
+	CookedMeshHeader header;
+	if (size < sizeof(header))
+		throw std::runtime_error("cooked mesh is truncated!");
+
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != COOKED_MESH_MAGIC)
+		throw std::runtime_error("not a cooked mesh!");
+	if (header.version != COOKED_MESH_VERSION)
+		throw std::runtime_error("cooked mesh version mismatch, re-run the asset cooker!");
+
+	size_t lodBytes = static_cast<size_t>(header.lodCount) * sizeof(MeshLod);
+	if (size < sizeof(header) + lodBytes + header.vertexBytes + header.indexBytes)
+		throw std::runtime_error("cooked mesh is truncated!");
+
+	CookedMeshView view;
+	CookedMesh& mesh = view.mesh;
+	mesh.vertices.layout = {
+		static_cast<PositionFormat>(header.positionFormat),
+		static_cast<TexCoordFormat>(header.texCoordFormat),
+		static_cast<NormalFormat>(header.normalFormat)
+	};
+	std::memcpy(&mesh.vertices.quantization.scale, header.quantizationScale, sizeof(header.quantizationScale));
+	std::memcpy(&mesh.vertices.quantization.offset, header.quantizationOffset, sizeof(header.quantizationOffset));
+	std::memcpy(&mesh.bounds.min, header.boundsMin, sizeof(header.boundsMin));
+	std::memcpy(&mesh.bounds.max, header.boundsMax, sizeof(header.boundsMax));
+	mesh.vertices.count = header.vertexCount;
+	mesh.vertices.attributeOffset = header.attributeOffset;
+	mesh.indices.format = static_cast<IndexFormat>(header.indexFormat);
+	mesh.indices.count = header.indexCount;
+
+	const uint8_t* cursor = data + sizeof(header);
+	mesh.lods.resize(header.lodCount);
+	std::memcpy(mesh.lods.data(), cursor, lodBytes);
+	cursor += lodBytes;
+	view.vertexData = { cursor, static_cast<size_t>(header.vertexBytes) };
+	cursor += header.vertexBytes;
+	view.indexData = { cursor, static_cast<size_t>(header.indexBytes) };
+
+	return view;
+}
+
+// Parses a cooked mesh from memory into owning buffers. Throws on malformed data.
+inline CookedMesh parseCookedMesh(const uint8_t* data, size_t size)
+{
+	CookedMeshView view = viewCookedMesh(data, size);
+	view.mesh.vertices.data.assign(view.vertexData.begin(), view.vertexData.end());
+	view.mesh.indices.data.assign(view.indexData.begin(), view.indexData.end());
+	return std::move(view.mesh);
+}
+
+inline void writeCookedMesh(const std::filesystem::path& path, const CookedMesh& mesh)
+{
+	std::vector<uint8_t> bytes = serializeCookedMesh(mesh);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw std::runtime_error("failed to write cooked mesh: " + path.string());
+
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+inline CookedMesh readCookedMesh(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		throw std::runtime_error("failed to open cooked mesh: " + path.string());
+
+	std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	return parseCookedMesh(bytes.data(), bytes.size());
+}
+
+inline bool matchesLayout(const CookedMesh& mesh, const VertexLayout& layout)
+{
+	const VertexLayout& cooked = mesh.vertices.layout;
+	return cooked.position == layout.position && cooked.texCoord == layout.texCoord && cooked.normal == layout.normal;
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+// Lightweight CPU zone tracer with Chrome trace-event (JSON) export.
+//
+// Every thread writes completed zones into its own fixed-size ring buffer: the owning thread is the
+// only writer, so recording a zone is two clock reads plus a store, with no locks or allocations.
+// The exporter reads all rings and drops entries that were overwritten while it was reading.
+// GPU timings can be added on a separate track once they are converted to the CPU clock.
+// The output loads in chrome://tracing and in Perfetto (ui.perfetto.dev).
+//
+// Define VSA_DISABLE_TRACING to compile all zones out.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class CpuTracer
+{
+public:
+	static constexpr size_t EVENTS_PER_THREAD = 1 << 14;
+	static constexpr size_t MAX_GPU_EVENTS = 1 << 14;
+
+	struct Event
+	{
+		const char* name = nullptr;
+		uint64_t beginNs = 0;
+		uint64_t endNs = 0;
+	};
+
+	static CpuTracer& instance()
+	{
+		static CpuTracer tracer;
+		return tracer;
+	}
+
+	// Same clock the GPU timestamps are calibrated against.
+	static uint64_t now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	// name must outlive the tracer (string literals in practice).
+	void record(const char* name, uint64_t beginNs, uint64_t endNs)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		uint64_t head = buffer.head.load(std::memory_order_relaxed);
+		buffer.events[head % EVENTS_PER_THREAD] = { name, beginNs, endNs };
+		buffer.head.store(head + 1, std::memory_order_release);
+	}
+
+	void setThreadName(const std::string& name)
+	{
+		ThreadBuffer& buffer = threadBuffer();
+		std::lock_guard lock(mutex);
+		buffer.name = name;
+	}
+
+	void addGpuEvent(const std::string& name, uint64_t beginNs, uint64_t endNs)
+	{
+		std::lock_guard lock(mutex);
+		if (gpuEvents.size() < MAX_GPU_EVENTS)
+			gpuEvents.push_back({ name, beginNs, endNs });
+		else
+			gpuEvents[gpuEventHead % MAX_GPU_EVENTS] = { name, beginNs, endNs };
+		gpuEventHead++;
+	}
+
+	bool exportChromeTrace(const std::string& path)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		std::lock_guard lock(mutex);
+		uint64_t origin = std::numeric_limits<uint64_t>::max();
+
+		struct Snapshot
+		{
+			uint32_t threadId;
+			std::string name;
+			std::vector<Event> events;
+		};
+		std::vector<Snapshot> snapshots;
+
+		for (const auto& buffer : buffers)
+		{
+			Snapshot snapshot{ buffer->threadId, buffer->name, {} };
+
+			uint64_t head = buffer->head.load(std::memory_order_acquire);
+			uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+			snapshot.events.reserve(head - first);
+			for (uint64_t i = first; i < head; i++)
+				snapshot.events.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+
+			// The writer kept going while we copied: anything it may have overwritten is dropped
+			uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+			if (headAfter > EVENTS_PER_THREAD + first)
+			{
+				size_t overwritten = static_cast<size_t>(std::min<uint64_t>(headAfter - EVENTS_PER_THREAD - first, snapshot.events.size()));
+				snapshot.events.erase(snapshot.events.begin(), snapshot.events.begin() + static_cast<std::ptrdiff_t>(overwritten));
+			}
+
+			for (const Event& event : snapshot.events)
+				origin = std::min(origin, event.beginNs);
+
+			snapshots.push_back(std::move(snapshot));
+		}
+
+		for (const GpuEvent& event : gpuEvents)
+			origin = std::min(origin, event.beginNs);
+
+		if (origin == std::numeric_limits<uint64_t>::max())
+			origin = 0;
+
+		auto microseconds = [origin](uint64_t ns)
+			{
+				return static_cast<double>(ns - std::min(ns, origin)) / 1000.0;
+			};
+
+		file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+		file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+		for (const Snapshot& snapshot : snapshots)
+		{
+			file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << snapshot.threadId
+				<< ",\"args\":{\"name\":\"" << snapshot.name << "\"}}";
+
+			for (const Event& event : snapshot.events)
+				file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << snapshot.threadId
+					<< ",\"ts\":" << microseconds(event.beginNs) << ",\"dur\":" << static_cast<double>(event.endNs - event.beginNs) / 1000.0 << "}";
+		}
+
+		for (const GpuEvent& event : gpuEvents)
+			file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":2,\"tid\":1"
+				<< ",\"ts\":" << microseconds(event.beginNs) << ",\"dur\":" << static_cast<double>(event.endNs - event.beginNs) / 1000.0 << "}";
+
+		file << "\n]}\n";
+		return true;
+	}
+
+	// Writes the trace when VSA_TRACE=<path> is set.
+	void exportFromEnvironment()
+	{
+		const char* path = std::getenv("VSA_TRACE");
+		if (path == nullptr || path[0] == '\0')
+			return;
+
+		if (exportChromeTrace(path))
+			std::cout << "CPU trace written to " << path << std::endl;
+		else
+			std::cerr << "failed to write CPU trace to " << path << std::endl;
+	}
+
+private:
+	struct ThreadBuffer
+	{
+		std::array<Event, EVENTS_PER_THREAD> events{};
+		std::atomic<uint64_t> head{ 0 };
+		uint32_t threadId = 0;
+		std::string name;
+	};
+
+	struct GpuEvent
+	{
+		std::string name;
+		uint64_t beginNs;
+		uint64_t endNs;
+	};
+
+	CpuTracer() = default;
+
+	ThreadBuffer& threadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+		{
+			auto newBuffer = std::make_unique<ThreadBuffer>();
+			std::lock_guard lock(mutex);
+			newBuffer->threadId = static_cast<uint32_t>(buffers.size()) + 1;
+			newBuffer->name = newBuffer->threadId == 1 ? "main" : "thread " + std::to_string(newBuffer->threadId);
+			buffer = newBuffer.get();
+			buffers.push_back(std::move(newBuffer));
+		}
+
+		return *buffer;
+	}
+
+	std::mutex mutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	std::vector<GpuEvent> gpuEvents;
+	uint64_t gpuEventHead = 0;
+};
+
+class CpuTraceZone
+{
+public:
+	explicit CpuTraceZone(const char* name)
+		: name(name), beginNs(CpuTracer::now())
+	{
+	}
+
+	~CpuTraceZone()
+	{
+		CpuTracer::instance().record(name, beginNs, CpuTracer::now());
+	}
+
+	CpuTraceZone(const CpuTraceZone&) = delete;
+	CpuTraceZone& operator=(const CpuTraceZone&) = delete;
+
+private:
+	const char* name;
+	uint64_t beginNs;
+};
+
+#define VSA_TRACE_CONCAT_INNER(a, b) a##b
+#define VSA_TRACE_CONCAT(a, b) VSA_TRACE_CONCAT_INNER(a, b)
+
+#ifdef VSA_DISABLE_TRACING
+#define VSA_TRACE_ZONE(name) ((void)0)
+#else
+#define VSA_TRACE_ZONE(name) CpuTraceZone VSA_TRACE_CONCAT(traceZone, __LINE__)(name)
+#endif
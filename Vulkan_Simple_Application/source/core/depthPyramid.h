@@ -0,0 +1,270 @@
+#pragma once
+
+// Hierarchical-Z depth pyramid for occlusion culling.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// A compute pass (resources/shaders/compute/shader_depth_pyramid.slang) reduces the depth buffer into
+// an R32 float image with a full mip chain, each texel holding the farthest depth of the region it
+// covers. Mip 0 is the largest power of two that fits the depth buffer, so every level halves exactly.
+// The pyramid stays in the general layout; readers Load() texels and take the max over the footprint.
+//
+// The barriers around a build are the caller's (see renderGraph.h): the depth buffer must be readable by
+// compute shaders in eDepthStencilReadOnlyOptimal, pyramidImage() is written as a storage image in the general
+// layout, and its readers must wait for those writes. Only the barriers between mips are recorded here, and
+// the one-time move of a new pyramid to the general layout (initializeLayout()).
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class DepthPyramid
+{
+public:
+	static constexpr uint32_t WORKGROUP_SIZE = 8; // must match numthreads in shader_depth_pyramid.slang; 2D, so not tuned
+
+	// shaderCode is the SPIR-V of resources/shaders/compute/slang_depth_pyramid.spv.
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, const std::vector<char>& shaderCode)
+	{
+		memoryProperties = physicalDevice.getMemoryProperties();
+		createPipeline(device, shaderCode);
+	}
+
+	/**
+	* (Re)creates the pyramid for a depth buffer; call after init() and whenever the depth buffer is
+	* recreated, while the device is idle.
+	*/
+	void resize(const vk::raii::Device& device, vk::ImageView depthView, vk::Extent2D depthExtent)
+	{
+		inputExtent = depthExtent;
+		pyramidWidth = std::bit_floor(std::max(depthExtent.width, 1u));
+		pyramidHeight = std::bit_floor(std::max(depthExtent.height, 1u));
+		mipCount = static_cast<uint32_t>(std::bit_width(std::max(pyramidWidth, pyramidHeight)));
+
+		mipViews.clear();
+		descriptorSets.clear();
+		fullView = nullptr;
+		image = nullptr;
+		memory = nullptr;
+
+		vk::ImageCreateInfo imageInfo
+		{
+			.imageType = vk::ImageType::e2D,
+			.format = vk::Format::eR32Sfloat,
+			.extent = { pyramidWidth, pyramidHeight, 1 },
+			.mipLevels = mipCount,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		image = vk::raii::Image(device, imageInfo);
+
+		vk::MemoryRequirements requirements = image.getMemoryRequirements();
+		memory = vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal) });
+		image.bindMemory(*memory, 0);
+
+		vk::ImageViewCreateInfo viewInfo
+		{
+			.image = *image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = vk::Format::eR32Sfloat,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mipCount, 0, 1 }
+		};
+		fullView = vk::raii::ImageView(device, viewInfo);
+
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			viewInfo.subresourceRange = { vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1 };
+			mipViews.emplace_back(device, viewInfo);
+		}
+
+		// One set per mip: reads the depth buffer (mip 0) or the previous mip, writes this mip
+		std::array poolSizes = {
+			vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, mipCount),
+			vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, mipCount)
+		};
+		descriptorPool = vk::raii::DescriptorPool(device, vk::DescriptorPoolCreateInfo{ .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, .maxSets = mipCount, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() });
+
+		std::vector<vk::DescriptorSetLayout> layouts(mipCount, *descriptorSetLayout);
+		descriptorSets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{ .descriptorPool = *descriptorPool, .descriptorSetCount = mipCount, .pSetLayouts = layouts.data() });
+
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			vk::DescriptorImageInfo inputInfo
+			{
+				.imageView = mip == 0 ? depthView : *mipViews[mip - 1],
+				.imageLayout = mip == 0 ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eGeneral
+			};
+			vk::DescriptorImageInfo outputInfo{ .imageView = *mipViews[mip], .imageLayout = vk::ImageLayout::eGeneral };
+
+			std::array writes = {
+				vk::WriteDescriptorSet{ .dstSet = *descriptorSets[mip], .dstBinding = 0, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eSampledImage, .pImageInfo = &inputInfo },
+				vk::WriteDescriptorSet{ .dstSet = *descriptorSets[mip], .dstBinding = 1, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = &outputInfo }
+			};
+			device.updateDescriptorSets(writes, {});
+		}
+	}
+
+	[[nodiscard]] bool ready() const
+	{
+		return mipCount > 0;
+	}
+
+	// Moves the pyramid of the last resize() to the general layout, which it keeps from then on.
+	void initializeLayout(const vk::raii::CommandBuffer& commandBuffer) const
+	{
+		vk::ImageMemoryBarrier2 barrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = {},
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead | vk::AccessFlagBits2::eShaderStorageWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eGeneral,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = *image,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mipCount, 0, 1 }
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &barrier });
+	}
+
+	// Builds the pyramid from the depth buffer given to resize().
+	void record(const vk::raii::CommandBuffer& commandBuffer) const
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+
+		vk::MemoryBarrier2 mipBarrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead
+		};
+
+		for (uint32_t mip = 0; mip < mipCount; mip++)
+		{
+			PyramidConstants constants
+			{
+				.inputWidth = mip == 0 ? inputExtent.width : mipWidth(mip - 1),
+				.inputHeight = mip == 0 ? inputExtent.height : mipHeight(mip - 1),
+				.outputWidth = mipWidth(mip),
+				.outputHeight = mipHeight(mip)
+			};
+
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, *descriptorSets[mip], nullptr);
+			commandBuffer.pushConstants<PyramidConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+			commandBuffer.dispatch((constants.outputWidth + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, (constants.outputHeight + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+			if (mip + 1 < mipCount)
+				commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &mipBarrier });
+		}
+	}
+
+	[[nodiscard]] vk::Image pyramidImage() const
+	{
+		return *image;
+	}
+
+	// View of every mip, in the general layout.
+	[[nodiscard]] const vk::raii::ImageView& view() const
+	{
+		return fullView;
+	}
+
+	[[nodiscard]] uint32_t width() const
+	{
+		return pyramidWidth;
+	}
+
+	[[nodiscard]] uint32_t height() const
+	{
+		return pyramidHeight;
+	}
+
+	[[nodiscard]] uint32_t mips() const
+	{
+		return mipCount;
+	}
+
+private:
+	struct PyramidConstants
+	{
+		uint32_t inputWidth;
+		uint32_t inputHeight;
+		uint32_t outputWidth;
+		uint32_t outputHeight;
+	};
+
+	[[nodiscard]] uint32_t mipWidth(uint32_t mip) const
+	{
+		return std::max(pyramidWidth >> mip, 1u);
+	}
+
+	[[nodiscard]] uint32_t mipHeight(uint32_t mip) const
+	{
+		return std::max(pyramidHeight >> mip, 1u);
+	}
+
+	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if ((typeFilter & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+				return i;
+
+		throw std::runtime_error("failed to find a memory type for the depth pyramid!");
+	}
+
+	void createPipeline(const vk::raii::Device& device, const std::vector<char>& shaderCode)
+	{
+		std::array bindings = {
+			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eSampledImage, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute, nullptr)
+		};
+		descriptorSetLayout = vk::raii::DescriptorSetLayout(device, vk::DescriptorSetLayoutCreateInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() });
+
+		vk::PushConstantRange pushConstantRange
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eCompute,
+			.offset = 0,
+			.size = sizeof(PyramidConstants)
+		};
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo
+		{
+			.setLayoutCount = 1,
+			.pSetLayouts = &*descriptorSetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
+		};
+		pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
+
+		vk::raii::ShaderModule shaderModule(device, vk::ShaderModuleCreateInfo{ .codeSize = shaderCode.size(), .pCode = reinterpret_cast<const uint32_t*>(shaderCode.data()) });
+		vk::ComputePipelineCreateInfo pipelineInfo
+		{
+			.stage = { .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "downsampleMain" },
+			.layout = *pipelineLayout
+		};
+		pipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+	}
+
+	vk::PhysicalDeviceMemoryProperties memoryProperties{};
+	vk::Extent2D inputExtent{};
+	uint32_t pyramidWidth = 0;
+	uint32_t pyramidHeight = 0;
+	uint32_t mipCount = 0;
+
+	vk::raii::Image image = nullptr;
+	vk::raii::DeviceMemory memory = nullptr;
+	vk::raii::ImageView fullView = nullptr;
+	std::vector<vk::raii::ImageView> mipViews;
+
+	vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
+	vk::raii::PipelineLayout pipelineLayout = nullptr;
+	vk::raii::Pipeline pipeline = nullptr;
+	vk::raii::DescriptorPool descriptorPool = nullptr;
+	std::vector<vk::raii::DescriptorSet> descriptorSets;
+};
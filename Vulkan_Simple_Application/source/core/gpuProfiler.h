@@ -0,0 +1,581 @@
+#pragma once
+
+// GPU timestamp / pipeline-statistics profiler.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Every frame in flight owns its own query pools. Scopes write a timestamp pair (and optionally
+// a pipeline-statistics query) into the pools of the current frame; the results are collected the
+// next time that frame slot comes around (after its fence wait), so reading them never stalls.
+// Query pools are reset from the host, which needs VkPhysicalDeviceHostQueryResetFeatures::hostQueryReset.
+// After calibrate(), resolved scopes are also forwarded to the CPU tracer on the CPU timeline.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/cpuTracer.h"
+
+class GpuProfiler
+{
+	struct FrameQueries;
+
+	struct PendingScope
+	{
+		uint32_t pass;
+		uint32_t timestampQuery;
+		uint32_t statisticsQuery;
+	};
+
+public:
+	static constexpr uint32_t PIPELINE_STATISTIC_COUNT = 6;
+	static constexpr size_t HISTORY_SIZE = 256;
+
+	struct PassStatistics
+	{
+		std::string name;
+		size_t samples = 0;
+		double lastMs = 0.0;
+		double minMs = 0.0;
+		double avgMs = 0.0;
+		double p99Ms = 0.0;
+		bool hasPipelineStatistics = false;
+		std::array<uint64_t, PIPELINE_STATISTIC_COUNT> pipelineStatistics{};
+	};
+
+	// A resolved timestamp pair in raw device ticks, kept for the most recently collected frame.
+	struct ResolvedScope
+	{
+		uint32_t pass = 0;
+		uint64_t beginTicks = 0;
+		uint64_t endTicks = 0;
+	};
+
+	class Scope
+	{
+	public:
+		Scope(GpuProfiler& profiler, const vk::raii::CommandBuffer& commandBuffer, const char* name, bool pipelineStatistics)
+			: profiler(profiler), commandBuffer(commandBuffer)
+		{
+			if (!profiler.enabled())
+				return;
+
+			FrameQueries& frame = *profiler.frames[profiler.currentFrame];
+			timestampQuery = frame.nextTimestamp.fetch_add(2, std::memory_order_relaxed);
+			if (timestampQuery + 2 > profiler.maxScopes * 2)
+			{
+				timestampQuery = INVALID_QUERY;
+				return;
+			}
+
+			if (pipelineStatistics && profiler.pipelineStatisticsEnabled)
+			{
+				statisticsQuery = frame.nextStatistics.fetch_add(1, std::memory_order_relaxed);
+				if (statisticsQuery >= profiler.maxScopes)
+					statisticsQuery = INVALID_QUERY;
+			}
+
+			frameQueries = &frame;
+			profiler.addPendingScope(frame, name, timestampQuery, statisticsQuery);
+
+			commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, frame.timestamps, timestampQuery);
+			if (statisticsQuery != INVALID_QUERY)
+				commandBuffer.beginQuery(frame.statistics, statisticsQuery, {});
+		}
+
+		~Scope()
+		{
+			if (frameQueries == nullptr)
+				return;
+
+			if (statisticsQuery != INVALID_QUERY)
+				commandBuffer.endQuery(frameQueries->statistics, statisticsQuery);
+			commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, frameQueries->timestamps, timestampQuery + 1);
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		GpuProfiler& profiler;
+		const vk::raii::CommandBuffer& commandBuffer;
+		FrameQueries* frameQueries = nullptr;
+		uint32_t timestampQuery = INVALID_QUERY;
+		uint32_t statisticsQuery = INVALID_QUERY;
+	};
+
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, uint32_t queueFamilyIndex, uint32_t framesInFlight, bool pipelineStatistics, uint32_t scopesPerFrame = 64)
+	{
+		auto properties = physicalDevice.getProperties();
+		timestampValidBits = physicalDevice.getQueueFamilyProperties()[queueFamilyIndex].timestampValidBits;
+		timestampPeriod = properties.limits.timestampPeriod;
+		this->queueFamilyIndex = queueFamilyIndex;
+		calibrated = false;
+		maxScopes = scopesPerFrame;
+		pipelineStatisticsEnabled = pipelineStatistics;
+
+		frames.clear();
+		if (timestampValidBits == 0)
+		{
+			std::cout << "GPU profiler disabled: queue family " << queueFamilyIndex << " has no timestamp support" << std::endl;
+			return;
+		}
+
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			auto frame = std::make_unique<FrameQueries>();
+			frame->timestamps = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo
+				{
+					.queryType = vk::QueryType::eTimestamp,
+					.queryCount = maxScopes * 2
+				});
+			frame->timestamps.reset(0, maxScopes * 2);
+
+			if (pipelineStatisticsEnabled)
+			{
+				frame->statistics = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo
+					{
+						.queryType = vk::QueryType::ePipelineStatistics,
+						.queryCount = maxScopes,
+						.pipelineStatistics = pipelineStatisticFlags()
+					});
+				frame->statistics.reset(0, maxScopes);
+			}
+
+			frames.push_back(std::move(frame));
+		}
+
+		oneShotTimestamps = vk::raii::QueryPool(device, vk::QueryPoolCreateInfo{ .queryType = vk::QueryType::eTimestamp, .queryCount = 2 });
+	}
+
+	[[nodiscard]] bool enabled() const
+	{
+		return !frames.empty();
+	}
+
+	/**
+	* Measures the offset between device timestamps and CpuTracer::now() so GPU scopes can be placed on
+	* the CPU trace. Submits an empty command buffer that writes one timestamp and assumes the GPU wrote
+	* it halfway between submit and fence signal; the tightest of a few rounds wins. The error is bounded
+	* by half the submit round trip (typically tens of microseconds), which is plenty for frame traces
+	* and needs no VK_KHR_calibrated_timestamps. Call while the queue is idle.
+	*/
+	void calibrate(const vk::raii::Device& device, const vk::raii::Queue& queue)
+	{
+		if (!enabled())
+			return;
+
+		vk::raii::CommandPool commandPool(device, vk::CommandPoolCreateInfo{ .queueFamilyIndex = queueFamilyIndex });
+		vk::raii::CommandBuffer commandBuffer = std::move(vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo
+			{
+				.commandPool = commandPool,
+				.level = vk::CommandBufferLevel::ePrimary,
+				.commandBufferCount = 1
+			}).front());
+		vk::raii::QueryPool queryPool(device, vk::QueryPoolCreateInfo{ .queryType = vk::QueryType::eTimestamp, .queryCount = 1 });
+		vk::raii::Fence fence(device, vk::FenceCreateInfo{});
+
+		commandBuffer.begin(vk::CommandBufferBeginInfo{});
+		commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, queryPool, 0);
+		commandBuffer.end();
+
+		uint64_t mask = timestampValidBits >= 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+		uint64_t bestRoundTrip = std::numeric_limits<uint64_t>::max();
+
+		for (uint32_t round = 0; round < 5; round++)
+		{
+			queryPool.reset(0, 1);
+			device.resetFences(*fence);
+
+			uint64_t cpuBefore = CpuTracer::now();
+			queue.submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*commandBuffer }, *fence);
+			while (vk::Result::eTimeout == device.waitForFences(*fence, vk::True, UINT64_MAX))
+				;
+			uint64_t cpuAfter = CpuTracer::now();
+
+			auto [result, ticks] = queryPool.getResult<uint64_t>(0, 1, sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+			if (result != vk::Result::eSuccess || cpuAfter - cpuBefore >= bestRoundTrip)
+				continue;
+
+			bestRoundTrip = cpuAfter - cpuBefore;
+			cpuOffsetNs = static_cast<double>(cpuBefore + bestRoundTrip / 2) - ticksToNanoseconds(ticks & mask);
+			calibrated = true;
+		}
+	}
+
+	[[nodiscard]] uint64_t ticksToCpuNanoseconds(uint64_t ticks) const
+	{
+		return static_cast<uint64_t>(ticksToNanoseconds(ticks) + cpuOffsetNs);
+	}
+
+	// Call once the fence of frameIndex has been waited on and before anything records scopes for it.
+	void beginFrame(uint32_t frameIndex)
+	{
+		if (!enabled())
+			return;
+
+		FrameQueries& frame = *frames[frameIndex];
+		collect(frame);
+
+		uint32_t usedTimestamps = std::min(frame.nextTimestamp.load(), maxScopes * 2);
+		if (usedTimestamps > 0)
+			frame.timestamps.reset(0, usedTimestamps);
+
+		uint32_t usedStatistics = std::min(frame.nextStatistics.load(), maxScopes);
+		if (usedStatistics > 0)
+			frame.statistics.reset(0, usedStatistics);
+
+		frame.pending.clear();
+		frame.nextTimestamp = 0;
+		frame.nextStatistics = 0;
+		currentFrame = frameIndex;
+	}
+
+	// The scopes recorded for the current frame so far, kept with a command buffer that is submitted again.
+	struct RecordedScopes
+	{
+		std::vector<PendingScope> scopes;
+		uint32_t timestamps = 0;
+		uint32_t statistics = 0;
+	};
+
+	[[nodiscard]] RecordedScopes recordedScopes() const
+	{
+		if (!enabled())
+			return {};
+
+		const FrameQueries& frame = *frames[currentFrame];
+		std::lock_guard lock(mutex);
+		return { frame.pending, frame.nextTimestamp.load(), frame.nextStatistics.load() };
+	}
+
+	/**
+	* Registers the scopes of a command buffer that is submitted again instead of being recorded, as if it
+	* had just recorded them; call right after beginFrame(). The buffer must have been recorded for the same
+	* frame slot, since its queries are that slot's, and beginFrame() left them all reset.
+	*/
+	void replay(const RecordedScopes& recorded)
+	{
+		if (!enabled())
+			return;
+
+		FrameQueries& frame = *frames[currentFrame];
+		std::lock_guard lock(mutex);
+		frame.pending = recorded.scopes;
+		frame.nextTimestamp = recorded.timestamps;
+		frame.nextStatistics = recorded.statistics;
+	}
+
+	// Pipeline-statistics scopes must not nest, and must begin and end on the same side of beginRendering/endRendering.
+	[[nodiscard]] Scope scope(const vk::raii::CommandBuffer& commandBuffer, const char* name, bool pipelineStatistics = false)
+	{
+		return Scope(*this, commandBuffer, name, pipelineStatistics);
+	}
+
+	[[nodiscard]] std::vector<PassStatistics> statistics() const
+	{
+		std::lock_guard lock(mutex);
+
+		std::vector<PassStatistics> result;
+		for (const auto& pass : passes)
+		{
+			PassStatistics stats
+			{
+				.name = pass.name,
+				.samples = pass.count,
+				.hasPipelineStatistics = pass.hasPipelineStatistics,
+				.pipelineStatistics = pass.pipelineStatistics
+			};
+
+			size_t sampleCount = std::min(pass.count, HISTORY_SIZE);
+			if (sampleCount > 0)
+			{
+				std::vector<double> sorted(pass.history.begin(), pass.history.begin() + static_cast<std::ptrdiff_t>(sampleCount));
+				std::ranges::sort(sorted);
+
+				double sum = 0.0;
+				for (double sample : sorted)
+					sum += sample;
+
+				stats.lastMs = pass.history[(pass.count - 1) % HISTORY_SIZE];
+				stats.minMs = sorted.front();
+				stats.avgMs = sum / static_cast<double>(sampleCount);
+				stats.p99Ms = sorted[std::min(sampleCount - 1, static_cast<size_t>(static_cast<double>(sampleCount) * 0.99))];
+			}
+
+			result.push_back(stats);
+		}
+
+		return result;
+	}
+
+	// Drops all collected samples, e.g. once a benchmark warm-up is over. Pass names are kept.
+	void resetStatistics()
+	{
+		std::lock_guard lock(mutex);
+		for (Pass& pass : passes)
+			pass = Pass{ .name = pass.name };
+	}
+
+	/**
+	* Times one-off work such as startup uploads, outside the per-frame scopes: record beginOneShot() and
+	* endOneShot() around it, then read oneShotMs() once the command buffer has completed.
+	*/
+	void beginOneShot(const vk::raii::CommandBuffer& commandBuffer) const
+	{
+		if (!enabled())
+			return;
+
+		commandBuffer.resetQueryPool(*oneShotTimestamps, 0, 2);
+		commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *oneShotTimestamps, 0);
+	}
+
+	void endOneShot(const vk::raii::CommandBuffer& commandBuffer) const
+	{
+		if (enabled())
+			commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *oneShotTimestamps, 1);
+	}
+
+	// Milliseconds between the last beginOneShot()/endOneShot() pair, or 0 without timestamp support.
+	[[nodiscard]] double oneShotMs() const
+	{
+		if (!enabled())
+			return 0.0;
+
+		auto [result, ticks] = oneShotTimestamps.getResults<uint64_t>(0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+		if (result != vk::Result::eSuccess)
+			return 0.0;
+
+		uint64_t mask = timestampValidBits >= 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+		return ticksToNanoseconds((ticks[1] - ticks[0]) & mask) / 1e6;
+	}
+
+	[[nodiscard]] std::vector<ResolvedScope> lastResolvedScopes() const
+	{
+		std::lock_guard lock(mutex);
+		return lastResolved;
+	}
+
+	[[nodiscard]] std::string passName(uint32_t pass) const
+	{
+		std::lock_guard lock(mutex);
+		return pass < passes.size() ? passes[pass].name : std::string();
+	}
+
+	[[nodiscard]] double ticksToNanoseconds(uint64_t ticks) const
+	{
+		return static_cast<double>(ticks) * timestampPeriod;
+	}
+
+	bool exportCsv(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file << "pass,samples,last_ms,min_ms,avg_ms,p99_ms";
+		for (const char* statisticName : pipelineStatisticNames())
+			file << "," << statisticName;
+		file << "\n";
+
+		file << std::fixed << std::setprecision(4);
+		for (const auto& pass : statistics())
+		{
+			file << pass.name << "," << pass.samples << "," << pass.lastMs << "," << pass.minMs << "," << pass.avgMs << "," << pass.p99Ms;
+			for (uint64_t value : pass.pipelineStatistics)
+			{
+				file << ",";
+				if (pass.hasPipelineStatistics)
+					file << value;
+			}
+			file << "\n";
+		}
+
+		return true;
+	}
+
+	bool exportJson(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file << "{\n  \"passes\": " << toJson("  ") << "\n}\n";
+		return true;
+	}
+
+	// JSON array of passes, shared with the benchmark report.
+	[[nodiscard]] std::string toJson(const std::string& indent = "") const
+	{
+		std::ostringstream json;
+		json << std::fixed << std::setprecision(4) << "[";
+
+		auto passStatistics = statistics();
+		for (size_t i = 0; i < passStatistics.size(); i++)
+		{
+			const auto& pass = passStatistics[i];
+			json << (i == 0 ? "\n" : ",\n") << indent << "  { \"name\": \"" << pass.name << "\", \"samples\": " << pass.samples
+				<< ", \"last_ms\": " << pass.lastMs << ", \"min_ms\": " << pass.minMs << ", \"avg_ms\": " << pass.avgMs << ", \"p99_ms\": " << pass.p99Ms;
+
+			if (pass.hasPipelineStatistics)
+			{
+				json << ", \"pipeline_statistics\": {";
+				for (uint32_t s = 0; s < PIPELINE_STATISTIC_COUNT; s++)
+					json << (s == 0 ? " " : ", ") << "\"" << pipelineStatisticNames()[s] << "\": " << pass.pipelineStatistics[s];
+				json << " }";
+			}
+			json << " }";
+		}
+
+		json << (passStatistics.empty() ? "]" : "\n" + indent + "]");
+		return json.str();
+	}
+
+	// Writes <prefix>.csv and <prefix>.json when VSA_GPU_PROFILE=<prefix> is set.
+	void exportFromEnvironment() const
+	{
+		const char* prefix = std::getenv("VSA_GPU_PROFILE");
+		if (prefix == nullptr || prefix[0] == '\0' || !enabled())
+			return;
+
+		if (!exportCsv(std::string(prefix) + ".csv") || !exportJson(std::string(prefix) + ".json"))
+			std::cerr << "failed to write GPU profile to " << prefix << std::endl;
+		else
+			std::cout << "GPU profile written to " << prefix << ".csv/.json" << std::endl;
+	}
+
+	static vk::QueryPipelineStatisticFlags pipelineStatisticFlags()
+	{
+		// Results come back in bit order, which matches pipelineStatisticNames()
+		return vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+			vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+			vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+			vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+	}
+
+	static const std::array<const char*, PIPELINE_STATISTIC_COUNT>& pipelineStatisticNames()
+	{
+		static const std::array<const char*, PIPELINE_STATISTIC_COUNT> names =
+		{
+			"ia_vertices", "ia_primitives", "vs_invocations", "clipping_primitives", "fs_invocations", "cs_invocations"
+		};
+		return names;
+	}
+
+private:
+	static constexpr uint32_t INVALID_QUERY = ~0u;
+
+	struct FrameQueries
+	{
+		vk::raii::QueryPool timestamps = nullptr;
+		vk::raii::QueryPool statistics = nullptr;
+		std::atomic<uint32_t> nextTimestamp{ 0 };
+		std::atomic<uint32_t> nextStatistics{ 0 };
+		std::vector<PendingScope> pending;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		std::array<double, HISTORY_SIZE> history{};
+		size_t count = 0;
+		bool hasPipelineStatistics = false;
+		std::array<uint64_t, PIPELINE_STATISTIC_COUNT> pipelineStatistics{};
+	};
+
+	void addPendingScope(FrameQueries& frame, const char* name, uint32_t timestampQuery, uint32_t statisticsQuery)
+	{
+		std::lock_guard lock(mutex);
+
+		auto passIt = passIndices.find(name);
+		uint32_t pass;
+		if (passIt == passIndices.end())
+		{
+			pass = static_cast<uint32_t>(passes.size());
+			passIndices.emplace(name, pass);
+			passes.push_back(Pass{ .name = name });
+		}
+		else
+			pass = passIt->second;
+
+		frame.pending.push_back({ pass, timestampQuery, statisticsQuery });
+	}
+
+	void collect(FrameQueries& frame)
+	{
+		if (frame.pending.empty())
+			return;
+
+		uint32_t timestampCount = std::min(frame.nextTimestamp.load(), maxScopes * 2);
+		auto [timestampResult, timestamps] = frame.timestamps.getResults<uint64_t>(0, timestampCount, timestampCount * 2 * sizeof(uint64_t), 2 * sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability);
+
+		std::vector<uint64_t> statistics;
+		uint32_t statisticsCount = std::min(frame.nextStatistics.load(), maxScopes);
+		if (statisticsCount > 0)
+		{
+			constexpr size_t stride = (PIPELINE_STATISTIC_COUNT + 1) * sizeof(uint64_t);
+			statistics = frame.statistics.getResults<uint64_t>(0, statisticsCount, statisticsCount * stride, stride,
+				vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWithAvailability).second;
+		}
+
+		uint64_t mask = timestampValidBits >= 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+
+		std::lock_guard lock(mutex);
+		lastResolved.clear();
+		for (const PendingScope& scope : frame.pending)
+		{
+			// Each query is a (value, availability) pair
+			const uint64_t* begin = &timestamps[scope.timestampQuery * 2];
+			const uint64_t* end = &timestamps[(scope.timestampQuery + 1) * 2];
+			if (begin[1] == 0 || end[1] == 0)
+				continue;
+
+			Pass& pass = passes[scope.pass];
+			pass.history[pass.count % HISTORY_SIZE] = ticksToNanoseconds((end[0] - begin[0]) & mask) / 1e6;
+			pass.count++;
+			lastResolved.push_back({ scope.pass, begin[0] & mask, end[0] & mask });
+			if (calibrated)
+				CpuTracer::instance().addGpuEvent(pass.name, ticksToCpuNanoseconds(begin[0] & mask), ticksToCpuNanoseconds(end[0] & mask));
+
+			if (scope.statisticsQuery != INVALID_QUERY)
+			{
+				const uint64_t* values = &statistics[scope.statisticsQuery * (PIPELINE_STATISTIC_COUNT + 1)];
+				if (values[PIPELINE_STATISTIC_COUNT] != 0)
+				{
+					std::copy_n(values, PIPELINE_STATISTIC_COUNT, pass.pipelineStatistics.begin());
+					pass.hasPipelineStatistics = true;
+				}
+			}
+		}
+	}
+
+	std::vector<std::unique_ptr<FrameQueries>> frames;
+	vk::raii::QueryPool oneShotTimestamps = nullptr;
+	uint32_t currentFrame = 0;
+	uint32_t maxScopes = 64;
+	uint32_t timestampValidBits = 0;
+	float timestampPeriod = 1.0f;
+	bool pipelineStatisticsEnabled = false;
+	uint32_t queueFamilyIndex = 0;
+	bool calibrated = false;
+	double cpuOffsetNs = 0.0;
+
+	mutable std::mutex mutex;
+	std::unordered_map<std::string, uint32_t> passIndices;
+	std::vector<Pass> passes;
+	std::vector<ResolvedScope> lastResolved;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+// Narrowest-fit index buffers.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Meshes keep 32-bit indices on the CPU for processing; packIndices() narrows them for upload to uint16
+// when every index fits, or to uint8 when VK_EXT_index_type_uint8 is enabled. The all-ones value of each
+// type is never used as an index so primitive restart can be switched on without repacking.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum class IndexFormat
+{
+	Uint8,
+	Uint16,
+	Uint32
+};
+
+inline uint32_t indexSize(IndexFormat format)
+{
+	switch (format)
+	{
+	case IndexFormat::Uint8:
+		return sizeof(uint8_t);
+	case IndexFormat::Uint16:
+		return sizeof(uint16_t);
+	default:
+		return sizeof(uint32_t);
+	}
+}
+
+inline vk::IndexType toIndexType(IndexFormat format)
+{
+	switch (format)
+	{
+	case IndexFormat::Uint8:
+		return vk::IndexType::eUint8EXT;
+	case IndexFormat::Uint16:
+		return vk::IndexType::eUint16;
+	default:
+		return vk::IndexType::eUint32;
+	}
+}
+
+inline const char* indexFormatName(IndexFormat format)
+{
+	switch (format)
+	{
+	case IndexFormat::Uint8:
+		return "uint8";
+	case IndexFormat::Uint16:
+		return "uint16";
+	default:
+		return "uint32";
+	}
+}
+
+// vertexCount is the number of vertices the indices can reference (for a meshlet, its local vertex count).
+// Up to 2^n - 1 vertices fit n bits: the largest index is then 2^n - 2, below the restart value.
+inline IndexFormat selectIndexFormat(size_t vertexCount, bool uint8Supported)
+{
+	if (uint8Supported && vertexCount <= UINT8_MAX)
+		return IndexFormat::Uint8;
+
+	if (vertexCount <= UINT16_MAX)
+		return IndexFormat::Uint16;
+
+	return IndexFormat::Uint32;
+}
+
+struct PackedIndices
+{
+	IndexFormat format = IndexFormat::Uint32;
+	uint32_t count = 0;
+	std::vector<uint8_t> data;
+
+	[[nodiscard]] vk::IndexType indexType() const
+	{
+		return toIndexType(format);
+	}
+};
+
+inline PackedIndices packIndices(const std::vector<uint32_t>& indices, IndexFormat format)
+{
+	PackedIndices packed
+	{
+		.format = format,
+		.count = static_cast<uint32_t>(indices.size()),
+		.data = {}
+	};
+	packed.data.resize(indices.size() * indexSize(format));
+
+	switch (format)
+	{
+	case IndexFormat::Uint8:
+		std::ranges::transform(indices, packed.data.begin(), [](uint32_t index) { return static_cast<uint8_t>(index); });
+		break;
+	case IndexFormat::Uint16:
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			uint16_t index = static_cast<uint16_t>(indices[i]);
+			std::memcpy(packed.data.data() + i * sizeof(uint16_t), &index, sizeof(uint16_t));
+		}
+		break;
+	case IndexFormat::Uint32:
+		std::memcpy(packed.data.data(), indices.data(), packed.data.size());
+		break;
+	}
+
+	return packed;
+}
+
+inline PackedIndices packIndices(const std::vector<uint32_t>& indices, size_t vertexCount, bool uint8Supported)
+{
+	return packIndices(indices, selectIndexFormat(vertexCount, uint8Supported));
+}
+
+// True when the device exposes VK_EXT_index_type_uint8 with the indexTypeUint8 feature.
+inline bool indexTypeUint8Supported(const vk::raii::PhysicalDevice& physicalDevice)
+{
+	auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+	bool extensionAvailable = std::ranges::any_of(extensions, [](const vk::ExtensionProperties& extension)
+		{
+			return strcmp(extension.extensionName, vk::EXTIndexTypeUint8ExtensionName) == 0;
+		});
+
+	if (!extensionAvailable)
+		return false;
+
+	auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>();
+	return features.get<vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>().indexTypeUint8;
+}
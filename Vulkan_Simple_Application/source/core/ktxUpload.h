@@ -0,0 +1,111 @@
+#pragma once
+
+// KTX2 texture helpers: Basis Universal transcode target selection and multi-region uploads.
+// Expects Vulkan-Hpp (header or module) and <ktx.h> to be visible at the include site.
+//
+// Basis payloads (UASTC or ETC1S) are transcoded to the best block-compressed format the device can
+// sample with linear filtering: BC7 on desktop GPUs, ASTC 4x4 or ETC2 on mobile ones, and RGBA8 only
+// when none of them is available. Every mip level, array layer and cube face of the texture is then
+// copied from one staging buffer with a single copyBufferToImage.
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Compressed formats the device can sample; the matching device features must be enabled to use them.
+struct TextureCompressionSupport
+{
+	bool bc7 = false;
+	bool astc = false;
+	bool etc2 = false;
+};
+
+struct KtxTranscodeTarget
+{
+	ktx_transcode_fmt_e format;
+	const char* name;
+};
+
+namespace ktx_upload
+{
+	inline TextureCompressionSupport compressionSupport(const vk::raii::PhysicalDevice& physicalDevice)
+	{
+		vk::PhysicalDeviceFeatures features = physicalDevice.getFeatures();
+		auto sampleable = [&](vk::Format format)
+			{
+				vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eSampledImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+				return (physicalDevice.getFormatProperties(format).optimalTilingFeatures & required) == required;
+			};
+
+		return {
+			.bc7 = features.textureCompressionBC && sampleable(vk::Format::eBc7SrgbBlock),
+			.astc = features.textureCompressionASTC_LDR && sampleable(vk::Format::eAstc4x4SrgbBlock),
+			.etc2 = features.textureCompressionETC2 && sampleable(vk::Format::eEtc2R8G8B8A8SrgbBlock)
+		};
+	}
+
+	inline KtxTranscodeTarget transcodeTarget(const TextureCompressionSupport& support)
+	{
+		if (support.bc7)
+			return { KTX_TTF_BC7_RGBA, "BC7" };
+		if (support.astc)
+			return { KTX_TTF_ASTC_4x4_RGBA, "ASTC 4x4" };
+		if (support.etc2)
+			return { KTX_TTF_ETC2_RGBA, "ETC2" };
+		return { KTX_TTF_RGBA32, "RGBA8" };
+	}
+
+	/**
+	* Transcodes a Basis Universal texture in place and returns the name of the format it now holds, or
+	* nullptr when the texture already stores a GPU format. texture->vkFormat is valid afterwards.
+	*/
+	inline const char* transcode(ktxTexture2* texture, const TextureCompressionSupport& support)
+	{
+		if (!ktxTexture2_NeedsTranscoding(texture))
+			return nullptr;
+
+		KtxTranscodeTarget target = transcodeTarget(support);
+		if (ktxTexture2_TranscodeBasis(texture, target.format, 0) != KTX_SUCCESS)
+			throw std::runtime_error("failed to transcode ktx2 texture!");
+
+		return target.name;
+	}
+
+	inline uint32_t layerCount(const ktxTexture2* texture)
+	{
+		return std::max(texture->numLayers, 1u) * texture->numFaces;
+	}
+
+	// One region per (level, layer, face), with buffer offsets relative to the start of the texture data.
+	inline std::vector<vk::BufferImageCopy> copyRegions(ktxTexture2* texture)
+	{
+		auto* base = reinterpret_cast<ktxTexture*>(texture);
+		std::vector<vk::BufferImageCopy> regions;
+		regions.reserve(static_cast<size_t>(texture->numLevels) * layerCount(texture));
+
+		for (uint32_t level = 0; level < texture->numLevels; level++)
+		{
+			for (uint32_t layer = 0; layer < std::max(texture->numLayers, 1u); layer++)
+			{
+				for (uint32_t face = 0; face < texture->numFaces; face++)
+				{
+					ktx_size_t offset = 0;
+					if (ktxTexture_GetImageOffset(base, level, layer, face, &offset) != KTX_SUCCESS)
+						throw std::runtime_error("failed to locate a ktx2 image!");
+
+					regions.push_back({
+						.bufferOffset = offset,
+						.bufferRowLength = 0,
+						.bufferImageHeight = 0,
+						.imageSubresource = { vk::ImageAspectFlagBits::eColor, level, layer * texture->numFaces + face, 1 },
+						.imageOffset = { 0, 0, 0 },
+						.imageExtent = { std::max(texture->baseWidth >> level, 1u), std::max(texture->baseHeight >> level, 1u), std::max(texture->baseDepth >> level, 1u) }
+					});
+				}
+			}
+		}
+
+		return regions;
+	}
+}
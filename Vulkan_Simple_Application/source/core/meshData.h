@@ -0,0 +1,94 @@
+#pragma once
+
+// CPU-side mesh representation shared by the model loaders.
+// Loaders fill full-precision vertices; vertexLayout.h turns them into the compact GPU format.
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct MeshVertex
+{
+	glm::vec3 pos{ 0.0f };
+	glm::vec3 normal{ 0.0f, 0.0f, 1.0f };
+	glm::vec2 texCoord{ 0.0f };
+
+	bool operator==(const MeshVertex& other) const
+	{
+		return pos == other.pos && normal == other.normal && texCoord == other.texCoord;
+	}
+};
+
+template <>
+struct std::hash<MeshVertex>
+{
+	size_t operator()(const MeshVertex& vertex) const noexcept
+	{
+		float values[8] = {
+			vertex.pos.x, vertex.pos.y, vertex.pos.z,
+			vertex.normal.x, vertex.normal.y, vertex.normal.z,
+			vertex.texCoord.x, vertex.texCoord.y
+		};
+
+		size_t seed = 0;
+		for (float value : values)
+			seed ^= std::hash<float>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+		return seed;
+	}
+};
+
+struct MeshBounds
+{
+	glm::vec3 min{ std::numeric_limits<float>::max() };
+	glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+	[[nodiscard]] bool valid() const
+	{
+		return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+	}
+
+	[[nodiscard]] glm::vec3 center() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	[[nodiscard]] glm::vec3 extent() const
+	{
+		return max - min;
+	}
+
+	void expand(const glm::vec3& point)
+	{
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+};
+
+// A level of detail: a range of MeshData::indices plus its simplification error in object-space units.
+struct MeshLod
+{
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f;
+};
+
+struct MeshData
+{
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<MeshLod> lods; // empty until meshSimplifier.h builds a chain; LODs share the index buffer
+
+	[[nodiscard]] MeshBounds bounds() const
+	{
+		MeshBounds bounds;
+		for (const MeshVertex& vertex : vertices)
+			bounds.expand(vertex.pos);
+
+		return bounds;
+	}
+};
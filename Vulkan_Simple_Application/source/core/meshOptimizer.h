@@ -0,0 +1,451 @@
+#pragma once
+
+// Load-time mesh optimization, run between loading and encoding/upload:
+//
+//   1. optimizeVertexCache:  Tipsify triangle reordering for the post-transform vertex cache
+//                            (Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+//   2. optimizeOverdraw:     splits the cache-ordered triangles into clusters and draws outward-facing clusters first,
+//                            trading a little cache efficiency (bounded by threshold) for fewer occluded fragments.
+//   3. optimizeVertexFetch:  reorders vertices by first use and remaps the indices so fetches walk memory linearly;
+//                            unreferenced vertices are dropped.
+//
+// analyzeVertexCache/analyzeVertexFetch simulate a FIFO post-transform cache and a direct-mapped memory cache
+// and report ACMR (misses per triangle), ATVR (misses per referenced vertex) and fetched bytes.
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/meshData.h"
+
+struct VertexCacheStatistics
+{
+	uint32_t vertexTransforms = 0;
+	float acmr = 0.0f; // transformed vertices per triangle: 0.5 is ideal on a regular grid, 3 is the worst case
+	float atvr = 0.0f; // transformed vertices per referenced vertex: 1 is ideal
+};
+
+struct VertexFetchStatistics
+{
+	uint64_t bytesFetched = 0;
+	float overfetch = 0.0f; // fetched bytes per byte of referenced vertex data: 1 is ideal
+};
+
+struct MeshStatistics
+{
+	VertexCacheStatistics cache;
+	VertexFetchStatistics fetch;
+};
+
+struct MeshOptimizationOptions
+{
+	uint32_t cacheSize = 16;        // post-transform cache entries the reordering targets
+	bool optimizeOverdraw = true;
+	float overdrawThreshold = 1.05f; // allowed ACMR growth when splitting clusters for overdraw ordering
+};
+
+struct MeshOptimizationReport
+{
+	MeshStatistics original;
+	MeshStatistics vertexCache;
+	MeshStatistics overdraw;
+	MeshStatistics vertexFetch;
+};
+
+namespace mesh_optimizer
+{
+	// Per-vertex triangle lists in compressed row form.
+	struct Adjacency
+	{
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+	};
+
+	inline Adjacency buildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		Adjacency adjacency;
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for (uint32_t index : indices)
+			adjacency.offsets[index + 1]++;
+
+		std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+		std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		adjacency.triangles.resize(indices.size());
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		return adjacency;
+	}
+
+	// FIFO post-transform cache; returns how many of the triangle's vertices missed.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t size)
+			: timestamps(vertexCount, 0), size(size), time(size + 1)
+		{
+		}
+
+		bool access(uint32_t vertex)
+		{
+			if (time - timestamps[vertex] <= size)
+				return false;
+
+			timestamps[vertex] = time++;
+			return true;
+		}
+
+		void reset()
+		{
+			time += size + 1;
+		}
+
+	private:
+		std::vector<uint32_t> timestamps;
+		uint32_t size;
+		uint32_t time;
+	};
+
+	inline size_t vertexCount(const std::vector<uint32_t>& indices)
+	{
+		return indices.empty() ? 0 : static_cast<size_t>(*std::max_element(indices.begin(), indices.end())) + 1;
+	}
+}
+
+inline VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16)
+{
+	VertexCacheStatistics statistics;
+	if (indices.empty())
+		return statistics;
+
+	mesh_optimizer::FifoCache cache(vertexCount, cacheSize);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t uniqueVertices = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (cache.access(index))
+			statistics.vertexTransforms++;
+
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			uniqueVertices++;
+		}
+	}
+
+	statistics.acmr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(indices.size() / 3);
+	statistics.atvr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(uniqueVertices);
+	return statistics;
+}
+
+// Vertex fetches happen on post-transform cache misses and go through a 16 KB direct-mapped cache of 64-byte lines.
+inline VertexFetchStatistics analyzeVertexFetch(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t vertexStride, uint32_t cacheSize = 16)
+{
+	constexpr uint32_t LINE_SIZE = 64;
+	constexpr uint32_t LINE_COUNT = 256;
+
+	VertexFetchStatistics statistics;
+	if (indices.empty())
+		return statistics;
+
+	mesh_optimizer::FifoCache transformCache(vertexCount, cacheSize);
+	std::vector<uint64_t> lines(LINE_COUNT, UINT64_MAX);
+	std::vector<bool> referenced(vertexCount, false);
+	uint64_t referencedBytes = 0;
+
+	for (uint32_t index : indices)
+	{
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			referencedBytes += vertexStride;
+		}
+
+		if (!transformCache.access(index))
+			continue;
+
+		uint64_t begin = static_cast<uint64_t>(index) * vertexStride;
+		for (uint64_t line = begin / LINE_SIZE; line <= (begin + vertexStride - 1) / LINE_SIZE; line++)
+		{
+			uint64_t& slot = lines[line % LINE_COUNT];
+			if (slot != line)
+			{
+				slot = line;
+				statistics.bytesFetched += LINE_SIZE;
+			}
+		}
+	}
+
+	statistics.overfetch = static_cast<float>(statistics.bytesFetched) / static_cast<float>(referencedBytes);
+	return statistics;
+}
+
+inline MeshStatistics analyzeMesh(const MeshData& mesh, uint32_t vertexStride, uint32_t cacheSize = 16)
+{
+	return {
+		analyzeVertexCache(mesh.indices, mesh.vertices.size(), cacheSize),
+		analyzeVertexFetch(mesh.indices, mesh.vertices.size(), vertexStride, cacheSize)
+	};
+}
+
+// Tipsify: greedily fans around the current vertex and picks the next one that is still in the cache
+// and will not be evicted before its remaining triangles are emitted.
+inline std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16)
+{
+	using namespace mesh_optimizer;
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return indices;
+
+	Adjacency adjacency = buildAdjacency(indices, vertexCount);
+
+	std::vector<uint32_t> liveTriangles(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	uint32_t time = cacheSize + 1;
+	size_t cursor = 0;
+
+	auto nextUnprocessed = [&]() -> int64_t
+		{
+			while (!deadEnd.empty())
+			{
+				uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+
+			for (; cursor < vertexCount; cursor++)
+				if (liveTriangles[cursor] > 0)
+					return static_cast<int64_t>(cursor);
+
+			return -1;
+		};
+
+	int64_t fanning = nextUnprocessed();
+	while (fanning >= 0)
+	{
+		candidates.clear();
+
+		uint32_t vertex = static_cast<uint32_t>(fanning);
+		for (uint32_t i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++)
+		{
+			uint32_t triangle = adjacency.triangles[i];
+			if (emitted[triangle])
+				continue;
+
+			emitted[triangle] = true;
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				uint32_t index = indices[triangle * 3 + corner];
+				result.push_back(index);
+				deadEnd.push_back(index);
+				candidates.push_back(index);
+				liveTriangles[index]--;
+
+				if (time - cacheTime[index] > cacheSize)
+					cacheTime[index] = time++;
+			}
+		}
+
+		// Prefer the candidate that entered the cache earliest among those whose fan still fits in it
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t candidate : candidates)
+		{
+			if (liveTriangles[candidate] == 0)
+				continue;
+
+			int64_t priority = 0;
+			if (time - cacheTime[candidate] + 2 * liveTriangles[candidate] <= cacheSize)
+				priority = time - cacheTime[candidate];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = candidate;
+			}
+		}
+
+		fanning = best >= 0 ? best : nextUnprocessed();
+	}
+
+	return result;
+}
+
+// Expects cache-optimized indices. Hard cluster boundaries are where the cache restarts (a triangle with
+// three misses); those clusters are split further while their ACMR stays within threshold, then sorted so
+// clusters facing away from the mesh centre, which tend to occlude the rest, are drawn first.
+inline std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, uint32_t cacheSize = 16, float threshold = 1.05f)
+{
+	using namespace mesh_optimizer;
+
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return indices;
+
+	std::vector<uint32_t> hardBoundaries;
+	{
+		FifoCache cache(vertices.size(), cacheSize);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t misses = cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+			if (t == 0 || misses == 3)
+				hardBoundaries.push_back(static_cast<uint32_t>(t));
+		}
+	}
+	hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+	std::vector<uint32_t> clusters;
+	{
+		FifoCache cache(vertices.size(), cacheSize);
+		for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+		{
+			uint32_t begin = hardBoundaries[c];
+			uint32_t end = hardBoundaries[c + 1];
+
+			cache.reset();
+			uint32_t clusterMisses = 0;
+			for (uint32_t t = begin; t < end; t++)
+				clusterMisses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+			float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+			cache.reset();
+			clusters.push_back(begin);
+			uint32_t misses = 0;
+			uint32_t start = begin;
+			for (uint32_t t = begin; t < end; t++)
+			{
+				misses += cache.access(indices[t * 3 + 0]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+
+				float acmr = static_cast<float>(misses) / static_cast<float>(t - start + 1);
+				if (t + 1 < end && acmr <= clusterAcmr * threshold)
+				{
+					clusters.push_back(t + 1);
+					cache.reset();
+					misses = 0;
+					start = t + 1;
+				}
+			}
+		}
+	}
+	clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+	glm::vec3 meshCentroid(0.0f);
+	for (const MeshVertex& vertex : vertices)
+		meshCentroid += vertex.pos;
+	meshCentroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+
+	size_t clusterCount = clusters.size() - 1;
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+
+			glm::vec3 weightedNormal = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(weightedNormal);
+
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += weightedNormal;
+			area += triangleArea;
+		}
+
+		if (area > 0.0f)
+			centroid /= area;
+
+		float normalLength = glm::length(normal);
+		sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t c : order)
+		result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+	return result;
+}
+
+// Reorders vertices by first use, drops unreferenced ones and remaps the indices in place.
+inline void optimizeVertexFetch(MeshData& mesh)
+{
+	constexpr uint32_t UNUSED = UINT32_MAX;
+
+	std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+	std::vector<MeshVertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for (uint32_t& index : mesh.indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	mesh.vertices = std::move(vertices);
+}
+
+inline void printMeshStatistics(const char* stage, const MeshStatistics& statistics)
+{
+	std::cout << "  " << std::left << std::setw(13) << stage << std::right << std::fixed << std::setprecision(3)
+		<< " ACMR " << statistics.cache.acmr << "  ATVR " << statistics.cache.atvr
+		<< "  fetched " << statistics.fetch.bytesFetched << " bytes (overfetch " << statistics.fetch.overfetch << ")" << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+}
+
+// vertexStride is the size of one vertex in the uploaded buffer and only affects the fetch statistics.
+inline MeshOptimizationReport optimizeMesh(MeshData& mesh, uint32_t vertexStride, const MeshOptimizationOptions& options = {})
+{
+	MeshOptimizationReport report;
+	report.original = analyzeMesh(mesh, vertexStride, options.cacheSize);
+
+	mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size(), options.cacheSize);
+	report.vertexCache = analyzeMesh(mesh, vertexStride, options.cacheSize);
+
+	if (options.optimizeOverdraw)
+		mesh.indices = optimizeOverdraw(mesh.indices, mesh.vertices, options.cacheSize, options.overdrawThreshold);
+	report.overdraw = analyzeMesh(mesh, vertexStride, options.cacheSize);
+
+	optimizeVertexFetch(mesh);
+	report.vertexFetch = analyzeMesh(mesh, vertexStride, options.cacheSize);
+
+	std::cout << "Mesh optimization (" << mesh.vertices.size() << " vertices, " << mesh.indices.size() / 3 << " triangles):" << std::endl;
+	printMeshStatistics("original", report.original);
+	printMeshStatistics("vertex cache", report.vertexCache);
+	if (options.optimizeOverdraw)
+		printMeshStatistics("overdraw", report.overdraw);
+	printMeshStatistics("vertex fetch", report.vertexFetch);
+
+	return report;
+}
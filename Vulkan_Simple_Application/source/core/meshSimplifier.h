@@ -0,0 +1,413 @@
+#pragma once
+
+// Quadric-error mesh simplification and LOD chains.
+//
+// simplifyMesh() performs half-edge collapses ordered by quadric error (Garland & Heckbert) and only
+// produces new indices: every LOD references the original vertex buffer, so all levels share one
+// vertex buffer and are appended to one index buffer (MeshData::lods records the ranges).
+// Vertices on open borders or on attribute seams (several vertices at one position) are locked, which
+// keeps silhouettes and UV layouts intact at the cost of some reduction on heavily seamed meshes.
+//
+// Each LOD stores its geometric error in object-space units; selectLod() projects it to pixels and
+// picks the coarsest level whose error stays under the threshold.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/meshData.h"
+#include "core/meshOptimizer.h"
+
+struct LodOptions
+{
+	uint32_t maxLevels = 5;              // including the full-detail level
+	float reduction = 0.5f;              // target triangle ratio between consecutive levels
+	float minimumReduction = 0.9f;       // stop when a level keeps more than this share of its parent's triangles
+	float maxRelativeError = 0.05f;      // per-level error bound, relative to the mesh bounding-box diagonal
+};
+
+namespace mesh_simplifier
+{
+	// Symmetric 4x4 quadric stored as its 10 unique coefficients.
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		static Quadric fromPlane(const glm::dvec3& normal, double distance, double weight)
+		{
+			Quadric q;
+			q.a00 = weight * normal.x * normal.x; q.a01 = weight * normal.x * normal.y; q.a02 = weight * normal.x * normal.z; q.a03 = weight * normal.x * distance;
+			q.a11 = weight * normal.y * normal.y; q.a12 = weight * normal.y * normal.z; q.a13 = weight * normal.y * distance;
+			q.a22 = weight * normal.z * normal.z; q.a23 = weight * normal.z * distance;
+			q.a33 = weight * distance * distance;
+			return q;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+			a11 += other.a11; a12 += other.a12; a13 += other.a13;
+			a22 += other.a22; a23 += other.a23;
+			a33 += other.a33;
+			return *this;
+		}
+
+		// Sum of weighted squared distances from p to the accumulated planes.
+		[[nodiscard]] double error(const glm::dvec3& p) const
+		{
+			double result =
+				a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + 2 * a03 * p.x +
+				a11 * p.y * p.y + 2 * a12 * p.y * p.z + 2 * a13 * p.y +
+				a22 * p.z * p.z + 2 * a23 * p.z +
+				a33;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double error;
+		uint32_t vertex;
+		uint32_t target;
+		uint32_t version;
+
+		bool operator>(const Collapse& other) const
+		{
+			return error > other.error;
+		}
+	};
+
+	inline glm::dvec3 position(const MeshData& mesh, uint32_t vertex)
+	{
+		return glm::dvec3(mesh.vertices[vertex].pos);
+	}
+}
+
+struct SimplifyResult
+{
+	std::vector<uint32_t> indices;
+	float error = 0.0f; // largest collapse error, as a distance in object space
+};
+
+// Simplifies the triangles in indices (which reference mesh.vertices) towards targetIndexCount without
+// exceeding maxError (object-space distance).
+inline SimplifyResult simplifyMesh(const MeshData& mesh, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError)
+{
+	using namespace mesh_simplifier;
+
+	size_t vertexCount = mesh.vertices.size();
+	size_t triangleCount = indices.size() / 3;
+
+	// Vertices sharing a position collapse to one canonical id; edges and quadrics are tracked on those
+	std::vector<uint32_t> canonical(vertexCount);
+	std::vector<uint32_t> wedgeCount(vertexCount, 0);
+	{
+		std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			const glm::vec3& p = mesh.vertices[v].pos;
+			uint64_t key = std::hash<float>()(p.x) ^ (std::hash<float>()(p.y) * 31) ^ (std::hash<float>()(p.z) * 131);
+
+			canonical[v] = v;
+			for (uint32_t other : buckets[key])
+			{
+				if (mesh.vertices[other].pos == p)
+				{
+					canonical[v] = canonical[other];
+					break;
+				}
+			}
+			if (canonical[v] == v)
+				buckets[key].push_back(v);
+		}
+	}
+
+	std::vector<bool> referenced(vertexCount, false);
+	for (uint32_t index : indices)
+		referenced[index] = true;
+	for (uint32_t v = 0; v < vertexCount; v++)
+		if (referenced[v])
+			wedgeCount[canonical[v]]++;
+
+	std::vector<bool> locked(vertexCount, false);
+	for (uint32_t v = 0; v < vertexCount; v++)
+		if (wedgeCount[canonical[v]] > 1)
+			locked[canonical[v]] = true;
+
+	// Border and non-manifold edges lock both ends
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUses;
+		auto edgeKey = [](uint32_t a, uint32_t b) { return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b); };
+		for (size_t t = 0; t < triangleCount; t++)
+			for (uint32_t e = 0; e < 3; e++)
+				edgeUses[edgeKey(canonical[indices[t * 3 + e]], canonical[indices[t * 3 + (e + 1) % 3]])]++;
+
+		for (const auto& [key, uses] : edgeUses)
+		{
+			if (uses != 2)
+			{
+				locked[static_cast<uint32_t>(key >> 32)] = true;
+				locked[static_cast<uint32_t>(key & 0xffffffffu)] = true;
+			}
+		}
+	}
+
+	std::vector<uint32_t> triangles(indices);
+	std::vector<bool> removed(triangleCount, false);
+	std::vector<std::vector<uint32_t>> adjacency(vertexCount);
+	std::vector<Quadric> quadrics(vertexCount);
+
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		glm::dvec3 p0 = position(mesh, triangles[t * 3 + 0]);
+		glm::dvec3 p1 = position(mesh, triangles[t * 3 + 1]);
+		glm::dvec3 p2 = position(mesh, triangles[t * 3 + 2]);
+
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double area = glm::length(normal);
+		if (area > 0.0)
+		{
+			normal /= area;
+			Quadric plane = Quadric::fromPlane(normal, -glm::dot(normal, p0), area);
+			for (uint32_t corner = 0; corner < 3; corner++)
+				quadrics[canonical[triangles[t * 3 + corner]]] += plane;
+		}
+
+		for (uint32_t corner = 0; corner < 3; corner++)
+			adjacency[canonical[triangles[t * 3 + corner]]].push_back(static_cast<uint32_t>(t));
+	}
+
+	std::vector<uint32_t> versions(vertexCount, 0);
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+
+	auto triangleHas = [&](uint32_t t, uint32_t vertex)
+		{
+			return canonical[triangles[t * 3 + 0]] == vertex || canonical[triangles[t * 3 + 1]] == vertex || canonical[triangles[t * 3 + 2]] == vertex;
+		};
+
+	// Rejects collapses that would flip or degenerate one of the triangles that move.
+	auto collapseIsValid = [&](uint32_t vertex, uint32_t target)
+		{
+			glm::dvec3 targetPosition = position(mesh, target);
+			for (uint32_t t : adjacency[vertex])
+			{
+				if (removed[t] || triangleHas(t, target))
+					continue;
+
+				glm::dvec3 before[3], after[3];
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t index = triangles[t * 3 + corner];
+					before[corner] = position(mesh, index);
+					after[corner] = canonical[index] == vertex ? targetPosition : before[corner];
+				}
+
+				glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+				if (glm::dot(normalBefore, normalAfter) <= 0.25 * glm::length(normalBefore) * glm::length(normalAfter))
+					return false;
+			}
+			return true;
+		};
+
+	// Queues the cheapest collapse of vertex that collapseIsValid() accepts
+	auto pushBestCollapse = [&](uint32_t vertex)
+		{
+			if (locked[vertex] || !referenced[vertex])
+				return;
+
+			Collapse best{ INFINITY, vertex, vertex, versions[vertex] };
+			for (uint32_t t : adjacency[vertex])
+			{
+				if (removed[t])
+					continue;
+
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					uint32_t target = canonical[triangles[t * 3 + corner]];
+					if (target == vertex)
+						continue;
+
+					Quadric combined = quadrics[vertex];
+					combined += quadrics[target];
+					double error = combined.error(position(mesh, target));
+					if (error < best.error && collapseIsValid(vertex, target))
+						best = { error, vertex, target, versions[vertex] };
+				}
+			}
+
+			if (best.target != vertex)
+				queue.push(best);
+		};
+
+	for (uint32_t v = 0; v < vertexCount; v++)
+		if (canonical[v] == v)
+			pushBestCollapse(v);
+
+	// Quadric errors are area-weighted squared distances; compare against the squared bound times the
+	// collapsed vertex's total area so the threshold stays a distance
+	auto totalArea = [&](uint32_t vertex)
+		{
+			double area = 0.0;
+			for (uint32_t t : adjacency[vertex])
+			{
+				if (removed[t])
+					continue;
+				glm::dvec3 p0 = position(mesh, triangles[t * 3 + 0]);
+				area += glm::length(glm::cross(position(mesh, triangles[t * 3 + 1]) - p0, position(mesh, triangles[t * 3 + 2]) - p0));
+			}
+			return std::max(area, 1e-12);
+		};
+
+	size_t liveIndexCount = indices.size();
+	double maxDistance = 0.0;
+
+	while (liveIndexCount > targetIndexCount && !queue.empty())
+	{
+		Collapse collapse = queue.top();
+		queue.pop();
+
+		if (collapse.version != versions[collapse.vertex])
+			continue;
+
+		uint32_t vertex = collapse.vertex;
+		uint32_t target = collapse.target;
+
+		// The queue is ordered by quadric error, not by this distance, so cheaper collapses may still follow.
+		// The vertex is queued again when a collapse next to it changes its neighbourhood
+		double distance = std::sqrt(collapse.error / totalArea(vertex));
+		if (distance > maxError)
+			continue;
+
+		if (!collapseIsValid(vertex, target))
+		{
+			// Queue the best collapse that is still valid instead
+			versions[vertex]++;
+			pushBestCollapse(vertex);
+			continue;
+		}
+
+		// The vertex has a single wedge (it is not on a seam), so the wedge of target used by the
+		// triangles around the collapsed edge is valid for the whole fan
+		uint32_t targetWedge = target;
+		for (uint32_t t : adjacency[vertex])
+		{
+			if (removed[t])
+				continue;
+			for (uint32_t corner = 0; corner < 3; corner++)
+				if (canonical[triangles[t * 3 + corner]] == target)
+					targetWedge = triangles[t * 3 + corner];
+		}
+
+		for (uint32_t t : adjacency[vertex])
+		{
+			if (removed[t])
+				continue;
+
+			if (triangleHas(t, target))
+			{
+				removed[t] = true;
+				liveIndexCount -= 3;
+				continue;
+			}
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+				if (canonical[triangles[t * 3 + corner]] == vertex)
+					triangles[t * 3 + corner] = targetWedge;
+			adjacency[target].push_back(t);
+		}
+
+		adjacency[vertex].clear();
+		quadrics[target] += quadrics[vertex];
+		referenced[vertex] = false;
+		maxDistance = std::max(maxDistance, distance);
+
+		// Costs change for the target and everything around it
+		std::vector<uint32_t> neighbours;
+		for (uint32_t t : adjacency[target])
+			if (!removed[t])
+				for (uint32_t corner = 0; corner < 3; corner++)
+					neighbours.push_back(canonical[triangles[t * 3 + corner]]);
+
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		for (uint32_t neighbour : neighbours)
+		{
+			versions[neighbour]++;
+			pushBestCollapse(neighbour);
+		}
+	}
+
+	SimplifyResult result;
+	result.indices.reserve(liveIndexCount);
+	for (size_t t = 0; t < triangleCount; t++)
+		if (!removed[t])
+			result.indices.insert(result.indices.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+
+	result.error = static_cast<float>(maxDistance);
+	return result;
+}
+
+/**
+* Replaces mesh.indices with the full-detail indices followed by every generated LOD and fills
+* mesh.lods. Each coarser level is simplified from the previous one (so errors accumulate) and
+* reordered for the vertex cache.
+*/
+inline void buildLodChain(MeshData& mesh, const LodOptions& options = {})
+{
+	MeshBounds bounds = mesh.bounds();
+	float maxError = options.maxRelativeError * glm::length(bounds.extent());
+
+	std::vector<uint32_t> combined = mesh.indices;
+	mesh.lods = { MeshLod{ 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f } };
+
+	std::vector<uint32_t> previous = mesh.indices;
+	float accumulatedError = 0.0f;
+	while (mesh.lods.size() < options.maxLevels)
+	{
+		size_t target = static_cast<size_t>(static_cast<float>(previous.size() / 3) * options.reduction) * 3;
+		SimplifyResult simplified = simplifyMesh(mesh, previous, target, maxError);
+		if (simplified.indices.empty() || static_cast<float>(simplified.indices.size()) > static_cast<float>(previous.size()) * options.minimumReduction)
+			break;
+
+		accumulatedError += simplified.error;
+		simplified.indices = optimizeVertexCache(simplified.indices, mesh.vertices.size());
+
+		mesh.lods.push_back({ static_cast<uint32_t>(combined.size()), static_cast<uint32_t>(simplified.indices.size()), accumulatedError });
+		combined.insert(combined.end(), simplified.indices.begin(), simplified.indices.end());
+		previous = std::move(simplified.indices);
+	}
+
+	mesh.indices = std::move(combined);
+
+	std::cout << "LOD chain:";
+	for (const MeshLod& lod : mesh.lods)
+		std::cout << " " << lod.indexCount / 3 << " (error " << lod.error << ")";
+	std::cout << " triangles" << std::endl;
+}
+
+/**
+* Picks the coarsest LOD whose error, projected at the given distance, stays under maxPixelError.
+* pixelsPerUnit is viewportHeight / (2 * tan(fovY / 2)); scale is the object's largest scale factor.
+*/
+inline uint32_t selectLod(const std::vector<MeshLod>& lods, float distance, float scale, float pixelsPerUnit, float maxPixelError = 1.0f)
+{
+	uint32_t selected = 0;
+	for (uint32_t i = 1; i < lods.size(); i++)
+	{
+		float projected = lods[i].error * scale * pixelsPerUnit / std::max(distance, 1e-4f);
+		if (projected > maxPixelError)
+			break;
+		selected = i;
+	}
+	return selected;
+}
@@ -0,0 +1,563 @@
+#pragma once
+
+// GPU meshlet culling: a compute pass tests the meshlets of every object against the view frustum and
+// their normal cones, appends the survivors to a per-object indirect draw list and counts them, and the
+// graphics pass draws each object with drawIndexedIndirectCount. Each object names the meshlet range it
+// uses, which is how a per-instance LOD (see meshSimplifier.h) reaches the GPU.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// With a depth pyramid attached (see depthPyramid.h) culling runs in two phases. The early phase draws
+// the meshlets that were visible last frame; after the pyramid is built from that depth, the late phase
+// tests every meshlet against it, records the new visibility and draws only the newly visible ones.
+//
+// Needs the multiDrawIndirect and drawIndirectCount features (see supported()). All buffers are
+// host-visible: meshlet data is tiny, object data is rewritten every frame, and the counters are read
+// back for the culling statistics once the frame's fence has been waited on.
+//
+// The barriers between the culling dispatches and their readers are the caller's (see renderGraph.h):
+// drawBuffer() stands for the frame's culling output, which the early dispatch writes at the transfer and
+// compute stages, the late dispatch reads and writes at the compute stage, the draws read as indirect
+// commands and the host reads once the frame is done.
+//
+// The workgroup size is specialization constant 0 of the shader, so it can be tuned per device (see
+// workgroupTuner.h): buildPipeline() and recordTuning() are what WorkgroupTuner::tune() needs.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/meshlets.h"
+
+class MeshletCuller
+{
+public:
+	static constexpr uint32_t WORKGROUP_SIZE = 64; // default of WORKGROUP_SIZE_X in shader_meshlet_cull.slang
+	static constexpr uint32_t EARLY_PHASE = 0;
+	static constexpr uint32_t LATE_PHASE = 1;
+
+	struct Statistics
+	{
+		uint64_t tested = 0;
+		uint64_t frustumCulled = 0;
+		uint64_t coneCulled = 0;
+		uint64_t occlusionCulled = 0;
+		uint64_t visible = 0;
+		uint64_t visibleTriangles = 0;
+	};
+
+	struct Instance
+	{
+		glm::mat4 model{ 1.0f };
+		MeshletRange meshlets;
+	};
+
+	static bool supported(const vk::raii::PhysicalDevice& physicalDevice)
+	{
+		auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+		return features.get<vk::PhysicalDeviceFeatures2>().features.multiDrawIndirect &&
+			features.get<vk::PhysicalDeviceVulkan12Features>().drawIndirectCount;
+	}
+
+	// shaderCode is the SPIR-V of resources/shaders/compute/slang_meshlet_cull.spv.
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, const std::vector<char>& shaderCode,
+		const std::vector<Meshlet>& meshlets, uint32_t maxObjects, uint32_t framesInFlight, uint32_t workgroupSize = WORKGROUP_SIZE)
+	{
+		if (meshlets.empty())
+			throw std::runtime_error("meshlet culling needs at least one meshlet!");
+
+		memoryProperties = physicalDevice.getMemoryProperties();
+		meshletCount = static_cast<uint32_t>(meshlets.size());
+		this->maxObjects = maxObjects;
+		this->workgroupSize = workgroupSize;
+
+		std::vector<MeshletCullData> cullData;
+		cullData.reserve(meshlets.size());
+		for (const Meshlet& meshlet : meshlets)
+		{
+			cullData.push_back({
+				.sphere = glm::vec4(meshlet.center, meshlet.radius),
+				.cone = glm::vec4(meshlet.coneAxis, meshlet.coneCutoff),
+				.firstIndex = meshlet.firstIndex,
+				.indexCount = meshlet.indexCount
+			});
+		}
+
+		meshletBuffer = createBuffer(device, sizeof(MeshletCullData) * cullData.size(), vk::BufferUsageFlagBits::eStorageBuffer);
+		std::memcpy(meshletBuffer.mapped, cullData.data(), sizeof(MeshletCullData) * cullData.size());
+
+		// One flag per (object, meshlet), shared by all frames: the late phase of a frame writes what the
+		// early phase of the next submitted frame reads
+		visibilityBuffer = createBuffer(device, sizeof(uint32_t) * meshletCount * maxObjects, vk::BufferUsageFlagBits::eStorageBuffer);
+		std::memset(visibilityBuffer.mapped, 0, sizeof(uint32_t) * meshletCount * maxObjects);
+
+		frames.clear();
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			Frame frame;
+			frame.objects = createBuffer(device, sizeof(CullObject) * maxObjects, vk::BufferUsageFlagBits::eStorageBuffer);
+			frame.draws = createBuffer(device, sizeof(vk::DrawIndexedIndirectCommand) * meshletCount * maxObjects * 2,
+				vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer);
+			frame.counters = createBuffer(device, sizeof(uint32_t) * (maxObjects * 2 + 3),
+				vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eTransferDst);
+			frames.push_back(std::move(frame));
+		}
+
+		createPipeline(device, shaderCode, framesInFlight);
+		statistics = {};
+	}
+
+	[[nodiscard]] bool enabled() const
+	{
+		return !frames.empty();
+	}
+
+	// The culling pipeline specialized for a workgroup size; init() must have run.
+	[[nodiscard]] vk::raii::Pipeline buildPipeline(const vk::raii::Device& device, uint32_t workgroupSize) const
+	{
+		vk::SpecializationMapEntry specializationEntry{ .constantID = 0, .offset = 0, .size = sizeof(uint32_t) };
+		vk::SpecializationInfo specializationInfo
+		{
+			.mapEntryCount = 1,
+			.pMapEntries = &specializationEntry,
+			.dataSize = sizeof(uint32_t),
+			.pData = &workgroupSize
+		};
+		vk::ComputePipelineCreateInfo pipelineInfo
+		{
+			.stage = { .stage = vk::ShaderStageFlagBits::eCompute, .module = *shaderModule, .pName = "cullMain", .pSpecializationInfo = &specializationInfo },
+			.layout = *pipelineLayout
+		};
+		return vk::raii::Pipeline(device, nullptr, pipelineInfo);
+	}
+
+	// Switches to another workgroup size while the device is idle.
+	void setWorkgroupSize(const vk::raii::Device& device, uint32_t workgroupSize)
+	{
+		pipeline = buildPipeline(device, workgroupSize);
+		this->workgroupSize = workgroupSize;
+	}
+
+	/**
+	* Points the late phase at a depth pyramid (a view of every mip in the general layout). Must be called
+	* before the first record() and again whenever the pyramid is recreated, while the device is idle.
+	*/
+	void setDepthPyramid(const vk::Device& device, vk::ImageView pyramidView, uint32_t width, uint32_t height, uint32_t mips)
+	{
+		pyramidWidth = width;
+		pyramidHeight = height;
+		pyramidMips = mips;
+
+		vk::DescriptorImageInfo imageInfo{ .imageView = pyramidView, .imageLayout = vk::ImageLayout::eGeneral };
+		for (const vk::raii::DescriptorSet& set : descriptorSets)
+		{
+			vk::WriteDescriptorSet write
+			{
+				.dstSet = *set,
+				.dstBinding = 5,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = vk::DescriptorType::eSampledImage,
+				.pImageInfo = &imageInfo
+			};
+			device.updateDescriptorSets(write, {});
+		}
+	}
+
+	// Whether the two-phase occlusion path is active; without it only the early phase runs.
+	[[nodiscard]] bool occlusionEnabled() const
+	{
+		return enabled() && pyramidMips > 0;
+	}
+
+	/**
+	* Call after the frame's fence wait: collects the counters of the last submission that used this
+	* frame slot, then writes the object-space frustum planes, camera position, view transform and
+	* meshlet range of every instance. proj must map depth to [0, 1].
+	*/
+	void update(uint32_t frameIndex, const std::vector<Instance>& instances, const glm::mat4& view, const glm::mat4& proj)
+	{
+		if (!enabled())
+			return;
+
+		if (instances.size() > maxObjects)
+			throw std::runtime_error("too many objects for meshlet culling!");
+
+		Frame& frame = frames[frameIndex];
+		collect(frame);
+
+		glm::vec3 cameraPosition = glm::inverse(view)[3];
+		auto* objects = static_cast<CullObject*>(frame.objects.mapped);
+		frame.maxMeshlets = 0;
+		frame.testedMeshlets = 0;
+		for (size_t i = 0; i < instances.size(); i++)
+		{
+			const MeshletRange& range = instances[i].meshlets;
+			if (range.firstMeshlet + range.meshletCount > meshletCount)
+				throw std::runtime_error("meshlet range out of bounds!");
+
+			glm::mat4 clip = proj * view * instances[i].model;
+			glm::vec4 rows[4];
+			for (int row = 0; row < 4; row++)
+				rows[row] = glm::vec4(clip[0][row], clip[1][row], clip[2][row], clip[3][row]);
+
+			// Depth is [0, 1], so the near plane is the third row on its own
+			glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[2], rows[3] - rows[2] };
+			for (int plane = 0; plane < 6; plane++)
+				objects[i].planes[plane] = planes[plane] / glm::length(glm::vec3(planes[plane]));
+
+			objects[i].cameraPosition = glm::inverse(instances[i].model) * glm::vec4(cameraPosition, 1.0f);
+
+			// Spheres go to view space for the occlusion test; the largest axis scale keeps them conservative
+			glm::mat4 modelView = view * instances[i].model;
+			for (int row = 0; row < 3; row++)
+				objects[i].modelView[row] = glm::vec4(modelView[0][row], modelView[1][row], modelView[2][row], modelView[3][row]);
+			objects[i].scale = std::max({ glm::length(glm::vec3(modelView[0])), glm::length(glm::vec3(modelView[1])), glm::length(glm::vec3(modelView[2])) });
+
+			objects[i].firstMeshlet = range.firstMeshlet;
+			objects[i].meshletCount = range.meshletCount;
+
+			frame.maxMeshlets = std::max(frame.maxMeshlets, range.meshletCount);
+			frame.testedMeshlets += range.meshletCount;
+		}
+
+		frame.objectCount = static_cast<uint32_t>(instances.size());
+		frame.projection = glm::vec4(proj[0][0], proj[1][1], proj[2][2], proj[3][2]);
+	}
+
+	// Records the early culling dispatch, which also clears the frame's counters; must be outside a render pass.
+	void record(const vk::raii::CommandBuffer& commandBuffer, uint32_t frameIndex)
+	{
+		Frame& frame = frames[frameIndex];
+		if (frame.objectCount == 0 || frame.maxMeshlets == 0)
+			return;
+
+		commandBuffer.fillBuffer(*frame.counters.buffer, 0, vk::WholeSize, 0);
+
+		// Also orders the visibility reads after the late phase of the previous submission
+		vk::MemoryBarrier2 clearBarrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &clearBarrier });
+
+		dispatch(commandBuffer, *pipeline, workgroupSize, frameIndex, EARLY_PHASE, occlusionEnabled());
+		frame.pending = true;
+	}
+
+	// Records the late culling dispatch; the depth pyramid must hold this frame's early depth.
+	void recordLate(const vk::raii::CommandBuffer& commandBuffer, uint32_t frameIndex)
+	{
+		const Frame& frame = frames[frameIndex];
+		if (!occlusionEnabled() || frame.objectCount == 0 || frame.maxMeshlets == 0)
+			return;
+
+		dispatch(commandBuffer, *pipeline, workgroupSize, frameIndex, LATE_PHASE, occlusionEnabled());
+	}
+
+	/**
+	* Records one early dispatch of frameIndex, as update() left it, through a candidate pipeline from
+	* buildPipeline(). The counters are cleared first so repeated dispatches stay within the draw lists,
+	* and occlusion is off so every meshlet in the frustum is tested; the statistics are not touched.
+	*/
+	void recordTuning(const vk::raii::CommandBuffer& commandBuffer, const vk::raii::Pipeline& candidate, uint32_t candidateSize, uint32_t frameIndex) const
+	{
+		const Frame& frame = frames[frameIndex];
+		if (frame.objectCount == 0 || frame.maxMeshlets == 0)
+			return;
+
+		vk::MemoryBarrier2 fillBarrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &fillBarrier });
+		commandBuffer.fillBuffer(*frame.counters.buffer, 0, vk::WholeSize, 0);
+
+		vk::MemoryBarrier2 clearBarrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &clearBarrier });
+
+		dispatch(commandBuffer, *candidate, candidateSize, frameIndex, EARLY_PHASE, false);
+	}
+
+	// For a command buffer holding this frame's record() that is submitted again instead of re-recorded.
+	void resubmit(uint32_t frameIndex)
+	{
+		Frame& frame = frames[frameIndex];
+		if (frame.objectCount != 0 && frame.maxMeshlets != 0)
+			frame.pending = true;
+	}
+
+	// Draws the meshlets of objectIndex that the given phase emitted; the index buffer must already be bound.
+	// Each object owns meshletCount draw slots per phase, enough for any range it can be given.
+	void draw(const vk::raii::CommandBuffer& commandBuffer, uint32_t frameIndex, uint32_t objectIndex, uint32_t phase = EARLY_PHASE) const
+	{
+		const Frame& frame = frames[frameIndex];
+		uint32_t list = phase * frame.objectCount + objectIndex;
+		commandBuffer.drawIndexedIndirectCount(
+			*frame.draws.buffer, sizeof(vk::DrawIndexedIndirectCommand) * meshletCount * list,
+			*frame.counters.buffer, sizeof(uint32_t) * list,
+			meshletCount, sizeof(vk::DrawIndexedIndirectCommand));
+	}
+
+	// The indirect draws of frameIndex, standing for all of its culling output in render graph dependencies.
+	[[nodiscard]] vk::Buffer drawBuffer(uint32_t frameIndex) const
+	{
+		return *frames[frameIndex].draws.buffer;
+	}
+
+	[[nodiscard]] const Statistics& getStatistics() const
+	{
+		return statistics;
+	}
+
+	// Triangles drawn by the most recently collected frame.
+	[[nodiscard]] uint64_t lastVisibleTriangles() const
+	{
+		return lastTriangles;
+	}
+
+	void resetStatistics()
+	{
+		statistics = {};
+	}
+
+	void printStatistics() const
+	{
+		if (statistics.tested == 0)
+			return;
+
+		auto percent = [this](uint64_t count) { return 100.0 * static_cast<double>(count) / static_cast<double>(statistics.tested); };
+		std::cout << "Meshlet culling: " << statistics.tested << " tested, " << percent(statistics.frustumCulled) << "% frustum culled, "
+			<< percent(statistics.coneCulled) << "% cone culled, " << percent(statistics.occlusionCulled) << "% occlusion culled, "
+			<< percent(statistics.visible) << "% drawn ("
+			<< statistics.visibleTriangles << " triangles)" << std::endl;
+	}
+
+private:
+	struct MeshletCullData
+	{
+		glm::vec4 sphere;
+		glm::vec4 cone;
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		uint32_t padding[2] = {};
+	};
+
+	struct CullObject
+	{
+		glm::vec4 planes[6];
+		glm::vec4 cameraPosition;
+		glm::vec4 modelView[3]; // rows of the object-to-view transform
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		float scale;
+		uint32_t padding = 0;
+	};
+
+	struct CullConstants
+	{
+		uint32_t meshletCount;
+		uint32_t objectCount;
+		uint32_t phase;
+		uint32_t occlusion;
+		uint32_t pyramidWidth;
+		uint32_t pyramidHeight;
+		uint32_t pyramidMips;
+		uint32_t padding;
+		glm::vec4 projection; // proj[0][0], proj[1][1], proj[2][2], proj[3][2]
+	};
+
+	struct HostBuffer
+	{
+		vk::raii::Buffer buffer = nullptr;
+		vk::raii::DeviceMemory memory = nullptr;
+		void* mapped = nullptr;
+	};
+
+	struct Frame
+	{
+		HostBuffer objects;
+		HostBuffer draws;
+		HostBuffer counters;
+		uint32_t objectCount = 0;
+		uint32_t maxMeshlets = 0;
+		uint64_t testedMeshlets = 0;
+		glm::vec4 projection{ 0.0f };
+		bool pending = false;
+	};
+
+	void dispatch(const vk::raii::CommandBuffer& commandBuffer, vk::Pipeline cullPipeline, uint32_t groupSize, uint32_t frameIndex, uint32_t phase, bool occlusion) const
+	{
+		const Frame& frame = frames[frameIndex];
+		CullConstants constants
+		{
+			.meshletCount = meshletCount,
+			.objectCount = frame.objectCount,
+			.phase = phase,
+			.occlusion = occlusion ? 1u : 0u,
+			.pyramidWidth = pyramidWidth,
+			.pyramidHeight = pyramidHeight,
+			.pyramidMips = pyramidMips,
+			.padding = 0,
+			.projection = frame.projection
+		};
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, cullPipeline);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, *descriptorSets[frameIndex], nullptr);
+		commandBuffer.pushConstants<CullConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+		commandBuffer.dispatch((frame.maxMeshlets + groupSize - 1) / groupSize, frame.objectCount, 1);
+	}
+
+	HostBuffer createBuffer(const vk::raii::Device& device, vk::DeviceSize size, vk::BufferUsageFlags usage) const
+	{
+		HostBuffer result;
+		result.buffer = vk::raii::Buffer(device, vk::BufferCreateInfo{ .size = size, .usage = usage, .sharingMode = vk::SharingMode::eExclusive });
+
+		vk::MemoryRequirements requirements = result.buffer.getMemoryRequirements();
+		vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+		uint32_t memoryType = UINT32_MAX;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				memoryType = i;
+				break;
+			}
+		}
+		if (memoryType == UINT32_MAX)
+			throw std::runtime_error("failed to find a host-visible memory type for meshlet culling!");
+
+		result.memory = vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = memoryType });
+		result.buffer.bindMemory(*result.memory, 0);
+		result.mapped = result.memory.mapMemory(0, size);
+		return result;
+	}
+
+	void createPipeline(const vk::raii::Device& device, const std::vector<char>& shaderCode, uint32_t framesInFlight)
+	{
+		std::array bindings = {
+			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(4, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(5, vk::DescriptorType::eSampledImage, 1, vk::ShaderStageFlagBits::eCompute, nullptr)
+		};
+		descriptorSetLayout = vk::raii::DescriptorSetLayout(device, vk::DescriptorSetLayoutCreateInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() });
+
+		vk::PushConstantRange pushConstantRange
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eCompute,
+			.offset = 0,
+			.size = sizeof(CullConstants)
+		};
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo
+		{
+			.setLayoutCount = 1,
+			.pSetLayouts = &*descriptorSetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
+		};
+		pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
+
+		// Kept for buildPipeline()
+		shaderModule = vk::raii::ShaderModule(device, vk::ShaderModuleCreateInfo{ .codeSize = shaderCode.size(), .pCode = reinterpret_cast<const uint32_t*>(shaderCode.data()) });
+		pipeline = buildPipeline(device, workgroupSize);
+
+		std::array poolSizes = {
+			vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, 5 * framesInFlight),
+			vk::DescriptorPoolSize(vk::DescriptorType::eSampledImage, framesInFlight)
+		};
+		descriptorPool = vk::raii::DescriptorPool(device, vk::DescriptorPoolCreateInfo{ .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, .maxSets = framesInFlight, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() });
+
+		std::vector<vk::DescriptorSetLayout> layouts(framesInFlight, *descriptorSetLayout);
+		descriptorSets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{ .descriptorPool = *descriptorPool, .descriptorSetCount = framesInFlight, .pSetLayouts = layouts.data() });
+
+		for (uint32_t i = 0; i < framesInFlight; i++)
+		{
+			std::array bufferInfos = {
+				vk::DescriptorBufferInfo{ .buffer = *meshletBuffer.buffer, .offset = 0, .range = vk::WholeSize },
+				vk::DescriptorBufferInfo{ .buffer = *frames[i].objects.buffer, .offset = 0, .range = vk::WholeSize },
+				vk::DescriptorBufferInfo{ .buffer = *frames[i].draws.buffer, .offset = 0, .range = vk::WholeSize },
+				vk::DescriptorBufferInfo{ .buffer = *frames[i].counters.buffer, .offset = 0, .range = vk::WholeSize },
+				vk::DescriptorBufferInfo{ .buffer = *visibilityBuffer.buffer, .offset = 0, .range = vk::WholeSize }
+			};
+
+			std::vector<vk::WriteDescriptorSet> writes;
+			for (uint32_t binding = 0; binding < bufferInfos.size(); binding++)
+			{
+				writes.push_back({
+					.dstSet = *descriptorSets[i],
+					.dstBinding = binding,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = vk::DescriptorType::eStorageBuffer,
+					.pBufferInfo = &bufferInfos[binding]
+				});
+			}
+			device.updateDescriptorSets(writes, {});
+		}
+	}
+
+	void collect(Frame& frame)
+	{
+		if (!frame.pending)
+			return;
+
+		const auto* counters = static_cast<const uint32_t*>(frame.counters.mapped);
+		const auto* draws = static_cast<const vk::DrawIndexedIndirectCommand*>(frame.draws.mapped);
+		lastTriangles = 0;
+		for (uint32_t list = 0; list < frame.objectCount * 2; list++)
+		{
+			statistics.visible += counters[list];
+			for (uint32_t draw = 0; draw < counters[list]; draw++)
+				lastTriangles += draws[static_cast<size_t>(list) * meshletCount + draw].indexCount / 3;
+		}
+		statistics.visibleTriangles += lastTriangles;
+		statistics.frustumCulled += counters[frame.objectCount * 2];
+		statistics.coneCulled += counters[frame.objectCount * 2 + 1];
+		statistics.occlusionCulled += counters[frame.objectCount * 2 + 2];
+		statistics.tested += frame.testedMeshlets;
+		frame.pending = false;
+	}
+
+	vk::PhysicalDeviceMemoryProperties memoryProperties{};
+	uint32_t meshletCount = 0;
+	uint32_t maxObjects = 0;
+	uint32_t workgroupSize = WORKGROUP_SIZE;
+	uint64_t lastTriangles = 0;
+	uint32_t pyramidWidth = 0;
+	uint32_t pyramidHeight = 0;
+	uint32_t pyramidMips = 0;
+
+	HostBuffer meshletBuffer;
+	HostBuffer visibilityBuffer;
+	std::vector<Frame> frames;
+
+	vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
+	vk::raii::PipelineLayout pipelineLayout = nullptr;
+	vk::raii::ShaderModule shaderModule = nullptr;
+	vk::raii::Pipeline pipeline = nullptr;
+	vk::raii::DescriptorPool descriptorPool = nullptr;
+	std::vector<vk::raii::DescriptorSet> descriptorSets;
+
+	Statistics statistics;
+};
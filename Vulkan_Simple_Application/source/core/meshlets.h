@@ -0,0 +1,172 @@
+#pragma once
+
+// Meshlet (cluster) generation for per-cluster culling.
+//
+// Meshlets are built greedily over the (cache-optimized) index buffer, so every meshlet is a contiguous
+// range of the mesh's indices and can be drawn from the regular index buffer with one indirect command.
+// Each meshlet carries a bounding sphere for frustum culling and a normal cone for backface culling:
+// the whole meshlet faces away from a camera at position c when
+//     dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius
+// A coneCutoff of 1 disables the cone test (the triangles point in too many directions).
+// Meshes with an LOD chain get one run of meshlets per level (buildLodMeshlets), so culling can pick a
+// level per instance and only test that level's meshlets.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "core/meshData.h"
+
+struct MeshletOptions
+{
+	uint32_t maxVertices = 64;
+	uint32_t maxTriangles = 124;
+	bool clockwiseFrontFaces = false; // set when the mesh winding is mirrored relative to the rasterizer's front face
+};
+
+struct Meshlet
+{
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	uint32_t vertexCount = 0;
+
+	glm::vec3 center{ 0.0f };
+	float radius = 0.0f;
+	glm::vec3 coneAxis{ 0.0f, 0.0f, 1.0f };
+	float coneCutoff = 1.0f;
+};
+
+// A contiguous run of meshlets, e.g. the meshlets of one LOD.
+struct MeshletRange
+{
+	uint32_t firstMeshlet = 0;
+	uint32_t meshletCount = 0;
+};
+
+namespace meshlet_builder
+{
+	inline void computeBounds(Meshlet& meshlet, const MeshData& mesh, const std::vector<uint32_t>& vertices, bool clockwiseFrontFaces)
+	{
+		MeshBounds bounds;
+		for (uint32_t vertex : vertices)
+			bounds.expand(mesh.vertices[vertex].pos);
+
+		meshlet.center = bounds.center();
+		meshlet.radius = 0.0f;
+		for (uint32_t vertex : vertices)
+			meshlet.radius = std::max(meshlet.radius, glm::length(mesh.vertices[vertex].pos - meshlet.center));
+
+		std::vector<glm::vec3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+		for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+		{
+			const glm::vec3& p0 = mesh.vertices[mesh.indices[i + 0]].pos;
+			const glm::vec3& p1 = mesh.vertices[mesh.indices[i + 1]].pos;
+			const glm::vec3& p2 = mesh.vertices[mesh.indices[i + 2]].pos;
+
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+				normals.push_back((clockwiseFrontFaces ? -normal : normal) / length);
+		}
+
+		meshlet.coneAxis = { 0.0f, 0.0f, 1.0f };
+		meshlet.coneCutoff = 1.0f;
+
+		glm::vec3 axis(0.0f);
+		for (const glm::vec3& normal : normals)
+			axis += normal;
+
+		float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength == 0.0f)
+			return;
+
+		axis /= axisLength;
+		float minimumDot = 1.0f;
+		for (const glm::vec3& normal : normals)
+			minimumDot = std::min(minimumDot, glm::dot(normal, axis));
+
+		// Cones wider than ~84 degrees almost never cull anything
+		if (minimumDot <= 0.1f)
+			return;
+
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+	}
+}
+
+// Builds meshlets over indexCount indices of mesh.indices starting at firstIndex.
+inline std::vector<Meshlet> buildMeshlets(const MeshData& mesh, uint32_t firstIndex, uint32_t indexCount, const MeshletOptions& options = {})
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> lastMeshlet(mesh.vertices.size(), UINT32_MAX);
+	std::vector<uint32_t> vertices;
+	vertices.reserve(options.maxVertices);
+
+	Meshlet current{ .firstIndex = firstIndex };
+	auto finish = [&]()
+		{
+			if (current.indexCount == 0)
+				return;
+
+			current.vertexCount = static_cast<uint32_t>(vertices.size());
+			meshlet_builder::computeBounds(current, mesh, vertices, options.clockwiseFrontFaces);
+			meshlets.push_back(current);
+
+			current = Meshlet{ .firstIndex = current.firstIndex + current.indexCount };
+			vertices.clear();
+		};
+
+	for (size_t i = firstIndex; i + 2 < static_cast<size_t>(firstIndex) + indexCount; i += 3)
+	{
+		uint32_t a = mesh.indices[i + 0];
+		uint32_t b = mesh.indices[i + 1];
+		uint32_t c = mesh.indices[i + 2];
+
+		uint32_t meshletId = static_cast<uint32_t>(meshlets.size());
+		uint32_t newVertices = (lastMeshlet[a] != meshletId) +
+			(lastMeshlet[b] != meshletId && b != a) +
+			(lastMeshlet[c] != meshletId && c != a && c != b);
+
+		if (vertices.size() + newVertices > options.maxVertices || current.indexCount / 3 + 1 > options.maxTriangles)
+		{
+			finish();
+			meshletId = static_cast<uint32_t>(meshlets.size());
+		}
+
+		for (uint32_t vertex : { a, b, c })
+		{
+			if (lastMeshlet[vertex] != meshletId)
+			{
+				lastMeshlet[vertex] = meshletId;
+				vertices.push_back(vertex);
+			}
+		}
+
+		current.indexCount += 3;
+	}
+
+	finish();
+	return meshlets;
+}
+
+inline std::vector<Meshlet> buildMeshlets(const MeshData& mesh, const MeshletOptions& options = {})
+{
+	return buildMeshlets(mesh, 0, static_cast<uint32_t>(mesh.indices.size()), options);
+}
+
+// Appends the meshlets of every LOD in mesh.lods to meshlets and returns one range per LOD.
+inline std::vector<MeshletRange> buildLodMeshlets(const MeshData& mesh, std::vector<Meshlet>& meshlets, const MeshletOptions& options = {})
+{
+	std::vector<MeshletRange> ranges;
+	for (const MeshLod& lod : mesh.lods)
+	{
+		std::vector<Meshlet> lodMeshlets = buildMeshlets(mesh, lod.firstIndex, lod.indexCount, options);
+		ranges.push_back({ static_cast<uint32_t>(meshlets.size()), static_cast<uint32_t>(lodMeshlets.size()) });
+		meshlets.insert(meshlets.end(), lodMeshlets.begin(), lodMeshlets.end());
+	}
+	return ranges;
+}
@@ -0,0 +1,301 @@
+#pragma once
+
+// Compute mip chain generation (resources/shaders/compute/shader_mipgen.slang).
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Replaces the vkCmdBlitImage chain: one dispatch writes up to twelve mips from workgroup shared
+// memory, with no barrier per level, and needs no linear-filter or blit support from the format,
+// only storage-image support on its non-sRGB alias. sRGB images are filtered in linear space.
+// The shader declares its images rgba8, so the format must be R8G8B8A8 (UNORM or sRGB), and it indexes
+// them by level, which needs shaderStorageImageArrayDynamicIndexing enabled.
+// Images must be created with eStorage usage and, for sRGB formats, eMutableFormat | eExtendedUsage.
+// The 256-thread workgroup is not tuned (see workgroupTuner.h): the shader maps its threads onto the
+// 64x64 tile and the groupshared levels.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+class MipGenerator
+{
+public:
+	static constexpr uint32_t MAX_MIPS_PER_DISPATCH = 12;
+	static constexpr uint32_t TILE_SIZE = 64; // base texels per workgroup and axis
+
+	// The format the shader reads and writes through; sRGB formats map to their UNORM alias.
+	static vk::Format storageFormat(vk::Format format)
+	{
+		switch (format)
+		{
+		case vk::Format::eR8G8B8A8Srgb:
+			return vk::Format::eR8G8B8A8Unorm;
+		case vk::Format::eB8G8R8A8Srgb:
+			return vk::Format::eB8G8R8A8Unorm;
+		default:
+			return format;
+		}
+	}
+
+	static bool isSrgb(vk::Format format)
+	{
+		return storageFormat(format) != format;
+	}
+
+	// Whether format can be generated for; the device must also have shaderStorageImageArrayDynamicIndexing enabled.
+	static bool supported(const vk::raii::PhysicalDevice& physicalDevice, vk::Format format)
+	{
+		if (storageFormat(format) != vk::Format::eR8G8B8A8Unorm || !physicalDevice.getFeatures().shaderStorageImageArrayDynamicIndexing)
+			return false;
+
+		vk::FormatProperties properties = physicalDevice.getFormatProperties(storageFormat(format));
+		return static_cast<bool>(properties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage);
+	}
+
+	// Create flags an image needs so generate() can alias it with its storage format.
+	static vk::ImageCreateFlags imageCreateFlags(vk::Format format)
+	{
+		return isSrgb(format) ? vk::ImageCreateFlagBits::eMutableFormat | vk::ImageCreateFlagBits::eExtendedUsage : vk::ImageCreateFlags{};
+	}
+
+	// shaderCode is the SPIR-V of resources/shaders/compute/slang_mipgen.spv.
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, const std::vector<char>& shaderCode)
+	{
+		memoryProperties = physicalDevice.getMemoryProperties();
+		createCounter(device);
+		createPipeline(device, shaderCode);
+	}
+
+	/**
+	* Records the generation of mips 1 to mipLevels - 1 from level 0. Level 0 must be in currentLayout
+	* with its writes done by a transfer; all levels end in eShaderReadOnlyOptimal for fragment shaders.
+	* The views and descriptor sets used are kept until the next call, so the command buffer must have
+	* completed before generate() is called again.
+	*/
+	void generate(const vk::raii::CommandBuffer& commandBuffer, const vk::raii::Device& device, vk::Image image, vk::Format format,
+		uint32_t width, uint32_t height, uint32_t mipLevels, vk::ImageLayout currentLayout)
+	{
+		descriptorSets.clear();
+		views.clear();
+		if (mipLevels < 2)
+			throw std::runtime_error("mip generation needs at least two levels!");
+
+		vk::Format viewFormat = storageFormat(format);
+		for (uint32_t mip = 0; mip < mipLevels; mip++)
+		{
+			vk::ImageViewCreateInfo viewInfo
+			{
+				.image = image,
+				.viewType = vk::ImageViewType::e2D,
+				.format = viewFormat,
+				.subresourceRange = { vk::ImageAspectFlagBits::eColor, mip, 1, 0, 1 }
+			};
+			views.emplace_back(device, viewInfo);
+		}
+
+		// Base level 0, 12, 24, ...; a dispatch only continues past six mips when mip 6 fits one tile
+		std::vector<uint32_t> bases;
+		std::vector<uint32_t> counts;
+		for (uint32_t base = 0; base + 1 < mipLevels;)
+		{
+			uint32_t baseSize = std::max(std::max(width >> base, 1u), std::max(height >> base, 1u));
+			uint32_t count = std::min(mipLevels - 1 - base, baseSize <= TILE_SIZE * TILE_SIZE ? MAX_MIPS_PER_DISPATCH : MAX_MIPS_PER_DISPATCH / 2);
+			bases.push_back(base);
+			counts.push_back(count);
+			base += count;
+		}
+
+		uint32_t dispatchCount = static_cast<uint32_t>(bases.size());
+		if (dispatchCount > maxDispatches)
+			createDescriptorPool(device, dispatchCount);
+
+		std::vector<vk::DescriptorSetLayout> layouts(dispatchCount, *descriptorSetLayout);
+		descriptorSets = device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{ .descriptorPool = *descriptorPool, .descriptorSetCount = dispatchCount, .pSetLayouts = layouts.data() });
+
+		for (uint32_t i = 0; i < dispatchCount; i++)
+		{
+			std::array<vk::DescriptorImageInfo, MAX_MIPS_PER_DISPATCH + 1> imageInfos;
+			for (uint32_t level = 0; level < imageInfos.size(); level++)
+				imageInfos[level] = { .imageView = *views[std::min(bases[i] + level, mipLevels - 1)], .imageLayout = vk::ImageLayout::eGeneral };
+
+			vk::DescriptorBufferInfo counterInfo{ .buffer = *counterBuffer, .offset = 0, .range = vk::WholeSize };
+			std::array writes = {
+				vk::WriteDescriptorSet{ .dstSet = *descriptorSets[i], .dstBinding = 0, .descriptorCount = static_cast<uint32_t>(imageInfos.size()), .descriptorType = vk::DescriptorType::eStorageImage, .pImageInfo = imageInfos.data() },
+				vk::WriteDescriptorSet{ .dstSet = *descriptorSets[i], .dstBinding = 1, .descriptorCount = 1, .descriptorType = vk::DescriptorType::eStorageBuffer, .pBufferInfo = &counterInfo }
+			};
+			device.updateDescriptorSets(writes, {});
+		}
+
+		std::array toGeneral = {
+			vk::ImageMemoryBarrier2
+			{
+				.srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead,
+				.oldLayout = currentLayout,
+				.newLayout = vk::ImageLayout::eGeneral,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = image,
+				.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 }
+			},
+			vk::ImageMemoryBarrier2
+			{
+				.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+				.srcAccessMask = {},
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+				.oldLayout = vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eGeneral,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = image,
+				.subresourceRange = { vk::ImageAspectFlagBits::eColor, 1, mipLevels - 1, 0, 1 }
+			}
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = static_cast<uint32_t>(toGeneral.size()), .pImageMemoryBarriers = toGeneral.data() });
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+		for (uint32_t i = 0; i < dispatchCount; i++)
+		{
+			uint32_t baseWidth = std::max(width >> bases[i], 1u);
+			uint32_t baseHeight = std::max(height >> bases[i], 1u);
+			uint32_t groupsX = (baseWidth + TILE_SIZE - 1) / TILE_SIZE;
+			uint32_t groupsY = (baseHeight + TILE_SIZE - 1) / TILE_SIZE;
+
+			MipConstants constants
+			{
+				.width = baseWidth,
+				.height = baseHeight,
+				.mipCount = counts[i],
+				.groupCount = groupsX * groupsY,
+				.srgb = isSrgb(format) ? 1u : 0u
+			};
+
+			if (i > 0)
+			{
+				vk::MemoryBarrier2 levelBarrier
+				{
+					.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+					.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+					.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+					.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+				};
+				commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &levelBarrier });
+			}
+
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, *descriptorSets[i], nullptr);
+			commandBuffer.pushConstants<MipConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, constants);
+			commandBuffer.dispatch(groupsX, groupsY, 1);
+		}
+
+		vk::ImageMemoryBarrier2 toShaderRead
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+			.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+			.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead,
+			.oldLayout = vk::ImageLayout::eGeneral,
+			.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 }
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toShaderRead });
+	}
+
+private:
+	struct MipConstants
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+		uint32_t groupCount;
+		uint32_t srgb;
+	};
+
+	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties) const
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+			if ((typeFilter & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+				return i;
+
+		throw std::runtime_error("failed to find a memory type for mip generation!");
+	}
+
+	// The shader's workgroup counter; the last workgroup resets it to zero after every dispatch.
+	void createCounter(const vk::raii::Device& device)
+	{
+		counterBuffer = vk::raii::Buffer(device, vk::BufferCreateInfo{ .size = sizeof(uint32_t), .usage = vk::BufferUsageFlagBits::eStorageBuffer, .sharingMode = vk::SharingMode::eExclusive });
+
+		vk::MemoryRequirements requirements = counterBuffer.getMemoryRequirements();
+		vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+		counterMemory = vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties) });
+		counterBuffer.bindMemory(*counterMemory, 0);
+
+		void* mapped = counterMemory.mapMemory(0, sizeof(uint32_t));
+		*static_cast<uint32_t*>(mapped) = 0;
+		counterMemory.unmapMemory();
+	}
+
+	void createPipeline(const vk::raii::Device& device, const std::vector<char>& shaderCode)
+	{
+		std::array bindings = {
+			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageImage, MAX_MIPS_PER_DISPATCH + 1, vk::ShaderStageFlagBits::eCompute, nullptr),
+			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr)
+		};
+		descriptorSetLayout = vk::raii::DescriptorSetLayout(device, vk::DescriptorSetLayoutCreateInfo{ .bindingCount = static_cast<uint32_t>(bindings.size()), .pBindings = bindings.data() });
+
+		vk::PushConstantRange pushConstantRange
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eCompute,
+			.offset = 0,
+			.size = sizeof(MipConstants)
+		};
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo
+		{
+			.setLayoutCount = 1,
+			.pSetLayouts = &*descriptorSetLayout,
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
+		};
+		pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
+
+		vk::raii::ShaderModule shaderModule(device, vk::ShaderModuleCreateInfo{ .codeSize = shaderCode.size(), .pCode = reinterpret_cast<const uint32_t*>(shaderCode.data()) });
+		vk::ComputePipelineCreateInfo pipelineInfo
+		{
+			.stage = { .stage = vk::ShaderStageFlagBits::eCompute, .module = shaderModule, .pName = "downsampleMain" },
+			.layout = *pipelineLayout
+		};
+		pipeline = vk::raii::Pipeline(device, nullptr, pipelineInfo);
+
+		createDescriptorPool(device, 2);
+	}
+
+	void createDescriptorPool(const vk::raii::Device& device, uint32_t dispatches)
+	{
+		descriptorSets.clear();
+		std::array poolSizes = {
+			vk::DescriptorPoolSize(vk::DescriptorType::eStorageImage, (MAX_MIPS_PER_DISPATCH + 1) * dispatches),
+			vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer, dispatches)
+		};
+		descriptorPool = vk::raii::DescriptorPool(device, vk::DescriptorPoolCreateInfo{ .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet, .maxSets = dispatches, .poolSizeCount = static_cast<uint32_t>(poolSizes.size()), .pPoolSizes = poolSizes.data() });
+		maxDispatches = dispatches;
+	}
+
+	vk::PhysicalDeviceMemoryProperties memoryProperties{};
+	uint32_t maxDispatches = 0;
+
+	vk::raii::Buffer counterBuffer = nullptr;
+	vk::raii::DeviceMemory counterMemory = nullptr;
+
+	vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
+	vk::raii::PipelineLayout pipelineLayout = nullptr;
+	vk::raii::Pipeline pipeline = nullptr;
+	vk::raii::DescriptorPool descriptorPool = nullptr;
+	std::vector<vk::raii::DescriptorSet> descriptorSets;
+	std::vector<vk::raii::ImageView> views;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// Records the draws of a pass into secondary command buffers on a ThreadPool.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// The draw list is cut into contiguous slices, each recorded by one task into a buffer of its own; the
+// primary executes them in slice order inside its dynamic rendering scope, so the pass draws in the same
+// order as when it is recorded inline. Secondaries inherit nothing from the primary but the attachment
+// formats (CommandBufferInheritanceRenderingInfo) and, where inheritedQueries is enabled, active
+// pipeline-statistics queries: every slice binds its own pipeline, buffers, descriptors and dynamic state.
+//
+// A command pool may only be used by one thread at a time, so each slice has a pool of its own. Several
+// passes can be recorded per frame: reset() rewinds the recorder, and every record() after it takes the
+// next buffer of each pool. The buffers must not be pending execution when reset() is called.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "core/taskGraph.h"
+
+class ParallelRecorder
+{
+public:
+	using RecordSlice = std::function<void(const vk::raii::CommandBuffer& commandBuffer, uint32_t first, uint32_t count)>;
+
+	// sliceCount is the most slices a pass is cut into, usually the pool's thread count.
+	void init(const vk::raii::Device& device, uint32_t queueFamilyIndex, uint32_t sliceCount)
+	{
+		this->device = &device;
+		slices.clear();
+		for (uint32_t i = 0; i < std::max(sliceCount, 1u); i++)
+		{
+			Slice slice;
+			slice.pool = vk::raii::CommandPool(device, vk::CommandPoolCreateInfo{ .queueFamilyIndex = queueFamilyIndex });
+			slices.push_back(std::move(slice));
+		}
+		recorded.clear();
+	}
+
+	[[nodiscard]] bool ready() const
+	{
+		return !slices.empty();
+	}
+
+	// Makes every buffer available again, for the first pass of a new recording.
+	void reset()
+	{
+		for (Slice& slice : slices)
+		{
+			if (slice.used > 0)
+				slice.pool.reset();
+			slice.used = 0;
+		}
+		recorded.clear();
+	}
+
+	/**
+	* Records items [0, itemCount) in slices of at least minItemsPerSlice items and blocks until all are
+	* recorded; recordSlice runs on the pool's threads, concurrently for different slices. Then call
+	* execute() inside a rendering scope begun with eContentsSecondaryCommandBuffers.
+	*/
+	void record(ThreadPool& pool, const vk::CommandBufferInheritanceRenderingInfo& rendering, vk::QueryPipelineStatisticFlags pipelineStatistics,
+		uint32_t itemCount, uint32_t minItemsPerSlice, const RecordSlice& recordSlice)
+	{
+		uint32_t minItems = std::max(minItemsPerSlice, 1u);
+		uint32_t sliceCount = std::clamp((itemCount + minItems - 1) / minItems, 1u, static_cast<uint32_t>(slices.size()));
+		uint32_t itemsPerSlice = (itemCount + sliceCount - 1) / sliceCount;
+
+		recorded.assign(sliceCount, nullptr);
+		TaskGraph graph;
+		for (uint32_t i = 0; i < sliceCount; i++)
+		{
+			graph.add("record_slice", [&, i]()
+				{
+					Slice& slice = slices[i];
+					if (slice.used == slice.buffers.size())
+					{
+						vk::CommandBufferAllocateInfo allocInfo
+						{
+							.commandPool = *slice.pool,
+							.level = vk::CommandBufferLevel::eSecondary,
+							.commandBufferCount = 1
+						};
+						slice.buffers.push_back(std::move(vk::raii::CommandBuffers(*device, allocInfo).front()));
+					}
+					const vk::raii::CommandBuffer& commandBuffer = slice.buffers[slice.used++];
+
+					vk::CommandBufferInheritanceInfo inheritance
+					{
+						.pNext = &rendering,
+						.pipelineStatistics = pipelineStatistics
+					};
+					commandBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue, .pInheritanceInfo = &inheritance });
+
+					uint32_t first = std::min(i * itemsPerSlice, itemCount);
+					recordSlice(commandBuffer, first, std::min(itemsPerSlice, itemCount - first));
+					commandBuffer.end();
+					recorded[i] = *commandBuffer;
+				});
+		}
+		graph.run(pool);
+	}
+
+	// Executes the slices of the last record() in order.
+	void execute(const vk::raii::CommandBuffer& primary) const
+	{
+		primary.executeCommands(recorded);
+	}
+
+private:
+	struct Slice
+	{
+		vk::raii::CommandPool pool = nullptr;
+		std::vector<vk::raii::CommandBuffer> buffers;
+		size_t used = 0;
+	};
+
+	const vk::raii::Device* device = nullptr;
+	std::vector<Slice> slices;
+	std::vector<vk::CommandBuffer> recorded;
+};
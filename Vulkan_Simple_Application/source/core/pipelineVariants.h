@@ -0,0 +1,245 @@
+#pragma once
+
+// Render state that draws vary, and the graphics pipelines that cover it.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// A pipeline bakes every piece of state it does not declare dynamic, so each cull mode, depth test or
+// topology a renderer draws with would otherwise need a pipeline of its own. PipelineVariants takes the
+// RenderStates one pipeline description is drawn with and declares as much of them dynamic as the device
+// allows: the extended dynamic state that Vulkan 1.3 made core (VK_EXT_extended_dynamic_state and _state2:
+// cull mode, front face, topology, primitive restart, depth test, write, compare and bias enable) and the
+// polygon mode of VK_EXT_extended_dynamic_state3 where its feature is enabled. bind() sets those values
+// while recording. What stays baked gets one pipeline per distinct value, so without dynamic state every
+// RenderState is a pipeline of its own. The topology stays baked per class (points, lines, triangles,
+// patches) unless the device reports dynamicPrimitiveTopologyUnrestricted.
+//
+// All variants are created in create(), recording never compiles a pipeline.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+struct RenderState
+{
+	vk::CullModeFlags cullMode = vk::CullModeFlagBits::eBack;
+	vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise;
+	vk::PrimitiveTopology topology = vk::PrimitiveTopology::eTriangleList;
+	bool primitiveRestart = false;
+	bool depthTest = true;
+	bool depthWrite = true;
+	vk::CompareOp depthCompare = vk::CompareOp::eLess;
+	bool depthBias = false;          // the bias factors stay those of the pipeline description
+	vk::PolygonMode polygonMode = vk::PolygonMode::eFill;
+
+	bool operator==(const RenderState&) const = default;
+};
+
+class PipelineVariants
+{
+public:
+	// What of RenderState a device can set while recording.
+	struct Support
+	{
+		bool extended = false;              // everything but the polygon mode, core in Vulkan 1.3
+		bool polygonMode = false;           // needs VK_EXT_extended_dynamic_state3 enabled
+		bool unrestrictedTopology = false;  // the topology may change class, not just e.g. list to strip
+	};
+
+	static Support supported(const vk::raii::PhysicalDevice& physicalDevice)
+	{
+		Support support{ .extended = physicalDevice.getProperties().apiVersion >= VK_API_VERSION_1_3 };
+
+		auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+		bool extension3Available = std::ranges::any_of(extensions, [](const vk::ExtensionProperties& extension)
+			{
+				return strcmp(extension.extensionName, vk::EXTExtendedDynamicState3ExtensionName) == 0;
+			});
+
+		if (!support.extended || !extension3Available)
+			return support;
+
+		auto features = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>();
+		support.polygonMode = features.get<vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT>().extendedDynamicState3PolygonMode;
+		if (support.polygonMode)
+		{
+			auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceExtendedDynamicState3PropertiesEXT>();
+			support.unrestrictedTopology = properties.get<vk::PhysicalDeviceExtendedDynamicState3PropertiesEXT>().dynamicPrimitiveTopologyUnrestricted;
+		}
+		return support;
+	}
+
+	// Name of a support level for reports: extended3, extended or off.
+	static const char* name(const Support& support)
+	{
+		return support.polygonMode ? "extended3" : support.extended ? "extended" : "off";
+	}
+
+	// A default Support bakes everything. Drops the pipelines of an earlier create().
+	void init(const Support& support)
+	{
+		this->support = support;
+		variants.clear();
+		createTimeMs = 0.0;
+	}
+
+	/**
+	* Creates the pipelines that draw every state of states. pipelineInfo is the description they share:
+	* its input assembly, rasterization and depth-stencil state are overridden per variant, and the state
+	* made dynamic here is appended to its dynamic state.
+	*/
+	void create(const vk::raii::Device& device, const vk::GraphicsPipelineCreateInfo& pipelineInfo, const std::vector<RenderState>& states)
+	{
+		auto begin = std::chrono::steady_clock::now();
+
+		std::vector<vk::DynamicState> dynamicStates;
+		if (pipelineInfo.pDynamicState)
+			dynamicStates.assign(pipelineInfo.pDynamicState->pDynamicStates, pipelineInfo.pDynamicState->pDynamicStates + pipelineInfo.pDynamicState->dynamicStateCount);
+		if (support.extended)
+		{
+			dynamicStates.insert(dynamicStates.end(), {
+				vk::DynamicState::eCullMode, vk::DynamicState::eFrontFace, vk::DynamicState::ePrimitiveTopology,
+				vk::DynamicState::ePrimitiveRestartEnable, vk::DynamicState::eDepthBiasEnable });
+			if (pipelineInfo.pDepthStencilState)
+				dynamicStates.insert(dynamicStates.end(), { vk::DynamicState::eDepthTestEnable, vk::DynamicState::eDepthWriteEnable, vk::DynamicState::eDepthCompareOp });
+		}
+		if (support.polygonMode)
+			dynamicStates.push_back(vk::DynamicState::ePolygonModeEXT);
+
+		vk::PipelineDynamicStateCreateInfo dynamicState
+		{
+			.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+			.pDynamicStates = dynamicStates.data()
+		};
+		vk::PipelineInputAssemblyStateCreateInfo inputAssembly = *pipelineInfo.pInputAssemblyState;
+		vk::PipelineRasterizationStateCreateInfo rasterizer = *pipelineInfo.pRasterizationState;
+		vk::PipelineDepthStencilStateCreateInfo depthStencil = pipelineInfo.pDepthStencilState ? *pipelineInfo.pDepthStencilState : vk::PipelineDepthStencilStateCreateInfo{};
+
+		vk::GraphicsPipelineCreateInfo variantInfo = pipelineInfo;
+		variantInfo.pInputAssemblyState = &inputAssembly;
+		variantInfo.pRasterizationState = &rasterizer;
+		if (pipelineInfo.pDepthStencilState)
+			variantInfo.pDepthStencilState = &depthStencil;
+		variantInfo.pDynamicState = &dynamicState;
+
+		for (const RenderState& state : states)
+		{
+			RenderState key = baked(state);
+			if (std::ranges::any_of(variants, [&key](const Variant& variant) { return variant.baked == key; }))
+				continue;
+
+			inputAssembly.topology = key.topology;
+			inputAssembly.primitiveRestartEnable = key.primitiveRestart;
+			rasterizer.polygonMode = key.polygonMode;
+			rasterizer.cullMode = key.cullMode;
+			rasterizer.frontFace = key.frontFace;
+			rasterizer.depthBiasEnable = key.depthBias;
+			depthStencil.depthTestEnable = key.depthTest;
+			depthStencil.depthWriteEnable = key.depthWrite;
+			depthStencil.depthCompareOp = key.depthCompare;
+			variants.push_back({ key, vk::raii::Pipeline(device, nullptr, variantInfo) });
+		}
+
+		createTimeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	[[nodiscard]] bool ready() const
+	{
+		return !variants.empty();
+	}
+
+	// The pipeline that draws state; state must have been passed to create().
+	[[nodiscard]] vk::Pipeline pipeline(const RenderState& state) const
+	{
+		RenderState key = baked(state);
+		auto variant = std::ranges::find_if(variants, [&key](const Variant& candidate) { return candidate.baked == key; });
+		if (variant == variants.end())
+			throw std::runtime_error("render state has no pipeline, pass it to PipelineVariants::create!");
+
+		return *variant->pipeline;
+	}
+
+	// Binds the pipeline of state and sets its dynamic part. Dynamic state is not inherited, so every
+	// secondary command buffer binds on its own.
+	void bind(const vk::raii::CommandBuffer& commandBuffer, const RenderState& state) const
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline(state));
+		if (support.extended)
+		{
+			commandBuffer.setCullMode(state.cullMode);
+			commandBuffer.setFrontFace(state.frontFace);
+			commandBuffer.setPrimitiveTopology(state.topology);
+			commandBuffer.setPrimitiveRestartEnable(state.primitiveRestart);
+			commandBuffer.setDepthBiasEnable(state.depthBias);
+			commandBuffer.setDepthTestEnable(state.depthTest);
+			commandBuffer.setDepthWriteEnable(state.depthWrite);
+			commandBuffer.setDepthCompareOp(state.depthCompare);
+		}
+		if (support.polygonMode)
+			commandBuffer.setPolygonModeEXT(state.polygonMode);
+	}
+
+	[[nodiscard]] uint32_t pipelineCount() const
+	{
+		return static_cast<uint32_t>(variants.size());
+	}
+
+	// Time spent in create() since init().
+	[[nodiscard]] double createMs() const
+	{
+		return createTimeMs;
+	}
+
+private:
+	struct Variant
+	{
+		RenderState baked;
+		vk::raii::Pipeline pipeline = nullptr;
+	};
+
+	// state with what is set while recording replaced by the defaults, which identifies its pipeline.
+	[[nodiscard]] RenderState baked(const RenderState& state) const
+	{
+		RenderState key = state;
+		RenderState defaults;
+		if (support.extended)
+		{
+			key.cullMode = defaults.cullMode;
+			key.frontFace = defaults.frontFace;
+			key.topology = support.unrestrictedTopology ? defaults.topology : topologyClass(state.topology);
+			key.primitiveRestart = defaults.primitiveRestart;
+			key.depthTest = defaults.depthTest;
+			key.depthWrite = defaults.depthWrite;
+			key.depthCompare = defaults.depthCompare;
+			key.depthBias = defaults.depthBias;
+		}
+		if (support.polygonMode)
+			key.polygonMode = defaults.polygonMode;
+
+		return key;
+	}
+
+	// One topology of the class of topology, which a pipeline can be switched within.
+	static vk::PrimitiveTopology topologyClass(vk::PrimitiveTopology topology)
+	{
+		switch (topology)
+		{
+		case vk::PrimitiveTopology::ePointList:
+			return vk::PrimitiveTopology::ePointList;
+		case vk::PrimitiveTopology::eLineList:
+		case vk::PrimitiveTopology::eLineStrip:
+		case vk::PrimitiveTopology::eLineListWithAdjacency:
+		case vk::PrimitiveTopology::eLineStripWithAdjacency:
+			return vk::PrimitiveTopology::eLineList;
+		case vk::PrimitiveTopology::ePatchList:
+			return vk::PrimitiveTopology::ePatchList;
+		default:
+			return vk::PrimitiveTopology::eTriangleList;
+		}
+	}
+
+	Support support;
+	std::vector<Variant> variants;
+	double createTimeMs = 0.0;
+};
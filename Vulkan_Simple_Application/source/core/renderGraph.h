@@ -0,0 +1,731 @@
+#pragma once
+
+// Frame render graph: passes declare the images and buffers they read and write, and the graph derives
+// the barriers between them. Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// A graph is declared for every recording: reset(), import the resources the frame touches, add the
+// passes in submission order with their reads and writes, then execute() into a command buffer. compile()
+// (called by execute()) does three things:
+//   - culls passes nothing needs: a pass is kept when it has side effects, writes an exported resource
+//     (one with a final usage) or writes what a kept pass after it reads;
+//   - gives every kept pass one batch of barriers, recorded as a single pipelineBarrier2 in front of it.
+//     Only layout changes get image barriers; every other dependency of the batch is folded into one
+//     global memory barrier, which is what drivers do with buffer barriers anyway. A read after a read in
+//     the same layout needs nothing. The first use of a resource in the frame only waits on work of
+//     earlier submissions, so its barrier moves into the batch of the first pass;
+//   - assigns transient images to memory blocks, sharing a block between images whose lifetimes do not
+//     overlap.
+//
+// An import states the usage the frame finds it in. That must not depend on the frame before: a recording
+// may be replayed after any other (see commandCache.h). So a persistent image that must keep its contents is
+// moved to one layout at creation and imported in it every frame; others are imported as eUndefined.
+// Transient images start every frame undefined; their memory is created by allocate() from the lifetimes
+// of a compiled graph, and later graphs must declare the same transients with lifetimes that still fit
+// their blocks. Frames in flight share the transients, as they share any other attachment: the first
+// use in a frame waits for every use of the block in a frame, which orders it after the frames before.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+class RenderGraph
+{
+public:
+	using Resource = uint32_t;
+	using Record = std::function<void(const vk::raii::CommandBuffer& commandBuffer)>;
+
+	// How a pass touches a resource; layout only applies to images.
+	struct Usage
+	{
+		vk::PipelineStageFlags2 stages;
+		vk::AccessFlags2 access;
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+	};
+
+	struct ImageDesc
+	{
+		vk::Format format = vk::Format::eUndefined;
+		vk::Extent2D extent;
+		vk::ImageUsageFlags usage;
+		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+
+		bool operator==(const ImageDesc&) const = default;
+	};
+
+	static Usage colorAttachment()
+	{
+		return { vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite, vk::ImageLayout::eColorAttachmentOptimal };
+	}
+
+	static Usage depthAttachment()
+	{
+		return { vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+			vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite, vk::ImageLayout::eDepthStencilAttachmentOptimal };
+	}
+
+	// A depth buffer sampled by shaders.
+	static Usage depthSampled(vk::PipelineStageFlags2 stages)
+	{
+		return { stages, vk::AccessFlagBits2::eShaderSampledRead, vk::ImageLayout::eDepthStencilReadOnlyOptimal };
+	}
+
+	static Usage sampled(vk::PipelineStageFlags2 stages, vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal)
+	{
+		return { stages, vk::AccessFlagBits2::eShaderSampledRead, layout };
+	}
+
+	static Usage storageRead(vk::PipelineStageFlags2 stages)
+	{
+		return { stages, vk::AccessFlagBits2::eShaderStorageRead, vk::ImageLayout::eGeneral };
+	}
+
+	static Usage storageWrite(vk::PipelineStageFlags2 stages)
+	{
+		return { stages, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite, vk::ImageLayout::eGeneral };
+	}
+
+	static Usage indirectRead()
+	{
+		return { vk::PipelineStageFlagBits2::eDrawIndirect, vk::AccessFlagBits2::eIndirectCommandRead };
+	}
+
+	static Usage hostRead()
+	{
+		return { vk::PipelineStageFlagBits2::eHost, vk::AccessFlagBits2::eHostRead };
+	}
+
+	static Usage present()
+	{
+		return { vk::PipelineStageFlagBits2::eBottomOfPipe, {}, vk::ImageLayout::ePresentSrcKHR };
+	}
+
+	// The barriers recorded in front of one pass: a global memory barrier (unused when its stages are empty)
+	// and the layout transitions.
+	struct Batch
+	{
+		vk::MemoryBarrier2 memory;
+		std::vector<vk::ImageMemoryBarrier2> images;
+
+		[[nodiscard]] bool empty() const
+		{
+			return !memory.srcStageMask && !memory.dstStageMask && images.empty();
+		}
+	};
+
+	// Drops the passes and resources of the previous frame; allocated transients stay.
+	void reset()
+	{
+		resources.clear();
+		passes.clear();
+		transientCount = 0;
+		compiled = false;
+	}
+
+	/**
+	* An image the graph does not own. initial is how the previous work leaves it: the stages and accesses
+	* to wait for and its layout, eUndefined to discard its contents. final, when given, is the usage the
+	* frame hands it on in, and makes the image an output of the frame.
+	*/
+	Resource importImage(const char* name, vk::Image image, const vk::ImageSubresourceRange& range, const Usage& initial, std::optional<Usage> final = std::nullopt)
+	{
+		ResourceInfo info{ .name = name, .image = image, .buffer = {}, .range = range, .initial = initial, .final = final };
+		return addResource(info);
+	}
+
+	// A buffer that carries a dependency between passes; it stands for every buffer the passes share this way.
+	Resource importBuffer(const char* name, vk::Buffer buffer, const Usage& initial, std::optional<Usage> final = std::nullopt)
+	{
+		ResourceInfo info{ .name = name, .image = {}, .buffer = buffer, .range = {}, .initial = initial, .final = final };
+		return addResource(info);
+	}
+
+	// An image that only lives within the frame; its contents are undefined at its first use.
+	Resource transientImage(const char* name, const ImageDesc& desc)
+	{
+		ResourceInfo info{ .name = name, .image = {}, .buffer = {}, .range = { desc.aspect, 0, 1, 0, 1 }, .initial = { {}, {}, vk::ImageLayout::eUndefined },
+			.final = std::nullopt, .desc = desc, .transient = transientCount++ };
+		return addResource(info);
+	}
+
+	uint32_t addPass(const char* name, Record record)
+	{
+		passes.push_back({ .name = name, .record = std::move(record), .accesses = {}, .sideEffects = false });
+		compiled = false;
+		return static_cast<uint32_t>(passes.size() - 1);
+	}
+
+	void read(uint32_t pass, Resource resource, const Usage& usage)
+	{
+		addAccess(pass, resource, usage, false);
+	}
+
+	// A write that also reads the previous contents (a depth test, a loaded attachment) keeps their writers.
+	void write(uint32_t pass, Resource resource, const Usage& usage)
+	{
+		addAccess(pass, resource, usage, true);
+	}
+
+	// Keeps a pass whose results leave the frame some other way than through an exported resource.
+	void keep(uint32_t pass)
+	{
+		passes[pass].sideEffects = true;
+	}
+
+	void compile()
+	{
+		if (compiled)
+			return;
+
+		cullPasses();
+		computeLifetimes();
+		transientsFit = transientCount == 0 || allocationFits();
+		computeBarriers();
+		compiled = true;
+	}
+
+	/**
+	* Creates the memory and images of the transients of the compiled graph, aliasing those whose
+	* lifetimes do not overlap. Any transients allocated before must no longer be in use.
+	*/
+	void allocate(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device)
+	{
+		compile();
+		releaseTransients();
+
+		std::vector<vk::raii::Image> images;
+		std::vector<vk::MemoryRequirements> requirements;
+		for (const ResourceInfo& info : resources)
+		{
+			if (info.transient < 0)
+				continue;
+
+			vk::ImageCreateInfo imageInfo
+			{
+				.imageType = vk::ImageType::e2D,
+				.format = info.desc.format,
+				.extent = { info.desc.extent.width, info.desc.extent.height, 1 },
+				.mipLevels = 1,
+				.arrayLayers = 1,
+				.samples = vk::SampleCountFlagBits::e1,
+				.tiling = vk::ImageTiling::eOptimal,
+				.usage = info.desc.usage,
+				.sharingMode = vk::SharingMode::eExclusive,
+				.initialLayout = vk::ImageLayout::eUndefined
+			};
+			images.emplace_back(device, imageInfo);
+			requirements.push_back(images.back().getMemoryRequirements());
+			allocated.push_back({ .desc = info.desc, .first = info.firstPass, .last = info.lastPass });
+		}
+
+		// Largest first, each into the first block it fits next to
+		std::vector<uint32_t> order(allocated.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return requirements[a].size > requirements[b].size; });
+
+		std::vector<Block> layout;
+		for (uint32_t index : order)
+		{
+			Allocated& transient = allocated[index];
+			auto fits = [&](const Block& block)
+				{
+					return (block.memoryTypeBits & requirements[index].memoryTypeBits) != 0 && std::none_of(block.members.begin(), block.members.end(),
+						[&](uint32_t member) { return overlaps(allocated[member], transient.first, transient.last); });
+				};
+			auto block = std::find_if(layout.begin(), layout.end(), fits);
+			if (block == layout.end())
+				block = layout.insert(layout.end(), Block{ .size = 0, .memoryTypeBits = requirements[index].memoryTypeBits, .members = {} });
+
+			block->size = std::max({ block->size, requirements[index].size, requirements[index].alignment });
+			block->memoryTypeBits &= requirements[index].memoryTypeBits;
+			block->members.push_back(index);
+			transient.block = static_cast<uint32_t>(block - layout.begin());
+		}
+
+		vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+		for (const Block& block : layout)
+		{
+			uint32_t memoryType = UINT32_MAX;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && memoryType == UINT32_MAX; i++)
+			{
+				if ((block.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+					memoryType = i;
+			}
+
+			if (memoryType == UINT32_MAX)
+				throw std::runtime_error("failed to find a memory type for render graph transients!");
+
+			blocks.emplace_back(device, vk::MemoryAllocateInfo{ .allocationSize = block.size, .memoryTypeIndex = memoryType });
+		}
+
+		for (size_t i = 0; i < allocated.size(); i++)
+		{
+			Allocated& transient = allocated[i];
+			transient.image = std::move(images[i]);
+			transient.image.bindMemory(*blocks[transient.block], 0);
+
+			// A view of a depth/stencil image sees the depth, which is what gets sampled
+			vk::ImageAspectFlags viewAspect = transient.desc.aspect;
+			if (viewAspect & vk::ImageAspectFlagBits::eDepth)
+				viewAspect = vk::ImageAspectFlagBits::eDepth;
+
+			vk::ImageViewCreateInfo viewInfo
+			{
+				.image = *transient.image,
+				.viewType = vk::ImageViewType::e2D,
+				.format = transient.desc.format,
+				.subresourceRange = { viewAspect, 0, 1, 0, 1 }
+			};
+			transient.view = vk::raii::ImageView(device, viewInfo);
+		}
+
+		transientsFit = true;
+		compiled = false;
+	}
+
+	// Whether the transients of this graph need an allocate() before it can execute.
+	[[nodiscard]] bool needsAllocation()
+	{
+		compile();
+		return !transientsFit;
+	}
+
+	// Frees the transients, e.g. before their extent changes. They must no longer be in use.
+	void releaseTransients()
+	{
+		allocated.clear();
+		blocks.clear();
+		compiled = false;
+	}
+
+	// Records the kept passes with their barriers, then the transitions to the final usages.
+	void execute(const vk::raii::CommandBuffer& commandBuffer)
+	{
+		compile();
+		if (!transientsFit)
+			throw std::runtime_error("render graph transients changed, call allocate() again!");
+
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			emit(commandBuffer, batches[i]);
+			passes[order[i]].record(commandBuffer);
+		}
+		emit(commandBuffer, batches.back());
+	}
+
+	// The image of an import, or of a transient once allocate() has run.
+	[[nodiscard]] vk::Image image(Resource resource) const
+	{
+		const ResourceInfo& info = resources[resource];
+		if (info.transient < 0)
+			return info.image;
+		return static_cast<size_t>(info.transient) < allocated.size() ? *allocated[info.transient].image : vk::Image();
+	}
+
+	// Transients only: imports come with their own views.
+	[[nodiscard]] vk::ImageView view(Resource resource) const
+	{
+		return *allocated[resources[resource].transient].view;
+	}
+
+	// Of the last execute(): pipelineBarrier2 calls recorded and passes culled.
+	[[nodiscard]] uint32_t barrierCount() const
+	{
+		uint32_t count = 0;
+		for (const Batch& batch : batches)
+			count += batch.empty() ? 0 : 1;
+		return count;
+	}
+
+	[[nodiscard]] uint32_t culledPasses() const
+	{
+		return static_cast<uint32_t>(passes.size() - order.size());
+	}
+
+	// After compile(), for tests and debugging: the batch recorded in front of a kept pass, and the one
+	// with the transitions to the final usages.
+	[[nodiscard]] const Batch& barriersBefore(uint32_t pass) const
+	{
+		auto position = std::find(order.begin(), order.end(), pass);
+		if (!compiled || position == order.end())
+			throw std::runtime_error("render graph pass is culled or the graph is not compiled!");
+
+		return batches[position - order.begin()];
+	}
+
+	[[nodiscard]] const Batch& finalBarriers() const
+	{
+		if (!compiled)
+			throw std::runtime_error("render graph is not compiled!");
+
+		return batches.back();
+	}
+
+	// Memory blocks backing the transients, fewer than transients when some alias.
+	[[nodiscard]] uint32_t transientBlocks() const
+	{
+		return static_cast<uint32_t>(blocks.size());
+	}
+
+private:
+	struct ResourceInfo
+	{
+		const char* name = "";
+		vk::Image image;
+		vk::Buffer buffer;
+		vk::ImageSubresourceRange range;
+		Usage initial;
+		std::optional<Usage> final;
+		ImageDesc desc{};
+		int32_t transient = -1;  // index among the transients of the graph
+		uint32_t firstPass = 0;  // position among the kept passes
+		uint32_t lastPass = 0;
+		bool used = false;
+	};
+
+	struct Access
+	{
+		Resource resource;
+		Usage usage;
+		bool write;
+	};
+
+	struct Pass
+	{
+		const char* name;
+		Record record;
+		std::vector<Access> accesses;
+		bool sideEffects = false;
+	};
+
+	// Where a resource stands while the barriers are computed: the last write (or layout transition) and
+	// the reads since, which are what the next use has to wait for.
+	struct State
+	{
+		vk::PipelineStageFlags2 writeStages;
+		vk::AccessFlags2 writeAccess;
+		vk::PipelineStageFlags2 readStages;
+		vk::AccessFlags2 readAccess;
+		vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+	};
+
+	struct Allocated
+	{
+		ImageDesc desc;
+		uint32_t first = 0;
+		uint32_t last = 0;
+		uint32_t block = 0;
+		vk::raii::Image image = nullptr;
+		vk::raii::ImageView view = nullptr;
+	};
+
+	struct Block
+	{
+		vk::DeviceSize size = 0;
+		uint32_t memoryTypeBits = 0;
+		std::vector<uint32_t> members;
+	};
+
+	static constexpr vk::AccessFlags2 WRITE_ACCESS = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eShaderStorageWrite |
+		vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eDepthStencilAttachmentWrite | vk::AccessFlagBits2::eTransferWrite |
+		vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+	static constexpr vk::AccessFlags2 READ_ACCESS = ~WRITE_ACCESS;
+
+	static bool overlaps(const Allocated& transient, uint32_t first, uint32_t last)
+	{
+		return transient.first <= last && first <= transient.last;
+	}
+
+	Resource addResource(const ResourceInfo& info)
+	{
+		resources.push_back(info);
+		compiled = false;
+		return static_cast<Resource>(resources.size() - 1);
+	}
+
+	// Barriers in one call are not ordered among themselves, so a pass touches a resource once.
+	void addAccess(uint32_t pass, Resource resource, const Usage& usage, bool write)
+	{
+		for (Access& access : passes[pass].accesses)
+		{
+			if (access.resource != resource)
+				continue;
+
+			if (access.usage.layout != usage.layout)
+				throw std::runtime_error("a render graph pass uses an image in two layouts!");
+
+			access.usage.stages |= usage.stages;
+			access.usage.access |= usage.access;
+			access.write = access.write || write;
+			return;
+		}
+
+		passes[pass].accesses.push_back({ resource, usage, write });
+		compiled = false;
+	}
+
+	void cullPasses()
+	{
+		std::vector<bool> needed(resources.size());
+		for (size_t i = 0; i < resources.size(); i++)
+			needed[i] = resources[i].final.has_value();
+
+		std::vector<bool> kept(passes.size());
+		for (size_t p = passes.size(); p-- > 0;)
+		{
+			const Pass& pass = passes[p];
+			kept[p] = pass.sideEffects || std::any_of(pass.accesses.begin(), pass.accesses.end(),
+				[&](const Access& access) { return access.write && needed[access.resource]; });
+			if (!kept[p])
+				continue;
+
+			// Writers before a plain overwrite are dead; anything this pass reads keeps its writers
+			for (const Access& access : pass.accesses)
+			{
+				if (access.write && !(access.usage.access & READ_ACCESS))
+					needed[access.resource] = false;
+			}
+			for (const Access& access : pass.accesses)
+			{
+				if (!access.write || (access.usage.access & READ_ACCESS))
+					needed[access.resource] = true;
+			}
+		}
+
+		order.clear();
+		for (uint32_t p = 0; p < passes.size(); p++)
+		{
+			if (kept[p])
+				order.push_back(p);
+		}
+	}
+
+	void computeLifetimes()
+	{
+		for (ResourceInfo& info : resources)
+			info.used = false;
+
+		for (uint32_t position = 0; position < order.size(); position++)
+		{
+			for (const Access& access : passes[order[position]].accesses)
+			{
+				ResourceInfo& info = resources[access.resource];
+				if (!info.used)
+					info.firstPass = position;
+				info.lastPass = position;
+				info.used = true;
+			}
+		}
+	}
+
+	// The transients must match what allocate() created, in order, and still fit next to their block mates.
+	[[nodiscard]] bool allocationFits() const
+	{
+		std::vector<const ResourceInfo*> transients;
+		for (const ResourceInfo& info : resources)
+		{
+			if (info.transient >= 0)
+				transients.push_back(&info);
+		}
+
+		if (transients.size() != allocated.size())
+			return false;
+
+		for (size_t i = 0; i < transients.size(); i++)
+		{
+			if (!(transients[i]->desc == allocated[i].desc))
+				return false;
+
+			for (size_t j = 0; j < i; j++)
+			{
+				if (allocated[j].block == allocated[i].block && transients[j]->used && transients[i]->used &&
+					transients[j]->firstPass <= transients[i]->lastPass && transients[i]->firstPass <= transients[j]->lastPass)
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// How the transients of a block are used this frame: what the first use of one has to wait for, as the
+	// same uses of the frame before may still be running on its memory.
+	[[nodiscard]] State blockState(int32_t transient) const
+	{
+		State state;
+		uint32_t block = static_cast<size_t>(transient) < allocated.size() ? allocated[transient].block : UINT32_MAX;
+		for (uint32_t p : order)
+		{
+			for (const Access& access : passes[p].accesses)
+			{
+				int32_t other = resources[access.resource].transient;
+				if (other != transient && (other < 0 || static_cast<size_t>(other) >= allocated.size() || allocated[other].block != block))
+					continue;
+
+				if (access.write)
+				{
+					state.writeStages |= access.usage.stages;
+					state.writeAccess |= access.usage.access & WRITE_ACCESS;
+				}
+				else
+					state.readStages |= access.usage.stages;
+			}
+		}
+		return state;
+	}
+
+	// Whether a transient is the first of its block this frame, so nothing in the frame precedes its first use.
+	[[nodiscard]] bool firstInBlock(const ResourceInfo& info) const
+	{
+		if (static_cast<size_t>(info.transient) >= allocated.size())
+			return true;
+
+		for (const ResourceInfo& other : resources)
+		{
+			if (other.transient >= 0 && other.transient != info.transient && other.used && static_cast<size_t>(other.transient) < allocated.size() &&
+				allocated[other.transient].block == allocated[info.transient].block && other.firstPass < info.firstPass)
+				return false;
+		}
+		return true;
+	}
+
+	void computeBarriers()
+	{
+		std::vector<State> states(resources.size());
+		std::vector<bool> touched(resources.size());
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			const ResourceInfo& info = resources[i];
+			State& state = states[i];
+			if (info.transient >= 0)
+			{
+				if (info.used)
+					state = blockState(info.transient);
+			}
+			else if (info.initial.access & WRITE_ACCESS)
+			{
+				state.writeStages = info.initial.stages;
+				state.writeAccess = info.initial.access & WRITE_ACCESS;
+			}
+			else
+			{
+				state.readStages = info.initial.stages;
+				state.readAccess = info.initial.access;
+			}
+			state.layout = info.initial.layout;
+		}
+
+		batches.assign(order.size() + 1, Batch{});
+		for (size_t position = 0; position < order.size(); position++)
+		{
+			for (const Access& access : passes[order[position]].accesses)
+			{
+				const ResourceInfo& info = resources[access.resource];
+				bool hoist = !touched[access.resource] && (info.transient < 0 || firstInBlock(info));
+				use(info, states[access.resource], access.usage, access.write, batches[hoist ? 0 : position]);
+				touched[access.resource] = true;
+			}
+		}
+
+		for (size_t i = 0; i < resources.size(); i++)
+		{
+			const ResourceInfo& info = resources[i];
+			if (info.final)
+				use(info, states[i], *info.final, (info.final->access & WRITE_ACCESS) != vk::AccessFlags2(), batches.back());
+		}
+	}
+
+	void use(const ResourceInfo& info, State& state, const Usage& usage, bool write, Batch& batch)
+	{
+		bool isImage = info.image || info.transient >= 0;
+		bool transition = isImage && usage.layout != state.layout;
+		bool readCovered = (state.readStages & usage.stages) == usage.stages && (state.readAccess & usage.access) == usage.access;
+
+		vk::PipelineStageFlags2 srcStages;
+		vk::AccessFlags2 srcAccess;
+		if (transition || write)
+		{
+			// After reads only an execution dependency is needed; writes must also be made visible
+			srcStages = state.writeStages | state.readStages;
+			srcAccess = state.writeAccess;
+		}
+		else if (state.writeStages && !readCovered)
+		{
+			srcStages = state.writeStages;
+			srcAccess = state.writeAccess;
+		}
+
+		if (transition)
+		{
+			batch.images.push_back(vk::ImageMemoryBarrier2
+				{
+					.srcStageMask = srcStages,
+					.srcAccessMask = srcAccess,
+					.dstStageMask = usage.stages,
+					.dstAccessMask = usage.access,
+					.oldLayout = state.layout,
+					.newLayout = usage.layout,
+					.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+					.image = image(static_cast<Resource>(&info - resources.data())),
+					.subresourceRange = info.range
+				});
+		}
+		else if (srcStages)
+		{
+			batch.memory.srcStageMask |= srcStages;
+			batch.memory.srcAccessMask |= srcAccess;
+			batch.memory.dstStageMask |= usage.stages;
+			batch.memory.dstAccessMask |= usage.access;
+		}
+
+		if (write)
+		{
+			state.writeStages = usage.stages;
+			state.writeAccess = usage.access & WRITE_ACCESS;
+			state.readStages = {};
+			state.readAccess = {};
+		}
+		else if (transition)
+		{
+			// Later uses order after the transition, which completes before these stages
+			state.writeStages = usage.stages;
+			state.writeAccess = {};
+			state.readStages = usage.stages;
+			state.readAccess = usage.access;
+		}
+		else
+		{
+			state.readStages |= usage.stages;
+			state.readAccess |= usage.access;
+		}
+		state.layout = usage.layout;
+	}
+
+	static void emit(const vk::raii::CommandBuffer& commandBuffer, const Batch& batch)
+	{
+		if (batch.empty())
+			return;
+
+		bool memory = batch.memory.srcStageMask || batch.memory.dstStageMask;
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo
+			{
+				.memoryBarrierCount = memory ? 1u : 0u,
+				.pMemoryBarriers = &batch.memory,
+				.imageMemoryBarrierCount = static_cast<uint32_t>(batch.images.size()),
+				.pImageMemoryBarriers = batch.images.data()
+			});
+	}
+
+	std::vector<ResourceInfo> resources;
+	std::vector<Pass> passes;
+	std::vector<uint32_t> order;   // kept passes, in submission order
+	std::vector<Batch> batches;    // one per kept pass, then the final transitions
+	int32_t transientCount = 0;
+	bool compiled = false;
+	bool transientsFit = true;
+
+	std::vector<Allocated> allocated;
+	std::vector<vk::raii::DeviceMemory> blocks;
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+// Persistently mapped staging ring for host -> device uploads.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Replaces a staging buffer (plus allocation, map and free) per upload with sub-allocations from one
+// host-visible buffer. Allocations made since the last submitFence() form a batch; the fence it returns
+// must be signalled by the submission that reads them. When the ring is full, allocate() waits for the
+// oldest batch's fence and reuses its space, so uploads larger than the ring are streamed through it in
+// chunks of at most maxAllocation() bytes; tryAllocate() reports a full ring instead, for callers that
+// must not block. Not thread-safe: one thread records all uploads.
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+class StagingRing
+{
+public:
+	struct Allocation
+	{
+		vk::Buffer buffer;
+		vk::DeviceSize offset = 0;
+		uint8_t* data = nullptr;
+		vk::DeviceSize size = 0;
+	};
+
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, vk::DeviceSize size)
+	{
+		this->device = &device;
+		capacity = size;
+		ringBuffer = vk::raii::Buffer(device, vk::BufferCreateInfo{ .size = capacity, .usage = vk::BufferUsageFlagBits::eTransferSrc, .sharingMode = vk::SharingMode::eExclusive });
+
+		vk::MemoryRequirements requirements = ringBuffer.getMemoryRequirements();
+		vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+		vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+		uint32_t memoryType = UINT32_MAX;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				memoryType = i;
+				break;
+			}
+		}
+
+		if (memoryType == UINT32_MAX)
+			throw std::runtime_error("failed to find a memory type for the staging ring!");
+
+		ringMemory = vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = memoryType });
+		ringBuffer.bindMemory(*ringMemory, 0);
+		mapped = static_cast<uint8_t*>(ringMemory.mapMemory(0, capacity));
+	}
+
+	// Largest single allocation; half the ring, so the next chunk can be filled while one is copied.
+	[[nodiscard]] vk::DeviceSize maxAllocation() const
+	{
+		return capacity / 2;
+	}
+
+	// Write-only memory: it is usually uncached, so read back nothing from Allocation::data.
+	Allocation allocate(vk::DeviceSize size, vk::DeviceSize alignment = 16)
+	{
+		while (true)
+		{
+			if (std::optional<Allocation> allocation = tryAllocate(size, alignment))
+				return *allocation;
+
+			if (batches.empty())
+				throw std::runtime_error("staging ring is too small for the open batch, submit it before allocating more!");
+
+			retireOldest();
+		}
+	}
+
+	// Like allocate(), but returns nothing instead of waiting for a batch when the ring is full.
+	std::optional<Allocation> tryAllocate(vk::DeviceSize size, vk::DeviceSize alignment = 16)
+	{
+		if (size > maxAllocation())
+			throw std::runtime_error("staging allocation larger than the staging ring!");
+
+		if (batches.empty() && !batchOpen)
+			head = tail = 0;
+
+		vk::DeviceSize offset = alignUp(head, alignment);
+		bool empty = batches.empty() && !batchOpen;
+		if (head > tail || empty)
+		{
+			// Free space is [head, capacity) followed by [0, tail)
+			if (offset + size <= capacity)
+				return take(offset, size);
+			if (!empty && size <= tail)
+				return take(0, size);
+		}
+		else if (offset + size <= tail)
+		{
+			return take(offset, size);
+		}
+
+		return std::nullopt;
+	}
+
+	// Closes the current batch. The returned fence must be passed to the submission that reads it.
+	vk::Fence submitFence()
+	{
+		vk::raii::Fence fence = freeFences.empty() ? vk::raii::Fence(*device, vk::FenceCreateInfo{}) : std::move(freeFences.back());
+		if (!freeFences.empty())
+			freeFences.pop_back();
+
+		vk::Fence handle = *fence;
+		batches.push_back({ head, std::move(fence) });
+		batchOpen = false;
+		submitted++;
+		return handle;
+	}
+
+	// Releases the space of every batch whose copies have finished, without blocking.
+	void reclaim()
+	{
+		while (!batches.empty() && batches.front().fence.getStatus() == vk::Result::eSuccess)
+			retireOldest();
+	}
+
+	// Blocks until every submitted batch has completed.
+	void waitIdle()
+	{
+		while (!batches.empty())
+			retireOldest();
+	}
+
+	// Batches are numbered from 1 in submission order and complete in that order, so batch n is done
+	// once completedBatches() >= n.
+	[[nodiscard]] uint64_t submittedBatches() const
+	{
+		return submitted;
+	}
+
+	[[nodiscard]] uint64_t completedBatches() const
+	{
+		return submitted - batches.size();
+	}
+
+	[[nodiscard]] vk::Buffer buffer() const
+	{
+		return *ringBuffer;
+	}
+
+	[[nodiscard]] vk::DeviceSize size() const
+	{
+		return capacity;
+	}
+
+private:
+	struct Batch
+	{
+		vk::DeviceSize end;
+		vk::raii::Fence fence;
+	};
+
+	static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	Allocation take(vk::DeviceSize offset, vk::DeviceSize size)
+	{
+		head = offset + size;
+		batchOpen = true;
+		return { *ringBuffer, offset, mapped + offset, size };
+	}
+
+	void retireOldest()
+	{
+		Batch& batch = batches.front();
+		while (device->waitForFences(*batch.fence, vk::True, std::numeric_limits<uint64_t>::max()) == vk::Result::eTimeout)
+			;
+
+		device->resetFences(*batch.fence);
+		tail = batch.end;
+		freeFences.push_back(std::move(batch.fence));
+		batches.pop_front();
+	}
+
+	const vk::raii::Device* device = nullptr;
+	vk::raii::Buffer ringBuffer = nullptr;
+	vk::raii::DeviceMemory ringMemory = nullptr;
+	uint8_t* mapped = nullptr;
+	vk::DeviceSize capacity = 0;
+	vk::DeviceSize head = 0; // next free byte
+	vk::DeviceSize tail = 0; // oldest byte still read by an in-flight batch
+	bool batchOpen = false;
+	uint64_t submitted = 0;
+	std::deque<Batch> batches;
+	std::vector<vk::raii::Fence> freeFences;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+// Small thread pool plus a dependency-ordered task graph on top of it.
+//
+// Tasks are added with the ids of the tasks they depend on and start as soon as all of those have
+// finished. run() blocks until every task is done and rethrows the first exception a task threw;
+// once a task has failed the remaining ones are skipped. Every task is traced as a CPU zone.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/cpuTracer.h"
+
+class ThreadPool
+{
+public:
+	explicit ThreadPool(uint32_t threadCount = defaultThreadCount())
+	{
+		for (uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+			threads.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		workAvailable.notify_all();
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Leaves one core for the thread that submits work.
+	static uint32_t defaultThreadCount()
+	{
+		return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	}
+
+	[[nodiscard]] uint32_t threadCount() const
+	{
+		return static_cast<uint32_t>(threads.size());
+	}
+
+	void submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard lock(mutex);
+			jobs.push_back(std::move(job));
+		}
+		workAvailable.notify_one();
+	}
+
+private:
+	void workerLoop(uint32_t index)
+	{
+		CpuTracer::instance().setThreadName("pool " + std::to_string(index));
+
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock lock(mutex);
+				workAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+				if (jobs.empty())
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::deque<std::function<void()>> jobs;
+	bool stopping = false;
+};
+
+class TaskGraph
+{
+public:
+	using TaskId = uint32_t;
+	using Clock = std::chrono::steady_clock;
+
+	struct TaskTiming
+	{
+		const char* name;
+		Clock::time_point begin;
+		Clock::time_point end;
+	};
+
+	// name must outlive the graph (string literals in practice). Dependencies must already be added.
+	TaskId add(const char* name, std::function<void()> work, std::initializer_list<TaskId> dependencies = {})
+	{
+		TaskId id = static_cast<TaskId>(tasks.size());
+		for (TaskId dependency : dependencies)
+		{
+			if (dependency >= id)
+				throw std::invalid_argument(std::string("task ") + name + " depends on a task added after it");
+
+			tasks[dependency].dependents.push_back(id);
+		}
+
+		tasks.push_back({ name, std::move(work), {}, static_cast<uint32_t>(dependencies.size()) });
+		return id;
+	}
+
+	void run(ThreadPool& pool)
+	{
+		timings.assign(tasks.size(), {});
+		if (tasks.empty())
+			return;
+
+		std::vector<uint32_t> remaining(tasks.size());
+		for (size_t i = 0; i < tasks.size(); i++)
+			remaining[i] = tasks[i].dependencyCount;
+
+		size_t finished = 0;
+		std::exception_ptr failure;
+		std::mutex mutex;
+		std::condition_variable allFinished;
+
+		std::function<void(TaskId)> start = [&](TaskId id)
+			{
+				pool.submit([&, id]()
+					{
+						Task& task = tasks[id];
+						bool skip;
+						{
+							std::lock_guard lock(mutex);
+							skip = failure != nullptr;
+						}
+
+						timings[id] = { task.name, Clock::now(), {} };
+						if (!skip)
+						{
+							try
+							{
+								CpuTraceZone zone(task.name);
+								task.work();
+							}
+							catch (...)
+							{
+								std::lock_guard lock(mutex);
+								if (failure == nullptr)
+									failure = std::current_exception();
+							}
+						}
+						timings[id].end = Clock::now();
+
+						std::lock_guard lock(mutex);
+						for (TaskId dependent : task.dependents)
+							if (--remaining[dependent] == 0)
+								start(dependent);
+
+						if (++finished == tasks.size())
+							allFinished.notify_one();
+					});
+			};
+
+		{
+			std::unique_lock lock(mutex);
+			for (TaskId id = 0; id < tasks.size(); id++)
+				if (remaining[id] == 0)
+					start(id);
+
+			allFinished.wait(lock, [&]() { return finished == tasks.size(); });
+		}
+
+		if (failure != nullptr)
+			std::rethrow_exception(failure);
+	}
+
+	// Start and end time of every task of the last run(), in the order they were added.
+	[[nodiscard]] const std::vector<TaskTiming>& taskTimings() const
+	{
+		return timings;
+	}
+
+private:
+	struct Task
+	{
+		const char* name;
+		std::function<void()> work;
+		std::vector<TaskId> dependents;
+		uint32_t dependencyCount;
+	};
+
+	std::vector<Task> tasks;
+	std::vector<TaskTiming> timings;
+};
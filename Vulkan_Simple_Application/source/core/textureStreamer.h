@@ -0,0 +1,377 @@
+#pragma once
+
+// Progressive mip streaming for 2D textures under a device memory budget.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// The full mip chain of every streamed texture stays in system memory; the GPU only holds the levels
+// a texture is actually seen at. A texture starts out with its mip tail, the levels of at most
+// TAIL_SIZE texels on a side, which is cheap enough to upload before the first frame. After that the
+// app reports every frame the finest level each visible texture is sampled at (see request()), and
+// update() moves each texture's allocation towards that level. Levels are uploaded coarse to fine
+// through the UploadManager, and the image view's baseMipLevel is clamped to the finest level that has
+// landed, so a texture sharpens over a few frames without sampling undefined levels.
+//
+// Growing or shrinking a texture means a new image holding exactly the wanted levels: it is filled
+// from system memory while the old one stays in use, and replaces it once it is at least as sharp.
+// When the wanted levels exceed the budget, the top mips of the least recently requested textures are
+// dropped first; their views are clamped at once and the memory is returned once the smaller image is
+// in place. Replaced images and views are destroyed after every frame that may still use them is done.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "core/uploadManager.h"
+
+class TextureStreamer
+{
+public:
+	using TextureId = uint32_t;
+
+	static constexpr uint32_t TAIL_SIZE = 128;
+
+	struct Level
+	{
+		size_t offset = 0;
+		size_t size = 0;
+	};
+
+	// A texture in system memory: layer 0 of every mip level, finest first.
+	struct Source
+	{
+		vk::Format format = vk::Format::eUndefined;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t rowHeight = 1; // texel block height, see UploadManager::ImageRegion
+		std::vector<uint8_t> data;
+		std::vector<Level> levels;
+	};
+
+	struct Statistics
+	{
+		uint64_t residentBytes = 0;     // device memory of every image still alive
+		uint64_t peakResidentBytes = 0;
+		uint64_t uploadedBytes = 0;
+		uint32_t evictedLevels = 0;     // top mips released, for the budget or a smaller footprint on screen
+		uint32_t allocations = 0;
+	};
+
+	/**
+	* budget is in bytes of mip data, 0 for no limit. framesInFlight is how many frames the app records
+	* ahead; views and images are kept alive for twice that after they are replaced, so every per-frame
+	* descriptor set can switch to the new view first.
+	*/
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, UploadManager& uploads, vk::DeviceSize budget, uint32_t framesInFlight)
+	{
+		this->device = &device;
+		this->uploads = &uploads;
+		budgetBytes = budget;
+		retireFrames = 2 * framesInFlight;
+		memoryProperties = physicalDevice.getMemoryProperties();
+	}
+
+	// Queues the mip tail; it is usable once the uploads have completed and update() has run.
+	TextureId add(Source source)
+	{
+		if (source.levels.empty())
+			throw std::runtime_error("streamed texture has no mip levels!");
+
+		auto texture = std::make_unique<Texture>();
+		uint32_t levelCount = static_cast<uint32_t>(source.levels.size());
+		texture->source = std::move(source);
+		texture->tailFirst = levelCount - 1;
+		while (texture->tailFirst > 0 && std::max(levelWidth(*texture, texture->tailFirst - 1), levelHeight(*texture, texture->tailFirst - 1)) <= TAIL_SIZE)
+			texture->tailFirst--;
+
+		texture->wanted = texture->tailFirst;
+		texture->viewFirst = levelCount;
+		texture->current = allocate(*texture, texture->tailFirst);
+
+		textures.push_back(std::move(texture));
+		return static_cast<TextureId>(textures.size() - 1);
+	}
+
+	/**
+	* Asks for level (0 = full resolution, may be fractional) of a texture this frame. Call it for every
+	* visible use; the finest request of the frame counts.
+	*/
+	void request(TextureId id, float level)
+	{
+		Texture& texture = *textures[id];
+		texture.requested = std::min(texture.requested, std::max(level, 0.0f));
+		texture.lastUsed = frame;
+	}
+
+	// Once per frame, after the requests. Handles replaced this frame stay valid until retired.
+	void update()
+	{
+		chooseLevels();
+
+		for (auto& texture : textures)
+		{
+			if (texture->pending && texture->pending->loaded <= texture->viewFirst)
+			{
+				retire(std::move(texture->current), nullptr);
+				texture->current = std::move(texture->pending);
+				texture->viewFirst = levelCount(*texture); // the view still points at the old image
+			}
+
+			if (!texture->pending && texture->wanted != texture->current->first)
+			{
+				if (texture->wanted > texture->current->first)
+					stats.evictedLevels += texture->wanted - texture->current->first;
+				texture->pending = allocate(*texture, texture->wanted);
+			}
+
+			// Never finer than wanted (an eviction clamps at once) nor than what has landed
+			uint32_t viewFirst = std::max(texture->current->loaded, texture->wanted);
+			if (viewFirst != texture->viewFirst && viewFirst < levelCount(*texture))
+				createView(*texture, viewFirst);
+
+			texture->requested = std::numeric_limits<float>::max();
+		}
+
+		frame++;
+		while (!retired.empty() && retired.front().frame + retireFrames <= frame && (!retired.front().allocation || retired.front().allocation->outstanding == 0))
+		{
+			if (retired.front().allocation)
+				stats.residentBytes -= retired.front().allocation->bytes;
+			retired.pop_front();
+		}
+	}
+
+	// Null until the mip tail has landed.
+	[[nodiscard]] vk::ImageView view(TextureId id) const
+	{
+		const Texture& texture = *textures[id];
+		return texture.view == nullptr ? vk::ImageView{} : *texture.view;
+	}
+
+	// Changes whenever view() does; descriptors holding the old view must be rewritten before reuse.
+	[[nodiscard]] uint64_t viewVersion(TextureId id) const
+	{
+		return textures[id]->viewVersion;
+	}
+
+	// The finest level sampled right now.
+	[[nodiscard]] uint32_t residentLevel(TextureId id) const
+	{
+		return textures[id]->viewFirst;
+	}
+
+	[[nodiscard]] vk::Extent2D extent(TextureId id) const
+	{
+		const Texture& texture = *textures[id];
+		return { texture.source.width, texture.source.height };
+	}
+
+	// True once the view samples every level the last update() wanted and nothing is being streamed.
+	[[nodiscard]] bool settled(TextureId id) const
+	{
+		const Texture& texture = *textures[id];
+		return !texture.pending && texture.viewFirst == texture.wanted;
+	}
+
+	[[nodiscard]] const Statistics& statistics() const
+	{
+		return stats;
+	}
+
+private:
+	struct Allocation
+	{
+		vk::raii::Image image = nullptr;
+		vk::raii::DeviceMemory memory = nullptr;
+		vk::DeviceSize bytes = 0;
+		uint32_t first = 0;       // mip chain index of the image's level 0
+		uint32_t loaded = 0;      // finest level whose upload has completed
+		uint32_t outstanding = 0; // uploads not completed yet
+	};
+
+	struct Texture
+	{
+		Source source;
+		std::unique_ptr<Allocation> current;
+		std::unique_ptr<Allocation> pending;
+		vk::raii::ImageView view = nullptr;
+		uint32_t viewFirst = 0;
+		uint64_t viewVersion = 0;
+		uint32_t tailFirst = 0;
+		uint32_t wanted = 0;
+		float requested = std::numeric_limits<float>::max();
+		uint64_t lastUsed = 0;
+	};
+
+	struct Retired
+	{
+		std::unique_ptr<Allocation> allocation;
+		vk::raii::ImageView view = nullptr;
+		uint64_t frame = 0;
+	};
+
+	static uint32_t levelCount(const Texture& texture)
+	{
+		return static_cast<uint32_t>(texture.source.levels.size());
+	}
+
+	static uint32_t levelWidth(const Texture& texture, uint32_t level)
+	{
+		return std::max(texture.source.width >> level, 1u);
+	}
+
+	static uint32_t levelHeight(const Texture& texture, uint32_t level)
+	{
+		return std::max(texture.source.height >> level, 1u);
+	}
+
+	static vk::DeviceSize chainBytes(const Texture& texture, uint32_t first)
+	{
+		vk::DeviceSize bytes = 0;
+		for (uint32_t level = first; level < levelCount(texture); level++)
+			bytes += texture.source.levels[level].size;
+		return bytes;
+	}
+
+	// Screen-space requests with one level of hysteresis, then LRU eviction down to the budget.
+	void chooseLevels()
+	{
+		vk::DeviceSize total = 0;
+		for (auto& texture : textures)
+		{
+			uint32_t first = texture->current->first;
+			if (texture->requested != std::numeric_limits<float>::max())
+			{
+				auto level = static_cast<uint32_t>(std::min(std::floor(texture->requested), static_cast<float>(texture->tailFirst)));
+				if (level < first || level > first + 1)
+					first = level;
+			}
+
+			texture->wanted = first;
+			total += chainBytes(*texture, first);
+		}
+
+		if (budgetBytes == 0)
+			return;
+
+		while (total > budgetBytes)
+		{
+			Texture* victim = nullptr;
+			for (auto& texture : textures)
+				if (texture->wanted < texture->tailFirst && (victim == nullptr || texture->lastUsed < victim->lastUsed || (texture->lastUsed == victim->lastUsed && texture->wanted < victim->wanted)))
+					victim = texture.get();
+
+			if (victim == nullptr)
+				break;
+
+			total -= victim->source.levels[victim->wanted].size;
+			victim->wanted++;
+		}
+	}
+
+	// A new image for levels [first, levelCount), with every level queued coarse to fine.
+	std::unique_ptr<Allocation> allocate(Texture& texture, uint32_t first)
+	{
+		auto allocation = std::make_unique<Allocation>();
+		allocation->first = first;
+		allocation->loaded = levelCount(texture);
+
+		vk::ImageCreateInfo imageInfo
+		{
+			.imageType = vk::ImageType::e2D,
+			.format = texture.source.format,
+			.extent = { levelWidth(texture, first), levelHeight(texture, first), 1 },
+			.mipLevels = levelCount(texture) - first,
+			.arrayLayers = 1,
+			.samples = vk::SampleCountFlagBits::e1,
+			.tiling = vk::ImageTiling::eOptimal,
+			.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined
+		};
+		allocation->image = vk::raii::Image(*device, imageInfo);
+
+		vk::MemoryRequirements requirements = allocation->image.getMemoryRequirements();
+		uint32_t memoryType = UINT32_MAX;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eDeviceLocal))
+			{
+				memoryType = i;
+				break;
+			}
+		}
+
+		if (memoryType == UINT32_MAX)
+			throw std::runtime_error("failed to find a memory type for a streamed texture!");
+
+		allocation->memory = vk::raii::DeviceMemory(*device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = memoryType });
+		allocation->image.bindMemory(*allocation->memory, 0);
+		allocation->bytes = requirements.size;
+
+		stats.residentBytes += allocation->bytes;
+		stats.peakResidentBytes = std::max(stats.peakResidentBytes, stats.residentBytes);
+		stats.allocations++;
+
+		Allocation* target = allocation.get();
+		for (uint32_t level = levelCount(texture); level-- > first;)
+		{
+			const Level& slice = texture.source.levels[level];
+			UploadManager::ImageRegion region
+			{
+				.image = *allocation->image,
+				.mipLevel = level - first,
+				.extent = { levelWidth(texture, level), levelHeight(texture, level) },
+				.rowHeight = texture.source.rowHeight
+			};
+
+			target->outstanding++;
+			uploads->upload({ texture.source.data.data() + slice.offset, slice.size }, region, [target, level]()
+				{
+					target->loaded = std::min(target->loaded, level);
+					target->outstanding--;
+				});
+			stats.uploadedBytes += slice.size;
+		}
+
+		return allocation;
+	}
+
+	void createView(Texture& texture, uint32_t first)
+	{
+		const Allocation& allocation = *texture.current;
+		vk::ImageViewCreateInfo viewInfo
+		{
+			.image = *allocation.image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = texture.source.format,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, first - allocation.first, levelCount(texture) - first, 0, 1 }
+		};
+
+		retire(nullptr, std::move(texture.view));
+		texture.view = vk::raii::ImageView(*device, viewInfo);
+		texture.viewFirst = first;
+		texture.viewVersion++;
+	}
+
+	void retire(std::unique_ptr<Allocation> allocation, vk::raii::ImageView view)
+	{
+		if (allocation || view != nullptr)
+			retired.push_back({ std::move(allocation), std::move(view), frame });
+	}
+
+	const vk::raii::Device* device = nullptr;
+	UploadManager* uploads = nullptr;
+	vk::PhysicalDeviceMemoryProperties memoryProperties;
+	vk::DeviceSize budgetBytes = 0;
+	uint32_t retireFrames = 0;
+	uint64_t frame = 0;
+
+	std::vector<std::unique_ptr<Texture>> textures;
+	std::deque<Retired> retired;
+	Statistics stats;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+// Per-frame linear allocator for uniform data, bound with dynamic offsets.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// One persistently mapped, host-visible uniform buffer holds a region per frame in flight. A frame
+// resets its region with beginFrame() and appends what its draws read with push(), each value at
+// minUniformBufferOffsetAlignment; the returned offset goes into the dynamic offsets of a
+// eUniformBufferDynamic descriptor whose base is offset 0 of buffer(). So a scene needs one buffer and
+// one descriptor per kind of data however many objects it draws, and data shared by every draw (the
+// camera) is written once per frame instead of once per object.
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+class UniformArena
+{
+public:
+	// Each frame can push up to valuesPerFrame values of at most largestValue bytes.
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, uint32_t framesInFlight, vk::DeviceSize largestValue, uint32_t valuesPerFrame)
+	{
+		offsetAlignment = physicalDevice.getProperties().limits.minUniformBufferOffsetAlignment;
+		regionSize = alignUp(largestValue, offsetAlignment) * valuesPerFrame;
+		vk::DeviceSize size = regionSize * framesInFlight;
+		arenaBuffer = vk::raii::Buffer(device, vk::BufferCreateInfo{ .size = size, .usage = vk::BufferUsageFlagBits::eUniformBuffer, .sharingMode = vk::SharingMode::eExclusive });
+
+		vk::MemoryRequirements requirements = arenaBuffer.getMemoryRequirements();
+		vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+		vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
+
+		uint32_t memoryType = UINT32_MAX;
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+		{
+			if ((requirements.memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+			{
+				memoryType = i;
+				break;
+			}
+		}
+
+		if (memoryType == UINT32_MAX)
+			throw std::runtime_error("failed to find a memory type for the uniform arena!");
+
+		arenaMemory = vk::raii::DeviceMemory(device, vk::MemoryAllocateInfo{ .allocationSize = requirements.size, .memoryTypeIndex = memoryType });
+		arenaBuffer.bindMemory(*arenaMemory, 0);
+		mapped = static_cast<uint8_t*>(arenaMemory.mapMemory(0, size));
+		regionBegin = 0;
+		cursor = 0;
+	}
+
+	// Starts writing the region of frameIndex; the GPU must be done with what it held (the frame's fence).
+	void beginFrame(uint32_t frameIndex)
+	{
+		regionBegin = regionSize * frameIndex;
+		cursor = 0;
+	}
+
+	// Copies value into the current region and returns its dynamic offset.
+	template <typename T>
+	uint32_t push(const T& value)
+	{
+		if (cursor + sizeof(T) > regionSize)
+			throw std::runtime_error("uniform arena is full, raise valuesPerFrame!");
+
+		vk::DeviceSize offset = regionBegin + cursor;
+		std::memcpy(mapped + offset, &value, sizeof(T));
+		cursor = alignUp(cursor + sizeof(T), offsetAlignment);
+		return static_cast<uint32_t>(offset);
+	}
+
+	[[nodiscard]] vk::Buffer buffer() const
+	{
+		return *arenaBuffer;
+	}
+
+	[[nodiscard]] vk::DeviceSize alignment() const
+	{
+		return offsetAlignment;
+	}
+
+	// Bytes written to the current region so far.
+	[[nodiscard]] vk::DeviceSize used() const
+	{
+		return cursor;
+	}
+
+private:
+	static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	vk::raii::Buffer arenaBuffer = nullptr;
+	vk::raii::DeviceMemory arenaMemory = nullptr;
+	uint8_t* mapped = nullptr;
+	vk::DeviceSize offsetAlignment = 256;
+	vk::DeviceSize regionSize = 0;
+	vk::DeviceSize regionBegin = 0;
+	vk::DeviceSize cursor = 0;
+};
@@ -0,0 +1,458 @@
+#pragma once
+
+// Streams data into device-local buffers and images: disk reads, decompression and GPU copies as one pipeline.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Every upload is cut into chunks that pass through a StagingRing. Raw file ranges, such as an
+// uncompressed asset pack blob, are read by AsyncIO straight into the mapped staging memory, so their
+// bytes never touch the heap. Compressed pack blobs are read into a heap buffer, decompressed on a
+// worker thread and then staged like memory sources, which are copied into their chunk directly.
+// Image uploads fill one mip level and are cut at rows of texel blocks, so any chunk maps to a band of
+// the level; the level is moved to eTransferDstOptimal before its first band and to
+// eShaderReadOnlyOptimal after its last.
+//
+// pump() advances everything without blocking and is meant to run once per frame. It issues reads
+// while the ring has space; once every chunk of the current wave has landed, their copies go out in
+// one command buffer that signals the ring's fence, and the next wave fills the other half of the ring
+// while that one is copied. Completion callbacks run inside pump() after the copies have finished on
+// the GPU. flush() blocks until every upload is done. Not thread-safe: one thread calls everything.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/assetPack.h"
+#include "core/asyncIO.h"
+#include "core/stagingRing.h"
+#include "core/taskGraph.h"
+
+class UploadManager
+{
+public:
+	using Callback = std::function<void()>;
+
+	struct Statistics
+	{
+		uint64_t bytesRead = 0;      // read from disk, compressed size for compressed blobs
+		uint64_t bytesUploaded = 0;  // copied to the GPU
+		uint32_t submissions = 0;
+	};
+
+	// One mip level of layer 0 of a 2D image. rowHeight is the height of a texel block (4 for BC7, ASTC
+	// 4x4 and ETC2, 1 for uncompressed formats); the data holds tightly packed rows of blocks.
+	struct ImageRegion
+	{
+		vk::Image image;
+		uint32_t mipLevel = 0;
+		vk::Extent2D extent;
+		uint32_t rowHeight = 1;
+	};
+
+	/**
+	* queue must belong to queueFamily and is only used from the thread that calls pump().
+	* preferIoUring = false reads through the thread pool fallback even where io_uring is available.
+	*/
+	void init(const vk::raii::PhysicalDevice& physicalDevice, const vk::raii::Device& device, const vk::raii::Queue& queue, uint32_t queueFamily,
+		vk::DeviceSize stagingSize, bool preferIoUring = true, uint32_t decompressThreads = 2)
+	{
+		this->device = &device;
+		this->queue = &queue;
+		ring.init(physicalDevice, device, stagingSize);
+		io.init(IO_QUEUE_DEPTH, preferIoUring);
+
+		// Several chunks per wave keep that many reads in flight at once
+		chunkSize = std::max<vk::DeviceSize>(ring.maxAllocation() / 4, 1);
+		commandPool = vk::raii::CommandPool(device, vk::CommandPoolCreateInfo{ .flags = vk::CommandPoolCreateFlagBits::eTransient, .queueFamilyIndex = queueFamily });
+		workers = std::make_unique<ThreadPool>(decompressThreads);
+	}
+
+	// Copies bytes into destination; they must stay alive until onComplete has run.
+	void upload(std::span<const uint8_t> bytes, vk::Buffer destination, vk::DeviceSize destinationOffset = 0, Callback onComplete = {})
+	{
+		Upload& upload = enqueue(bytes.size(), destination, destinationOffset, std::move(onComplete));
+		upload.memory = bytes;
+	}
+
+	// Reads size bytes at offset of file straight into staging memory; file must stay open until onComplete.
+	void upload(const AsyncFile& file, uint64_t offset, uint64_t size, vk::Buffer destination, vk::DeviceSize destinationOffset = 0, Callback onComplete = {})
+	{
+		Upload& upload = enqueue(size, destination, destinationOffset, std::move(onComplete));
+		upload.file = &file;
+		upload.fileOffset = offset;
+	}
+
+	// Replaces the contents of a mip level; bytes must stay alive until onComplete has run.
+	void upload(std::span<const uint8_t> bytes, const ImageRegion& region, Callback onComplete = {})
+	{
+		uint32_t rowCount = (region.extent.height + region.rowHeight - 1) / region.rowHeight;
+		if (rowCount == 0 || bytes.size() % rowCount != 0)
+			throw std::runtime_error("image upload size is not a whole number of block rows!");
+
+		Upload& upload = enqueue(bytes.size(), nullptr, 0, std::move(onComplete));
+		upload.memory = bytes;
+		upload.image = region;
+		upload.rowPitch = bytes.size() / rowCount;
+	}
+
+	// Uploads a pack entry from packFile, the pack opened for async reads; compressed entries are inflated first.
+	void upload(const AsyncFile& packFile, const AssetPackEntry& entry, vk::Buffer destination, vk::DeviceSize destinationOffset = 0, Callback onComplete = {})
+	{
+		Upload& upload = enqueue(entry.size, destination, destinationOffset, std::move(onComplete));
+		upload.file = &packFile;
+		upload.fileOffset = entry.offset;
+		if (entry.compression == AssetCompression::Lz4)
+		{
+			upload.stage = Stage::Compressed;
+			upload.storedSize = entry.storedSize;
+		}
+	}
+
+	void pump()
+	{
+		completions.clear();
+		io.poll(completions);
+		handleReads();
+
+		ring.reclaim();
+		while (!submissions.empty() && ring.completedBatches() >= submissions.front().batch)
+		{
+			for (auto upload : submissions.front().finished)
+			{
+				if (upload->onComplete)
+					upload->onComplete();
+				uploads.erase(upload);
+			}
+			submissions.pop_front();
+		}
+
+		fillWave();
+		if (!wave.empty() && std::ranges::all_of(wave, &Chunk::ready))
+			submitWave();
+	}
+
+	void flush()
+	{
+		pump();
+		while (!idle())
+		{
+			if (io.outstanding() > 0)
+			{
+				completions.clear();
+				io.wait(completions);
+				handleReads();
+			}
+			else if (!submissions.empty())
+			{
+				ring.waitIdle();
+			}
+			else
+			{
+				// Only decompression on the workers is left
+				std::this_thread::yield();
+			}
+			pump();
+		}
+	}
+
+	[[nodiscard]] bool idle() const
+	{
+		return uploads.empty();
+	}
+
+	[[nodiscard]] const char* ioBackendName() const
+	{
+		return io.backendName();
+	}
+
+	[[nodiscard]] const Statistics& statistics() const
+	{
+		return stats;
+	}
+
+private:
+	static constexpr uint32_t IO_QUEUE_DEPTH = 32;
+	static constexpr uint64_t CHUNK_READ = 1ull << 63; // userData tag: the low bits index the wave
+
+	enum class Stage
+	{
+		Compressed, // the stored blob still has to be read
+		Reading,
+		Inflating,
+		Streaming   // chunks are staged from memory or the file
+	};
+
+	struct Upload
+	{
+		Stage stage = Stage::Streaming;
+		uint64_t size = 0;
+		vk::Buffer destination;
+		vk::DeviceSize destinationOffset = 0;
+		std::optional<ImageRegion> image; // instead of destination
+		uint64_t rowPitch = 0;
+		Callback onComplete;
+
+		std::span<const uint8_t> memory; // source bytes, or the inflated blob
+		const AsyncFile* file = nullptr;
+		uint64_t fileOffset = 0;
+		uint64_t staged = 0;             // bytes handed to chunks so far
+		bool emptyQueued = false;
+
+		uint64_t storedSize = 0;
+		std::vector<uint8_t> stored;
+		std::vector<uint8_t> inflated;
+		std::atomic<bool> inflateDone = false;
+		bool inflateFailed = false;      // written by the worker before inflateDone
+	};
+
+	using UploadIt = std::list<Upload>::iterator;
+
+	struct Chunk
+	{
+		UploadIt upload;
+		StagingRing::Allocation staging;
+		vk::DeviceSize destinationOffset = 0;
+		bool ready = false;
+		bool first = false;
+		bool last = false;
+	};
+
+	struct Submission
+	{
+		uint64_t batch = 0;
+		vk::raii::CommandBuffer commandBuffer;
+		std::vector<UploadIt> finished; // uploads whose last chunk this submission copies
+	};
+
+	Upload& enqueue(uint64_t size, vk::Buffer destination, vk::DeviceSize destinationOffset, Callback onComplete)
+	{
+		if (device == nullptr)
+			throw std::runtime_error("upload manager used before init!");
+
+		Upload& upload = uploads.emplace_back();
+		upload.size = size;
+		upload.destination = destination;
+		upload.destinationOffset = destinationOffset;
+		upload.onComplete = std::move(onComplete);
+		return upload;
+	}
+
+	void handleReads()
+	{
+		for (const IoCompletion& completion : completions)
+		{
+			if (!completion.succeeded)
+				throw std::runtime_error("failed to read an asset range for upload!");
+
+			if (completion.userData & CHUNK_READ)
+			{
+				wave[completion.userData & ~CHUNK_READ].ready = true;
+				continue;
+			}
+
+			// A compressed blob has landed on the heap; inflate it off this thread
+			auto* upload = reinterpret_cast<Upload*>(completion.userData);
+			upload->stage = Stage::Inflating;
+			workers->submit([upload]()
+				{
+					try
+					{
+						upload->inflated.resize(static_cast<size_t>(upload->size));
+						lz4_block::decompress(upload->stored.data(), upload->stored.size(), upload->inflated.data(), upload->inflated.size());
+					}
+					catch (...)
+					{
+						upload->inflateFailed = true;
+					}
+					upload->stored = {};
+					upload->inflateDone.store(true, std::memory_order_release);
+				});
+		}
+	}
+
+	void fillWave()
+	{
+		bool ringFull = false;
+		for (auto it = uploads.begin(); it != uploads.end(); ++it)
+		{
+			Upload& upload = *it;
+			if (upload.stage == Stage::Compressed)
+			{
+				upload.stage = Stage::Reading;
+				upload.stored.resize(static_cast<size_t>(upload.storedSize));
+				io.read(*upload.file, upload.fileOffset, upload.stored.size(), upload.stored.data(), reinterpret_cast<uint64_t>(&upload));
+				stats.bytesRead += upload.storedSize;
+				continue;
+			}
+
+			if (upload.stage == Stage::Inflating && upload.inflateDone.load(std::memory_order_acquire))
+			{
+				if (upload.inflateFailed)
+					throw std::runtime_error("failed to decompress an asset for upload!");
+
+				upload.memory = upload.inflated;
+				upload.file = nullptr;
+				upload.stage = Stage::Streaming;
+			}
+
+			if (upload.stage != Stage::Streaming)
+				continue;
+
+			// Zero-sized uploads still complete in order with the rest, through an empty chunk
+			if (upload.size == 0 && !upload.emptyQueued)
+			{
+				upload.emptyQueued = true;
+				wave.push_back({ it, {}, 0, true, false, true });
+				continue;
+			}
+
+			// Leaves the other half of the ring to the wave before this one; compressed blobs further
+			// down the list still start their reads
+			while (!ringFull && upload.staged < upload.size)
+			{
+				vk::DeviceSize size = std::min<vk::DeviceSize>(upload.size - upload.staged, chunkSize);
+				if (upload.image && size < upload.size - upload.staged)
+					size = std::max<vk::DeviceSize>(size / upload.rowPitch, 1) * upload.rowPitch;
+
+				std::optional<StagingRing::Allocation> staging;
+				if (waveBytes + size <= ring.maxAllocation())
+					staging = ring.tryAllocate(size);
+				if (!staging)
+				{
+					ringFull = true;
+					break;
+				}
+
+				Chunk chunk{ it, *staging, upload.destinationOffset + upload.staged, false, upload.staged == 0, upload.staged + size == upload.size };
+				if (upload.file != nullptr)
+				{
+					io.read(*upload.file, upload.fileOffset + upload.staged, static_cast<size_t>(size), staging->data, CHUNK_READ | wave.size());
+					stats.bytesRead += size;
+				}
+				else
+				{
+					std::memcpy(staging->data, upload.memory.data() + upload.staged, static_cast<size_t>(size));
+					chunk.ready = true;
+				}
+
+				wave.push_back(chunk);
+				waveBytes += size;
+				upload.staged += size;
+			}
+		}
+	}
+
+	void submitWave()
+	{
+		vk::CommandBufferAllocateInfo allocInfo{ .commandPool = commandPool, .level = vk::CommandBufferLevel::ePrimary, .commandBufferCount = 1 };
+		Submission submission{ .commandBuffer = std::move(device->allocateCommandBuffers(allocInfo).front()) };
+
+		vk::raii::CommandBuffer& commandBuffer = submission.commandBuffer;
+		commandBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+		std::vector<vk::ImageMemoryBarrier2> barriers;
+		for (const Chunk& chunk : wave)
+			if (chunk.first && chunk.upload->image)
+				barriers.push_back(levelBarrier(*chunk.upload->image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal));
+		if (!barriers.empty())
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()), .pImageMemoryBarriers = barriers.data() });
+
+		barriers.clear();
+		for (const Chunk& chunk : wave)
+		{
+			const Upload& upload = *chunk.upload;
+			if (upload.image && chunk.staging.size > 0)
+			{
+				const ImageRegion& region = *upload.image;
+				uint32_t firstRow = static_cast<uint32_t>(chunk.destinationOffset / upload.rowPitch) * region.rowHeight;
+				uint32_t rows = static_cast<uint32_t>(chunk.staging.size / upload.rowPitch) * region.rowHeight;
+				vk::BufferImageCopy copy
+				{
+					.bufferOffset = chunk.staging.offset,
+					.bufferRowLength = 0,
+					.bufferImageHeight = 0,
+					.imageSubresource = { vk::ImageAspectFlagBits::eColor, region.mipLevel, 0, 1 },
+					.imageOffset = { 0, static_cast<int32_t>(firstRow), 0 },
+					.imageExtent = { region.extent.width, std::min(rows, region.extent.height - firstRow), 1 }
+				};
+				commandBuffer.copyBufferToImage(chunk.staging.buffer, region.image, vk::ImageLayout::eTransferDstOptimal, copy);
+			}
+			else if (chunk.staging.size > 0)
+			{
+				commandBuffer.copyBuffer(chunk.staging.buffer, upload.destination, vk::BufferCopy{ .srcOffset = chunk.staging.offset, .dstOffset = chunk.destinationOffset, .size = chunk.staging.size });
+			}
+
+			if (chunk.last)
+			{
+				submission.finished.push_back(chunk.upload);
+				if (upload.image)
+					barriers.push_back(levelBarrier(*upload.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal));
+			}
+		}
+
+		// Later submissions may read the data anywhere: vertex input, index fetch, shaders
+		vk::MemoryBarrier2 barrier
+		{
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+			.dstAccessMask = vk::AccessFlagBits2::eMemoryRead
+		};
+		commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &barrier,
+			.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size()), .pImageMemoryBarriers = barriers.data() });
+		commandBuffer.end();
+
+		queue->submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*commandBuffer }, ring.submitFence());
+		submission.batch = ring.submittedBatches();
+		submissions.push_back(std::move(submission));
+
+		stats.bytesUploaded += waveBytes;
+		stats.submissions++;
+		wave.clear();
+		waveBytes = 0;
+	}
+
+	static vk::ImageMemoryBarrier2 levelBarrier(const ImageRegion& region, vk::ImageLayout oldLayout, vk::ImageLayout newLayout)
+	{
+		bool toTransfer = newLayout == vk::ImageLayout::eTransferDstOptimal;
+		return {
+			.srcStageMask = toTransfer ? vk::PipelineStageFlagBits2::eNone : vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = toTransfer ? vk::AccessFlagBits2::eNone : vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = toTransfer ? vk::PipelineStageFlagBits2::eCopy : vk::PipelineStageFlagBits2::eAllCommands,
+			.dstAccessMask = toTransfer ? vk::AccessFlagBits2::eTransferWrite : vk::AccessFlagBits2::eShaderSampledRead,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = region.image,
+			.subresourceRange = { vk::ImageAspectFlagBits::eColor, region.mipLevel, 1, 0, 1 }
+		};
+	}
+
+	const vk::raii::Device* device = nullptr;
+	const vk::raii::Queue* queue = nullptr;
+	StagingRing ring;
+	vk::raii::CommandPool commandPool = nullptr;
+	vk::DeviceSize chunkSize = 0;
+
+	std::list<Upload> uploads;
+	std::vector<Chunk> wave; // chunks in the ring's open batch
+	vk::DeviceSize waveBytes = 0;
+	std::deque<Submission> submissions;
+	std::vector<IoCompletion> completions;
+	Statistics stats;
+
+	// Declared after the uploads and the ring, so outstanding reads and inflates finish before either goes away
+	AsyncIO io;
+	std::unique_ptr<ThreadPool> workers;
+};
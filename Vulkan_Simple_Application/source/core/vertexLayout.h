@@ -0,0 +1,322 @@
+#pragma once
+
+// Compact GPU vertex layouts.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// Positions are stored as float32 or as 16-bit snorm/unorm relative to the mesh bounding box and
+// dequantized in the vertex shader with PositionQuantization (pos = offset + scale * encoded), so
+// the same shader works for every position format. Texture coordinates are float32, half or unorm16;
+// normals are optional and octahedral-encoded into two snorm16 components.
+// Attribute locations are fixed: 0 position, 1 normal, 2 texCoord (see shader_mesh.slang).
+//
+// Vertices are stored as two streams: positions alone on binding 0 and the remaining attributes on
+// binding 1. Depth-only passes bind just the position stream and never fetch normals or UVs.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "core/meshData.h"
+
+enum class PositionFormat
+{
+	Float32,
+	Snorm16,
+	Unorm16
+};
+
+enum class TexCoordFormat
+{
+	Float32,
+	Half,
+	Unorm16 // texture coordinates must lie in [0, 1]
+};
+
+enum class NormalFormat
+{
+	None,
+	Octahedral16
+};
+
+// Push constant block read by the mesh vertex shaders.
+struct PositionQuantization
+{
+	glm::vec4 scale{ 1.0f };
+	glm::vec4 offset{ 0.0f };
+};
+
+struct VertexLayout
+{
+	static constexpr uint32_t POSITION_BINDING = 0;
+	static constexpr uint32_t ATTRIBUTE_BINDING = 1;
+
+	PositionFormat position = PositionFormat::Snorm16;
+	TexCoordFormat texCoord = TexCoordFormat::Half;
+	NormalFormat normal = NormalFormat::None;
+
+	// The uncompressed layout, equivalent to the old 32-byte vertex minus its constant colour.
+	static VertexLayout full()
+	{
+		return { PositionFormat::Float32, TexCoordFormat::Float32, NormalFormat::Octahedral16 };
+	}
+
+	[[nodiscard]] uint32_t positionSize() const
+	{
+		// 16-bit positions are padded to four components: three-component 16-bit vertex formats are optional
+		return position == PositionFormat::Float32 ? 3 * sizeof(float) : 4 * sizeof(uint16_t);
+	}
+
+	[[nodiscard]] uint32_t normalSize() const
+	{
+		return normal == NormalFormat::None ? 0 : 2 * sizeof(int16_t);
+	}
+
+	[[nodiscard]] uint32_t texCoordSize() const
+	{
+		return texCoord == TexCoordFormat::Float32 ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+	}
+
+	[[nodiscard]] uint32_t positionStride() const
+	{
+		return positionSize();
+	}
+
+	[[nodiscard]] uint32_t attributeStride() const
+	{
+		return normalSize() + texCoordSize();
+	}
+
+	// Offsets within the attribute stream.
+	[[nodiscard]] uint32_t normalOffset() const
+	{
+		return 0;
+	}
+
+	[[nodiscard]] uint32_t texCoordOffset() const
+	{
+		return normalSize();
+	}
+
+	// Total bytes per vertex across both streams.
+	[[nodiscard]] uint32_t stride() const
+	{
+		return positionStride() + attributeStride();
+	}
+
+	// Vertex shader entry point in shader_mesh.slang that consumes this layout.
+	[[nodiscard]] const char* vertexEntryPoint() const
+	{
+		return normal == NormalFormat::None ? "vertMain" : "vertMainNormal";
+	}
+
+	// Depth-only entry point in shader_mesh.slang; it reads the position stream only.
+	[[nodiscard]] static const char* depthEntryPoint()
+	{
+		return "vertMainDepth";
+	}
+
+	[[nodiscard]] vk::VertexInputBindingDescription positionBindingDescription() const
+	{
+		return { POSITION_BINDING, positionStride(), vk::VertexInputRate::eVertex };
+	}
+
+	[[nodiscard]] vk::VertexInputAttributeDescription positionAttributeDescription() const
+	{
+		switch (position)
+		{
+		case PositionFormat::Float32:
+			return { 0, POSITION_BINDING, vk::Format::eR32G32B32Sfloat, 0 };
+		case PositionFormat::Snorm16:
+			return { 0, POSITION_BINDING, vk::Format::eR16G16B16A16Snorm, 0 };
+		default:
+			return { 0, POSITION_BINDING, vk::Format::eR16G16B16A16Unorm, 0 };
+		}
+	}
+
+	[[nodiscard]] std::vector<vk::VertexInputBindingDescription> bindingDescriptions() const
+	{
+		return {
+			positionBindingDescription(),
+			{ ATTRIBUTE_BINDING, attributeStride(), vk::VertexInputRate::eVertex }
+		};
+	}
+
+	[[nodiscard]] std::vector<vk::VertexInputAttributeDescription> attributeDescriptions() const
+	{
+		std::vector<vk::VertexInputAttributeDescription> attributes = { positionAttributeDescription() };
+
+		if (normal == NormalFormat::Octahedral16)
+			attributes.emplace_back(1, ATTRIBUTE_BINDING, vk::Format::eR16G16Snorm, normalOffset());
+
+		switch (texCoord)
+		{
+		case TexCoordFormat::Float32:
+			attributes.emplace_back(2, ATTRIBUTE_BINDING, vk::Format::eR32G32Sfloat, texCoordOffset());
+			break;
+		case TexCoordFormat::Half:
+			attributes.emplace_back(2, ATTRIBUTE_BINDING, vk::Format::eR16G16Sfloat, texCoordOffset());
+			break;
+		case TexCoordFormat::Unorm16:
+			attributes.emplace_back(2, ATTRIBUTE_BINDING, vk::Format::eR16G16Unorm, texCoordOffset());
+			break;
+		}
+
+		return attributes;
+	}
+};
+
+// Both streams in one allocation: positions from offset 0, attributes from attributeOffset.
+struct EncodedVertices
+{
+	VertexLayout layout;
+	PositionQuantization quantization;
+	uint32_t count = 0;
+	uint64_t attributeOffset = 0;
+	std::vector<uint8_t> data;
+};
+
+namespace vertex_encoding
+{
+	inline uint16_t toUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	inline int16_t toSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	// Octahedral mapping of a unit vector onto [-1, 1]^2.
+	inline glm::vec2 octahedralEncode(glm::vec3 normal)
+	{
+		float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if (length == 0.0f)
+			return { 0.0f, 0.0f };
+
+		normal /= length;
+		glm::vec2 encoded(normal.x, normal.y);
+		if (normal.z < 0.0f)
+		{
+			encoded = (1.0f - glm::abs(glm::vec2(normal.y, normal.x))) *
+				glm::vec2(normal.x >= 0.0f ? 1.0f : -1.0f, normal.y >= 0.0f ? 1.0f : -1.0f);
+		}
+
+		return encoded;
+	}
+
+	template <typename T>
+	void write(uint8_t* destination, const T& value)
+	{
+		std::memcpy(destination, &value, sizeof(T));
+	}
+}
+
+inline PositionQuantization positionQuantization(PositionFormat format, const MeshBounds& bounds)
+{
+	PositionQuantization quantization;
+	if (format == PositionFormat::Float32 || !bounds.valid())
+		return quantization;
+
+	// Keep degenerate axes (flat meshes) from dividing by zero
+	glm::vec3 extent = glm::max(bounds.extent(), glm::vec3(1e-6f));
+	if (format == PositionFormat::Snorm16)
+	{
+		quantization.scale = glm::vec4(extent * 0.5f, 1.0f);
+		quantization.offset = glm::vec4(bounds.center(), 0.0f);
+	}
+	else
+	{
+		quantization.scale = glm::vec4(extent, 1.0f);
+		quantization.offset = glm::vec4(bounds.min, 0.0f);
+	}
+
+	return quantization;
+}
+
+inline EncodedVertices encodeVertices(const std::vector<MeshVertex>& vertices, const VertexLayout& layout, const MeshBounds& bounds)
+{
+	using namespace vertex_encoding;
+
+	// Keep the attribute stream 16-byte aligned, which satisfies every attribute format used here
+	size_t positionBytes = static_cast<size_t>(layout.positionStride()) * vertices.size();
+	size_t attributeOffset = (positionBytes + 15) & ~static_cast<size_t>(15);
+
+	EncodedVertices encoded
+	{
+		.layout = layout,
+		.quantization = positionQuantization(layout.position, bounds),
+		.count = static_cast<uint32_t>(vertices.size()),
+		.attributeOffset = attributeOffset
+	};
+	encoded.data.resize(attributeOffset + static_cast<size_t>(layout.attributeStride()) * vertices.size());
+
+	glm::vec3 scale(encoded.quantization.scale);
+	glm::vec3 offset(encoded.quantization.offset);
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const MeshVertex& vertex = vertices[i];
+		uint8_t* destination = encoded.data.data() + i * layout.positionStride();
+		uint8_t* attributes = encoded.data.data() + attributeOffset + i * layout.attributeStride();
+
+		switch (layout.position)
+		{
+		case PositionFormat::Float32:
+			write(destination, vertex.pos);
+			break;
+		case PositionFormat::Snorm16:
+		{
+			glm::vec3 normalized = (vertex.pos - offset) / scale;
+			int16_t packed[4] = { toSnorm16(normalized.x), toSnorm16(normalized.y), toSnorm16(normalized.z), 0 };
+			write(destination, packed);
+			break;
+		}
+		case PositionFormat::Unorm16:
+		{
+			glm::vec3 normalized = (vertex.pos - offset) / scale;
+			uint16_t packed[4] = { toUnorm16(normalized.x), toUnorm16(normalized.y), toUnorm16(normalized.z), 0 };
+			write(destination, packed);
+			break;
+		}
+		}
+
+		if (layout.normal == NormalFormat::Octahedral16)
+		{
+			glm::vec2 octahedral = octahedralEncode(vertex.normal);
+			int16_t packed[2] = { toSnorm16(octahedral.x), toSnorm16(octahedral.y) };
+			write(attributes + layout.normalOffset(), packed);
+		}
+
+		uint8_t* texCoordDestination = attributes + layout.texCoordOffset();
+		switch (layout.texCoord)
+		{
+		case TexCoordFormat::Float32:
+			write(texCoordDestination, vertex.texCoord);
+			break;
+		case TexCoordFormat::Half:
+		{
+			uint16_t packed[2] = { glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y) };
+			write(texCoordDestination, packed);
+			break;
+		}
+		case TexCoordFormat::Unorm16:
+		{
+			if (glm::any(glm::lessThan(vertex.texCoord, glm::vec2(0.0f))) || glm::any(glm::greaterThan(vertex.texCoord, glm::vec2(1.0f))))
+				throw std::runtime_error("texture coordinates outside [0, 1] cannot be stored as unorm16!");
+
+			uint16_t packed[2] = { toUnorm16(vertex.texCoord.x), toUnorm16(vertex.texCoord.y) };
+			write(texCoordDestination, packed);
+			break;
+		}
+		}
+	}
+
+	return encoded;
+}
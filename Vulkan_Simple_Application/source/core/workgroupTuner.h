@@ -0,0 +1,229 @@
+#pragma once
+
+// Compute workgroup-size autotuner.
+// Expects Vulkan-Hpp (header or module) to be visible at the include site.
+//
+// A tuned compute shader exposes its workgroup size as specialization constant 0. The tuner
+// times every candidate size with timestamp queries on the current device and stores the
+// winner per pipeline key in a small text cache keyed by device UUID + driver version.
+// Candidates are 1D, so shaders with 2D tiles or a group size their algorithm is built around
+// (the depth pyramid, the single-pass mip downsampler) keep a fixed numthreads.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr uint32_t DEFAULT_WORKGROUP_SIZE = 256;
+constexpr uint32_t WORKGROUP_SIZE_CONSTANT_ID = 0;
+
+class WorkgroupTuner
+{
+public:
+	explicit WorkgroupTuner(const vk::raii::PhysicalDevice& physicalDevice, std::string cachePath = "workgroup_cache.txt")
+		: cachePath(std::move(cachePath))
+	{
+		auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+		const auto& deviceProperties = properties.get<vk::PhysicalDeviceProperties2>().properties;
+		const auto& idProperties = properties.get<vk::PhysicalDeviceIDProperties>();
+
+		std::ostringstream key;
+		for (uint8_t byte : idProperties.deviceUUID)
+		{
+			char hex[3];
+			std::snprintf(hex, sizeof(hex), "%02x", byte);
+			key << hex;
+		}
+		key << "-" << deviceProperties.driverVersion;
+		deviceKey = key.str();
+
+		limits = deviceProperties.limits;
+		load();
+	}
+
+	// Tuning only runs when VSA_AUTOTUNE is set, everything else just reads the cache.
+	static bool autotuneRequested()
+	{
+		const char* value = std::getenv("VSA_AUTOTUNE");
+		return value != nullptr && value[0] != '\0' && value[0] != '0';
+	}
+
+	[[nodiscard]] std::vector<uint32_t> candidates() const
+	{
+		std::vector<uint32_t> sizes;
+		for (uint32_t size = 32; size <= 1024; size *= 2)
+			if (size <= limits.maxComputeWorkGroupSize[0] && size <= limits.maxComputeWorkGroupInvocations)
+				sizes.push_back(size);
+
+		return sizes;
+	}
+
+	// Returns the cached size for this device, or fallback when nothing has been tuned yet.
+	[[nodiscard]] uint32_t cachedOr(const std::string& pipelineKey, uint32_t fallback = DEFAULT_WORKGROUP_SIZE) const
+	{
+		for (const auto& entry : entries)
+			if (entry.device == deviceKey && entry.pipeline == pipelineKey)
+				return entry.workgroupSize;
+
+		return fallback;
+	}
+
+	/**
+	* createPipeline builds the pipeline specialized for a workgroup size, recordDispatch binds
+	* everything and records one dispatch of the real workload. Returns the fastest size (or the
+	* cached size, or fallback, when the queue cannot write timestamps).
+	*/
+	uint32_t tune(
+		const std::string& pipelineKey,
+		const vk::raii::Device& device,
+		const vk::raii::Queue& queue,
+		uint32_t queueFamilyIndex,
+		uint32_t timestampValidBits,
+		const std::function<vk::raii::Pipeline(uint32_t)>& createPipeline,
+		const std::function<void(const vk::raii::CommandBuffer&, const vk::raii::Pipeline&, uint32_t)>& recordDispatch,
+		uint32_t fallback = DEFAULT_WORKGROUP_SIZE)
+	{
+		if (timestampValidBits == 0 || !limits.timestampComputeAndGraphics)
+		{
+			std::cout << "Workgroup autotune skipped: queue has no timestamp support" << std::endl;
+			return cachedOr(pipelineKey, fallback);
+		}
+
+		vk::raii::CommandPool commandPool(device, vk::CommandPoolCreateInfo
+			{
+				.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+				.queueFamilyIndex = queueFamilyIndex
+			});
+		vk::raii::CommandBuffer commandBuffer = std::move(vk::raii::CommandBuffers(device, vk::CommandBufferAllocateInfo
+			{
+				.commandPool = commandPool,
+				.level = vk::CommandBufferLevel::ePrimary,
+				.commandBufferCount = 1
+			}).front());
+		vk::raii::QueryPool queryPool(device, vk::QueryPoolCreateInfo
+			{
+				.queryType = vk::QueryType::eTimestamp,
+				.queryCount = 2
+			});
+
+		uint32_t bestSize = cachedOr(pipelineKey, fallback);
+		double bestTime = std::numeric_limits<double>::max();
+
+		for (uint32_t size : candidates())
+		{
+			vk::raii::Pipeline pipeline = createPipeline(size);
+
+			commandBuffer.reset();
+			commandBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+			commandBuffer.resetQueryPool(queryPool, 0, 2);
+
+			// One untimed dispatch to warm caches and clocks
+			recordDispatch(commandBuffer, pipeline, size);
+			vk::MemoryBarrier2 barrier
+			{
+				.srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.srcAccessMask = vk::AccessFlagBits2::eShaderWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite
+			};
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &barrier });
+
+			commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, queryPool, 0);
+			for (uint32_t i = 0; i < iterations; i++)
+			{
+				recordDispatch(commandBuffer, pipeline, size);
+				commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &barrier });
+			}
+			commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, queryPool, 1);
+			commandBuffer.end();
+
+			queue.submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*commandBuffer }, nullptr);
+			queue.waitIdle();
+
+			auto [result, timestamps] = queryPool.getResults<uint64_t>(0, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+			if (result != vk::Result::eSuccess)
+				continue;
+
+			uint64_t mask = timestampValidBits >= 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+			double nanoseconds = static_cast<double>((timestamps[1] - timestamps[0]) & mask) * limits.timestampPeriod / iterations;
+			std::cout << "Workgroup autotune [" << pipelineKey << "] size " << size << ": " << nanoseconds / 1000.0 << " us" << std::endl;
+
+			if (nanoseconds < bestTime)
+			{
+				bestTime = nanoseconds;
+				bestSize = size;
+			}
+		}
+
+		store(pipelineKey, bestSize);
+		std::cout << "Workgroup autotune [" << pipelineKey << "] selected " << bestSize << std::endl;
+		return bestSize;
+	}
+
+	void store(const std::string& pipelineKey, uint32_t workgroupSize)
+	{
+		auto entryIt = std::ranges::find_if(entries, [&](const Entry& entry)
+			{
+				return entry.device == deviceKey && entry.pipeline == pipelineKey;
+			});
+
+		if (entryIt != entries.end())
+			entryIt->workgroupSize = workgroupSize;
+		else
+			entries.push_back({ deviceKey, pipelineKey, workgroupSize });
+
+		save();
+	}
+
+	// Number of workgroups needed to cover count elements.
+	static uint32_t groupCount(uint32_t count, uint32_t workgroupSize)
+	{
+		return (count + workgroupSize - 1) / workgroupSize;
+	}
+
+private:
+	struct Entry
+	{
+		std::string device;
+		std::string pipeline;
+		uint32_t workgroupSize = DEFAULT_WORKGROUP_SIZE;
+	};
+
+	void load()
+	{
+		std::ifstream file(cachePath);
+		if (!file.is_open())
+			return;
+
+		Entry entry;
+		while (file >> entry.device >> entry.pipeline >> entry.workgroupSize)
+			entries.push_back(entry);
+	}
+
+	void save() const
+	{
+		std::ofstream file(cachePath, std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << "failed to write workgroup cache: " << cachePath << std::endl;
+			return;
+		}
+
+		for (const auto& entry : entries)
+			file << entry.device << " " << entry.pipeline << " " << entry.workgroupSize << "\n";
+	}
+
+	static constexpr uint32_t iterations = 16;
+
+	std::string cachePath;
+	std::string deviceKey;
+	vk::PhysicalDeviceLimits limits;
+	std::vector<Entry> entries;
+};
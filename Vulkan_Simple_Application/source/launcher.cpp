@@ -0,0 +1,38 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include "core/benchmark.h"
+
+int runHelloTriangle(const BenchmarkOptions& options);
+int runTriangle(const BenchmarkOptions& options);
+int runComputeShader(const BenchmarkOptions& options);
+int runMultithreaded(const BenchmarkOptions& options);
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	try
+	{
+		options = BenchmarkOptions::parse(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		BenchmarkOptions::printUsage();
+		return EXIT_FAILURE;
+	}
+
+	if (options.app == "hello")
+		return runHelloTriangle(options);
+	if (options.app == "triangle")
+		return runTriangle(options);
+	if (options.app == "compute")
+		return runComputeShader(options);
+	if (options.app == "multithreaded")
+		return runMultithreaded(options);
+
+	std::cerr << "unknown app: " << options.app << std::endl;
+	BenchmarkOptions::printUsage();
+	return EXIT_FAILURE;
+}
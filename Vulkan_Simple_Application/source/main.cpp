@@ -29,13 +29,17 @@
 #include <array>
 #include <assert.h>
 #include <chrono>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <span>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 #define VULKAN_HPP_NO_STRUCT_CONSTRUCTORS
@@ -54,7 +58,6 @@ import vulkan_hpp;
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/hash.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -62,9 +65,25 @@ import vulkan_hpp;
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#include "core/cpuTracer.h"
+#include "core/gpuProfiler.h"
+#include "core/benchmark.h"
+#include "core/taskGraph.h"
+#include "core/meshData.h"
+#include "core/meshOptimizer.h"
+#include "core/vertexLayout.h"
+#include "core/indexFormat.h"
+#include "core/cookedMesh.h"
+#include "core/assetPack.h"
+#include "core/uploadManager.h"
+#include "core/mipGenerator.h"
+
 constexpr uint32_t WIDTH = 1280;
 constexpr uint32_t HEIGHT = 720;
 const std::string  MODEL_PATH = "resources/models/viking_room.obj";
+const std::string  COOKED_MODEL_PATH = "resources/cooked/models/viking_room.mesh"; // written by Asset_Cooker, see cook.bat
+const std::string  ASSET_PACK_PATH = "resources/assets.pack"; // Asset_Cooker --pack; --assets=loose ignores it
+constexpr vk::DeviceSize STAGING_RING_SIZE = 4 * 1024 * 1024;
 const std::string  TEXTURE_PATH = "resources/textures/viking_room.png";
 constexpr int MAX_FRAMES_IN_FLIGHT = 2;
 
@@ -84,55 +103,27 @@ enum Option
 	Index = 1
 };
 
-struct Vertex
-{
-	glm::vec3 pos;
-	glm::vec3 color;
-	glm::vec2 texCoord;
-
-	static vk::VertexInputBindingDescription getBindingDescription()
-	{
-		return { 0, sizeof(Vertex), vk::VertexInputRate::eVertex };
-	}
-
-	static std::array<vk::VertexInputAttributeDescription, 3> getAttributeDescriptions()
-	{
-		return {
-			vk::VertexInputAttributeDescription(0, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, pos)),
-			vk::VertexInputAttributeDescription(1, 0, vk::Format::eR32G32B32Sfloat, offsetof(Vertex, color)),
-			vk::VertexInputAttributeDescription(2, 0, vk::Format::eR32G32Sfloat, offsetof(Vertex, texCoord))
-		};
-	}
-
-	bool operator==(const Vertex& other) const
-	{
-		return pos == other.pos && color == other.color && texCoord == other.texCoord;
-	}
-};
-
-template <>
-struct std::hash<Vertex>
-{
-	size_t operator()(Vertex const& vertex) const noexcept
-	{
-		return ((hash<glm::vec3>()(vertex.pos) ^ (hash<glm::vec3>()(vertex.color) << 1)) >> 1) ^ (hash<glm::vec2>()(vertex.texCoord) << 1);
-	}
-};
-
+// shader_mesh.slang reads the model matrix from binding 0 and the camera from binding 2. Both point into
+// this buffer; the camera starts at 256 bytes, a multiple of any minUniformBufferOffsetAlignment.
 struct UniformBufferObject
 {
 	alignas(16) glm::mat4 model;
-	alignas(16) glm::mat4 view;
+	alignas(256) glm::mat4 view;
 	alignas(16) glm::mat4 proj;
 };
 
 class HelloTriangleApplication
 {
 public:
-	void run()
+	void run(const BenchmarkOptions& options = BenchmarkOptions())
 	{
+		benchmark = BenchmarkRun(options);
+		depthPrepass = options.depthPrepass;
+		benchmark.beginStartup();
 		initWindow();
+		benchmark.startupPhase("window");
 		initVulkan();
+		benchmark.endStartup();
 		mainLoop();
 		cleanup();
 	}
@@ -156,23 +147,39 @@ private:
 	vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
 	vk::raii::PipelineLayout pipelineLayout = nullptr;
 	vk::raii::Pipeline graphicsPipeline = nullptr;
+	vk::raii::Pipeline depthPrepassPipeline = nullptr;   // depth only, writes the depth buffer
+	vk::raii::Pipeline depthEqualPipeline = nullptr;     // main pass after a prepass: depth equal, no writes
+	bool depthPrepass = false;
 
 	vk::raii::Image depthImage = nullptr;
 	vk::raii::DeviceMemory depthImageMemory = nullptr;
 	vk::raii::ImageView depthImageView = nullptr;
 
 	uint32_t mipLevels = 0;
+	stbi_uc* texturePixels = nullptr;
+	int textureWidth = 0;
+	int textureHeight = 0;
 	vk::raii::Image textureImage = nullptr;
 	vk::raii::DeviceMemory textureImageMemory = nullptr;
 	vk::raii::ImageView textureImageView = nullptr;
 	vk::raii::Sampler textureSampler = nullptr;
 
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
+	MeshData mesh;
+	VertexLayout vertexLayout;
+	EncodedVertices encodedVertices;
+	PackedIndices packedIndices;
+	uint32_t drawIndexCount = 0; // the full-detail LOD when the index buffer holds a whole chain
+	std::span<const uint8_t> vertexData; // encodedVertices.data, or the cooked mesh inside the mapped pack
+	std::span<const uint8_t> indexData;
+	std::vector<uint8_t> modelBytes; // a compressed cooked mesh, decompressed out of the pack
+	bool uint8IndicesEnabled = false;
 	vk::raii::Buffer vertexBuffer = nullptr;
 	vk::raii::DeviceMemory vertexBufferMemory = nullptr;
 	vk::raii::Buffer indexBuffer = nullptr;
 	vk::raii::DeviceMemory indexBufferMemory = nullptr;
+	AssetPack assets;
+	AsyncFile packFile; // the pack opened again for asynchronous reads into staging memory
+	UploadManager uploads;
 
 	std::vector<vk::raii::Buffer> uniformBuffers;
 	std::vector<vk::raii::DeviceMemory> uniformBuffersMemory;
@@ -189,6 +196,10 @@ private:
 	std::vector<vk::raii::Fence> inFlightFences;
 	uint32_t frameIndex = 0;
 
+	GpuProfiler gpuProfiler;
+	MipGenerator mipGenerator;
+	BenchmarkRun benchmark;
+
 	bool framebufferResized = false;
 
 	std::vector<const char*> requiredDeviceExtension = {
@@ -204,6 +215,7 @@ private:
 
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+		glfwWindowHint(GLFW_VISIBLE, benchmark.options().headless ? GLFW_FALSE : GLFW_TRUE);
 
 		window = glfwCreateWindow(WIDTH, HEIGHT, "Vulkan", nullptr, nullptr);
 		glfwSetWindowUserPointer(window, this);
@@ -211,36 +223,71 @@ private:
 			{
 				static_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window))->framebufferResized = true;
 			});
+		glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int, int action, int)
+			{
+				if (key == GLFW_KEY_P && action == GLFW_PRESS)
+				{
+					auto* app = static_cast<HelloTriangleApplication*>(glfwGetWindowUserPointer(window));
+					app->depthPrepass = !app->depthPrepass;
+					std::cout << "Depth prepass " << (app->depthPrepass ? "on" : "off") << std::endl;
+				}
+			});
 	}
 
 	void initVulkan()
 	{
+		openAssetPack();
+		benchmark.startupPhase("asset_pack");
 		createInstance();
+		benchmark.startupPhase("instance");
 		createSurface();
+		benchmark.startupPhase("surface");
 		chooseSuitableDevice();
+		benchmark.startupPhase("device");
+		// Queries the framebuffer size, which GLFW only allows on the main thread
 		createSwapChain();
 		createImageViews();
-		createDescriptorSetLayout();
-		createGraphicsPipeline();
-		createCommandPool();
-		createDepthResources();
-		createTextureImage();
-		createTextureImageView();
-		createTextureSampler();
-		loadModel();
-		createUniformBuffers();
-		createDescriptorPool();
-		createDescriptorSets();
-		createCommandBuffers();
-		createSyncObjects();
+		benchmark.startupPhase("swapchain");
+
+		// The rest runs on a task graph. Texture uploads and vertex/index uploads both submit
+		// through the same queue and command pool, so they are chained.
+		TaskGraph startup;
+		auto layoutTask = startup.add("descriptor_layout", [this]() { createDescriptorSetLayout(); });
+		startup.add("pipeline", [this]() { createGraphicsPipeline(); }, { layoutTask });
+		auto commandPoolTask = startup.add("command_pool", [this]() { createCommandPool(); });
+		startup.add("depth", [this]() { createDepthResources(); });
+		auto decodeTask = startup.add("texture_decode", [this]() { decodeTextureImage(); });
+		auto modelTask = startup.add("model", [this]() { loadModel(); });
+		auto textureTask = startup.add("texture_upload", [this]()
+			{
+				createTextureImage();
+				createTextureImageView();
+				createTextureSampler();
+			}, { commandPoolTask, decodeTask });
+		// The upload manager records into a pool of its own but submits to the queue the texture upload uses
+		startup.add("geometry_upload", [this]() { createGeometryBuffers(); }, { modelTask, textureTask });
+		auto uniformTask = startup.add("uniform_buffers", [this]() { createUniformBuffers(); });
+		startup.add("descriptors", [this]() { createDescriptorPool(); createDescriptorSets(); }, { layoutTask, textureTask, uniformTask });
+		// Allocates from the pool the texture upload uses, so it waits for it
+		startup.add("command_buffers", [this]() { createCommandBuffers(); createSyncObjects(); }, { commandPoolTask, textureTask });
+
+		ThreadPool startupPool;
+		startup.run(startupPool);
+
+		for (const auto& task : startup.taskTimings())
+			benchmark.startupPhase(task.name, task.begin, task.end);
 	}
 
 	void mainLoop()
 	{
-		while (!glfwWindowShouldClose(window))
+		while (!glfwWindowShouldClose(window) && !benchmark.finished())
 		{
+			VSA_TRACE_ZONE("frame");
 			glfwPollEvents();
 			drawFrame();
+
+			if (benchmark.endFrame())
+				gpuProfiler.resetStatistics();
 		}
 
 		device.waitIdle();
@@ -254,6 +301,10 @@ private:
 
 	void cleanup() const
 	{
+		gpuProfiler.exportFromEnvironment();
+		CpuTracer::instance().exportFromEnvironment();
+		benchmark.writeReport(gpuProfiler.toJson("  "));
+
 		glfwDestroyWindow(window);
 
 		glfwTerminate();
@@ -410,12 +461,27 @@ private:
 		if (queueIndex == ~0)
 			throw std::runtime_error("Could not find a queue for graphics and present -> terminating");
 
+		// pipeline statistics are optional, the profiler falls back to timestamps only
+		bool pipelineStatisticsSupported = physicalDevice.getFeatures().pipelineStatisticsQuery;
+
+		// the compute mip generator indexes its storage images by level, without it mips are blitted
+		bool storageImageIndexingSupported = physicalDevice.getFeatures().shaderStorageImageArrayDynamicIndexing;
+
+		// 8-bit indices are optional, small meshes fall back to 16-bit indices
+		uint8IndicesEnabled = indexTypeUint8Supported(physicalDevice);
+		if (uint8IndicesEnabled)
+			requiredDeviceExtension.push_back(vk::EXTIndexTypeUint8ExtensionName);
+
 		// query for Vulkan 1.3 features
-		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT> featureChain = {
-			{.features = {.samplerAnisotropy = true}},                   // vk::PhysicalDeviceFeatures2
+		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features, vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT, vk::PhysicalDeviceHostQueryResetFeatures, vk::PhysicalDeviceIndexTypeUint8FeaturesEXT> featureChain = {
+			{.features = {.samplerAnisotropy = true, .pipelineStatisticsQuery = pipelineStatisticsSupported, .shaderStorageImageArrayDynamicIndexing = storageImageIndexingSupported}}, // vk::PhysicalDeviceFeatures2
 			{.synchronization2 = true, .dynamicRendering = true},        // vk::PhysicalDeviceVulkan13Features
-			{.extendedDynamicState = true}                               // vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
+			{.extendedDynamicState = true},                              // vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT
+			{.hostQueryReset = true},                                    // vk::PhysicalDeviceHostQueryResetFeatures
+			{.indexTypeUint8 = true}                                     // vk::PhysicalDeviceIndexTypeUint8FeaturesEXT
 		};
+		if (!uint8IndicesEnabled)
+			featureChain.unlink<vk::PhysicalDeviceIndexTypeUint8FeaturesEXT>();
 
 		// create a Device
 		float queuePriority = 0.5f;
@@ -436,6 +502,12 @@ private:
 
 		device = vk::raii::Device(physicalDevice, deviceCreateInfo);
 		queue = vk::raii::Queue(device, queueIndex, 0);
+
+		gpuProfiler.init(physicalDevice, device, queueIndex, MAX_FRAMES_IN_FLIGHT, pipelineStatisticsSupported);
+		gpuProfiler.calibrate(device, queue);
+
+		auto deviceProperties = physicalDevice.getProperties();
+		benchmark.setDevice(deviceProperties.deviceName, deviceProperties.driverVersion);
 	}
 
 	void createSwapChain()
@@ -484,7 +556,8 @@ private:
 	{
 		std::array bindings = {
 			vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex, nullptr),
-			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment, nullptr) 
+			vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment, nullptr),
+			vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex, nullptr)
 		};
 
 		vk::DescriptorSetLayoutCreateInfo layoutInfo
@@ -497,12 +570,13 @@ private:
 
 	void createGraphicsPipeline()
 	{
-		vk::raii::ShaderModule shaderModule = createShaderModule(readFile("resources/shaders/slang.spv"));
+		vk::raii::ShaderModule shaderModule = createShaderModule(readFile("resources/shaders/slang_mesh.spv"));
 
+		// The entry point matching the layout's attributes: positions from binding 0, the rest from binding 1
 		vk::PipelineShaderStageCreateInfo vertShaderStageInfo
 		{
 			.stage = vk::ShaderStageFlagBits::eVertex,
-			.module = shaderModule, .pName = "vertMain"
+			.module = shaderModule, .pName = vertexLayout.vertexEntryPoint()
 		};
 		vk::PipelineShaderStageCreateInfo fragShaderStageInfo
 		{
@@ -511,12 +585,12 @@ private:
 		};
 		vk::PipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescriptions = Vertex::getAttributeDescriptions();
+		auto bindingDescriptions = vertexLayout.bindingDescriptions();
+		auto attributeDescriptions = vertexLayout.attributeDescriptions();
 		vk::PipelineVertexInputStateCreateInfo vertexInputInfo
 		{
-			.vertexBindingDescriptionCount = 1,
-			.pVertexBindingDescriptions = &bindingDescription,
+			.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size()),
+			.pVertexBindingDescriptions = bindingDescriptions.data(),
 			.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
 			.pVertexAttributeDescriptions = attributeDescriptions.data()
 		};
@@ -578,11 +652,20 @@ private:
 			.pDynamicStates = dynamicStates.data() 
 		};
 
+		// Dequantization constants for the compact vertex positions
+		vk::PushConstantRange pushConstantRange
+		{
+			.stageFlags = vk::ShaderStageFlagBits::eVertex,
+			.offset = 0,
+			.size = sizeof(PositionQuantization)
+		};
+
 		vk::PipelineLayoutCreateInfo pipelineLayoutInfo
 		{ 
 			.setLayoutCount = 1, 
 			.pSetLayouts = &*descriptorSetLayout,
-			.pushConstantRangeCount = 0
+			.pushConstantRangeCount = 1,
+			.pPushConstantRanges = &pushConstantRange
 		};
 
 		pipelineLayout = vk::raii::PipelineLayout(device, pipelineLayoutInfo);
@@ -611,6 +694,43 @@ private:
 		};
 
 		graphicsPipeline = vk::raii::Pipeline(device, nullptr, pipelineCreateInfoChain.get<vk::GraphicsPipelineCreateInfo>());
+
+		// After a depth prepass the main pass only shades the visible surface
+		depthStencil.depthWriteEnable = vk::False;
+		depthStencil.depthCompareOp = vk::CompareOp::eEqual;
+		depthEqualPipeline = vk::raii::Pipeline(device, nullptr, pipelineCreateInfoChain.get<vk::GraphicsPipelineCreateInfo>());
+
+		// The prepass binds positions only and has no fragment shader or colour attachment; vertMainDepth
+		// transforms positions exactly like the main vertex shaders, so the equal test passes
+		vk::PipelineShaderStageCreateInfo depthShaderStage
+		{
+			.stage = vk::ShaderStageFlagBits::eVertex,
+			.module = shaderModule, .pName = VertexLayout::depthEntryPoint()
+		};
+		auto positionBinding = vertexLayout.positionBindingDescription();
+		auto positionAttribute = vertexLayout.positionAttributeDescription();
+		vk::PipelineVertexInputStateCreateInfo depthVertexInputInfo
+		{
+			.vertexBindingDescriptionCount = 1,
+			.pVertexBindingDescriptions = &positionBinding,
+			.vertexAttributeDescriptionCount = 1,
+			.pVertexAttributeDescriptions = &positionAttribute
+		};
+		vk::PipelineColorBlendStateCreateInfo depthColorBlending
+		{
+			.logicOpEnable = vk::False,
+			.attachmentCount = 0
+		};
+		depthStencil.depthWriteEnable = vk::True;
+		depthStencil.depthCompareOp = vk::CompareOp::eLess;
+
+		auto& depthPipelineInfo = pipelineCreateInfoChain.get<vk::GraphicsPipelineCreateInfo>();
+		depthPipelineInfo.stageCount = 1;
+		depthPipelineInfo.pStages = &depthShaderStage;
+		depthPipelineInfo.pVertexInputState = &depthVertexInputInfo;
+		depthPipelineInfo.pColorBlendState = &depthColorBlending;
+		pipelineCreateInfoChain.get<vk::PipelineRenderingCreateInfo>().colorAttachmentCount = 0;
+		depthPrepassPipeline = vk::raii::Pipeline(device, nullptr, depthPipelineInfo);
 	}
 
 	void createCommandPool()
@@ -665,16 +785,35 @@ private:
 		return format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD24UnormS8Uint;
 	}
 
+	// CPU-only half of the texture setup, safe to run next to other startup work.
+	void decodeTextureImage()
+	{
+		int texChannels;
+		if (const AssetPackEntry* entry = assets.find(TEXTURE_PATH))
+		{
+			// PNGs are stored raw (LZ4 cannot shrink them), so stb decodes straight out of the mapping
+			std::vector<uint8_t> scratch;
+			std::span<const uint8_t> encoded = assets.contents(*entry, scratch);
+			texturePixels = stbi_load_from_memory(encoded.data(), static_cast<int>(encoded.size()), &textureWidth, &textureHeight, &texChannels, STBI_rgb_alpha);
+		}
+		else
+		{
+			texturePixels = stbi_load(TEXTURE_PATH.c_str(), &textureWidth, &textureHeight, &texChannels, STBI_rgb_alpha);
+		}
+
+		if (!texturePixels)
+			throw std::runtime_error("failed to load texture image!");
+	}
+
 	void createTextureImage()
 	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(TEXTURE_PATH.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		int texWidth = textureWidth;
+		int texHeight = textureHeight;
+		stbi_uc* pixels = texturePixels;
+		texturePixels = nullptr;
 		vk::DeviceSize imageSize = texWidth * texHeight * 4;
 		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
-		if (!pixels)
-			throw std::runtime_error("failed to load texture image!");
-
 		vk::raii::Buffer stagingBuffer({});
 		vk::raii::DeviceMemory stagingBufferMemory({});
 		createBuffer(imageSize, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
@@ -685,24 +824,50 @@ private:
 
 		stbi_image_free(pixels);
 
-		createImage(texWidth, texHeight, mipLevels, vk::Format::eR8G8B8A8Srgb, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, textureImage, textureImageMemory);
+		// The compute generator writes mips through storage views; the blit chain copies between levels
+		bool computeMips = benchmark.options().mipGenerator == "compute" && mipLevels > 1 && MipGenerator::supported(physicalDevice, vk::Format::eR8G8B8A8Srgb);
+		vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled |
+			(computeMips ? vk::ImageUsageFlagBits::eStorage : vk::ImageUsageFlagBits::eTransferSrc);
+		vk::ImageCreateFlags flags = computeMips ? MipGenerator::imageCreateFlags(vk::Format::eR8G8B8A8Srgb) : vk::ImageCreateFlags{};
+		createImage(texWidth, texHeight, mipLevels, vk::Format::eR8G8B8A8Srgb, vk::ImageTiling::eOptimal, usage, vk::MemoryPropertyFlagBits::eDeviceLocal, textureImage, textureImageMemory, flags);
 
 		transitionImageLayout(textureImage, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, mipLevels);
 		copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
 
-		generateMipmaps(textureImage, vk::Format::eR8G8B8A8Srgb, texWidth, texHeight, mipLevels);
+		generateMipmaps(textureImage, vk::Format::eR8G8B8A8Srgb, texWidth, texHeight, mipLevels, computeMips);
+	}
+
+	// Fills mips 1 and up from level 0 (in eTransferDstOptimal) and reports the GPU time of either path.
+	void generateMipmaps(vk::raii::Image& image, vk::Format imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels, bool compute)
+	{
+		std::unique_ptr<vk::raii::CommandBuffer> commandBuffer = beginSingleTimeCommands();
+		gpuProfiler.beginOneShot(*commandBuffer);
+
+		if (compute)
+		{
+			mipGenerator.init(physicalDevice, device, readFile("resources/shaders/compute/slang_mipgen.spv"));
+			mipGenerator.generate(*commandBuffer, device, *image, imageFormat, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), mipLevels, vk::ImageLayout::eTransferDstOptimal);
+		}
+		else
+		{
+			recordBlitMipmaps(*commandBuffer, image, imageFormat, texWidth, texHeight, mipLevels);
+		}
+
+		gpuProfiler.endOneShot(*commandBuffer);
+		endSingleTimeCommands(*commandBuffer);
+
+		double gpuMs = gpuProfiler.oneShotMs();
+		benchmark.setOneShotGpuMs("texture_mips", gpuMs);
+		std::cout << "Texture mips (" << (compute ? "compute" : "blit") << "): " << mipLevels << " levels, " << gpuMs << " ms GPU" << std::endl;
 	}
 
-	void generateMipmaps(vk::raii::Image& image, vk::Format imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
+	void recordBlitMipmaps(const vk::raii::CommandBuffer& commandBuffer, vk::raii::Image& image, vk::Format imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels)
 	{
 		// Check if image format supports linear blit-ing
 		vk::FormatProperties formatProperties = physicalDevice.getFormatProperties(imageFormat);
 
 		if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
 			throw std::runtime_error("texture image format does not support linear blitting!");
-		
-
-		std::unique_ptr<vk::raii::CommandBuffer> commandBuffer = beginSingleTimeCommands();
 
 		vk::ImageMemoryBarrier barrier = { 
 			.srcAccessMask = vk::AccessFlagBits::eTransferWrite, 
@@ -729,7 +894,7 @@ private:
 			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
 			barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
 
-			commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
 
 			vk::ArrayWrapper1D<vk::Offset3D, 2> offsets, dstOffsets;
 			offsets[0] = vk::Offset3D(0, 0, 0);
@@ -745,14 +910,14 @@ private:
 			blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i - 1, 0, 1);
 			blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, i, 0, 1);
 
-			commandBuffer->blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, { blit }, vk::Filter::eLinear);
+			commandBuffer.blitImage(image, vk::ImageLayout::eTransferSrcOptimal, image, vk::ImageLayout::eTransferDstOptimal, { blit }, vk::Filter::eLinear);
 
 			barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
 			barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
 			barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
 			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
 
-			commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
 
 			if (mipWidth > 1)
 				mipWidth /= 2;
@@ -766,9 +931,7 @@ private:
 		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
 		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
 
-		commandBuffer->pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
-
-		endSingleTimeCommands(*commandBuffer);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
 	}
 
 	void createTextureImageView()
@@ -810,10 +973,11 @@ private:
 		return vk::raii::ImageView(device, viewInfo);
 	}
 
-	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Image& image, vk::raii::DeviceMemory& imageMemory)
+	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Image& image, vk::raii::DeviceMemory& imageMemory, vk::ImageCreateFlags flags = {})
 	{
 		vk::ImageCreateInfo imageInfo
 		{
+			.flags = flags,
 			.imageType = vk::ImageType::e2D,
 			.format = format,
 			.extent = {width, height, 1},
@@ -899,6 +1063,9 @@ private:
 
 	void loadModel()
 	{
+		if (loadCookedModel())
+			return;
+
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
 		std::vector<tinyobj::material_t> materials;
@@ -908,13 +1075,13 @@ private:
 			throw std::runtime_error(warn + err);
 		
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+		std::unordered_map<MeshVertex, uint32_t> uniqueVertices{};
 
 		for (const auto& shape : shapes)
 		{
 			for (const auto& index : shape.mesh.indices)
 			{
-				Vertex vertex{};
+				MeshVertex vertex{};
 
 				vertex.pos = {
 					attrib.vertices[3 * index.vertex_index + 0],
@@ -927,21 +1094,92 @@ private:
 					1.0f - attrib.texcoords[2 * index.texcoord_index + 1] 
 				};
 
-				vertex.color = { 1.0f, 1.0f, 1.0f };
+				if (index.normal_index >= 0)
+				{
+					vertex.normal = {
+						attrib.normals[3 * index.normal_index + 0],
+						attrib.normals[3 * index.normal_index + 1],
+						attrib.normals[3 * index.normal_index + 2]
+					};
+				}
 
 				if (!uniqueVertices.contains(vertex))
 				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
+					uniqueVertices[vertex] = static_cast<uint32_t>(mesh.vertices.size());
+					mesh.vertices.push_back(vertex);
 				}
 
-				indices.push_back(uniqueVertices[vertex]);
+				mesh.indices.push_back(uniqueVertices[vertex]);
 			}
 		}
+
+		optimizeMesh(mesh, vertexLayout.stride());
+		encodedVertices = encodeVertices(mesh.vertices, vertexLayout, mesh.bounds());
+		packedIndices = packIndices(mesh.indices, mesh.vertices.size(), uint8IndicesEnabled);
+		drawIndexCount = packedIndices.count;
+		vertexData = encodedVertices.data;
+		indexData = packedIndices.data;
+		std::cout << "Vertex buffer: " << encodedVertices.data.size() << " bytes (" << vertexLayout.positionStride() << " + " << vertexLayout.attributeStride() << " bytes per vertex in position and attribute streams, "
+			<< mesh.vertices.size() * sizeof(MeshVertex) << " bytes unpacked)" << std::endl;
+		std::cout << "Index buffer: " << packedIndices.data.size() << " bytes (" << indexFormatName(packedIndices.format) << ")" << std::endl;
 	}
 
-	template <typename T>
-	void createBufferForOption(Option option, std::vector<T> data, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory)
+	// The cooked mesh is already deduplicated, optimized and encoded; a stale or mismatched one falls back to the OBJ.
+	// From the pack its vertex and index bytes are never copied to the heap: they are read straight into staging memory.
+	bool loadCookedModel()
+	{
+		const AssetPackEntry* entry = assets.find(COOKED_MODEL_PATH);
+		if (entry == nullptr && !std::filesystem::exists(COOKED_MODEL_PATH))
+			return false;
+
+		CookedMeshView cooked;
+		try
+		{
+			if (entry != nullptr)
+			{
+				std::span<const uint8_t> bytes = assets.contents(*entry, modelBytes);
+				cooked = viewCookedMesh(bytes.data(), bytes.size());
+			}
+			else
+			{
+				cooked.mesh = readCookedMesh(COOKED_MODEL_PATH);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Ignoring cooked model: " << e.what() << std::endl;
+			return false;
+		}
+
+		if (!matchesLayout(cooked.mesh, vertexLayout))
+		{
+			std::cout << "Ignoring cooked model: vertex layout differs, re-run the asset cooker" << std::endl;
+			return false;
+		}
+
+		encodedVertices = std::move(cooked.mesh.vertices);
+		packedIndices = std::move(cooked.mesh.indices);
+		vertexData = entry != nullptr ? cooked.vertexData : std::span<const uint8_t>(encodedVertices.data);
+		indexData = entry != nullptr ? cooked.indexData : std::span<const uint8_t>(packedIndices.data);
+		drawIndexCount = cooked.mesh.lods.empty() ? packedIndices.count : cooked.mesh.lods.front().indexCount;
+		std::cout << "Loaded cooked model: " << encodedVertices.count << " vertices, " << drawIndexCount / 3 << " triangles, "
+			<< vertexData.size() << " + " << indexData.size() << " bytes (" << indexFormatName(packedIndices.format) << ")" << std::endl;
+		return true;
+	}
+
+	void openAssetPack()
+	{
+		if (benchmark.options().assets == "pack" && !assets.open(ASSET_PACK_PATH, "resources/"))
+			std::cout << "No asset pack at " << ASSET_PACK_PATH << ", loading loose files (see cook.bat)" << std::endl;
+		if (assets.isOpen())
+			packFile = AsyncFile(ASSET_PACK_PATH);
+
+		benchmark.setAssetSource(assets.isOpen() ? "pack" : "loose");
+	}
+
+	// Queues the upload without waiting for it. Bytes inside the mapped pack are read from the pack file
+	// straight into staging memory by the upload manager instead of being faulted in through the mapping.
+	void createBufferForOption(Option option, std::span<const uint8_t> data, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory)
 	{
 		vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eTransferDst;
 		switch (option)
@@ -954,27 +1192,29 @@ private:
 			break;
 		}
 
-		vk::DeviceSize size = sizeof(data[0]) * data.size();
+		createBuffer(data.size(), usage, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, bufferMemory);
 
-		vk::raii::Buffer stagingBuffer({});
-		vk::raii::DeviceMemory stagingBufferMemory({});
-		createBuffer(size, vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible |vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory);
-
-		void* dataStaging = stagingBufferMemory.mapMemory(0, size);
-		memcpy(dataStaging, data.data(), size);
-		stagingBufferMemory.unmapMemory();
+		if (std::optional<uint64_t> offset = assets.fileOffset(data))
+			uploads.upload(packFile, *offset, data.size(), *buffer);
+		else
+			uploads.upload(data, *buffer);
+	}
 
-		createBuffer(size, usage, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, bufferMemory);
+	// Streams the vertex and index data into device-local buffers through the upload manager
+	void createGeometryBuffers()
+	{
+		uploads.init(physicalDevice, device, queue, queueIndex, STAGING_RING_SIZE, benchmark.options().io != "threads");
+		benchmark.setIoBackend(uploads.ioBackendName());
+		// 
+		createBufferForOption(Option::Vert, vertexData, vertexBuffer, vertexBufferMemory);
+		createBufferForOption(Option::Index, indexData, indexBuffer, indexBufferMemory);
 
-		copyBuffer(stagingBuffer, buffer, size);
+		// The first frame draws the mesh; later uploads are left to the per-frame pump
+		uploads.flush();
 	}
 
 	void createUniformBuffers()
 	{
-		// 
-		createBufferForOption(Option::Vert, vertices, vertexBuffer, vertexBufferMemory);
-		createBufferForOption(Option::Index, indices, indexBuffer, indexBufferMemory);
-
 		uniformBuffers.clear();
 		uniformBuffersMemory.clear();
 		uniformBuffersMapped.clear();
@@ -995,7 +1235,7 @@ private:
 	{
 		std::array poolSize
 		{
-			vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, MAX_FRAMES_IN_FLIGHT),
+			vk::DescriptorPoolSize(vk::DescriptorType::eUniformBuffer, 2 * MAX_FRAMES_IN_FLIGHT),
 			vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, MAX_FRAMES_IN_FLIGHT)
 		};
 		vk::DescriptorPoolCreateInfo poolInfo
@@ -1027,7 +1267,13 @@ private:
 			{
 				.buffer = uniformBuffers[i],
 				.offset = 0,
-				.range = sizeof(UniformBufferObject)
+				.range = sizeof(glm::mat4)
+			};
+			vk::DescriptorBufferInfo frameBufferInfo
+			{
+				.buffer = uniformBuffers[i],
+				.offset = offsetof(UniformBufferObject, view),
+				.range = 2 * sizeof(glm::mat4)
 			};
 			vk::DescriptorImageInfo imageInfo
 			{
@@ -1053,7 +1299,16 @@ private:
 					.descriptorCount = 1,
 					.descriptorType = vk::DescriptorType::eCombinedImageSampler,
 					.pImageInfo = &imageInfo
-				} 
+				},
+				vk::WriteDescriptorSet
+				{
+					.dstSet = descriptorSets[i],
+					.dstBinding = 2,
+					.dstArrayElement = 0,
+					.descriptorCount = 1,
+					.descriptorType = vk::DescriptorType::eUniformBuffer,
+					.pBufferInfo = &frameBufferInfo
+				}
 			};
 			device.updateDescriptorSets(descriptorWrites, {});
 		}
@@ -1106,22 +1361,6 @@ private:
 		queue.waitIdle();
 	}
 
-	void copyBuffer(vk::raii::Buffer& srcBuffer, vk::raii::Buffer& dstBuffer, vk::DeviceSize size)
-	{
-		vk::CommandBufferAllocateInfo allocInfo
-		{ 
-			.commandPool = commandPool, 
-			.level = vk::CommandBufferLevel::ePrimary, 
-			.commandBufferCount = 1 
-		};
-		vk::raii::CommandBuffer commandCopyBuffer = std::move(device.allocateCommandBuffers(allocInfo).front());
-		commandCopyBuffer.begin(vk::CommandBufferBeginInfo{ .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
-		commandCopyBuffer.copyBuffer(*srcBuffer, *dstBuffer, vk::BufferCopy{ .size = size });
-		commandCopyBuffer.end();
-		queue.submit(vk::SubmitInfo{ .commandBufferCount = 1, .pCommandBuffers = &*commandCopyBuffer }, nullptr);
-		queue.waitIdle();
-	}
-
 	uint32_t findMemoryType(uint32_t typeFilter, vk::MemoryPropertyFlags properties)
 	{
 		vk::PhysicalDeviceMemoryProperties memProperties = physicalDevice.getMemoryProperties();
@@ -1149,26 +1388,29 @@ private:
 	{
 		auto& commandBuffer = commandBuffers[frameIndex];
 		commandBuffer.begin({});
-		// Before starting rendering, transition the swapchain image to COLOR_ATTACHMENT_OPTIMAL
-		transition_image_layout(
-			swapChainImages[imageIndex],
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::eColorAttachmentOptimal,
-			{},                                                        // srcAccessMask (no need to wait for previous operations)
-			vk::AccessFlagBits2::eColorAttachmentWrite,                // dstAccessMask
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // srcStage
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // dstStage
-			vk::ImageAspectFlagBits::eColor);
-		// Transition depth image to depth attachment optimal layout
-		transition_image_layout(
-			*depthImage,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::eDepthAttachmentOptimal,
-			vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
-			vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
-			vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
-			vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
-			vk::ImageAspectFlagBits::eDepth);
+		{
+			auto barrierScope = gpuProfiler.scope(commandBuffer, "transitions_begin");
+			// Before starting rendering, transition the swapchain image to COLOR_ATTACHMENT_OPTIMAL
+			transition_image_layout(
+				swapChainImages[imageIndex],
+				vk::ImageLayout::eUndefined,
+				vk::ImageLayout::eColorAttachmentOptimal,
+				{},                                                        // srcAccessMask (no need to wait for previous operations)
+				vk::AccessFlagBits2::eColorAttachmentWrite,                // dstAccessMask
+				vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // srcStage
+				vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // dstStage
+				vk::ImageAspectFlagBits::eColor);
+			// Transition depth image to depth attachment optimal layout
+			transition_image_layout(
+				*depthImage,
+				vk::ImageLayout::eUndefined,
+				vk::ImageLayout::eDepthAttachmentOptimal,
+				vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+				vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+				vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+				vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+				vk::ImageAspectFlagBits::eDepth);
+		}
 
 		vk::ClearValue clearColor = vk::ClearColorValue(0.0f, 0.0f, 0.0f, 1.0f);
 		vk::ClearValue clearDepth = vk::ClearDepthStencilValue(1.0f, 0);
@@ -1189,6 +1431,41 @@ private:
 			.clearValue = clearDepth
 		};
 
+		if (depthPrepass)
+		{
+			auto prepassScope = gpuProfiler.scope(commandBuffer, "depth_prepass", true);
+			depthAttachmentInfo.storeOp = vk::AttachmentStoreOp::eStore;
+			vk::RenderingInfo depthRenderingInfo = {
+				.renderArea = {.offset = {0, 0}, .extent = swapChainExtent},
+				.layerCount = 1,
+				.colorAttachmentCount = 0,
+				.pDepthAttachment = &depthAttachmentInfo
+			};
+
+			commandBuffer.beginRendering(depthRenderingInfo);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *depthPrepassPipeline);
+			commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+			commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+			commandBuffer.bindVertexBuffers(0, *vertexBuffer, { 0 });
+			commandBuffer.bindIndexBuffer(*indexBuffer, 0, packedIndices.indexType());
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptorSets[frameIndex], nullptr);
+			commandBuffer.pushConstants<PositionQuantization>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, encodedVertices.quantization);
+			commandBuffer.drawIndexed(drawIndexCount, 1, 0, 0, 0);
+			commandBuffer.endRendering();
+
+			vk::MemoryBarrier2 depthBarrier
+			{
+				.srcStageMask = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+				.srcAccessMask = vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+				.dstAccessMask = vk::AccessFlagBits2::eDepthStencilAttachmentRead
+			};
+			commandBuffer.pipelineBarrier2(vk::DependencyInfo{ .memoryBarrierCount = 1, .pMemoryBarriers = &depthBarrier });
+
+			depthAttachmentInfo.loadOp = vk::AttachmentLoadOp::eLoad;
+			depthAttachmentInfo.storeOp = vk::AttachmentStoreOp::eDontCare;
+		}
+
 		vk::RenderingInfo renderingInfo = {
 			.renderArea = {.offset = {0, 0}, .extent = swapChainExtent},
 			.layerCount = 1,
@@ -1196,25 +1473,32 @@ private:
 			.pColorAttachments = &colorAttachmentInfo,
 			.pDepthAttachment = &depthAttachmentInfo 
 		};
-		commandBuffer.beginRendering(renderingInfo);
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, *graphicsPipeline);
-		commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
-		commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
-		commandBuffer.bindVertexBuffers(0, *vertexBuffer, { 0 });
-		commandBuffer.bindIndexBuffer(*indexBuffer, 0, vk::IndexType::eUint32);
-		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptorSets[frameIndex], nullptr);
-		commandBuffer.drawIndexed(indices.size(), 1, 0, 0, 0);
-		commandBuffer.endRendering();
-		// After rendering, transition the swapchain image to PRESENT_SRC
-		transition_image_layout(
-			swapChainImages[imageIndex],
-			vk::ImageLayout::eColorAttachmentOptimal,
-			vk::ImageLayout::ePresentSrcKHR,
-			vk::AccessFlagBits2::eColorAttachmentWrite,                // srcAccessMask
-			{},                                                        // dstAccessMask
-			vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // srcStage
-			vk::PipelineStageFlagBits2::eBottomOfPipe,                 // dstStage
-			vk::ImageAspectFlagBits::eColor);
+		{
+			auto passScope = gpuProfiler.scope(commandBuffer, "main_pass", true);
+			commandBuffer.beginRendering(renderingInfo);
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, depthPrepass ? *depthEqualPipeline : *graphicsPipeline);
+			commandBuffer.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapChainExtent.width), static_cast<float>(swapChainExtent.height), 0.0f, 1.0f));
+			commandBuffer.setScissor(0, vk::Rect2D(vk::Offset2D(0, 0), swapChainExtent));
+			commandBuffer.bindVertexBuffers(0, { *vertexBuffer, *vertexBuffer }, { 0, encodedVertices.attributeOffset });
+			commandBuffer.bindIndexBuffer(*indexBuffer, 0, packedIndices.indexType());
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, *descriptorSets[frameIndex], nullptr);
+			commandBuffer.pushConstants<PositionQuantization>(*pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, encodedVertices.quantization);
+			commandBuffer.drawIndexed(drawIndexCount, 1, 0, 0, 0);
+			commandBuffer.endRendering();
+		}
+		{
+			auto barrierScope = gpuProfiler.scope(commandBuffer, "transitions_present");
+			// After rendering, transition the swapchain image to PRESENT_SRC
+			transition_image_layout(
+				swapChainImages[imageIndex],
+				vk::ImageLayout::eColorAttachmentOptimal,
+				vk::ImageLayout::ePresentSrcKHR,
+				vk::AccessFlagBits2::eColorAttachmentWrite,                // srcAccessMask
+				{},                                                        // dstAccessMask
+				vk::PipelineStageFlagBits2::eColorAttachmentOutput,        // srcStage
+				vk::PipelineStageFlagBits2::eBottomOfPipe,                 // dstStage
+				vk::ImageAspectFlagBits::eColor);
+		}
 		commandBuffer.end();
 	}
 
@@ -1287,11 +1571,26 @@ private:
 	{
 		// Note: inFlightFences, presentCompleteSemaphores, and commandBuffers are indexed by frameIndex,
 		//       while renderFinishedSemaphores is indexed by imageIndex
-		while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[frameIndex], vk::True, UINT64_MAX))
-			;
+		{
+			VSA_TRACE_ZONE("wait_fence");
+			while (vk::Result::eTimeout == device.waitForFences(*inFlightFences[frameIndex], vk::True, UINT64_MAX))
+				;
+		}
 		device.resetFences(*inFlightFences[frameIndex]);
 
-		auto [result, imageIndex] = swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[frameIndex], nullptr);
+		{
+			VSA_TRACE_ZONE("uploads");
+			uploads.pump();
+		}
+
+		// The fence guarantees this slot's queries from MAX_FRAMES_IN_FLIGHT frames ago are done
+		gpuProfiler.beginFrame(frameIndex);
+
+		auto [result, imageIndex] = [&]
+			{
+				VSA_TRACE_ZONE("acquire");
+				return swapChain.acquireNextImage(UINT64_MAX, *presentCompleteSemaphores[frameIndex], nullptr);
+			}();
 
 		if (result == vk::Result::eErrorOutOfDateKHR)
 		{
@@ -1301,26 +1600,36 @@ private:
 		if (result != vk::Result::eSuccess && result != vk::Result::eSuboptimalKHR)
 			throw std::runtime_error("failed to acquire swap chain image!");
 		
-		updateUniformBuffer(frameIndex);
+		{
+			VSA_TRACE_ZONE("update_ubo");
+			updateUniformBuffer(frameIndex);
+		}
 
-		commandBuffers[frameIndex].reset();
-		recordCommandBuffer(imageIndex);
+		{
+			VSA_TRACE_ZONE("record");
+			commandBuffers[frameIndex].reset();
+			recordCommandBuffer(imageIndex);
+		}
 
-		vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		const vk::SubmitInfo submitInfo
 		{
-			.waitSemaphoreCount = 1,
-			.pWaitSemaphores = &*presentCompleteSemaphores[frameIndex],
-			.pWaitDstStageMask = &waitDestinationStageMask,
-			.commandBufferCount = 1,
-			.pCommandBuffers = &*commandBuffers[frameIndex],
-			.signalSemaphoreCount = 1,
-			.pSignalSemaphores = &*renderFinishedSemaphores[imageIndex]
-		};
-		queue.submit(submitInfo, *inFlightFences[frameIndex]);
+			VSA_TRACE_ZONE("submit");
+			vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
+			const vk::SubmitInfo submitInfo
+			{
+				.waitSemaphoreCount = 1,
+				.pWaitSemaphores = &*presentCompleteSemaphores[frameIndex],
+				.pWaitDstStageMask = &waitDestinationStageMask,
+				.commandBufferCount = 1,
+				.pCommandBuffers = &*commandBuffers[frameIndex],
+				.signalSemaphoreCount = 1,
+				.pSignalSemaphores = &*renderFinishedSemaphores[imageIndex]
+			};
+			queue.submit(submitInfo, *inFlightFences[frameIndex]);
+		}
 
 		try
 		{
+			VSA_TRACE_ZONE("present");
 			const vk::PresentInfoKHR presentInfoKHR
 			{ 
 				.waitSemaphoreCount = 1,
@@ -1429,8 +1738,15 @@ private:
 		return vk::False;
 	}
 
-	static std::vector<char> readFile(const std::string& filename)
+	std::vector<char> readFile(const std::string& filename) const
 	{
+		if (const AssetPackEntry* entry = assets.find(filename))
+		{
+			std::vector<char> buffer(entry->size);
+			assets.read(*entry, buffer.data());
+			return buffer;
+		}
+
 		std::ifstream file(filename, std::ios::ate | std::ios::binary);
 		if (!file.is_open())
 			throw std::runtime_error("failed to open file!");
@@ -1443,12 +1759,12 @@ private:
 	}
 };
 
-int main()
+int runHelloTriangle(const BenchmarkOptions& options)
 {
 	try
 	{
 		HelloTriangleApplication app;
-		app.run();
+		app.run(options);
 	}
 	catch (const std::exception& e)
 	{
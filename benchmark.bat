@@ -0,0 +1,29 @@
+set CONFIG=ReleaseX64
+if not "%~1"=="" set CONFIG=%~1
+
+pushd Vulkan_Simple_Application
+for %%a in (hello triangle compute multithreaded) do ..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=%%a --benchmark --headless --seed=1337 --output=..\benchmark_%%a.json
+rem Triangle throughput with LOD selection at increasing object counts
+for %%n in (1 16 64 256) do ..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=%%n --output=..\benchmark_triangle_%%n.json
+rem Depth prepass on the most overlapped scene; compare the depth_prepass + main_pass GPU times with the run above
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --depth-prepass --output=..\benchmark_triangle_256_prepass.json
+rem Mip chain built with the blit chain instead of the compute downsampler; compare one_shot_gpu_ms.texture_mips with benchmark_hello.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=hello --benchmark --headless --seed=1337 --mips=blit --output=..\benchmark_hello_blit_mips.json
+rem Triangle with the uncompressed PNG texture; compare memory.resources.texture and the texture startup phases with benchmark_triangle.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --texture=png --output=..\benchmark_triangle_png.json
+rem Loose files instead of the memory-mapped asset pack; compare the startup phases and memory.peak_rss_bytes with benchmark_hello.json and benchmark_triangle.json
+for %%a in (hello triangle) do ..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=%%a --benchmark --headless --seed=1337 --assets=loose --output=..\benchmark_%%a_loose.json
+rem Streamed texture mips under a tight budget; compare memory.resources.texture, counters.texture_resident_mib and the texture_streaming phase with benchmark_triangle_256.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --texture-budget=1 --output=..\benchmark_triangle_256_budget.json
+rem Per-frame descriptor sets with dynamic uniform offsets instead of the bindless table; compare cpu_frame_ms and counters.draws / descriptor_binds with benchmark_triangle_256.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --descriptors=classic --output=..\benchmark_triangle_256_classic.json
+rem Every command buffer recorded each frame instead of resubmitting cached ones; compare cpu_frame_ms and the record zone of the CPU trace with benchmark_triangle_256.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --command-cache=off --output=..\benchmark_triangle_256_recorded.json
+rem Recording a large per-object draw list every frame on 1 (inline), 2, 4 and 8 threads; compare the record zone of the CPU trace and cpu_frame_ms
+for %%t in (1 2 4 8) do ..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=16384 --descriptors=classic --command-cache=off --record-threads=%%t --output=..\benchmark_triangle_16384_record_%%t.json
+rem Depth prepass with extended dynamic state (one main pipeline) and with a pipeline per render state; compare pipelines.count / create_ms and the pipeline startup phase
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --depth-prepass --output=..\benchmark_triangle_256_dynamic.json
+..\binaries\%CONFIG%\Vulkan_Simple_Application.exe --app=triangle --benchmark --headless --seed=1337 --objects=256 --depth-prepass --dynamic-state=off --output=..\benchmark_triangle_256_baked.json
+popd
+
+PAUSE
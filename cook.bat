@@ -0,0 +1,8 @@
+set CONFIG=ReleaseX64
+if not "%~1"=="" set CONFIG=%~1
+
+rem Cooks resources\ into resources\cooked\; only assets whose content changed since the last run are re-cooked (--force cooks everything)
+rem and packs the runtime files into resources\assets.pack, which the apps map instead of opening loose files
+binaries\%CONFIG%\Asset_Cooker.exe Vulkan_Simple_Application\resources Vulkan_Simple_Application\resources\cooked --pack=Vulkan_Simple_Application\resources\assets.pack %2
+
+PAUSE
\ No newline at end of file
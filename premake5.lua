@@ -20,6 +20,25 @@ IncludeDir["GLFW"] = third_party_path .. "/glfw"
 IncludeDir["STB_IMAGE"] = third_party_path .. "/stb_image"
 IncludeDir["TINY"] = third_party_path .. "/tiny"
 
+shader_path = "Vulkan_Simple_Application/resources/shaders"
+
+-- Builds a Slang shader into the SPIR-V next to it, with the flags of the compile.bat in its folder. The
+-- .spv files stay committed, so the app also runs from a tree whose shaders were never built.
+function slang_shader(source, output, entries)
+	local entry_flags = ""
+	for _, entry in ipairs(entries) do
+		entry_flags = entry_flags .. " -entry " .. entry
+	end
+
+	files { source }
+
+	filter("files:" .. source)
+		buildmessage("slangc " .. path.getname(source))
+		buildcommands { '"%{Vulkan_SDK}/Bin/slangc" "%{file.abspath}" -target spirv -profile spirv_1_4 -emit-spirv-directly -fvk-use-entrypoint-name' .. entry_flags .. ' -o "%{file.directory}/' .. output .. '"' }
+		buildoutputs { "%{file.directory}/" .. output }
+	filter {}
+end
+
 project "Vulkan_Simple_Application"
 	kind "ConsoleApp"
 	location "Vulkan_Simple_Application"
@@ -78,6 +97,120 @@ project "Vulkan_Simple_Application"
 		"STB_IMAGE_WRITE_IMPLEMENTATION",
 	}
 
+	slang_shader(shader_path .. "/compute/shader_compute.slang", "slang_compute.spv", { "vertMain", "fragMain", "compMain" })
+	slang_shader(shader_path .. "/shader_mesh.slang", "slang_mesh.spv", { "vertMain", "vertMainNormal", "vertMainDepth", "fragMain" })
+	slang_shader(shader_path .. "/compute/shader_meshlet_cull.slang", "slang_meshlet_cull.spv", { "cullMain" })
+	slang_shader(shader_path .. "/compute/shader_depth_pyramid.slang", "slang_depth_pyramid.spv", { "downsampleMain" })
+	slang_shader(shader_path .. "/compute/shader_mipgen.slang", "slang_mipgen.spv", { "downsampleMain" })
+	slang_shader(shader_path .. "/shader_mesh_bindless.slang", "slang_mesh_bindless.spv", { "vertMain", "vertMainNormal", "vertMainDepth", "fragMain" })
+
+	filter "configurations:DebugX64"
+		defines "VSA_Debug"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:ReleaseX64"
+		defines "VSA_Release"
+		runtime "Release"
+		optimize "On"
+
+-- Offline asset cooker: PNG/JPG -> KTX2 (UASTC) and OBJ/glTF -> cooked meshes. Shares the app's core headers.
+project "Asset_Cooker"
+	kind "ConsoleApp"
+	location "Asset_Cooker"
+	cppdialect "C++20"
+
+	targetdir("binaries/" .. outdir)
+	objdir("intermediaries/" .. outdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/source/**.cpp",
+		"%{prj.name}/source/**.h",
+	}
+
+	includedirs
+	{
+		"%{prj.name}/source",
+		"Vulkan_Simple_Application/source",
+		"Vulkan_Simple_Application/third_party",
+
+		"Vulkan_Simple_Application/third_party/stb_image",
+		"Vulkan_Simple_Application/third_party/tiny",
+		"%{KTX_Software}/include",
+		"%{Vulkan_SDK}/Include",
+	}
+
+	libdirs
+	{
+		"%{KTX_Software}/lib",
+	}
+
+	defines
+	{
+		"VULKAN_HPP_NO_STRUCT_CONSTRUCTORS",
+		"STB_IMAGE_IMPLEMENTATION",
+		"TINYOBJLOADER_IMPLEMENTATION",
+		"TINYGLTF_IMPLEMENTATION",
+		"STB_IMAGE_WRITE_IMPLEMENTATION",
+	}
+
+	filter "system:windows"
+		links "ktx.lib"
+
+	filter "system:not windows"
+		links { "ktx", "pthread" }
+
+	filter "configurations:DebugX64"
+		defines "VSA_Debug"
+		runtime "Debug"
+		symbols "On"
+
+	filter "configurations:ReleaseX64"
+		defines "VSA_Release"
+		runtime "Release"
+		optimize "On"
+
+-- Unit tests for the core headers (Tests/source). Tests that need a Vulkan device skip themselves when
+-- the machine has none.
+project "Tests"
+	kind "ConsoleApp"
+	location "Tests"
+	cppdialect "C++20"
+
+	targetdir("binaries/" .. outdir)
+	objdir("intermediaries/" .. outdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/source/**.cpp",
+		"%{prj.name}/source/**.h",
+	}
+
+	includedirs
+	{
+		"%{prj.name}/source",
+		"Vulkan_Simple_Application/source",
+		"Vulkan_Simple_Application/third_party",
+		"%{Vulkan_SDK}/Include",
+	}
+
+	libdirs
+	{
+		"%{Vulkan_SDK}/Lib",
+	}
+
+	defines
+	{
+		"VULKAN_HPP_NO_STRUCT_CONSTRUCTORS",
+	}
+
+	filter "system:windows"
+		links "vulkan-1.lib"
+
+	filter "system:not windows"
+		links { "vulkan", "pthread" }
+
 	filter "configurations:DebugX64"
 		defines "VSA_Debug"
 		runtime "Debug"
@@ -86,4 +219,4 @@ project "Vulkan_Simple_Application"
 	filter "configurations:ReleaseX64"
 		defines "VSA_Release"
 		runtime "Release"
-		optimize "On"
\ No newline at end of file
+		optimize "On"